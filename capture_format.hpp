@@ -0,0 +1,207 @@
+#pragma once
+
+#ifndef CAPTURE_FORMAT_HPP
+#define CAPTURE_FORMAT_HPP
+
+#include <cstring>
+#include <cstddef>
+#include <stdint.h>
+
+#include "msg_defs.hpp"
+
+/*
+------------------------------------------------------------------------------------------------------------------------
+    CAPTURE FILE FORMAT
+
+    A capture file is a file header followed by a sequence of blocks. The file header and every block start on a
+    CAPTURE_BLOCK_ALIGNMENT boundary, so files can be written with O_DIRECT and read back with mmap.
+
+        [capture_file_header][pad] [capture_block_header][records or compressed records][pad] ...
+
+    A block holds record_count capture_record entries. When CAPTURE_BLOCK_COMPRESSED is set, the records are stored
+    as one capture_lz block and must be decompressed to raw_size bytes before use.
+------------------------------------------------------------------------------------------------------------------------
+*/
+static constexpr uint32_t CAPTURE_FILE_MAGIC        = 0x46435644; // "DVCF"
+static constexpr uint32_t CAPTURE_BLOCK_MAGIC       = 0x42435644; // "DVCB"
+static constexpr uint16_t CAPTURE_FORMAT_VERSION    = 1;
+static constexpr uint32_t CAPTURE_BLOCK_ALIGNMENT   = 4096;
+
+static constexpr uint16_t CAPTURE_BLOCK_COMPRESSED  = 0x0001;
+
+enum CAPTURE_DIRECTION : uint8_t {
+    CAPTURE_RECEIVED,
+    CAPTURE_SENT,
+};
+
+struct capture_file_header {
+    uint32_t magic;
+    uint16_t format_version;
+    uint16_t message_version;
+    uint32_t record_size;
+    uint32_t block_alignment;
+    uint64_t created_us;
+};
+
+struct capture_block_header {
+    uint32_t magic;
+    uint16_t flags;
+    uint16_t reserved;
+    uint32_t record_count;
+    uint32_t raw_size;
+    uint32_t stored_size;
+    uint32_t reserved2;
+    uint64_t min_timestamp_us;
+    uint64_t max_timestamp_us;
+};
+
+struct capture_record {
+    uint64_t capture_timestamp_us;
+    uint32_t peer_id;
+    uint8_t  direction;
+    uint8_t  reserved[3];
+    message  frame;
+};
+
+static_assert(sizeof(capture_block_header) == 40, "capture_block_header layout changed");
+static_assert(sizeof(capture_record) == 16 + sizeof(message), "capture_record must stay packed");
+
+inline uint64_t capture_align_up(uint64_t value, uint64_t alignment = CAPTURE_BLOCK_ALIGNMENT) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+/*
+------------------------------------------------------------------------------------------------------------------------
+    BLOCK COMPRESSION
+
+    capture_lz is a small LZ77 codec using the LZ4 block layout: a token byte with 4-bit literal and match lengths,
+    255-continuation length bytes, the literals, and a 2-byte little-endian match offset. Capture blocks compress well
+    because consecutive frames share headers, stream names and zeroed payload tails.
+------------------------------------------------------------------------------------------------------------------------
+*/
+static constexpr uint32_t CAPTURE_LZ_MIN_MATCH  = 4;
+static constexpr uint32_t CAPTURE_LZ_HASH_BITS  = 12;
+static constexpr uint32_t CAPTURE_LZ_MAX_OFFSET = 65535;
+// The LZ4 layout requires the last bytes of a block to be literals.
+static constexpr uint32_t CAPTURE_LZ_TAIL       = 12;
+
+inline uint32_t capture_lz_bound(uint32_t raw_size) {
+    return raw_size + raw_size / 255 + 16;
+}
+
+inline uint32_t capture_lz_hash(const uint8_t *src) {
+    uint32_t v;
+    memcpy(&v, src, sizeof(uint32_t));
+    return (v * 2654435761U) >> (32 - CAPTURE_LZ_HASH_BITS);
+}
+
+inline uint8_t *capture_lz_put_length(uint8_t *dst, uint32_t length) {
+    while (length >= 255) {
+        *dst++  = 255;
+        length -= 255;
+    }
+    *dst++ = static_cast<uint8_t>(length);
+    return dst;
+}
+
+/*
+    Compresses raw_size bytes into dst, which must hold capture_lz_bound(raw_size) bytes. Returns the compressed size.
+*/
+inline uint32_t capture_lz_compress(const uint8_t *src, uint32_t raw_size, uint8_t *dst) {
+    uint32_t table[1U << CAPTURE_LZ_HASH_BITS];
+    memset(table, 0xFF, sizeof(table));
+
+    uint8_t *out          = dst;
+    uint32_t anchor       = 0;
+    uint32_t pos          = 0;
+    const uint32_t limit  = raw_size > CAPTURE_LZ_TAIL ? raw_size - CAPTURE_LZ_TAIL : 0;
+
+    while (pos < limit) {
+        const uint32_t h    = capture_lz_hash(&src[pos]);
+        const uint32_t cand = table[h];
+        table[h] = pos;
+        if (cand == UINT32_MAX || pos - cand > CAPTURE_LZ_MAX_OFFSET || memcmp(&src[cand], &src[pos], CAPTURE_LZ_MIN_MATCH) != 0) {
+            pos++;
+            continue;
+        }
+
+        uint32_t match_len = CAPTURE_LZ_MIN_MATCH;
+        while (pos + match_len < limit && src[cand + match_len] == src[pos + match_len]) {
+            match_len++;
+        }
+
+        const uint32_t literal_len = pos - anchor;
+        const uint32_t match_code  = match_len - CAPTURE_LZ_MIN_MATCH;
+        uint8_t *token = out++;
+        *token = static_cast<uint8_t>(((literal_len >= 15 ? 15 : literal_len) << 4) | (match_code >= 15 ? 15 : match_code));
+        if (literal_len >= 15) out = capture_lz_put_length(out, literal_len - 15);
+        memcpy(out, &src[anchor], literal_len);
+        out += literal_len;
+
+        const uint16_t offset = static_cast<uint16_t>(pos - cand);
+        memcpy(out, &offset, sizeof(uint16_t));
+        out += sizeof(uint16_t);
+        if (match_code >= 15) out = capture_lz_put_length(out, match_code - 15);
+
+        pos   += match_len;
+        anchor = pos;
+    }
+
+    const uint32_t literal_len = raw_size - anchor;
+    *out++ = static_cast<uint8_t>((literal_len >= 15 ? 15 : literal_len) << 4);
+    if (literal_len >= 15) out = capture_lz_put_length(out, literal_len - 15);
+    memcpy(out, &src[anchor], literal_len);
+    out += literal_len;
+
+    return static_cast<uint32_t>(out - dst);
+}
+
+/*
+    Decompresses stored_size bytes into dst, which holds raw_size bytes. Returns false on malformed input.
+*/
+inline bool capture_lz_decompress(const uint8_t *src, uint32_t stored_size, uint8_t *dst, uint32_t raw_size) {
+    const uint8_t *in      = src;
+    const uint8_t *in_end  = src + stored_size;
+    uint32_t out           = 0;
+
+    while (in < in_end) {
+        const uint8_t token  = *in++;
+        uint32_t literal_len = token >> 4;
+        if (literal_len == 15) {
+            uint8_t more;
+            do {
+                if (in >= in_end) return false;
+                more         = *in++;
+                literal_len += more;
+            } while (more == 255);
+        }
+        if (literal_len > static_cast<uint32_t>(in_end - in) || literal_len > raw_size - out) return false;
+        memcpy(&dst[out], in, literal_len);
+        in  += literal_len;
+        out += literal_len;
+        if (in == in_end) break;
+
+        uint16_t offset;
+        if (in_end - in < 2) return false;
+        memcpy(&offset, in, sizeof(uint16_t));
+        in += sizeof(uint16_t);
+        uint32_t match_len = (token & 0x0F);
+        if (match_len == 15) {
+            uint8_t more;
+            do {
+                if (in >= in_end) return false;
+                more       = *in++;
+                match_len += more;
+            } while (more == 255);
+        }
+        match_len += CAPTURE_LZ_MIN_MATCH;
+        if (offset == 0 || offset > out || match_len > raw_size - out) return false;
+        // Byte-wise copy, since matches may overlap their own output.
+        for (uint32_t i = 0; i < match_len; ++i, ++out) {
+            dst[out] = dst[out - offset];
+        }
+    }
+    return out == raw_size;
+}
+
+#endif // CAPTURE_FORMAT_HPP
@@ -0,0 +1,356 @@
+#pragma once
+
+#ifndef CAPTURE_READER_HPP
+#define CAPTURE_READER_HPP
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <stdint.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "capture_format.hpp"
+
+/*
+------------------------------------------------------------------------------------------------------------------------
+    CAPTURE READER
+
+    Memory-maps a capture file written by capture_recorder and keeps one index entry per block. An entry holds the
+    block's time range, a bitmask of the parameter types it contains, a bloom filter over stream names and the sorted
+    list of TRACKED_DETECTION track ids in the block. A block holds thousands of records and can hold as many tracks,
+    which would fill any fixed-size filter, so track lookups use the exact list. Queries check the index first and
+    only touch the pages of blocks that may match.
+
+    Building the index reads every block once. The index is then saved as a sidecar file (<capture>.idx): the header,
+    the block entries, then the track id lists of all blocks back to back. It is reused on the next open as long as
+    the capture size and mtime still match.
+
+    Records in uncompressed blocks are passed to the visitor straight from the mapping. Compressed blocks are
+    decompressed into a reader-owned buffer first. In both cases a record reference is only valid during the call.
+------------------------------------------------------------------------------------------------------------------------
+*/
+static constexpr uint32_t CAPTURE_INDEX_MAGIC   = 0x49435644; // "DVCI"
+static constexpr uint16_t CAPTURE_INDEX_VERSION = 2;
+
+struct capture_block_index_entry {
+    uint64_t offset;
+    uint64_t min_timestamp_us;
+    uint64_t max_timestamp_us;
+    uint32_t record_count;
+    uint32_t flags;
+    uint64_t param_type_mask;   // Bit n set if param_type n occurs. Bit 63 covers param_type >= 63.
+    uint64_t stream_bloom;
+    uint32_t track_first;       // The block's track ids are track_ids()[track_first, track_first + track_count).
+    uint32_t track_count;
+};
+
+struct capture_index_header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint64_t capture_size;
+    int64_t  capture_mtime_ns;
+    uint64_t block_count;
+    uint64_t track_id_count;    // uint16_t track ids following the block entries.
+};
+
+struct capture_query {
+    uint64_t    from_us     = 0;
+    uint64_t    to_us       = UINT64_MAX;
+    int16_t     param_type  = -1;       // -1 matches any parameter type.
+    const char *stream_name = nullptr;  // nullptr matches any stream.
+    int32_t     track_id    = -1;       // -1 matches any track. Otherwise only TRACKED_DETECTION frames match.
+};
+
+inline uint64_t capture_param_type_bit(uint8_t param_type) {
+    return 1ULL << (param_type < 63 ? param_type : 63);
+}
+
+inline uint64_t capture_stream_hash(std::string_view stream_name) {
+    uint64_t h = 0xCBF29CE484222325ULL;
+    for (char c : stream_name) {
+        h ^= static_cast<uint8_t>(c);
+        h *= 0x100000001B3ULL;
+    }
+    return h;
+}
+
+inline uint64_t capture_stream_bloom_bits(std::string_view stream_name) {
+    const uint64_t h = capture_stream_hash(stream_name);
+    return (1ULL << (h & 63)) | (1ULL << ((h >> 6) & 63));
+}
+
+class capture_reader {
+public:
+    capture_reader() = default;
+    capture_reader(const capture_reader &) = delete;
+    capture_reader &operator=(const capture_reader &) = delete;
+
+    ~capture_reader() {
+        close();
+    }
+
+    /*
+        Maps the capture and loads or builds its block index. Returns false if the file is missing or not a capture.
+    */
+    bool open(const char *path, bool use_sidecar = true) {
+        close();
+        const int fd = ::open(path, O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) < CAPTURE_BLOCK_ALIGNMENT) {
+            ::close(fd);
+            return false;
+        }
+        size_     = static_cast<uint64_t>(st.st_size);
+        mtime_ns_ = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+        void *mapped = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) return false;
+        base_ = static_cast<const uint8_t *>(mapped);
+        madvise(mapped, size_, MADV_RANDOM);
+
+        capture_file_header header;
+        memcpy(&header, base_, sizeof(header));
+        if (header.magic != CAPTURE_FILE_MAGIC || header.record_size != sizeof(capture_record) ||
+            header.block_alignment != CAPTURE_BLOCK_ALIGNMENT) {
+            close();
+            return false;
+        }
+
+        const std::string sidecar = std::string(path) + ".idx";
+        if (use_sidecar && load_index(sidecar.c_str())) return true;
+        build_index();
+        if (use_sidecar) save_index(sidecar.c_str());
+        return true;
+    }
+
+    void close() {
+        if (base_ != nullptr) {
+            munmap(const_cast<uint8_t *>(base_), size_);
+            base_ = nullptr;
+        }
+        size_ = 0;
+        index_.clear();
+        track_ids_.clear();
+    }
+
+    const std::vector<capture_block_index_entry> &index() const {
+        return index_;
+    }
+
+    const std::vector<uint16_t> &track_ids() const {
+        return track_ids_;
+    }
+
+    /*
+        Blocks whose records the last query() read, i.e. that the index could not rule out.
+    */
+    uint64_t blocks_scanned() const {
+        return blocks_scanned_;
+    }
+
+    /*
+        Calls visit(const capture_record &) for every matching record in file order. Returns the number visited.
+    */
+    template <typename Visitor>
+    uint64_t query(const capture_query &q, Visitor &&visit) {
+        const bool     by_stream   = q.stream_name != nullptr;
+        const std::string_view stream = by_stream ? stream_name_source_view(q.stream_name).substr(0, STREAM_NAME_SIZE) : std::string_view{};
+        const uint64_t stream_bits = by_stream ? capture_stream_bloom_bits(stream) : 0;
+        uint64_t       type_bit    = q.param_type >= 0 ? capture_param_type_bit(static_cast<uint8_t>(q.param_type)) : 0;
+        blocks_scanned_ = 0;
+        if (q.track_id >= 0) {
+            if (q.param_type >= 0 && q.param_type != TRACKED_DETECTION) return 0;
+            if (q.track_id > UINT16_MAX) return 0;
+            type_bit = capture_param_type_bit(TRACKED_DETECTION);
+        }
+
+        uint64_t visited = 0;
+        for (const capture_block_index_entry &entry : index_) {
+            if (entry.max_timestamp_us < q.from_us || entry.min_timestamp_us > q.to_us) continue;
+            if (type_bit != 0 && (entry.param_type_mask & type_bit) == 0) continue;
+            if (by_stream && (entry.stream_bloom & stream_bits) != stream_bits) continue;
+            if (q.track_id >= 0 && !block_has_track(entry, static_cast<uint16_t>(q.track_id))) continue;
+
+            const capture_record *records = block_records(entry);
+            if (records == nullptr) continue;
+            blocks_scanned_++;
+            for (uint32_t i = 0; i < entry.record_count; ++i) {
+                const capture_record &rec = records[i];
+                if (rec.capture_timestamp_us < q.from_us || rec.capture_timestamp_us > q.to_us) continue;
+                if (q.param_type >= 0 && rec.frame.param_type != q.param_type) continue;
+                if (by_stream && frame_stream_name(rec.frame) != stream) continue;
+                if (q.track_id >= 0) {
+                    uint16_t track_id;
+                    if (!frame_track_id(rec.frame, track_id) || track_id != q.track_id) continue;
+                }
+                visit(rec);
+                visited++;
+            }
+        }
+        return visited;
+    }
+
+private:
+    bool block_has_track(const capture_block_index_entry &entry, uint16_t track_id) const {
+        const uint16_t *first = track_ids_.data() + entry.track_first;
+        return std::binary_search(first, first + entry.track_count, track_id);
+    }
+
+    const capture_record *block_records(const capture_block_index_entry &entry) {
+        capture_block_header header;
+        memcpy(&header, base_ + entry.offset, sizeof(header));
+        const uint8_t *payload = base_ + entry.offset + sizeof(capture_block_header);
+        if ((header.flags & CAPTURE_BLOCK_COMPRESSED) == 0) {
+            return reinterpret_cast<const capture_record *>(payload);
+        }
+        scratch_.resize(header.raw_size / sizeof(capture_record));
+        if (!capture_lz_decompress(payload, header.stored_size, reinterpret_cast<uint8_t *>(scratch_.data()), header.raw_size)) {
+            return nullptr;
+        }
+        return scratch_.data();
+    }
+
+    /*
+        Reads the block header at offset and checks that the whole block lies inside the mapping. An uncompressed
+        block is read in place, so its stored size must cover all of its records. A compressed block cannot claim more
+        than the codec's worst-case expansion, which bounds the decompression buffer.
+    */
+    bool valid_block(uint64_t offset, capture_block_header &header) const {
+        if (offset < CAPTURE_BLOCK_ALIGNMENT || offset % CAPTURE_BLOCK_ALIGNMENT != 0 ||
+            offset > size_ || size_ - offset < sizeof(capture_block_header)) {
+            return false;
+        }
+        memcpy(&header, base_ + offset, sizeof(header));
+        if (header.magic != CAPTURE_BLOCK_MAGIC ||
+            static_cast<uint64_t>(header.raw_size) != static_cast<uint64_t>(header.record_count) * sizeof(capture_record) ||
+            header.stored_size > size_ - offset - sizeof(capture_block_header)) {
+            return false;
+        }
+        if ((header.flags & CAPTURE_BLOCK_COMPRESSED) == 0) return header.stored_size == header.raw_size;
+        return header.raw_size <= header.stored_size * 255ULL + 16;
+    }
+
+    void build_index() {
+        uint64_t offset = CAPTURE_BLOCK_ALIGNMENT;
+        capture_block_header header;
+        std::vector<uint16_t> block_tracks;
+        while (valid_block(offset, header)) {
+            capture_block_index_entry entry;
+            memset(&entry, 0, sizeof(entry));
+            entry.offset           = offset;
+            entry.min_timestamp_us = header.min_timestamp_us;
+            entry.max_timestamp_us = header.max_timestamp_us;
+            entry.record_count     = header.record_count;
+            entry.flags            = header.flags;
+
+            const capture_record *records = block_records(entry);
+            if (records == nullptr) break;
+            block_tracks.clear();
+            for (uint32_t i = 0; i < header.record_count; ++i) {
+                const message &frame = records[i].frame;
+                entry.param_type_mask |= capture_param_type_bit(frame.param_type);
+                const int16_t name_offset = stream_name_offset(frame.param_type);
+                if (name_offset >= 0) {
+                    entry.stream_bloom |= capture_stream_bloom_bits(frame_stream_name(frame));
+                }
+                uint16_t track_id;
+                if (frame_track_id(frame, track_id)) block_tracks.push_back(track_id);
+            }
+            std::sort(block_tracks.begin(), block_tracks.end());
+            block_tracks.erase(std::unique(block_tracks.begin(), block_tracks.end()), block_tracks.end());
+            entry.track_first = static_cast<uint32_t>(track_ids_.size());
+            entry.track_count = static_cast<uint32_t>(block_tracks.size());
+            track_ids_.insert(track_ids_.end(), block_tracks.begin(), block_tracks.end());
+            index_.push_back(entry);
+            offset = capture_align_up(offset + sizeof(capture_block_header) + header.stored_size);
+        }
+    }
+
+    /*
+        Loads a sidecar index. Nothing in it is trusted: the block and track id counts must fit the capture and the
+        sidecar's own size, every entry must point at a valid block with the same record count and flags, and the
+        track id lists must follow each other and be sorted. Any mismatch returns false and the caller rebuilds the
+        index from the capture.
+    */
+    bool load_index(const char *path) {
+        FILE *file = fopen(path, "rb");
+        if (file == nullptr) return false;
+        capture_index_header header;
+        struct stat st;
+        // Every block occupies at least one aligned unit after the file header, and every record at least its size.
+        const uint64_t max_blocks = size_ / CAPTURE_BLOCK_ALIGNMENT;
+        const uint64_t max_tracks = size_ / sizeof(capture_record);
+        bool ok = fstat(fileno(file), &st) == 0 && fread(&header, sizeof(header), 1, file) == 1 &&
+                  header.magic == CAPTURE_INDEX_MAGIC && header.version == CAPTURE_INDEX_VERSION &&
+                  header.capture_size == size_ && header.capture_mtime_ns == mtime_ns_ &&
+                  header.block_count <= max_blocks && header.track_id_count <= max_tracks &&
+                  static_cast<uint64_t>(st.st_size) == sizeof(header) +
+                                                           header.block_count * sizeof(capture_block_index_entry) +
+                                                           header.track_id_count * sizeof(uint16_t);
+        if (ok) {
+            index_.resize(header.block_count);
+            track_ids_.resize(header.track_id_count);
+            ok = (header.block_count == 0 ||
+                  fread(index_.data(), sizeof(capture_block_index_entry), header.block_count, file) == header.block_count) &&
+                 (header.track_id_count == 0 ||
+                  fread(track_ids_.data(), sizeof(uint16_t), header.track_id_count, file) == header.track_id_count);
+        }
+        fclose(file);
+        uint64_t next_track = 0;
+        for (size_t i = 0; ok && i < index_.size(); ++i) {
+            const capture_block_index_entry &entry = index_[i];
+            capture_block_header block;
+            ok = valid_block(entry.offset, block) && block.record_count == entry.record_count &&
+                 block.flags == entry.flags && (i == 0 || entry.offset > index_[i - 1].offset) &&
+                 entry.track_first == next_track && entry.track_count <= entry.record_count &&
+                 entry.track_count <= track_ids_.size() - next_track;
+            if (!ok) break;
+            const uint16_t *first = track_ids_.data() + entry.track_first;
+            for (uint32_t t = 1; ok && t < entry.track_count; ++t) ok = first[t - 1] < first[t];
+            next_track += entry.track_count;
+        }
+        ok = ok && next_track == track_ids_.size();
+        if (!ok) {
+            index_.clear();
+            track_ids_.clear();
+        }
+        return ok;
+    }
+
+    void save_index(const char *path) const {
+        FILE *file = fopen(path, "wb");
+        if (file == nullptr) return;
+        capture_index_header header;
+        header.magic            = CAPTURE_INDEX_MAGIC;
+        header.version          = CAPTURE_INDEX_VERSION;
+        header.reserved         = 0;
+        header.capture_size     = size_;
+        header.capture_mtime_ns = mtime_ns_;
+        header.block_count      = index_.size();
+        header.track_id_count   = track_ids_.size();
+        fwrite(&header, sizeof(header), 1, file);
+        fwrite(index_.data(), sizeof(capture_block_index_entry), index_.size(), file);
+        fwrite(track_ids_.data(), sizeof(uint16_t), track_ids_.size(), file);
+        fclose(file);
+    }
+
+    const uint8_t                          *base_     = nullptr;
+    uint64_t                                size_     = 0;
+    int64_t                                 mtime_ns_ = 0;
+    std::vector<capture_block_index_entry>  index_;
+    std::vector<uint16_t>                   track_ids_;
+    std::vector<capture_record>             scratch_;
+    uint64_t                                blocks_scanned_ = 0;
+};
+
+#endif // CAPTURE_READER_HPP
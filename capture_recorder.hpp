@@ -0,0 +1,339 @@
+#pragma once
+
+#ifndef CAPTURE_RECORDER_HPP
+#define CAPTURE_RECORDER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <stdint.h>
+
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "capture_format.hpp"
+
+/*
+------------------------------------------------------------------------------------------------------------------------
+    CAPTURE RECORDER
+
+    Appends raw frames to a capture file (see capture_format.hpp). Any thread may call record(); it copies the frame
+    into a bounded lock-free queue and returns. A dedicated writer thread drains the queue into large aligned blocks,
+    optionally compresses them, and writes them with O_DIRECT. If the file system rejects O_DIRECT, at open() or on
+    a later write, the recorder falls back to buffered writes with the same file layout. A block that cannot be
+    written is cut off again, so the file always ends with a complete block.
+
+    When the queue is full, record() drops the frame and counts it instead of blocking the caller.
+------------------------------------------------------------------------------------------------------------------------
+*/
+struct capture_recorder_config {
+    const char *path            = nullptr;
+    uint32_t    block_size      = 1U << 20;  // Bytes per block, rounded up to CAPTURE_BLOCK_ALIGNMENT.
+    uint32_t    queue_capacity  = 1U << 16;  // Records, rounded up to a power of two, at most 2^31.
+    uint32_t    flush_interval_ms = 100;     // Partial blocks are written after this long.
+    bool        compress        = false;
+    bool        direct_io       = true;
+};
+
+struct capture_recorder_stats {
+    uint64_t records_written;
+    uint64_t records_dropped;
+    uint64_t blocks_written;
+    uint64_t bytes_written;
+};
+
+inline uint64_t capture_now_us() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000ULL + static_cast<uint64_t>(ts.tv_nsec) / 1000ULL;
+}
+
+class capture_recorder {
+public:
+    capture_recorder() = default;
+    capture_recorder(const capture_recorder &) = delete;
+    capture_recorder &operator=(const capture_recorder &) = delete;
+
+    ~capture_recorder() {
+        close();
+    }
+
+    bool open(const capture_recorder_config &config) {
+        if (fd_ >= 0 || config.path == nullptr) return false;
+
+        config_            = config;
+        config_.block_size = static_cast<uint32_t>(capture_align_up(config.block_size));
+        if (config_.block_size < CAPTURE_BLOCK_ALIGNMENT * 2) config_.block_size = CAPTURE_BLOCK_ALIGNMENT * 2;
+
+        // Clamped so the doubling cannot overflow and spin forever.
+        const uint32_t wanted = std::min<uint32_t>(config.queue_capacity, 1U << 31);
+        uint32_t capacity = 1;
+        while (capacity < wanted) capacity <<= 1;
+        mask_ = capacity - 1;
+
+        path_        = config.path;
+        file_offset_ = 0;
+        direct_.store(false, std::memory_order_relaxed);
+#ifdef O_DIRECT
+        if (config.direct_io) {
+            fd_ = ::open(config.path, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+            direct_.store(fd_ >= 0, std::memory_order_relaxed);
+        }
+#endif
+        if (fd_ < 0) {
+            fd_ = ::open(config.path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        }
+        if (fd_ < 0) return false;
+
+        slots_ = static_cast<slot *>(aligned_alloc(alignof(slot), sizeof(slot) * capacity));
+        block_ = static_cast<uint8_t *>(aligned_alloc(CAPTURE_BLOCK_ALIGNMENT, config_.block_size));
+        if (config_.compress) {
+            const uint64_t scratch_size =
+                capture_align_up(capture_lz_bound(config_.block_size) + sizeof(capture_block_header));
+            scratch_ = static_cast<uint8_t *>(aligned_alloc(CAPTURE_BLOCK_ALIGNMENT, scratch_size));
+        }
+        if (slots_ == nullptr || block_ == nullptr || (config_.compress && scratch_ == nullptr)) {
+            close();
+            return false;
+        }
+        for (uint32_t i = 0; i < capacity; ++i) {
+            new (&slots_[i].sequence) std::atomic<uint64_t>(i);
+        }
+        enqueue_pos_.store(0, std::memory_order_relaxed);
+        dequeue_pos_ = 0;
+
+        memset(block_, 0, CAPTURE_BLOCK_ALIGNMENT);
+        capture_file_header header;
+        header.magic           = CAPTURE_FILE_MAGIC;
+        header.format_version  = CAPTURE_FORMAT_VERSION;
+        header.message_version = VERSION;
+        header.record_size     = sizeof(capture_record);
+        header.block_alignment = CAPTURE_BLOCK_ALIGNMENT;
+        header.created_us      = capture_now_us();
+        memcpy(block_, &header, sizeof(header));
+        if (!write_aligned(block_, CAPTURE_BLOCK_ALIGNMENT)) {
+            close();
+            return false;
+        }
+
+        running_.store(true, std::memory_order_release);
+        writer_ = std::thread([this] { writer_loop(); });
+        return true;
+    }
+
+    /*
+        Queues one frame. Returns false if the recorder is closed or the queue is full.
+    */
+    bool record(const message &frame, CAPTURE_DIRECTION direction, uint32_t peer_id, uint64_t timestamp_us) {
+        if (slots_ == nullptr) return false;
+        uint64_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        slot *s;
+        for (;;) {
+            s = &slots_[pos & mask_];
+            const uint64_t seq = s->sequence.load(std::memory_order_acquire);
+            const int64_t diff = static_cast<int64_t>(seq - pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        s->record.capture_timestamp_us = timestamp_us;
+        s->record.peer_id              = peer_id;
+        s->record.direction            = direction;
+        memset(s->record.reserved, 0, sizeof(s->record.reserved));
+        memcpy(&s->record.frame, &frame, sizeof(message));
+        s->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool record(const message &frame, CAPTURE_DIRECTION direction, uint32_t peer_id) {
+        return record(frame, direction, peer_id, capture_now_us());
+    }
+
+    /*
+        Stops the writer thread after it has drained the queue and written the last partial block.
+        No thread may call record() once close() has started.
+    */
+    void close() {
+        if (writer_.joinable()) {
+            running_.store(false, std::memory_order_release);
+            writer_.join();
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+        free(slots_);
+        free(block_);
+        free(scratch_);
+        slots_   = nullptr;
+        block_   = nullptr;
+        scratch_ = nullptr;
+    }
+
+    /*
+        True while writes go through O_DIRECT. Turns false if a write falls back to buffered I/O.
+    */
+    bool direct_io_active() const {
+        return direct_.load(std::memory_order_relaxed);
+    }
+
+    capture_recorder_stats stats() const {
+        return {
+            written_.load(std::memory_order_relaxed),
+            dropped_.load(std::memory_order_relaxed),
+            blocks_.load(std::memory_order_relaxed),
+            bytes_.load(std::memory_order_relaxed),
+        };
+    }
+
+private:
+    struct alignas(64) slot {
+        std::atomic<uint64_t> sequence;
+        capture_record        record;
+    };
+
+    bool pop(capture_record &out) {
+        slot &s = slots_[dequeue_pos_ & mask_];
+        if (s.sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1) return false;
+        memcpy(&out, &s.record, sizeof(capture_record));
+        s.sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+        dequeue_pos_++;
+        return true;
+    }
+
+    void writer_loop() {
+        const uint32_t max_records = (config_.block_size - sizeof(capture_block_header)) / sizeof(capture_record);
+        uint32_t count       = 0;
+        uint64_t min_ts      = UINT64_MAX;
+        uint64_t max_ts      = 0;
+        auto     block_start = std::chrono::steady_clock::now();
+
+        for (;;) {
+            const bool stopping = !running_.load(std::memory_order_acquire);
+            bool       popped   = false;
+            while (count < max_records) {
+                capture_record *dst = reinterpret_cast<capture_record *>(block_ + sizeof(capture_block_header)) + count;
+                if (!pop(*dst)) break;
+                if (count == 0) block_start = std::chrono::steady_clock::now();
+                min_ts = std::min(min_ts, dst->capture_timestamp_us);
+                max_ts = std::max(max_ts, dst->capture_timestamp_us);
+                count++;
+                popped = true;
+            }
+
+            const bool timed_out = count > 0 &&
+                std::chrono::steady_clock::now() - block_start >= std::chrono::milliseconds(config_.flush_interval_ms);
+            if (count == max_records || timed_out || (stopping && count > 0)) {
+                flush_block(count, min_ts, max_ts);
+                count  = 0;
+                min_ts = UINT64_MAX;
+                max_ts = 0;
+                continue;
+            }
+            if (stopping) break;
+            if (!popped) std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+
+    void flush_block(uint32_t count, uint64_t min_ts, uint64_t max_ts) {
+        capture_block_header header;
+        header.magic            = CAPTURE_BLOCK_MAGIC;
+        header.flags            = 0;
+        header.reserved         = 0;
+        header.record_count     = count;
+        header.raw_size         = count * static_cast<uint32_t>(sizeof(capture_record));
+        header.stored_size      = header.raw_size;
+        header.reserved2        = 0;
+        header.min_timestamp_us = min_ts;
+        header.max_timestamp_us = max_ts;
+
+        uint8_t *out = block_;
+        if (config_.compress) {
+            const uint32_t packed = capture_lz_compress(block_ + sizeof(capture_block_header), header.raw_size,
+                                                        scratch_ + sizeof(capture_block_header));
+            if (packed < header.raw_size) {
+                header.flags      |= CAPTURE_BLOCK_COMPRESSED;
+                header.stored_size = packed;
+                out                = scratch_;
+            }
+        }
+        memcpy(out, &header, sizeof(header));
+
+        const uint64_t used   = sizeof(capture_block_header) + header.stored_size;
+        const uint64_t padded = capture_align_up(used);
+        memset(out + used, 0, padded - used);
+        if (write_aligned(out, padded)) {
+            written_.fetch_add(count, std::memory_order_relaxed);
+            blocks_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            dropped_.fetch_add(count, std::memory_order_relaxed);
+        }
+    }
+
+    bool write_aligned(const uint8_t *data, uint64_t size) {
+        uint64_t done = 0;
+        while (done < size) {
+            const ssize_t n = ::pwrite(fd_, data + done, size - done, static_cast<off_t>(file_offset_ + done));
+            if (n > 0) {
+                done += static_cast<uint64_t>(n);
+                continue;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            // Some file systems accept O_DIRECT at open() and only reject it on the first write.
+            if (n < 0 && errno == EINVAL && direct_.load(std::memory_order_relaxed) && reopen_buffered()) continue;
+            if (done > 0 && ::ftruncate(fd_, static_cast<off_t>(file_offset_)) != 0) {
+                // The partial block stays; the next one goes after it rather than into the middle of it.
+                file_offset_ = capture_align_up(file_offset_ + done);
+            }
+            return false;
+        }
+        file_offset_ += size;
+        bytes_.fetch_add(size, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool reopen_buffered() {
+        const int fd = ::open(path_.c_str(), O_WRONLY);
+        if (fd < 0) return false;
+        ::close(fd_);
+        fd_ = fd;
+        direct_.store(false, std::memory_order_relaxed);
+        return true;
+    }
+
+    capture_recorder_config config_;
+    std::string             path_;       // config_.path need not outlive open().
+    int                     fd_          = -1;
+    std::atomic<bool>       direct_{false};
+    uint64_t                file_offset_ = 0;
+
+    slot                   *slots_       = nullptr;
+    uint64_t                mask_        = 0;
+    alignas(64) std::atomic<uint64_t> enqueue_pos_{0};
+    alignas(64) uint64_t    dequeue_pos_ = 0;
+
+    uint8_t                *block_       = nullptr;
+    uint8_t                *scratch_     = nullptr;
+
+    std::atomic<bool>       running_{false};
+    std::thread             writer_;
+
+    alignas(64) std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t>   written_{0};
+    std::atomic<uint64_t>   blocks_{0};
+    std::atomic<uint64_t>   bytes_{0};
+};
+
+#endif // CAPTURE_RECORDER_HPP
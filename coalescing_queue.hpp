@@ -0,0 +1,241 @@
+#pragma once
+
+#ifndef COALESCING_QUEUE_HPP
+#define COALESCING_QUEUE_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <vector>
+#include <stdint.h>
+
+#include "msg_defs.hpp"
+#include "param_cache.hpp"
+
+/*
+------------------------------------------------------------------------------------------------------------------------
+    COALESCING OUTBOUND QUEUE
+
+    Latest-wins queue for high-rate SET commands such as CAM_TARGETING and SINGLE_TARGET_TRACKING. Frames are keyed
+    by message_type plus (param_type, stream_name, cam_id), the same key as param_cache, so a GET never replaces a
+    SET for the same target or the other way round. At most one frame per key waits to be sent.
+    Pushing a frame whose key is already pending overwrites the pending frame in place, so after a link stall the
+    sender sends each target's newest command once instead of replaying the backlog.
+
+    Pending keys leave in the order they first became pending. A command for one key therefore never jumps ahead of
+    an older command for another key, such as a SINGLE_TARGET_TRACKING target vector followed by the CAM_TARGETING
+    mode switch that uses it.
+
+    CAM_TARGETING SETs with euler_delta set are relative moves, and dropping one would lose motion. A delta SET
+    that lands on a pending SET in the same targeting mode is folded into it instead: the pending frame's
+    yaw/pitch/roll are advanced by the delta, and the remaining fields come from the new frame. The merged frame is
+    re-checksummed.
+
+    SET_PARAMETERS_RELIABLE frames are never coalesced. Each carries its own sequence number and must arrive for the
+    receiver to apply it exactly once, so every one waits in its own slot and counts against max_keys.
+
+    push() and pop() may be called from different threads.
+------------------------------------------------------------------------------------------------------------------------
+*/
+struct coalescing_queue_stats {
+    uint64_t pushed;
+    uint64_t coalesced;      // Pushes that replaced or merged into a pending frame.
+    uint64_t merged_deltas;  // Subset of coalesced: euler_delta moves folded into a pending frame.
+    uint64_t popped;
+    uint64_t rejected;       // Pushes refused because max_keys keys were already pending.
+    uint32_t max_depth;
+};
+
+class coalescing_queue {
+public:
+    explicit coalescing_queue(uint32_t max_keys = 64) {
+        // Clamped before sizing the table, so there is always an empty slot to end a probe.
+        max_keys_ = max_keys < 1 ? 1 : max_keys;
+        uint32_t size = 1;
+        while (size < max_keys_ * 2) size <<= 1;
+        mask_     = size - 1;
+        table_.assign(size, table_entry{});
+        order_.resize(max_keys_);
+    }
+
+    /*
+        Queues msg, replacing or merging into any pending frame with the same key. now_us is stored with the frame
+        so the sender can measure how long commands waited. Returns false only when the queue is full of other keys
+        (or of reliable SETs).
+    */
+    bool push(const message &msg, uint64_t now_us) {
+        const param_cache_key key = make_param_cache_key(msg);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stats_.pushed++;
+            table_entry *entry = msg.message_type == SET_PARAMETERS_RELIABLE ? nullptr : find(key, msg.message_type);
+            if (entry != nullptr) {
+                stats_.coalesced++;
+                if (merge_delta(entry->frame, msg)) {
+                    stats_.merged_deltas++;
+                } else {
+                    entry->frame = msg;
+                }
+                entry->updated_us = now_us;
+                return true;
+            }
+            if (depth_ == max_keys_) {
+                stats_.rejected++;
+                return false;
+            }
+            entry = insert(key, msg.message_type);
+            entry->frame       = msg;
+            entry->first_us    = now_us;
+            entry->updated_us  = now_us;
+            order_[(head_ + depth_) % max_keys_] = static_cast<uint32_t>(entry - table_.data());
+            depth_++;
+            if (depth_ > stats_.max_depth) stats_.max_depth = depth_;
+        }
+        ready_.notify_one();
+        return true;
+    }
+
+    /*
+        Takes the oldest pending key's newest frame. first_us is when that key became pending, updated_us when its
+        frame was last replaced. Returns false if nothing is pending.
+    */
+    bool pop(message &out, uint64_t *first_us = nullptr, uint64_t *updated_us = nullptr) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pop_locked(out, first_us, updated_us);
+    }
+
+    /*
+        Like pop(), but waits up to timeout_ms for a frame. timeout_ms < 0 waits forever.
+    */
+    bool wait_pop(message &out, int timeout_ms, uint64_t *first_us = nullptr, uint64_t *updated_us = nullptr) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (timeout_ms < 0) {
+            ready_.wait(lock, [this] { return depth_ != 0; });
+        } else if (!ready_.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this] { return depth_ != 0; })) {
+            return false;
+        }
+        return pop_locked(out, first_us, updated_us);
+    }
+
+    /*
+        Drops every pending frame, for example when the connection is re-established and state is re-synchronised.
+    */
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (table_entry &entry : table_) entry.used = false;
+        head_  = 0;
+        depth_ = 0;
+    }
+
+    uint32_t depth() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return depth_;
+    }
+
+    coalescing_queue_stats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+private:
+    struct table_entry {
+        bool            used = false;
+        uint8_t         message_type = 0;
+        param_cache_key key;
+        message         frame;
+        uint64_t        first_us   = 0;
+        uint64_t        updated_us = 0;
+    };
+
+    /*
+        Folds a CAM_TARGETING delta move into the pending frame. Returns false if the frames cannot be merged, in which
+        case the new frame simply replaces the pending one. Both frames have the same key, so the same message_type.
+    */
+    static bool merge_delta(message &pending, const message &next) {
+        if (next.message_type != SET_PARAMETERS && next.message_type != SET_PARAMETERS_NO_ACK) return false;
+        if (next.param_type != CAM_TARGETING || !next.data[CAM_TARGETING_EULER_DELTA_OFFSET]) return false;
+        if (pending.data[CAM_TARGETING_MODE_OFFSET] != next.data[CAM_TARGETING_MODE_OFFSET]) return false;
+
+        int32_t angles[3];
+        int32_t moves[3];
+        memcpy(angles, &pending.data[CAM_TARGETING_YAW_OFFSET], sizeof(angles));
+        memcpy(moves, &next.data[CAM_TARGETING_YAW_OFFSET], sizeof(moves));
+        const bool pending_is_delta = pending.data[CAM_TARGETING_EULER_DELTA_OFFSET] != 0;
+        pending = next;
+        // An absolute pending target plus a delta is still absolute; two deltas add up to one.
+        pending.data[CAM_TARGETING_EULER_DELTA_OFFSET] = pending_is_delta ? 1 : 0;
+        for (int i = 0; i < 3; ++i) angles[i] += moves[i];
+        memcpy(&pending.data[CAM_TARGETING_YAW_OFFSET], angles, sizeof(angles));
+        add_checksum_for_digiview_message(pending);
+        return true;
+    }
+
+    bool pop_locked(message &out, uint64_t *first_us, uint64_t *updated_us) {
+        if (depth_ == 0) return false;
+        table_entry &entry = table_[order_[head_]];
+        out = entry.frame;
+        if (first_us != nullptr) *first_us = entry.first_us;
+        if (updated_us != nullptr) *updated_us = entry.updated_us;
+        erase(entry);
+        head_ = (head_ + 1) % max_keys_;
+        depth_--;
+        stats_.popped++;
+        return true;
+    }
+
+    static uint32_t hash(const param_cache_key &key, uint8_t message_type) {
+        return (param_cache_hash(key) ^ message_type) * 16777619U;
+    }
+
+    table_entry *find(const param_cache_key &key, uint8_t message_type) {
+        for (uint32_t i = hash(key, message_type) & mask_;; i = (i + 1) & mask_) {
+            table_entry &entry = table_[i];
+            if (!entry.used) return nullptr;
+            if (entry.message_type == message_type && memcmp(&entry.key, &key, sizeof(key)) == 0) return &entry;
+        }
+    }
+
+    table_entry *insert(const param_cache_key &key, uint8_t message_type) {
+        uint32_t i = hash(key, message_type) & mask_;
+        while (table_[i].used) i = (i + 1) & mask_;
+        table_[i].used         = true;
+        table_[i].message_type = message_type;
+        table_[i].key          = key;
+        return &table_[i];
+    }
+
+    // Linear-probing delete with backward shift. Moved entries are re-pointed in order_.
+    void erase(table_entry &removed) {
+        uint32_t i = static_cast<uint32_t>(&removed - table_.data());
+        uint32_t j = i;
+        for (;;) {
+            table_[i].used = false;
+            for (;;) {
+                j = (j + 1) & mask_;
+                if (!table_[j].used) return;
+                const uint32_t home = hash(table_[j].key, table_[j].message_type) & mask_;
+                const bool stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+                if (!stays) break;
+            }
+            table_[i] = table_[j];
+            for (uint32_t k = 0; k < depth_; ++k) {
+                uint32_t &slot = order_[(head_ + k) % max_keys_];
+                if (slot == j) slot = i;
+            }
+            i = j;
+        }
+    }
+
+    mutable std::mutex        mutex_;
+    std::condition_variable   ready_;
+    uint32_t                  mask_     = 0;
+    uint32_t                  max_keys_ = 0;
+    uint32_t                  head_     = 0;
+    uint32_t                  depth_    = 0;
+    std::vector<table_entry>  table_;
+    std::vector<uint32_t>     order_;
+    coalescing_queue_stats    stats_ = {};
+};
+
+#endif // COALESCING_QUEUE_HPP
@@ -0,0 +1,226 @@
+#pragma once
+
+#ifndef DETECTION_ASSEMBLER_HPP
+#define DETECTION_ASSEMBLER_HPP
+
+#include <cstring>
+#include <vector>
+#include <stdint.h>
+
+#include "msg_defs.hpp"
+
+/*
+------------------------------------------------------------------------------------------------------------------------
+    DETECTION FRAME ASSEMBLER
+
+    DigiView answers a TRACKED_DETECTION GET with one CURRENT_PARAMETERS reply per detection, each carrying index and
+    total_detections. The assembler groups replies by (publish_timestamp_us, total_detections) into one snapshot per
+    published frame. Several frames may be in flight at once, for example when recurring GETs overlap.
+
+    A snapshot is emitted as complete once every index has arrived. A reply with total_detections = 0 is emitted
+    straight away as an empty complete snapshot. Duplicate indices are ignored. Frames still missing indices after
+    timeout_us are emitted as incomplete. The same happens to the oldest pending frame when a new one needs its slot.
+
+    The keys of the last recent_keys emitted frames are remembered, so a duplicate or late reply for a frame that has
+    already been emitted is dropped instead of opening a new pending frame that would later time out as a spurious
+    incomplete snapshot. Replies with publish_timestamp_us = 0 (legacy senders) cannot be told apart and are not
+    remembered.
+
+    Snapshots live in buffers allocated at construction. The snapshot reference passed to the handler is only valid
+    during the call. The assembler is not thread-safe.
+------------------------------------------------------------------------------------------------------------------------
+*/
+static constexpr uint32_t MAX_DETECTIONS_PER_FRAME = 255;
+
+struct detection_snapshot {
+    uint64_t publish_timestamp_us;
+    uint8_t  total_detections;
+    uint8_t  count;          // Detections present in detections[0 .. count - 1], ordered by index.
+    bool     complete;
+    tracked_detection_parameters *detections;
+};
+
+struct detection_assembler_stats {
+    uint64_t complete;
+    uint64_t incomplete;
+    uint64_t duplicates;
+    uint64_t late;          // Replies for a frame that had already been emitted.
+    uint64_t invalid;
+};
+
+class detection_assembler {
+public:
+    explicit detection_assembler(uint32_t max_pending = 8, uint64_t timeout_us = 200000, uint32_t recent_keys = 64)
+        : timeout_us_(timeout_us), pending_(max_pending < 1 ? 1 : max_pending),
+          storage_(static_cast<size_t>(pending_.size() + 1) * MAX_DETECTIONS_PER_FRAME),
+          recent_(recent_keys < 1 ? 1 : recent_keys) {
+        for (size_t i = 0; i < pending_.size(); ++i) {
+            pending_[i].detections = &storage_[i * MAX_DETECTIONS_PER_FRAME];
+        }
+        // The last buffer backs empty-frame snapshots.
+        spare_ = &storage_[pending_.size() * MAX_DETECTIONS_PER_FRAME];
+    }
+
+    /*
+        Adds one reply. handler(const detection_snapshot &) is called for every snapshot this reply completes or
+        displaces. now_us drives the timeout and may be any monotonic clock.
+    */
+    template <typename Handler>
+    void add(const tracked_detection_parameters &det, uint64_t now_us, Handler &&handler) {
+        if (det.total_detections != 0 && det.index >= det.total_detections) {
+            stats_.invalid++;
+            return;
+        }
+        pending_frame *frame = find(det.publish_timestamp_us, det.total_detections);
+        if (frame == nullptr && recently_emitted(det.publish_timestamp_us, det.total_detections)) {
+            stats_.late++;
+            return;
+        }
+        if (det.total_detections == 0) {
+            detection_snapshot snapshot{det.publish_timestamp_us, 0, 0, true, spare_};
+            remember(det.publish_timestamp_us, 0);
+            stats_.complete++;
+            handler(snapshot);
+            return;
+        }
+
+        if (frame == nullptr) {
+            frame = allocate(handler);
+            frame->in_use               = true;
+            frame->publish_timestamp_us = det.publish_timestamp_us;
+            frame->total_detections     = det.total_detections;
+            frame->received             = 0;
+            frame->first_seen_us        = now_us;
+            memset(frame->present, 0, sizeof(frame->present));
+        }
+
+        uint64_t &word = frame->present[det.index >> 6];
+        const uint64_t bit = 1ULL << (det.index & 63);
+        if (word & bit) {
+            stats_.duplicates++;
+            return;
+        }
+        word |= bit;
+        frame->detections[det.index] = det;
+        frame->received++;
+        if (frame->received == frame->total_detections) {
+            emit(*frame, handler);
+        }
+    }
+
+    template <typename Handler>
+    void add(message &raw_msg, uint64_t now_us, Handler &&handler) {
+        if (raw_msg.param_type != TRACKED_DETECTION) return;
+        tracked_detection_parameters det;
+        unpack_tracked_detection_parameters(raw_msg, det);
+        add(det, now_us, handler);
+    }
+
+    /*
+        Emits every pending frame that has waited longer than the timeout.
+    */
+    template <typename Handler>
+    void expire(uint64_t now_us, Handler &&handler) {
+        for (pending_frame &frame : pending_) {
+            if (frame.in_use && now_us - frame.first_seen_us >= timeout_us_) {
+                emit(frame, handler);
+            }
+        }
+    }
+
+    /*
+        Emits every pending frame, complete or not.
+    */
+    template <typename Handler>
+    void flush(Handler &&handler) {
+        for (pending_frame &frame : pending_) {
+            if (frame.in_use) emit(frame, handler);
+        }
+    }
+
+    const detection_assembler_stats &stats() const {
+        return stats_;
+    }
+
+private:
+    struct pending_frame {
+        bool     in_use = false;
+        uint8_t  total_detections = 0;
+        uint8_t  received = 0;
+        uint64_t publish_timestamp_us = 0;
+        uint64_t first_seen_us = 0;
+        uint64_t present[4] = {};
+        tracked_detection_parameters *detections = nullptr;
+    };
+
+    struct emitted_key {
+        uint64_t publish_timestamp_us = 0;
+        uint8_t  total_detections = 0;
+    };
+
+    bool recently_emitted(uint64_t publish_timestamp_us, uint8_t total_detections) const {
+        if (publish_timestamp_us == 0) return false;
+        for (const emitted_key &key : recent_) {
+            if (key.publish_timestamp_us == publish_timestamp_us && key.total_detections == total_detections) return true;
+        }
+        return false;
+    }
+
+    void remember(uint64_t publish_timestamp_us, uint8_t total_detections) {
+        if (publish_timestamp_us == 0) return;
+        recent_[recent_next_] = emitted_key{publish_timestamp_us, total_detections};
+        recent_next_ = recent_next_ + 1 == recent_.size() ? 0 : recent_next_ + 1;
+    }
+
+    pending_frame *find(uint64_t publish_timestamp_us, uint8_t total_detections) {
+        for (pending_frame &frame : pending_) {
+            if (frame.in_use && frame.publish_timestamp_us == publish_timestamp_us && frame.total_detections == total_detections) {
+                return &frame;
+            }
+        }
+        return nullptr;
+    }
+
+    template <typename Handler>
+    pending_frame *allocate(Handler &handler) {
+        pending_frame *oldest = nullptr;
+        for (pending_frame &frame : pending_) {
+            if (!frame.in_use) return &frame;
+            if (oldest == nullptr || frame.first_seen_us < oldest->first_seen_us) oldest = &frame;
+        }
+        emit(*oldest, handler);
+        return oldest;
+    }
+
+    template <typename Handler>
+    void emit(pending_frame &frame, Handler &handler) {
+        const bool complete = frame.received == frame.total_detections;
+        if (!complete) {
+            // Compact the received detections to the front, keeping index order.
+            uint8_t out = 0;
+            for (uint32_t i = 0; i < frame.total_detections; ++i) {
+                if ((frame.present[i >> 6] >> (i & 63)) & 1ULL) {
+                    if (out != i) frame.detections[out] = frame.detections[i];
+                    out++;
+                }
+            }
+            stats_.incomplete++;
+        } else {
+            stats_.complete++;
+        }
+        detection_snapshot snapshot{frame.publish_timestamp_us, frame.total_detections, frame.received, complete, frame.detections};
+        remember(frame.publish_timestamp_us, frame.total_detections);
+        frame.in_use = false;
+        handler(snapshot);
+    }
+
+    uint64_t                                   timeout_us_;
+    std::vector<pending_frame>                 pending_;
+    std::vector<tracked_detection_parameters>  storage_;
+    tracked_detection_parameters              *spare_ = nullptr;
+    std::vector<emitted_key>                   recent_;
+    uint32_t                                   recent_next_ = 0;
+    detection_assembler_stats                  stats_ = {};
+};
+
+#endif // DETECTION_ASSEMBLER_HPP
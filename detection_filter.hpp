@@ -0,0 +1,78 @@
+#pragma once
+
+#ifndef DETECTION_FILTER_HPP
+#define DETECTION_FILTER_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+
+#include "msg_defs.hpp"
+
+/*
+------------------------------------------------------------------------------------------------------------------------
+    DETECTION FILTER
+
+    Reference evaluation of the optional filter in a TRACKED_DETECTION GET (tracked_detection_filter). A server
+    answering a filtered GET works like this:
+
+        1. Take the base set the index field asks for: all detections (255) or the visible ones (254).
+        2. Pass it through select_tracked_detections().
+        3. Send one reply per selected detection, in the returned order. index is the position in that order and
+           total_detections is the selected count. An empty selection is still answered with one frame carrying
+           total_detections = 0.
+
+    The sector window is tested against yaw_global and pitch_global. Yaw is compared after wrapping to [-180, 180),
+    so a window with yaw_min > yaw_max covers the rear. Ties in any sort order fall back to ascending index, which
+    keeps replies stable from one frame to the next.
+------------------------------------------------------------------------------------------------------------------------
+*/
+inline float wrap_yaw_degrees(float yaw) {
+    yaw = std::fmod(yaw + 180.0f, 360.0f);
+    if (yaw < 0.0f) yaw += 360.0f;
+    return yaw - 180.0f;
+}
+
+inline bool tracked_detection_passes(const tracked_detection_filter &filter, const tracked_detection_parameters &det) {
+    if ((filter.flags & DETECTION_FILTER_SCORE) && det.score < filter.min_score) return false;
+    if (filter.flags & DETECTION_FILTER_CLASS) {
+        if (det.type < 0 || det.type > 31 || !(filter.class_mask & (1U << det.type))) return false;
+    }
+    if ((filter.flags & DETECTION_FILTER_SINCE) && det.publish_timestamp_us <= filter.since_us) return false;
+    if (filter.flags & DETECTION_FILTER_SECTOR) {
+        if (det.pitch_global < filter.pitch_min || det.pitch_global > filter.pitch_max) return false;
+        const float yaw     = wrap_yaw_degrees(det.yaw_global);
+        const float yaw_min = wrap_yaw_degrees(filter.yaw_min);
+        const float yaw_max = wrap_yaw_degrees(filter.yaw_max);
+        const bool inside = yaw_min <= yaw_max ? (yaw >= yaw_min && yaw <= yaw_max) : (yaw >= yaw_min || yaw <= yaw_max);
+        if (!inside) return false;
+    }
+    return true;
+}
+
+/*
+    Writes the positions (into detections) of the detections to send into selected, in reply order, and returns how
+    many there are. selected must have room for count entries.
+*/
+inline uint8_t select_tracked_detections(const tracked_detection_filter &filter, const tracked_detection_parameters *detections,
+                                         uint8_t count, uint8_t *selected) {
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < count; ++i) {
+        if (tracked_detection_passes(filter, detections[i])) selected[n++] = i;
+    }
+
+    const auto before = [&](uint8_t a, uint8_t b) {
+        const tracked_detection_parameters &da = detections[a];
+        const tracked_detection_parameters &db = detections[b];
+        if (filter.sort == DETECTION_SORT_SCORE && da.score != db.score) return da.score > db.score;
+        if (filter.sort == DETECTION_SORT_NEWEST && da.publish_timestamp_us != db.publish_timestamp_us) {
+            return da.publish_timestamp_us > db.publish_timestamp_us;
+        }
+        return da.index != db.index ? da.index < db.index : a < b;
+    };
+    const uint8_t limit = (filter.flags & DETECTION_FILTER_MAX_COUNT) ? std::min(n, filter.max_count) : n;
+    std::partial_sort(selected, selected + limit, selected + n, before);
+    return limit;
+}
+
+#endif // DETECTION_FILTER_HPP
@@ -0,0 +1,365 @@
+#pragma once
+
+#ifndef DETECTION_INDEX_HPP
+#define DETECTION_INDEX_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+#include "msg_defs.hpp"
+
+/*
+------------------------------------------------------------------------------------------------------------------------
+    DETECTION SPATIAL INDEX
+
+    Answers "which live detections are nearest this bearing / this position?" without scanning every detection.
+    detection_index keeps the latest tracked_detection_parameters per track_id in two sphere_grids:
+
+        bearing   yaw_global / pitch_global, distances in degrees of arc;
+        position  longitude / latitude, distances in metres along the surface. Detections with latitude and
+                  longitude both 0 have no position and are left out.
+
+    A sphere_grid divides longitude and latitude into square cells of cell_deg, rounded so that 360 is a whole number
+    of cells. Cells are hashed into a fixed array of buckets holding intrusive lists, so inserting, moving and removing
+    an entry never allocates. A radius query visits only the cells in the bounding box of the spherical cap, which
+    widens in longitude towards the poles and spans every column when the cap contains one. Nearest-k queries double
+    the radius from one cell until k entries are found. Distances are great-circle distances, so results are exact
+    and match a linear scan.
+
+    track_id 0 means "unavailable" on the wire and is not indexed. Nothing is thread-safe.
+------------------------------------------------------------------------------------------------------------------------
+*/
+static constexpr double DETECTION_INDEX_EARTH_RADIUS_M = 6371008.8;
+static constexpr double DETECTION_INDEX_DEG_TO_RAD     = 3.14159265358979323846 / 180.0;
+
+/*
+    Great-circle distance in degrees between two points given as longitude / latitude (or yaw / pitch) in degrees.
+*/
+inline double angular_distance_deg(double lon1, double lat1, double lon2, double lat2) {
+    const double dlat = (lat2 - lat1) * DETECTION_INDEX_DEG_TO_RAD;
+    const double dlon = (lon2 - lon1) * DETECTION_INDEX_DEG_TO_RAD;
+    const double s1 = std::sin(dlat / 2);
+    const double s2 = std::sin(dlon / 2);
+    const double a = s1 * s1 + std::cos(lat1 * DETECTION_INDEX_DEG_TO_RAD) * std::cos(lat2 * DETECTION_INDEX_DEG_TO_RAD) * s2 * s2;
+    return 2.0 * std::asin(std::min(1.0, std::sqrt(a))) / DETECTION_INDEX_DEG_TO_RAD;
+}
+
+class sphere_grid {
+public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    /*
+        cell_deg is rounded down so that a whole number of columns spans 360 degrees; the last column is then no
+        narrower than the others and a query box that wraps past 0 lands in the same columns as the entries.
+    */
+    sphere_grid(double cell_deg, uint32_t capacity) {
+        columns_  = static_cast<uint32_t>(std::ceil(360.0 / cell_deg));
+        cell_deg_ = 360.0 / columns_;
+        rows_     = static_cast<uint32_t>(std::ceil(180.0 / cell_deg_)) + 1;
+        uint32_t buckets = 1024;
+        while (buckets < capacity * 2) buckets <<= 1;
+        mask_ = buckets - 1;
+        heads_.assign(buckets, NONE);
+        entries_.assign(capacity, entry{});
+    }
+
+    /*
+        Inserts id, or moves it if it is already present. id must be below the capacity.
+    */
+    void place(uint32_t id, double lon, double lat) {
+        entry &e = entries_[id];
+        lat = std::max(-90.0, std::min(90.0, lat));
+        const uint32_t row = row_of(lat);
+        const uint32_t col = column_of(lon);
+        if (e.present && e.row == row && e.col == col) {
+            e.lon = lon;
+            e.lat = lat;
+            return;
+        }
+        if (e.present) unlink(id);
+        e = {lon, lat, row, col, NONE, NONE, true};
+        uint32_t &head = heads_[bucket_of(row, col)];
+        e.next = head;
+        if (head != NONE) entries_[head].prev = id;
+        head = id;
+        count_++;
+    }
+
+    void remove(uint32_t id) {
+        if (!entries_[id].present) return;
+        unlink(id);
+        entries_[id].present = false;
+    }
+
+    /*
+        Calls fn(uint32_t id, double distance_deg) for every entry within radius_deg of (lon, lat).
+    */
+    template <typename Fn>
+    void within(double lon, double lat, double radius_deg, Fn &&fn) const {
+        lat = std::max(-90.0, std::min(90.0, lat));
+        const auto visit = [&](uint32_t id) {
+            const entry &e = entries_[id];
+            const double d = angular_distance_deg(lon, lat, e.lon, e.lat);
+            if (d <= radius_deg) fn(id, d);
+        };
+
+        const double lat_lo = std::max(-90.0, lat - radius_deg);
+        const double lat_hi = std::min(90.0, lat + radius_deg);
+        const uint32_t row_lo = row_of(lat_lo);
+        const uint32_t row_hi = row_of(lat_hi);
+        // Longitude half-width of the cap's bounding box; every column if the cap reaches a pole.
+        uint32_t col_first = 0, col_count = columns_;
+        if (lat_lo > -90.0 && lat_hi < 90.0) {
+            const double ratio = std::sin(radius_deg * DETECTION_INDEX_DEG_TO_RAD) / std::cos(lat * DETECTION_INDEX_DEG_TO_RAD);
+            if (ratio < 1.0 && radius_deg < 90.0) {
+                const double half = std::asin(ratio) / DETECTION_INDEX_DEG_TO_RAD;
+                // The box ends take the same wrap as place(), so rounding cannot shift them off the entries' columns.
+                // A box within one column of the full circle is widened to every column.
+                if (2.0 * half + 2.0 * cell_deg_ < 360.0) {
+                    col_first = column_of(lon - half);
+                    col_count = (column_of(lon + half) + columns_ - col_first) % columns_ + 1;
+                }
+            }
+        }
+
+        // A box with more cells than there are buckets is cheaper to answer by visiting every entry.
+        if (static_cast<uint64_t>(row_hi - row_lo + 1) * col_count > heads_.size()) {
+            for (uint32_t id = 0; id < entries_.size(); ++id) {
+                if (entries_[id].present) visit(id);
+            }
+            return;
+        }
+        for (uint32_t row = row_lo; row <= row_hi; ++row) {
+            for (uint32_t c = 0; c < col_count; ++c) {
+                const uint32_t col = (col_first + c) % columns_;
+                for (uint32_t id = heads_[bucket_of(row, col)]; id != NONE; id = entries_[id].next) {
+                    // Buckets are shared by hashed cells; only entries of this cell belong to this visit.
+                    if (entries_[id].row == row && entries_[id].col == col) visit(id);
+                }
+            }
+        }
+    }
+
+    /*
+        Writes the ids and distances of the k entries nearest (lon, lat) to ids and distances_deg, nearest first.
+        Returns how many were written.
+    */
+    uint32_t nearest(double lon, double lat, uint32_t k, uint32_t *ids, double *distances_deg) const {
+        if (k == 0 || count_ == 0) return 0;
+        double radius = cell_deg_;
+        for (;;) {
+            scratch_.clear();
+            within(lon, lat, radius, [&](uint32_t id, double d) { scratch_.push_back({d, id}); });
+            if (scratch_.size() >= k || radius >= 180.0) break;
+            radius *= 2;
+        }
+        const uint32_t found = static_cast<uint32_t>(std::min<size_t>(k, scratch_.size()));
+        std::partial_sort(scratch_.begin(), scratch_.begin() + found, scratch_.end());
+        for (uint32_t i = 0; i < found; ++i) {
+            distances_deg[i] = scratch_[i].first;
+            ids[i]           = scratch_[i].second;
+        }
+        return found;
+    }
+
+    uint32_t size() const {
+        return count_;
+    }
+
+private:
+    struct entry {
+        double   lon = 0;
+        double   lat = 0;
+        uint32_t row = 0;
+        uint32_t col = 0;
+        uint32_t next = NONE;
+        uint32_t prev = NONE;
+        bool     present = false;
+    };
+
+    uint32_t row_of(double lat) const {
+        return static_cast<uint32_t>((lat + 90.0) / cell_deg_);
+    }
+
+    uint32_t column_of(double lon) const {
+        double wrapped = std::fmod(lon, 360.0);
+        if (wrapped < 0) wrapped += 360.0;
+        return std::min(columns_ - 1, static_cast<uint32_t>(wrapped / cell_deg_));
+    }
+
+    uint32_t bucket_of(uint32_t row, uint32_t col) const {
+        return ((row * 73856093U) ^ (col * 19349663U)) & mask_;
+    }
+
+    void unlink(uint32_t id) {
+        entry &e = entries_[id];
+        if (e.prev != NONE) {
+            entries_[e.prev].next = e.next;
+        } else {
+            heads_[bucket_of(e.row, e.col)] = e.next;
+        }
+        if (e.next != NONE) entries_[e.next].prev = e.prev;
+        e.next = e.prev = NONE;
+        count_--;
+    }
+
+    double                                     cell_deg_;
+    uint32_t                                   columns_;
+    uint32_t                                   rows_;
+    uint32_t                                   mask_;
+    uint32_t                                   count_ = 0;
+    std::vector<uint32_t>                      heads_;
+    std::vector<entry>                         entries_;
+    mutable std::vector<std::pair<double, uint32_t>> scratch_;
+};
+
+struct detection_hit {
+    uint16_t track_id;
+    double   distance;   // Degrees for bearing queries, metres for position queries.
+};
+
+struct detection_index_config {
+    uint32_t max_detections    = 4096;
+    double   bearing_cell_deg  = 2.0;
+    double   position_cell_deg = 0.002;   // About 220 m of latitude.
+};
+
+class detection_index {
+public:
+    static constexpr uint16_t NO_SLOT = UINT16_MAX;
+
+    explicit detection_index(const detection_index_config &config = detection_index_config())
+        : capacity_(std::min<uint32_t>(config.max_detections, NO_SLOT - 1)),
+          bearing_(config.bearing_cell_deg, capacity_), position_(config.position_cell_deg, capacity_) {
+        slot_of_.assign(65536, NO_SLOT);
+        detections_.resize(capacity_);
+        updated_us_.resize(capacity_);
+        free_slots_.resize(capacity_);
+        for (uint32_t i = 0; i < capacity_; ++i) free_slots_[i] = static_cast<uint16_t>(capacity_ - 1 - i);
+    }
+
+    /*
+        Inserts or moves the detection's track. Returns false for track_id 0 or when the index is full.
+    */
+    bool update(const tracked_detection_parameters &det, uint64_t now_us) {
+        if (det.track_id == 0) return false;
+        uint16_t slot = slot_of_[det.track_id];
+        if (slot == NO_SLOT) {
+            if (free_slots_.empty()) return false;
+            slot = free_slots_.back();
+            free_slots_.pop_back();
+            slot_of_[det.track_id] = slot;
+        }
+        detections_[slot] = det;
+        updated_us_[slot] = now_us;
+        bearing_.place(slot, det.yaw_global, det.pitch_global);
+        if (det.latitude != 0.0f || det.longitude != 0.0f) {
+            position_.place(slot, det.longitude, det.latitude);
+        } else {
+            position_.remove(slot);
+        }
+        return true;
+    }
+
+    /*
+        Indexes a TRACKED_DETECTION CURRENT_PARAMETERS frame. Returns false for any other frame.
+    */
+    bool observe(message &msg, uint64_t now_us) {
+        if (msg.message_type != CURRENT_PARAMETERS || msg.param_type != TRACKED_DETECTION) return false;
+        tracked_detection_parameters det;
+        unpack_tracked_detection_parameters(msg, det);
+        return update(det, now_us);
+    }
+
+    bool erase(uint16_t track_id) {
+        const uint16_t slot = slot_of_[track_id];
+        if (slot == NO_SLOT) return false;
+        bearing_.remove(slot);
+        position_.remove(slot);
+        slot_of_[track_id] = NO_SLOT;
+        free_slots_.push_back(slot);
+        return true;
+    }
+
+    /*
+        Removes detections not updated since now_us - max_age_us. Returns the number removed.
+    */
+    uint32_t evict_stale(uint64_t now_us, uint64_t max_age_us) {
+        uint32_t removed = 0;
+        for (uint32_t slot = 0; slot < capacity_; ++slot) {
+            const uint16_t track_id = detections_[slot].track_id;
+            if (track_id == 0 || slot_of_[track_id] != slot || updated_us_[slot] + max_age_us >= now_us) continue;
+            erase(track_id);
+            removed++;
+        }
+        return removed;
+    }
+
+    const tracked_detection_parameters *find(uint16_t track_id) const {
+        const uint16_t slot = slot_of_[track_id];
+        return slot == NO_SLOT ? nullptr : &detections_[slot];
+    }
+
+    /*
+        The k detections nearest a bearing, nearest first. Returns how many were written to out.
+    */
+    uint32_t nearest_bearing(float yaw_deg, float pitch_deg, uint32_t k, detection_hit *out) const {
+        return nearest(bearing_, yaw_deg, pitch_deg, k, 1.0, out);
+    }
+
+    /*
+        Detections within radius_deg of a bearing, unordered, up to max_out. Returns the number written.
+    */
+    uint32_t within_bearing(float yaw_deg, float pitch_deg, float radius_deg, detection_hit *out, uint32_t max_out) const {
+        return within(bearing_, yaw_deg, pitch_deg, radius_deg, 1.0, out, max_out);
+    }
+
+    uint32_t nearest_position(float latitude, float longitude, uint32_t k, detection_hit *out) const {
+        return nearest(position_, longitude, latitude, k, metres_per_degree(), out);
+    }
+
+    uint32_t within_position(float latitude, float longitude, float radius_m, detection_hit *out, uint32_t max_out) const {
+        return within(position_, longitude, latitude, radius_m / metres_per_degree(), metres_per_degree(), out, max_out);
+    }
+
+    uint32_t size() const {
+        return capacity_ - static_cast<uint32_t>(free_slots_.size());
+    }
+
+private:
+    static double metres_per_degree() {
+        return DETECTION_INDEX_EARTH_RADIUS_M * DETECTION_INDEX_DEG_TO_RAD;
+    }
+
+    uint32_t nearest(const sphere_grid &grid, double lon, double lat, uint32_t k, double scale, detection_hit *out) const {
+        ids_.resize(k);
+        distances_.resize(k);
+        const uint32_t found = grid.nearest(lon, lat, k, ids_.data(), distances_.data());
+        for (uint32_t i = 0; i < found; ++i) out[i] = {detections_[ids_[i]].track_id, distances_[i] * scale};
+        return found;
+    }
+
+    uint32_t within(const sphere_grid &grid, double lon, double lat, double radius_deg, double scale, detection_hit *out,
+                    uint32_t max_out) const {
+        uint32_t found = 0;
+        grid.within(lon, lat, radius_deg, [&](uint32_t id, double d) {
+            if (found < max_out) out[found++] = {detections_[id].track_id, d * scale};
+        });
+        return found;
+    }
+
+    uint32_t                                  capacity_;
+    sphere_grid                               bearing_;
+    sphere_grid                               position_;
+    std::vector<uint16_t>                     slot_of_;   // Indexed by track_id.
+    std::vector<tracked_detection_parameters> detections_;
+    std::vector<uint64_t>                     updated_us_;
+    std::vector<uint16_t>                     free_slots_;
+    mutable std::vector<uint32_t>             ids_;
+    mutable std::vector<double>               distances_;
+};
+
+#endif // DETECTION_INDEX_HPP
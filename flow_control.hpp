@@ -0,0 +1,215 @@
+#pragma once
+
+#ifndef FLOW_CONTROL_HPP
+#define FLOW_CONTROL_HPP
+
+#include <atomic>
+#include <stdint.h>
+
+#include "msg_defs.hpp"
+#include "outbound_scheduler.hpp"
+
+/*
+------------------------------------------------------------------------------------------------------------------------
+    CREDIT-BASED FLOW CONTROL
+
+    Keeps a slow client from being flooded by recurring streams. The client grants cumulative frame and byte limits
+    with CREDIT messages (credit_parameters) as it consumes frames. DigiView keeps one flow_controller per client:
+
+        - recurring-stream producers call admit_tick() before building a tick. While the client is out of credit the
+          tick is skipped and counted as dropped, so paused streams never queue up;
+        - the sender calls try_send() for every frame. Every frame uses up credit, but only classes at or below
+          config.pause_from wait for it; control traffic is always sent;
+        - the receive path hands CREDIT messages to on_message(), and pack_report() builds the report sent back.
+          The report is a control frame and is charged like one.
+
+    Flow control starts with the client's first grant, so clients that never send CREDIT are not limited. With
+    config.require_credit the controller starts engaged with config.initial_frames of credit instead. Counters are
+    relaxed atomics; grants, ticks and sends may come from different threads.
+
+    credit_granter is the client side: it counts consumed frames and says when to send the next grant. Limits count
+    frames sent, so frames lost on the way would use up credit for good; the granter adds the losses it infers from
+    the frames_sent of each report to its grants.
+------------------------------------------------------------------------------------------------------------------------
+*/
+struct flow_control_config {
+    bool          require_credit = false;               // Engage before the first grant.
+    uint64_t      initial_frames = 64;                  // Credit before the first grant when require_credit is set.
+    TRAFFIC_CLASS pause_from     = TRAFFIC_TELEMETRY;   // This class and lower-priority ones wait for credit.
+};
+
+struct flow_control_stats {
+    uint64_t frame_limit;
+    uint64_t byte_limit;
+    uint64_t frames_sent;
+    uint64_t bytes_sent;
+    uint64_t grants;
+    uint64_t refused;        // try_send() calls turned down for lack of credit.
+    uint32_t dropped_ticks;
+};
+
+class flow_controller {
+public:
+    explicit flow_controller(const flow_control_config &config = flow_control_config())
+        : pause_from_(config.pause_from), engaged_(config.require_credit),
+          frame_limit_(config.require_credit ? config.initial_frames : UINT64_MAX) {}
+
+    flow_controller(const flow_controller &) = delete;
+    flow_controller &operator=(const flow_controller &) = delete;
+
+    /*
+        Applies a grant. The first grant engages flow control and sets the limits; after that limits only grow, so an
+        older grant arriving late changes nothing.
+    */
+    void grant(uint64_t frame_limit, uint64_t byte_limit) {
+        if (!engaged_.exchange(true, std::memory_order_relaxed)) {
+            frame_limit_.store(frame_limit, std::memory_order_relaxed);
+            byte_limit_.store(byte_limit, std::memory_order_relaxed);
+        } else {
+            raise(frame_limit_, frame_limit);
+            raise(byte_limit_, byte_limit);
+        }
+        grants_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /*
+        Applies msg if it is a CREDIT message with a valid checksum. Returns false for any other message.
+    */
+    bool on_message(message &msg) {
+        if (msg.message_type != CREDIT || !has_valid_checksum_for_digiview_message(msg)) return false;
+        credit_parameters credit;
+        unpack_credit_parameters(msg, credit);
+        grant(credit.frame_limit, credit.byte_limit);
+        return true;
+    }
+
+    bool has_credit(uint32_t bytes = sizeof(message)) const {
+        return frames_sent_.load(std::memory_order_relaxed) < frame_limit_.load(std::memory_order_relaxed) &&
+               bytes_sent_.load(std::memory_order_relaxed) + bytes <= byte_limit_.load(std::memory_order_relaxed);
+    }
+
+    /*
+        Called by a recurring stream before producing a tick. Returns false, and counts the tick as dropped, while the
+        client is out of credit.
+    */
+    bool admit_tick() {
+        if (has_credit()) return true;
+        dropped_ticks_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    /*
+        Called by the sender before sending a frame of the given class. Returns false if the frame must wait for
+        credit; otherwise the frame is charged and may be sent.
+    */
+    bool try_send(TRAFFIC_CLASS traffic_class, uint32_t bytes = sizeof(message)) {
+        if (traffic_class >= pause_from_ && !has_credit(bytes)) {
+            refused_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        frames_sent_.fetch_add(1, std::memory_order_relaxed);
+        bytes_sent_.fetch_add(bytes, std::memory_order_relaxed);
+        return true;
+    }
+
+    /*
+        Builds the checksummed CREDIT report for the client: current limits, counters and dropped ticks. The report is
+        then charged as a control frame, so its frames_sent counts the frames sent before it.
+    */
+    void pack_report(message &msg) {
+        const flow_control_stats s = stats();
+        pack_credit_message(msg, s.frame_limit, s.byte_limit, s.frames_sent, s.bytes_sent, s.dropped_ticks);
+        add_checksum_for_digiview_message(msg);
+        try_send(TRAFFIC_CONTROL);
+    }
+
+    flow_control_stats stats() const {
+        return {frame_limit_.load(std::memory_order_relaxed), byte_limit_.load(std::memory_order_relaxed),
+                frames_sent_.load(std::memory_order_relaxed), bytes_sent_.load(std::memory_order_relaxed),
+                grants_.load(std::memory_order_relaxed), refused_.load(std::memory_order_relaxed),
+                dropped_ticks_.load(std::memory_order_relaxed)};
+    }
+
+private:
+    static void raise(std::atomic<uint64_t> &limit, uint64_t value) {
+        uint64_t current = limit.load(std::memory_order_relaxed);
+        while (value > current && !limit.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    const TRAFFIC_CLASS   pause_from_;
+    std::atomic<bool>     engaged_;
+    std::atomic<uint64_t> frame_limit_;
+    std::atomic<uint64_t> byte_limit_{UINT64_MAX};
+    std::atomic<uint64_t> frames_sent_{0};
+    std::atomic<uint64_t> bytes_sent_{0};
+    std::atomic<uint64_t> grants_{0};
+    std::atomic<uint64_t> refused_{0};
+    std::atomic<uint32_t> dropped_ticks_{0};
+};
+
+/*
+    Client side. Call consumed() for every frame the application has finished with, and on_report() instead for
+    CREDIT reports. Both return true when a grant is due: half the window has been used since the last grant, or a
+    report showed more frames lost. Call due() on a timer as well, so a lost grant is repeated. The limit granted is
+    frames consumed plus frames lost plus window.
+
+    Frames arrive in order, so when a report arrives every frame sent before it has been consumed, is still waiting
+    in the application (queued_frames) or was lost. A frame that is overtaken by the report counts as lost until the
+    next report, which only grants credit early.
+*/
+class credit_granter {
+public:
+    explicit credit_granter(uint64_t window_frames = 64, uint64_t regrant_us = 100000)
+        : window_(window_frames < 2 ? 2 : window_frames), regrant_us_(regrant_us) {}
+
+    bool consumed(uint32_t frames = 1) {
+        consumed_ += frames;
+        return consumed_ - granted_at_ >= window_ / 2;
+    }
+
+    bool on_report(message &msg, uint64_t queued_frames = 0) {
+        if (msg.message_type != CREDIT || !has_valid_checksum_for_digiview_message(msg)) return false;
+        credit_parameters report;
+        unpack_credit_parameters(msg, report);
+        bool more_lost = false;
+        if (report.frames_sent >= reported_sent_) {   // Ignore a report overtaken by a newer one.
+            reported_sent_ = report.frames_sent;
+            const uint64_t accounted = consumed_ + queued_frames;
+            const uint64_t lost      = report.frames_sent > accounted ? report.frames_sent - accounted : 0;
+            more_lost = lost > lost_;
+            lost_     = lost;
+        }
+        return consumed() || more_lost;
+    }
+
+    bool due(uint64_t now_us) const {
+        return now_us - last_grant_us_ >= regrant_us_;
+    }
+
+    void pack_grant(message &msg, uint64_t now_us) {
+        granted_at_    = consumed_;
+        last_grant_us_ = now_us;
+        pack_credit_message(msg, consumed_ + lost_ + window_);
+        add_checksum_for_digiview_message(msg);
+    }
+
+    uint64_t consumed_frames() const {
+        return consumed_;
+    }
+
+    uint64_t lost_frames() const {
+        return lost_;
+    }
+
+private:
+    uint64_t window_;
+    uint64_t regrant_us_;
+    uint64_t consumed_      = 0;
+    uint64_t granted_at_    = 0;
+    uint64_t last_grant_us_ = 0;
+    uint64_t reported_sent_ = 0;
+    uint64_t lost_          = 0;
+};
+
+#endif // FLOW_CONTROL_HPP
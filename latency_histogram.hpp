@@ -0,0 +1,182 @@
+#pragma once
+
+#ifndef LATENCY_HISTOGRAM_HPP
+#define LATENCY_HISTOGRAM_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <stdint.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+#include "msg_defs.hpp"
+
+/*
+------------------------------------------------------------------------------------------------------------------------
+    LATENCY HISTOGRAMS
+
+    Publish-to-consume latency per param_type, in microseconds. Buckets are log-linear, like an HDR histogram: values
+    below 2^LATENCY_SUB_BITS get one bucket each, and every power of two above that is split into 2^LATENCY_SUB_BITS
+    linear buckets, giving about 3% relative precision up to 2^LATENCY_MAX_EXPONENT us.
+
+    Each recording thread owns a latency_shard and is its only writer. A sample is two relaxed load/store pairs, with
+    no locked instructions. summarize() merges all shards on demand and may run concurrently with recording.
+------------------------------------------------------------------------------------------------------------------------
+*/
+static constexpr uint32_t LATENCY_SUB_BITS      = 5;
+static constexpr uint32_t LATENCY_SUB_BUCKETS   = 1U << LATENCY_SUB_BITS;
+static constexpr uint32_t LATENCY_MAX_EXPONENT  = 36;
+static constexpr uint32_t LATENCY_BUCKETS       = (LATENCY_MAX_EXPONENT - LATENCY_SUB_BITS + 2) * LATENCY_SUB_BUCKETS;
+static constexpr uint32_t LATENCY_PARAM_TYPES   = 32;  // param_type values >= 31 share the last slot.
+
+/*
+    Index of the highest set bit. value must not be 0.
+*/
+inline uint32_t latency_msb(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63U - static_cast<uint32_t>(__builtin_clzll(value));
+#elif defined(_M_X64) || defined(_M_ARM64)
+    unsigned long msb;
+    _BitScanReverse64(&msb, value);
+    return static_cast<uint32_t>(msb);
+#else
+    uint32_t msb = 0;
+    while (value >>= 1) msb++;
+    return msb;
+#endif
+}
+
+inline uint32_t latency_bucket(uint64_t value_us) {
+    if (value_us < LATENCY_SUB_BUCKETS) return static_cast<uint32_t>(value_us);
+    const uint32_t msb = latency_msb(value_us);
+    if (msb > LATENCY_MAX_EXPONENT) return LATENCY_BUCKETS - 1;
+    const uint32_t shift = msb - LATENCY_SUB_BITS;
+    return (shift << LATENCY_SUB_BITS) + static_cast<uint32_t>(value_us >> shift);
+}
+
+/*
+    Largest value that maps to bucket. The last bucket also takes every larger value, so it has no upper edge.
+*/
+inline uint64_t latency_bucket_upper(uint32_t bucket) {
+    if (bucket < LATENCY_SUB_BUCKETS) return bucket;
+    if (bucket >= LATENCY_BUCKETS - 1) return UINT64_MAX;
+    const uint32_t shift = (bucket >> LATENCY_SUB_BITS) - 1;
+    const uint64_t sub   = bucket - (shift << LATENCY_SUB_BITS);
+    return ((sub + 1) << shift) - 1;
+}
+
+inline uint32_t latency_param_slot(uint8_t param_type) {
+    return param_type < LATENCY_PARAM_TYPES ? param_type : LATENCY_PARAM_TYPES - 1;
+}
+
+struct latency_summary {
+    uint64_t count;
+    uint64_t p50_us;
+    uint64_t p99_us;
+    uint64_t p999_us;
+    uint64_t max_us;
+};
+
+class latency_shard {
+public:
+    latency_shard() {
+        for (auto &per_type : counts_) {
+            for (auto &count : per_type) count.store(0, std::memory_order_relaxed);
+        }
+        for (auto &max : max_us_) max.store(0, std::memory_order_relaxed);
+    }
+
+    /*
+        Records one sample. Must only be called from the thread that owns this shard.
+    */
+    void record(uint8_t param_type, uint64_t latency_us) {
+        const uint32_t slot = latency_param_slot(param_type);
+        std::atomic<uint64_t> &count = counts_[slot][latency_bucket(latency_us)];
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (latency_us > max_us_[slot].load(std::memory_order_relaxed)) {
+            max_us_[slot].store(latency_us, std::memory_order_relaxed);
+        }
+    }
+
+    /*
+        Records now_us minus the frame's publish time. TRACKED_DETECTION and SINGLE_TARGET_TRACKING use
+        publish_timestamp_us; every other group uses the header timestamp, which must then be in microseconds on the
+        same clock as now_us. Samples from the future (clock skew) are recorded as 0.
+    */
+    void record_frame(const message &msg, uint64_t now_us) {
+        uint64_t published_us;
+        if (!frame_publish_timestamp_us(msg, published_us)) published_us = msg.timestamp;
+        if (published_us == 0) return;
+        record(msg.param_type, now_us > published_us ? now_us - published_us : 0);
+    }
+
+private:
+    friend class latency_histograms;
+
+    std::atomic<uint64_t> counts_[LATENCY_PARAM_TYPES][LATENCY_BUCKETS];
+    std::atomic<uint64_t> max_us_[LATENCY_PARAM_TYPES];
+};
+
+class latency_histograms {
+public:
+    /*
+        Creates a shard for the calling thread. The shard lives as long as this object.
+    */
+    latency_shard *register_thread() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        shards_.push_back(std::unique_ptr<latency_shard>(new latency_shard()));
+        return shards_.back().get();
+    }
+
+    /*
+        Merges every shard's counts for one param_type into counts (LATENCY_BUCKETS entries) and returns the maximum.
+    */
+    uint64_t merge(uint8_t param_type, uint64_t *counts) const {
+        const uint32_t slot = latency_param_slot(param_type);
+        uint64_t max_us = 0;
+        for (uint32_t b = 0; b < LATENCY_BUCKETS; ++b) counts[b] = 0;
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto &shard : shards_) {
+            for (uint32_t b = 0; b < LATENCY_BUCKETS; ++b) {
+                counts[b] += shard->counts_[slot][b].load(std::memory_order_relaxed);
+            }
+            const uint64_t shard_max = shard->max_us_[slot].load(std::memory_order_relaxed);
+            if (shard_max > max_us) max_us = shard_max;
+        }
+        return max_us;
+    }
+
+    latency_summary summarize(uint8_t param_type) const {
+        std::vector<uint64_t> counts(LATENCY_BUCKETS);
+        latency_summary summary = {};
+        summary.max_us = merge(param_type, counts.data());
+        for (uint64_t c : counts) summary.count += c;
+        if (summary.count == 0) return summary;
+
+        const uint64_t rank50  = (summary.count * 500 + 999) / 1000;
+        const uint64_t rank99  = (summary.count * 990 + 999) / 1000;
+        const uint64_t rank999 = (summary.count * 999 + 999) / 1000;
+        uint64_t seen = 0;
+        for (uint32_t b = 0; b < LATENCY_BUCKETS; ++b) {
+            if (counts[b] == 0) continue;
+            const uint64_t before = seen;
+            seen += counts[b];
+            const uint64_t upper = std::min(latency_bucket_upper(b), summary.max_us);
+            if (before < rank50  && seen >= rank50)  summary.p50_us  = upper;
+            if (before < rank99  && seen >= rank99)  summary.p99_us  = upper;
+            if (before < rank999 && seen >= rank999) summary.p999_us = upper;
+        }
+        return summary;
+    }
+
+private:
+    mutable std::mutex                          mutex_;
+    std::vector<std::unique_ptr<latency_shard>> shards_;
+};
+
+#endif // LATENCY_HISTOGRAM_HPP
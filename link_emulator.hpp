@@ -0,0 +1,391 @@
+#pragma once
+
+#ifndef LINK_EMULATOR_HPP
+#define LINK_EMULATOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/*
+------------------------------------------------------------------------------------------------------------------------
+    LINK EMULATION
+
+    Reproduces a constrained link (narrowband radio, LTE) in-process, so protocol changes can be measured on a plain
+    Linux box. link_emulator models one direction of a link:
+
+        bandwidth    datagrams are serialised one after another at bandwidth_bps, including overhead_bytes of
+                     per-packet headers. Datagrams that would wait more than queue_bytes behind the link are
+                     tail-dropped, like a full modem buffer;
+        mtu          datagrams larger than mtu are sent as several fragments. Each fragment pays the header
+                     overhead and may be lost on its own; losing any fragment loses the datagram;
+        loss         average fraction of fragments lost. loss_burst is the mean length of a loss burst in packets
+                     (Gilbert-Elliott model); 1 gives roughly independent losses;
+        latency      fixed one-way delay, plus a uniform random jitter in [0, jitter_us]. Jitter does not reorder
+                     unless allow_jitter_reorder is set, since radio and LTE bearers deliver in order;
+        reorder      fraction of datagrams held back an extra reorder_us, so later ones overtake them.
+
+    All randomness comes from a splitmix64 generator seeded with config.seed, so the same seed and the same sequence
+    of send() calls give the same losses and delays on any platform. Time is passed in by the caller: the emulator
+    can run on a virtual clock, which makes benchmarks deterministic and faster than real time.
+
+    link_relay puts a pair of emulators between two UDP endpoints on the loopback interface, so unmodified socket
+    code can be run over an emulated link.
+
+    link_emulator is not thread-safe. link_relay runs its own thread.
+------------------------------------------------------------------------------------------------------------------------
+*/
+struct link_config {
+    uint64_t bandwidth_bps   = 0;        // 0: unlimited.
+    uint32_t latency_us      = 0;
+    uint32_t jitter_us       = 0;
+    bool     allow_jitter_reorder = false;
+    double   loss            = 0.0;      // 0..1, per fragment.
+    double   loss_burst      = 1.0;      // Mean packets per loss burst, >= 1.
+    double   reorder         = 0.0;      // 0..1, per datagram.
+    uint32_t reorder_us      = 0;
+    uint32_t mtu             = 0;        // Bytes per packet including overhead_bytes; 0: no fragmentation.
+    uint32_t overhead_bytes  = 28;       // IPv4 + UDP headers.
+    uint32_t queue_bytes     = 0;        // 0: unbounded.
+    uint64_t seed            = 1;
+};
+
+/*
+    Illustrative profiles for the links DigiView is deployed on. Measure with the parameters of the real link where
+    they are known.
+*/
+inline link_config link_profile_narrowband_radio(uint64_t seed = 1) {
+    link_config config;
+    config.bandwidth_bps = 250000;
+    config.latency_us    = 30000;
+    config.jitter_us     = 15000;
+    config.loss          = 0.02;
+    config.loss_burst    = 4.0;
+    config.mtu           = 255;
+    config.queue_bytes   = 16 * 1024;
+    config.seed          = seed;
+    return config;
+}
+
+inline link_config link_profile_lte_uplink(uint64_t seed = 1) {
+    link_config config;
+    config.bandwidth_bps = 5000000;
+    config.latency_us    = 45000;
+    config.jitter_us     = 20000;
+    config.loss          = 0.005;
+    config.loss_burst    = 2.0;
+    config.mtu           = 1428;
+    config.queue_bytes   = 256 * 1024;
+    config.seed          = seed;
+    return config;
+}
+
+struct link_stats {
+    uint64_t datagrams_sent;
+    uint64_t datagrams_delivered;
+    uint64_t bytes_delivered;       // Payload bytes.
+    uint64_t wire_bytes;            // Payload plus per-fragment overhead, for every datagram that entered the link.
+    uint64_t fragments;
+    uint64_t dropped_loss;
+    uint64_t dropped_queue;
+    uint64_t reordered;
+    uint64_t max_queue_us;          // Longest wait behind the link before serialisation started.
+};
+
+class link_emulator {
+public:
+    explicit link_emulator(const link_config &config = link_config()) {
+        reset(config);
+    }
+
+    /*
+        Discards everything in flight and starts over with config, including its seed.
+    */
+    void reset(const link_config &config) {
+        config_ = config;
+        if (config_.loss_burst < 1.0) config_.loss_burst = 1.0;
+        rng_state_ = config.seed;
+        bad_state_ = false;
+        link_free_us_ = 0;
+        last_delivery_us_ = 0;
+        sequence_ = 0;
+        in_flight_.clear();
+        free_.clear();
+        for (uint32_t i = 0; i < payloads_.size(); ++i) free_.push_back(i);
+        stats_ = {};
+    }
+
+    /*
+        Offers a datagram to the link at now_us. Returns false if the link dropped it. A dropped datagram still uses
+        the link if it was lost in transit rather than at the queue.
+    */
+    bool send(const void *data, size_t len, uint64_t now_us) {
+        stats_.datagrams_sent++;
+        const uint32_t payload_per_fragment =
+            config_.mtu > config_.overhead_bytes ? config_.mtu - config_.overhead_bytes : 0;
+        const uint64_t fragments = payload_per_fragment == 0 || len == 0
+                                       ? 1
+                                       : (len + payload_per_fragment - 1) / payload_per_fragment;
+        const uint64_t wire = len + fragments * config_.overhead_bytes;
+
+        const uint64_t start = std::max(now_us, link_free_us_);
+        const uint64_t wait  = start - now_us;
+        if (config_.queue_bytes != 0 && config_.bandwidth_bps != 0 &&
+            wait * config_.bandwidth_bps / 8000000 + wire > config_.queue_bytes) {
+            stats_.dropped_queue++;
+            return false;
+        }
+        stats_.max_queue_us = std::max(stats_.max_queue_us, wait);
+        stats_.wire_bytes += wire;
+        stats_.fragments  += fragments;
+        link_free_us_ = start + (config_.bandwidth_bps == 0 ? 0 : (wire * 8000000 + config_.bandwidth_bps - 1) / config_.bandwidth_bps);
+
+        bool lost = false;
+        for (uint64_t f = 0; f < fragments; ++f) lost |= fragment_lost();
+        if (lost) {
+            stats_.dropped_loss++;
+            return false;
+        }
+
+        uint64_t deliver = link_free_us_ + config_.latency_us;
+        if (config_.jitter_us != 0) deliver += next_random() % (config_.jitter_us + 1ULL);
+        if (!config_.allow_jitter_reorder) deliver = std::max(deliver, last_delivery_us_);
+        if (config_.reorder > 0.0 && next_unit() < config_.reorder) {
+            deliver += config_.reorder_us;
+            stats_.reordered++;
+        } else if (!config_.allow_jitter_reorder) {
+            last_delivery_us_ = deliver;
+        }
+
+        uint32_t slot;
+        if (free_.empty()) {
+            slot = static_cast<uint32_t>(payloads_.size());
+            payloads_.emplace_back();
+        } else {
+            slot = free_.back();
+            free_.pop_back();
+        }
+        const uint8_t *bytes = static_cast<const uint8_t *>(data);
+        payloads_[slot].assign(bytes, bytes + len);
+        in_flight_.push_back({deliver, sequence_++, slot});
+        std::push_heap(in_flight_.begin(), in_flight_.end(), later);
+        return true;
+    }
+
+    /*
+        Hands every datagram due by now_us to on_datagram(const uint8_t *data, size_t len, uint64_t delivered_us), in
+        delivery order. Returns the number delivered.
+    */
+    template <typename OnDatagram>
+    uint32_t receive(uint64_t now_us, OnDatagram &&on_datagram) {
+        uint32_t delivered = 0;
+        while (!in_flight_.empty() && in_flight_.front().deliver_us <= now_us) {
+            std::pop_heap(in_flight_.begin(), in_flight_.end(), later);
+            const packet p = in_flight_.back();
+            in_flight_.pop_back();
+            const std::vector<uint8_t> &payload = payloads_[p.slot];
+            stats_.datagrams_delivered++;
+            stats_.bytes_delivered += payload.size();
+            on_datagram(payload.data(), payload.size(), p.deliver_us);
+            free_.push_back(p.slot);
+            delivered++;
+        }
+        return delivered;
+    }
+
+    /*
+        Time of the next delivery, or UINT64_MAX if nothing is in flight.
+    */
+    uint64_t next_delivery_us() const {
+        return in_flight_.empty() ? UINT64_MAX : in_flight_.front().deliver_us;
+    }
+
+    size_t in_flight() const {
+        return in_flight_.size();
+    }
+
+    const link_stats &stats() const {
+        return stats_;
+    }
+
+    const link_config &config() const {
+        return config_;
+    }
+
+private:
+    struct packet {
+        uint64_t deliver_us;
+        uint64_t sequence;
+        uint32_t slot;
+    };
+
+    // Min-heap on delivery time; equal times keep send order.
+    static bool later(const packet &a, const packet &b) {
+        return a.deliver_us != b.deliver_us ? a.deliver_us > b.deliver_us : a.sequence > b.sequence;
+    }
+
+    uint64_t next_random() {
+        uint64_t z = (rng_state_ += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    double next_unit() {
+        return (next_random() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    /*
+        Two-state Gilbert-Elliott channel: every fragment in the bad state is lost. Leaving the bad state has
+        probability 1 / loss_burst, and entering it is chosen so the long-run loss rate equals config.loss.
+    */
+    bool fragment_lost() {
+        if (config_.loss <= 0.0) return false;
+        if (config_.loss >= 1.0) return true;
+        const double leave = 1.0 / config_.loss_burst;
+        const double enter = std::min(1.0, config_.loss * leave / (1.0 - config_.loss));
+        bad_state_ = bad_state_ ? next_unit() >= leave : next_unit() < enter;
+        return bad_state_;
+    }
+
+    link_config                       config_;
+    uint64_t                          rng_state_ = 1;
+    bool                              bad_state_ = false;
+    uint64_t                          link_free_us_ = 0;
+    uint64_t                          last_delivery_us_ = 0;
+    uint64_t                          sequence_ = 0;
+    std::vector<packet>               in_flight_;
+    std::vector<std::vector<uint8_t>> payloads_;
+    std::vector<uint32_t>             free_;
+    link_stats                        stats_ = {};
+};
+
+/*
+    Forwards UDP datagrams between a client and a target through two link_emulators. The client sends to
+    127.0.0.1:listen_port instead of the target. Datagrams pass through the uplink emulator to the target, and
+    replies pass back through the downlink emulator to the last client address seen. Runs on the steady clock in its
+    own thread; delivery times are accurate to the scheduler's wakeup latency.
+*/
+class link_relay {
+public:
+    link_relay() = default;
+    link_relay(const link_relay &) = delete;
+    link_relay &operator=(const link_relay &) = delete;
+
+    ~link_relay() {
+        close();
+    }
+
+    bool open(uint16_t listen_port, const sockaddr_in &target, const link_config &uplink, const link_config &downlink) {
+        close();
+        uplink_.reset(uplink);
+        downlink_.reset(downlink);
+        listen_fd_   = socket(AF_INET, SOCK_DGRAM, 0);
+        upstream_fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in addr = {};
+        addr.sin_family      = AF_INET;
+        addr.sin_port        = htons(listen_port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (listen_fd_ < 0 || upstream_fd_ < 0 ||
+            bind(listen_fd_, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0 ||
+            connect(upstream_fd_, reinterpret_cast<const sockaddr *>(&target), sizeof(target)) != 0) {
+            close();
+            return false;
+        }
+        stop_.store(false);
+        thread_ = std::thread([this] { run(); });
+        return true;
+    }
+
+    void close() {
+        if (thread_.joinable()) {
+            stop_.store(true);
+            thread_.join();
+        }
+        if (listen_fd_ >= 0) ::close(listen_fd_);
+        if (upstream_fd_ >= 0) ::close(upstream_fd_);
+        listen_fd_ = upstream_fd_ = -1;
+        has_client_ = false;
+    }
+
+    link_stats uplink_stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return uplink_.stats();
+    }
+
+    link_stats downlink_stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return downlink_.stats();
+    }
+
+private:
+    static uint64_t now_us() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                         std::chrono::steady_clock::now().time_since_epoch())
+                                         .count());
+    }
+
+    void run() {
+        uint8_t buffer[65536];
+        while (!stop_.load(std::memory_order_relaxed)) {
+            uint64_t next;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                next = std::min(uplink_.next_delivery_us(), downlink_.next_delivery_us());
+            }
+            const uint64_t now = now_us();
+            const uint64_t wait_us = next <= now ? 0 : std::min<uint64_t>(next - now, 5000);
+            pollfd fds[2] = {{listen_fd_, POLLIN, 0}, {upstream_fd_, POLLIN, 0}};
+            const timespec timeout = {0, static_cast<long>(wait_us * 1000)};
+            ppoll(fds, 2, &timeout, nullptr);
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (;;) {
+                sockaddr_in from;
+                socklen_t from_len = sizeof(from);
+                const ssize_t n = recvfrom(listen_fd_, buffer, sizeof(buffer), MSG_DONTWAIT,
+                                           reinterpret_cast<sockaddr *>(&from), &from_len);
+                if (n < 0) break;
+                client_     = from;
+                has_client_ = true;
+                uplink_.send(buffer, static_cast<size_t>(n), now_us());
+            }
+            for (;;) {
+                const ssize_t n = recv(upstream_fd_, buffer, sizeof(buffer), MSG_DONTWAIT);
+                if (n < 0) break;
+                if (has_client_) downlink_.send(buffer, static_cast<size_t>(n), now_us());
+            }
+            const uint64_t t = now_us();
+            uplink_.receive(t, [&](const uint8_t *data, size_t len, uint64_t) {
+                ::send(upstream_fd_, data, len, MSG_DONTWAIT);
+            });
+            downlink_.receive(t, [&](const uint8_t *data, size_t len, uint64_t) {
+                sendto(listen_fd_, data, len, MSG_DONTWAIT, reinterpret_cast<const sockaddr *>(&client_), sizeof(client_));
+            });
+        }
+    }
+
+    link_emulator      uplink_;
+    link_emulator      downlink_;
+    mutable std::mutex mutex_;
+    std::thread        thread_;
+    std::atomic<bool>  stop_{false};
+    int                listen_fd_   = -1;
+    int                upstream_fd_ = -1;
+    sockaddr_in        client_      = {};
+    bool               has_client_  = false;
+};
+
+#endif // LINK_EMULATOR_HPP
@@ -4,6 +4,7 @@
 #define MSG_DEFS_HPP
 
 #include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <cstddef>
 #include <string.h>
@@ -11,6 +12,15 @@
 #include <inttypes.h>
 #include <stdint.h>
 
+// MSVC does not define __SSE2__, but SSE2 is always available on x64 and selected by /arch:SSE2 on x86.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MSG_DEFS_SSE2 1
+#include <emmintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
 #include "digiview_commons/public_enums.hpp"
 
 static constexpr uint32_t PARAMCOUNT            = 72;
@@ -23,12 +33,73 @@ static constexpr uint8_t  CAP_FLAG_VIDEO        = 0x02;
 
 static constexpr uint32_t STREAM_NAME_SIZE      = 16;
 
+/*
+    Length of a stream name given as a C string: stops at the terminator or after STREAM_NAME_SIZE bytes, and never
+    reads past the terminator, so short literals such as "cam" are safe.
+*/
+inline uint32_t stream_name_length(const char *stream_name) {
+    return static_cast<uint32_t>(std::find(stream_name, stream_name + STREAM_NAME_SIZE, '\0') - stream_name);
+}
+
+/*
+    Length of a fixed 16-byte stream name field, such as the one in a frame. The field is always read in full, as one
+    vector register where available, so it must point at STREAM_NAME_SIZE readable bytes.
+*/
+inline uint32_t stream_name_field_length(const void *field) {
+#if defined(MSG_DEFS_SSE2)
+    const __m128i bytes = _mm_loadu_si128(static_cast<const __m128i *>(field));
+    const uint32_t zero_mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_setzero_si128())));
+    if (zero_mask == 0) return STREAM_NAME_SIZE;
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long first_zero;
+    _BitScanForward(&first_zero, zero_mask);
+    return static_cast<uint32_t>(first_zero);
+#else
+    return static_cast<uint32_t>(__builtin_ctz(zero_mask));
+#endif
+#else
+    return stream_name_length(static_cast<const char *>(field));
+#endif
+}
+
+/*
+    Byte-wise equality of two full stream name fields. Both fields must be zero padded after the terminator.
+*/
+inline bool stream_name_equal(const void *a, const void *b) {
+#if defined(MSG_DEFS_SSE2)
+    const __m128i lhs = _mm_loadu_si128(static_cast<const __m128i *>(a));
+    const __m128i rhs = _mm_loadu_si128(static_cast<const __m128i *>(b));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(lhs, rhs)) == 0xFFFF;
+#else
+    uint64_t lhs[2], rhs[2];
+    memcpy(lhs, a, STREAM_NAME_SIZE);
+    memcpy(rhs, b, STREAM_NAME_SIZE);
+    return ((lhs[0] ^ rhs[0]) | (lhs[1] ^ rhs[1])) == 0;
+#endif
+}
+
+/*
+    Hash of a full, zero padded stream name field.
+*/
+inline uint64_t stream_name_hash(const void *stream_name) {
+    uint64_t words[2];
+    memcpy(words, stream_name, STREAM_NAME_SIZE);
+    uint64_t h = words[0] * 0x9E3779B97F4A7C15ULL;
+    h ^= (words[1] + 0x632BE59BD9B4E019ULL) * 0xC2B2AE3D27D4EB4FULL;
+    return h ^ (h >> 29);
+}
+
 inline std::string_view stream_name_view(const char *stream_name) {
-    const char *const stream_name_end =
-        std::find(stream_name, stream_name + STREAM_NAME_SIZE, '\0');
     return {
         stream_name,
-        static_cast<size_t>(stream_name_end - stream_name)
+        stream_name_length(stream_name)
+    };
+}
+
+inline std::string_view stream_name_field_view(const void *field) {
+    return {
+        static_cast<const char *>(field),
+        stream_name_field_length(field)
     };
 }
 
@@ -47,8 +118,25 @@ inline std::string_view stream_name_source_view(const char (&stream_name)[N]) {
 }
 
 inline void copy_stream_name_field(uint8_t *dst, std::string_view stream_name) {
-    memset(dst, 0, STREAM_NAME_SIZE);
-    memcpy(dst, stream_name.data(), std::min(stream_name.size(), static_cast<size_t>(STREAM_NAME_SIZE)));
+    if (stream_name.size() >= STREAM_NAME_SIZE) {
+        memcpy(dst, stream_name.data(), STREAM_NAME_SIZE);
+        return;
+    }
+    // Build the padded field locally so the destination is written with a single 16-byte store.
+    uint8_t field[STREAM_NAME_SIZE] = {};
+    memcpy(field, stream_name.data(), stream_name.size());
+    memcpy(dst, field, STREAM_NAME_SIZE);
+}
+
+/*
+    Copies a 16-byte field and clears everything after the first terminator, so that fields from senders that left
+    garbage behind the name compare and hash equal.
+*/
+inline void canonical_stream_name_field(uint8_t *dst, const char *stream_name) {
+    const uint32_t length = stream_name_field_length(stream_name);
+    uint8_t field[STREAM_NAME_SIZE] = {};
+    memcpy(field, stream_name, length);
+    memcpy(dst, field, STREAM_NAME_SIZE);
 }
 
 template <typename EnumType>
@@ -97,11 +185,29 @@ enum PARAM_TYPE : uint8_t {
     SINGLE_TARGET_TRACKING,
     CALIBRATION,
     NAVIGATION,
+    BUNDLE,
+    CAM_OFFSET_BATCH,
 };
 
 static_assert(CAM_TARGETING == 13, "CAM_TARGETING wire value changed");
 static_assert(CAM_OPTICS_AND_CONTROL == 14, "CAM_OPTICS_AND_CONTROL wire value changed");
 static_assert(NAVIGATION == 20, "NAVIGATION wire value changed");
+static_assert(BUNDLE == 21, "BUNDLE wire value changed");
+static_assert(CAM_OFFSET_BATCH == 22, "CAM_OFFSET_BATCH wire value changed");
+
+/*
+    Bit for a parameter type in a BUNDLE mask. Parameter types above 31 cannot be bundled.
+*/
+inline constexpr uint32_t param_type_bit(uint8_t param_type) {
+    return param_type < 32 ? (1U << param_type) : 0U;
+}
+
+// Groups DigiView answers inside a BUNDLE. CAM_OFFSET needs per-request coordinates and is requested on its own.
+static constexpr uint32_t BUNDLE_SUPPORTED_MASK =
+    param_type_bit(SYSTEM_STATUS) | param_type_bit(AI) | param_type_bit(MODEL) | param_type_bit(VIDEO_OUTPUT) |
+    param_type_bit(CAPTURE) | param_type_bit(DETECTION) | param_type_bit(TRACKED_DETECTION) |
+    param_type_bit(CAM_TARGETING) | param_type_bit(CAM_OPTICS_AND_CONTROL) | param_type_bit(SENSOR) |
+    param_type_bit(SINGLE_TARGET_TRACKING) | param_type_bit(CALIBRATION);
 
 enum MESSAGE_TYPE : uint8_t {
     EMPTY,
@@ -114,9 +220,18 @@ enum MESSAGE_TYPE : uint8_t {
     FORBIDDEN,
     UNKNOWN,
     DEBUG,
+    CREDIT,
+    SET_PARAMETERS_NO_ACK,
+    SET_PARAMETERS_RELIABLE,
+    RELIABLE_STATUS,
     QUIT = 255,
 };
 
+static_assert(CREDIT == 10, "CREDIT wire value changed");
+static_assert(SET_PARAMETERS_NO_ACK == 11, "SET_PARAMETERS_NO_ACK wire value changed");
+static_assert(SET_PARAMETERS_RELIABLE == 12, "SET_PARAMETERS_RELIABLE wire value changed");
+static_assert(RELIABLE_STATUS == 13, "RELIABLE_STATUS wire value changed");
+
 /*
 ------------------------------------------------------------------------------------------------------------------------
     STRUCTS
@@ -218,6 +333,38 @@ struct tracked_detection_parameters {
     uint8_t view_id = UINT8_MAX;
 };
 
+/*
+    Optional filter for a TRACKED_DETECTION GET. A GET carries a filter when its type field is
+    TRACKED_DETECTION_FILTERED_GET. Each criterion applies only when its bit is set in flags. Reply frames are renumbered
+    0 .. total_detections - 1 in sort order; track_id stays the stable identity.
+*/
+static constexpr int16_t TRACKED_DETECTION_FILTERED_GET = -3;
+
+static constexpr uint8_t DETECTION_FILTER_SCORE     = 0x01;  // score >= min_score
+static constexpr uint8_t DETECTION_FILTER_CLASS     = 0x02;  // type in 0..31 and bit type set in class_mask
+static constexpr uint8_t DETECTION_FILTER_SECTOR    = 0x04;  // yaw_global/pitch_global inside the window
+static constexpr uint8_t DETECTION_FILTER_SINCE     = 0x08;  // publish_timestamp_us > since_us
+static constexpr uint8_t DETECTION_FILTER_MAX_COUNT = 0x10;  // at most max_count replies, after sorting
+
+enum DETECTION_SORT : uint8_t {
+    DETECTION_SORT_INDEX,    // Ascending detection index.
+    DETECTION_SORT_SCORE,    // Highest score first.
+    DETECTION_SORT_NEWEST,   // Newest publish_timestamp_us first.
+};
+
+struct tracked_detection_filter {
+    uint8_t        flags      = 0;
+    uint8_t        min_score  = 0;
+    uint32_t       class_mask = 0;
+    float          yaw_min    = 0.0f;   // Degrees. yaw_min > yaw_max selects a window across +-180.
+    float          yaw_max    = 0.0f;
+    float          pitch_min  = 0.0f;
+    float          pitch_max  = 0.0f;
+    uint64_t       since_us   = 0;
+    uint8_t        max_count  = 0;
+    DETECTION_SORT sort       = DETECTION_SORT_INDEX;
+};
+
 struct cam_targeting_parameters {
     char    stream_name[STREAM_NAME_SIZE];
     uint8_t cam_id;
@@ -325,6 +472,93 @@ struct navigation_parameters {
     uint8_t position_quality;
 };
 
+/*
+    GET: requested_mask selects the groups to return. CURRENT_PARAMETERS: closes the run of replies to a bundled GET.
+*/
+struct bundle_parameters {
+    char     stream_name[STREAM_NAME_SIZE];
+    uint8_t  cam_id;
+    uint32_t requested_mask;  // Bit n (param_type_bit) = PARAM_TYPE n.
+    uint32_t answered_mask;   // Groups that produced at least one reply frame.
+    uint16_t frame_count;     // Reply frames sent before this one.
+};
+
+/*
+    Many CAM_OFFSET conversions in one exchange. A batch of up to 255 points is split over as few frames as needed:
+    the GET carries CAM_OFFSET_BATCH_POINTS_PER_FRAME quantised (x, y) points per frame, and each reply carries the
+    angles for a consecutive run of points. first_point and point_count place a frame's points within the batch;
+    batch_id is chosen by the client and echoed in every reply.
+
+    Angles are int16 with +-32767 = +-180 degrees (about 0.0055 degree resolution). angles selects which pairs the
+    reply carries (0 means both): with both pairs a reply frame holds CAM_OFFSET_BATCH_POINTS_PER_FRAME / 2 points.
+*/
+static constexpr uint8_t  CAM_OFFSET_ANGLES_GLOBAL          = 0x01;
+static constexpr uint8_t  CAM_OFFSET_ANGLES_RELATIVE        = 0x02;
+static constexpr uint8_t  CAM_OFFSET_ANGLES_BOTH            = CAM_OFFSET_ANGLES_GLOBAL | CAM_OFFSET_ANGLES_RELATIVE;
+static constexpr uint16_t CAM_OFFSET_BATCH_HEADER_SIZE      = STREAM_NAME_SIZE + 6;
+static constexpr uint8_t  CAM_OFFSET_BATCH_POINTS_PER_FRAME = (PARAMCOUNT - CAM_OFFSET_BATCH_HEADER_SIZE) / 4;
+
+/*
+    Points carried by one GET or reply frame for the given angles selection.
+*/
+inline constexpr uint8_t cam_offset_batch_points_per_frame(bool reply, uint8_t angles) {
+    return reply && angles == CAM_OFFSET_ANGLES_BOTH ? CAM_OFFSET_BATCH_POINTS_PER_FRAME / 2 : CAM_OFFSET_BATCH_POINTS_PER_FRAME;
+}
+
+/*
+    Frames needed to carry total_points in a GET or in its reply.
+*/
+inline constexpr uint32_t cam_offset_batch_frames(uint32_t total_points, bool reply, uint8_t angles) {
+    return total_points == 0 ? 1 : (total_points + cam_offset_batch_points_per_frame(reply, angles) - 1) /
+                                       cam_offset_batch_points_per_frame(reply, angles);
+}
+
+struct cam_offset_batch_parameters {
+    char    stream_name[STREAM_NAME_SIZE];
+    uint8_t cam_id;
+    uint8_t batch_id;
+    uint8_t angles;
+    uint8_t total_points;
+    uint8_t first_point;
+    uint8_t point_count;   // Points in this frame; arrays below are indexed 0 .. point_count - 1.
+    float   x[CAM_OFFSET_BATCH_POINTS_PER_FRAME];
+    float   y[CAM_OFFSET_BATCH_POINTS_PER_FRAME];
+    float   yaw_global[CAM_OFFSET_BATCH_POINTS_PER_FRAME];
+    float   pitch_global[CAM_OFFSET_BATCH_POINTS_PER_FRAME];
+    float   yaw_rel[CAM_OFFSET_BATCH_POINTS_PER_FRAME];
+    float   pitch_rel[CAM_OFFSET_BATCH_POINTS_PER_FRAME];
+};
+
+/*
+    Flow-control credit, sent as MESSAGE_TYPE CREDIT. The client grants cumulative limits: DigiView may send frames
+    while frames_sent < frame_limit and bytes_sent < byte_limit, counted from the start of the connection. Limits
+    only grow, so a lost or reordered grant is repaired by the next one. DigiView sends the same message back as a
+    report with its counters and the number of recurring-stream ticks it dropped while out of credit.
+*/
+struct credit_parameters {
+    uint64_t frame_limit;
+    uint64_t byte_limit;     // UINT64_MAX = frames only.
+    uint64_t frames_sent;    // Report only.
+    uint64_t bytes_sent;     // Report only.
+    uint32_t dropped_ticks;  // Report only.
+};
+
+/*
+    Receive status for reliable SETs, sent as MESSAGE_TYPE RELIABLE_STATUS. It covers the RELIABLE_STATUS_SPAN
+    sequence numbers starting at base: bit i of received is set when base + i has arrived, bit i of missing when it
+    has not but a later one has (a NACK). outcomes holds 2 bits per sequence number (reliable_outcome_code) for the
+    ones received.
+*/
+static constexpr uint32_t RELIABLE_STATUS_SPAN = 64;
+
+struct reliable_status_parameters {
+    uint16_t session;
+    uint16_t base;
+    uint64_t received;
+    uint64_t missing;
+    uint8_t  outcomes[RELIABLE_STATUS_SPAN / 4];
+};
+
 struct debug_parameters {
     int32_t param1;
     int32_t param2;
@@ -355,6 +589,158 @@ inline message deserialize_message(char *buffer) {
     return msg;
 }
 
+/*
+------------------------------------------------------------------------------------------------------------------------
+    FRAME INSPECTION
+
+    Read routing keys straight from a packed frame without running the full unpack function.
+------------------------------------------------------------------------------------------------------------------------
+*/
+static constexpr uint16_t TRACKED_DETECTION_TRACK_ID_OFFSET               = 46;
+static constexpr uint16_t TRACKED_DETECTION_PUBLISH_TIMESTAMP_OFFSET       = 48;
+static constexpr uint16_t SINGLE_TARGET_TRACKING_PUBLISH_TIMESTAMP_OFFSET  = 46;
+static constexpr uint16_t CAM_TARGETING_MODE_OFFSET                       = 17;
+static constexpr uint16_t CAM_TARGETING_EULER_DELTA_OFFSET                = 18;
+static constexpr uint16_t CAM_TARGETING_YAW_OFFSET                        = 19;  // yaw, pitch, roll: int32 milli-degrees.
+static constexpr uint16_t TRACKED_DETECTION_SCORE_OFFSET                  = 1;
+static constexpr uint16_t TRACKED_DETECTION_TYPE_OFFSET                   = 3;
+static constexpr uint16_t TRACKED_DETECTION_FILTER_FLAGS_OFFSET           = 57;
+static constexpr uint16_t TRACKED_DETECTION_FILTER_CLASS_MASK_OFFSET      = 58;
+static constexpr uint16_t TRACKED_DETECTION_FILTER_MAX_COUNT_OFFSET       = 62;
+static constexpr uint16_t TRACKED_DETECTION_FILTER_SORT_OFFSET            = 63;
+static constexpr uint16_t TRACKED_DETECTION_FILTER_WINDOW_OFFSET          = 64;  // yaw min/max, pitch min/max: int16 centi-degrees.
+
+/*
+    SET_PARAMETERS_NO_ACK is applied exactly like SET_PARAMETERS, but a successful change is not answered with
+    ACKNOWLEDGEMENT. Failures are still reported (CHECKSUM_ERROR, DATA_ERROR, FORBIDDEN, UNKNOWN).
+*/
+inline bool is_set_message(uint8_t message_type) {
+    return message_type == SET_PARAMETERS || message_type == SET_PARAMETERS_NO_ACK || message_type == SET_PARAMETERS_RELIABLE;
+}
+
+inline bool acknowledges_set(uint8_t message_type) {
+    return message_type == SET_PARAMETERS;
+}
+
+inline uint8_t set_message_type(bool no_ack) {
+    return no_ack ? SET_PARAMETERS_NO_ACK : SET_PARAMETERS;
+}
+
+/*
+    SET_PARAMETERS_RELIABLE carries the sender's session in the high 16 bits of interval_ms, which SETs do not
+    otherwise use, and the sequence number in the low 16 bits. Success and failure are reported in RELIABLE_STATUS,
+    not with ACKNOWLEDGEMENT or error replies.
+*/
+inline uint16_t reliable_session(const message &msg) {
+    return static_cast<uint16_t>(msg.interval_ms >> 16);
+}
+
+inline uint16_t reliable_sequence(const message &msg) {
+    return static_cast<uint16_t>(msg.interval_ms & 0xFFFF);
+}
+
+/*
+    2-bit outcome codes used in reliable_status_parameters::outcomes.
+*/
+inline uint8_t reliable_outcome_code(uint8_t reply_type) {
+    switch (reply_type) {
+        case DATA_ERROR: return 1;
+        case FORBIDDEN:  return 2;
+        case UNKNOWN:    return 3;
+        default:         return 0;
+    }
+}
+
+inline uint8_t reliable_outcome_type(uint8_t code) {
+    static const uint8_t types[4] = {ACKNOWLEDGEMENT, DATA_ERROR, FORBIDDEN, UNKNOWN};
+    return types[code & 3];
+}
+
+/*
+    Offset of stream_name in the payload, or -1 if the parameter type has none.
+*/
+inline int16_t stream_name_offset(uint8_t param_type) {
+    switch (param_type) {
+        case VIDEO_OUTPUT:
+        case CAPTURE:
+        case CAM_TARGETING:
+        case CAM_OPTICS_AND_CONTROL:
+        case CAM_OFFSET:
+        case CAM_DEPTH_ESTIMATION:
+        case BUNDLE:
+        case CAM_OFFSET_BATCH:
+            return 0;
+        case SINGLE_TARGET_TRACKING:
+            return sizeof(uint8_t);
+        default:
+            return -1;
+    }
+}
+
+/*
+    Offset of cam_id in the payload, or -1 if the parameter type has none.
+*/
+inline int16_t cam_id_offset(uint8_t param_type) {
+    switch (param_type) {
+        case CAM_TARGETING:
+        case CAM_OPTICS_AND_CONTROL:
+        case CAM_OFFSET:
+        case CAM_DEPTH_ESTIMATION:
+        case BUNDLE:
+        case CAM_OFFSET_BATCH:
+            return STREAM_NAME_SIZE;
+        case SINGLE_TARGET_TRACKING:
+            return sizeof(uint8_t) + STREAM_NAME_SIZE;
+        case CALIBRATION:
+            return 0;
+        default:
+            return -1;
+    }
+}
+
+/*
+    cam_id of the frame, or 255 if the parameter type has none.
+*/
+inline uint8_t frame_cam_id(const message &msg) {
+    const int16_t offset = cam_id_offset(msg.param_type);
+    return offset < 0 ? 255 : msg.data[offset];
+}
+
+/*
+    stream_name of the frame, or an empty view if the parameter type has none.
+*/
+inline std::string_view frame_stream_name(const message &msg) {
+    const int16_t offset = stream_name_offset(msg.param_type);
+    if (offset < 0) return {};
+    return stream_name_field_view(&msg.data[offset]);
+}
+
+/*
+    publish_timestamp_us of a TRACKED_DETECTION or SINGLE_TARGET_TRACKING frame. Returns false for other parameter
+    types.
+*/
+inline bool frame_publish_timestamp_us(const message &msg, uint64_t &publish_timestamp_us) {
+    switch (msg.param_type) {
+        case TRACKED_DETECTION:
+            memcpy(&publish_timestamp_us, &msg.data[TRACKED_DETECTION_PUBLISH_TIMESTAMP_OFFSET], sizeof(uint64_t));
+            return true;
+        case SINGLE_TARGET_TRACKING:
+            memcpy(&publish_timestamp_us, &msg.data[SINGLE_TARGET_TRACKING_PUBLISH_TIMESTAMP_OFFSET], sizeof(uint64_t));
+            return true;
+        default:
+            return false;
+    }
+}
+
+/*
+    track_id of a TRACKED_DETECTION frame. Returns false for other parameter types.
+*/
+inline bool frame_track_id(const message &msg, uint16_t &track_id) {
+    if (msg.param_type != TRACKED_DETECTION) return false;
+    memcpy(&track_id, &msg.data[TRACKED_DETECTION_TRACK_ID_OFFSET], sizeof(uint16_t));
+    return true;
+}
+
 /*
 ------------------------------------------------------------------------------------------------------------------------
     PACKING FUNCTIONS
@@ -786,6 +1172,129 @@ inline void pack_navigation_parameters(
     memcpy(&msg.data[offset], &position_quality, sizeof(position_quality));
 }
 
+template <typename StreamName>
+inline void pack_bundle_parameters(
+    message &msg, StreamName &&stream_name, uint8_t cam_id, uint32_t requested_mask, uint32_t answered_mask = 0,
+    uint16_t frame_count = 0) {
+    msg.param_type = BUNDLE;
+    uint16_t offset = 0;
+    copy_stream_name_field(&msg.data[offset], stream_name_source_view(stream_name));
+    offset += STREAM_NAME_SIZE;
+    memcpy((void *)&msg.data[offset], &cam_id, sizeof(uint8_t));
+    offset += sizeof(uint8_t);
+    memcpy((void *)&msg.data[offset], &requested_mask, sizeof(uint32_t));
+    offset += sizeof(uint32_t);
+    memcpy((void *)&msg.data[offset], &answered_mask, sizeof(uint32_t));
+    offset += sizeof(uint32_t);
+    memcpy((void *)&msg.data[offset], &frame_count, sizeof(uint16_t));
+}
+
+/*
+    Batch angles are wrapped to [-180, 180) and stored as int16 with +-32767 = +-180 degrees.
+*/
+inline int16_t cam_offset_batch_angle_to_s16(float degrees) {
+    const float wrapped = degrees - 360.0f * std::floor((degrees + 180.0f) / 360.0f);
+    return static_cast<int16_t>(std::lround(wrapped / 180.0f * S16_MAX_F));
+}
+
+inline float cam_offset_batch_angle_from_s16(int16_t value) {
+    return static_cast<float>(value) / S16_MAX_F * 180.0f;
+}
+
+template <typename StreamName>
+inline void pack_cam_offset_batch_header(
+    message &msg, StreamName &&stream_name, uint8_t cam_id, uint8_t batch_id, uint8_t angles, uint8_t total_points,
+    uint8_t first_point, uint8_t point_count) {
+    msg.param_type = CAM_OFFSET_BATCH;
+    uint16_t offset = 0;
+    copy_stream_name_field(&msg.data[offset], stream_name_source_view(stream_name));
+    offset += STREAM_NAME_SIZE;
+    msg.data[offset++] = cam_id;
+    msg.data[offset++] = batch_id;
+    msg.data[offset++] = angles;
+    msg.data[offset++] = total_points;
+    msg.data[offset++] = first_point;
+    msg.data[offset]   = point_count;
+}
+
+/*
+    Packs the points of x[first_point ..] and y[first_point ..] that fit into one GET frame. x and y hold the whole
+    batch of total_points. Returns the number of points packed; the next frame starts at first_point plus that number.
+*/
+template <typename StreamName>
+inline uint8_t pack_cam_offset_batch_points(
+    message &msg, StreamName &&stream_name, uint8_t cam_id, uint8_t batch_id, uint8_t angles, const float *x, const float *y,
+    uint8_t total_points, uint8_t first_point) {
+    const uint8_t count = static_cast<uint8_t>(std::min<uint32_t>(
+        CAM_OFFSET_BATCH_POINTS_PER_FRAME, first_point < total_points ? total_points - first_point : 0));
+    pack_cam_offset_batch_header(msg, stream_name, cam_id, batch_id, angles, total_points, first_point, count);
+    uint16_t offset = CAM_OFFSET_BATCH_HEADER_SIZE;
+    for (uint8_t i = 0; i < count; ++i) {
+        const int16_t xy[2] = {static_cast<int16_t>(x[first_point + i] * S16_MAX_F), static_cast<int16_t>(y[first_point + i] * S16_MAX_F)};
+        memcpy((void *)&msg.data[offset], xy, sizeof(xy));
+        offset += sizeof(xy);
+    }
+    return count;
+}
+
+/*
+    Reply counterpart of pack_cam_offset_batch_points: packs the angles of the points starting at first_point. The
+    angle arrays hold the whole batch; pairs not selected by angles may be nullptr. Returns the number of points packed.
+*/
+template <typename StreamName>
+inline uint8_t pack_cam_offset_batch_angles(
+    message &msg, StreamName &&stream_name, uint8_t cam_id, uint8_t batch_id, uint8_t angles, const float *yaw_global,
+    const float *pitch_global, const float *yaw_rel, const float *pitch_rel, uint8_t total_points, uint8_t first_point) {
+    if ((angles & CAM_OFFSET_ANGLES_BOTH) == 0) angles = CAM_OFFSET_ANGLES_BOTH;
+    const uint8_t count = static_cast<uint8_t>(std::min<uint32_t>(
+        cam_offset_batch_points_per_frame(true, angles), first_point < total_points ? total_points - first_point : 0));
+    pack_cam_offset_batch_header(msg, stream_name, cam_id, batch_id, angles, total_points, first_point, count);
+    uint16_t offset = CAM_OFFSET_BATCH_HEADER_SIZE;
+    for (uint8_t i = 0; i < count; ++i) {
+        const uint8_t point = first_point + i;
+        if (angles & CAM_OFFSET_ANGLES_GLOBAL) {
+            const int16_t pair[2] = {cam_offset_batch_angle_to_s16(yaw_global[point]), cam_offset_batch_angle_to_s16(pitch_global[point])};
+            memcpy((void *)&msg.data[offset], pair, sizeof(pair));
+            offset += sizeof(pair);
+        }
+        if (angles & CAM_OFFSET_ANGLES_RELATIVE) {
+            const int16_t pair[2] = {cam_offset_batch_angle_to_s16(yaw_rel[point]), cam_offset_batch_angle_to_s16(pitch_rel[point])};
+            memcpy((void *)&msg.data[offset], pair, sizeof(pair));
+            offset += sizeof(pair);
+        }
+    }
+    return count;
+}
+
+inline void pack_credit_parameters(
+    message &msg, uint64_t frame_limit, uint64_t byte_limit = UINT64_MAX, uint64_t frames_sent = 0, uint64_t bytes_sent = 0,
+    uint32_t dropped_ticks = 0) {
+    uint16_t offset = 0;
+    memcpy((void *)&msg.data[offset], &frame_limit, sizeof(uint64_t));
+    offset += sizeof(uint64_t);
+    memcpy((void *)&msg.data[offset], &byte_limit, sizeof(uint64_t));
+    offset += sizeof(uint64_t);
+    memcpy((void *)&msg.data[offset], &frames_sent, sizeof(uint64_t));
+    offset += sizeof(uint64_t);
+    memcpy((void *)&msg.data[offset], &bytes_sent, sizeof(uint64_t));
+    offset += sizeof(uint64_t);
+    memcpy((void *)&msg.data[offset], &dropped_ticks, sizeof(uint32_t));
+}
+
+inline void pack_reliable_status_parameters(
+    message &msg, uint16_t session, uint16_t base, uint64_t received, uint64_t missing, const uint8_t *outcomes) {
+    uint16_t offset = 0;
+    memcpy((void *)&msg.data[offset], &session, sizeof(uint16_t));
+    offset += sizeof(uint16_t);
+    memcpy((void *)&msg.data[offset], &base, sizeof(uint16_t));
+    offset += sizeof(uint16_t);
+    memcpy((void *)&msg.data[offset], &received, sizeof(uint64_t));
+    offset += sizeof(uint64_t);
+    memcpy((void *)&msg.data[offset], &missing, sizeof(uint64_t));
+    offset += sizeof(uint64_t);
+    memcpy((void *)&msg.data[offset], outcomes, RELIABLE_STATUS_SPAN / 4);
+}
+
 inline void pack_debug_parameters(
     message &msg, int32_t param1 = 0, int32_t param2 = 0, int32_t param3 = 0, int32_t param4 = 0,
     int32_t param5 = 0, int32_t param6 = 0, int32_t param7 = 0, int32_t param8 = 0) {
@@ -854,6 +1363,27 @@ inline void pack_get_tracked_detection_all(message &msg, uint8_t rel_frame_of_re
     pack_tracked_detection_parameters(msg, 0, 255, 0, -2, 0.0f, 0.0f, rel_frame_of_reference, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
 }
 
+/*
+    Convenience function for TRACKED_DETECTION. Get the detections that pass filter, from all detections or only the
+    visible ones. since_us travels in the publish_timestamp_us field and min_score in the score field; the remaining
+    criteria use the payload tail after view_id.
+*/
+inline void pack_get_tracked_detection_filtered(
+    message &msg, const tracked_detection_filter &filter, uint8_t rel_frame_of_reference, bool visible_only = false) {
+    pack_get_parameters(msg, TRACKED_DETECTION);
+    pack_tracked_detection_parameters(msg, 0, visible_only ? 254 : 255, filter.min_score, TRACKED_DETECTION_FILTERED_GET,
+                                      0.0f, 0.0f, rel_frame_of_reference, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+                                      0, filter.since_us);
+    msg.data[TRACKED_DETECTION_FILTER_FLAGS_OFFSET] = filter.flags;
+    memcpy((void *)&msg.data[TRACKED_DETECTION_FILTER_CLASS_MASK_OFFSET], &filter.class_mask, sizeof(uint32_t));
+    msg.data[TRACKED_DETECTION_FILTER_MAX_COUNT_OFFSET] = filter.max_count;
+    msg.data[TRACKED_DETECTION_FILTER_SORT_OFFSET]      = filter.sort;
+    const int16_t window[4] = {
+        static_cast<int16_t>(filter.yaw_min * 100.0f), static_cast<int16_t>(filter.yaw_max * 100.0f),
+        static_cast<int16_t>(filter.pitch_min * 100.0f), static_cast<int16_t>(filter.pitch_max * 100.0f)};
+    memcpy((void *)&msg.data[TRACKED_DETECTION_FILTER_WINDOW_OFFSET], window, sizeof(window));
+}
+
 /*
     Convenience function for CAM_OFFSET. Specify the camera index and offset from center.
 */
@@ -866,11 +1396,32 @@ inline void pack_get_navigation_parameters(message &msg) {
     pack_get_parameters(msg, NAVIGATION);
 }
 
+/*
+    Requests several parameter groups in one message. requested_mask is an OR of param_type_bit values; bits outside
+    BUNDLE_SUPPORTED_MASK are ignored by DigiView. stream_name and cam apply to every group that takes them.
+*/
+inline void pack_get_bundle_parameters(message &msg, uint32_t requested_mask, const char *stream_name = nullptr, uint8_t cam = 255) {
+    pack_get_parameters(msg, BUNDLE, stream_name, cam);
+    pack_bundle_parameters(msg, stream_name != nullptr ? stream_name : "", cam, requested_mask);
+}
+
+/*
+    Convenience function for CAM_OFFSET_BATCH. Packs the GET frame that starts at first_point and returns the number of
+    points it carries. Start at first_point = 0 and advance by the return value until every point has been sent.
+*/
+inline uint8_t pack_get_cam_offset_batch(
+    message &msg, const char *stream_name, uint8_t cam, uint8_t batch_id, const float *x, const float *y, uint8_t total_points,
+    uint8_t first_point, uint8_t angles = CAM_OFFSET_ANGLES_BOTH) {
+    pack_get_parameters(msg, CAM_OFFSET_BATCH, stream_name, cam);
+    return pack_cam_offset_batch_points(msg, stream_name, cam, batch_id, angles, x, y, total_points, first_point);
+}
+
 /*
 ------------------------------------------------------------------------------------------------------------------------
     SET PACKING FUNCTIONS
 
-    For each parameter type there is one pack function.
+    For each parameter type there is one pack function. The high-rate control groups take no_ack to send
+    SET_PARAMETERS_NO_ACK instead of SET_PARAMETERS.
 ------------------------------------------------------------------------------------------------------------------------
 */
 inline void pack_set_ai_parameters(
@@ -909,20 +1460,20 @@ inline void pack_set_detection_parameters(
 inline void pack_set_cam_targeting_parameters(
     message &msg, const char *stream_name, uint8_t cam_id, View::TargetingMode targeting_mode, bool euler_delta, float yaw, float pitch, float roll,
     uint8_t lock_flags, float x_offset, float y_offset, float target_latitude,
-    float target_longitude, float target_altitude, uint16_t track_id = 0, int16_t view_id = -1, bool lock_target = false) {
+    float target_longitude, float target_altitude, uint16_t track_id = 0, int16_t view_id = -1, bool lock_target = false, bool no_ack = false) {
 
     msg.version      = VERSION;
-    msg.message_type = SET_PARAMETERS;
+    msg.message_type = set_message_type(no_ack);
     pack_cam_targeting_parameters(
         msg, stream_name, cam_id, targeting_mode, euler_delta, yaw, pitch, roll, lock_flags, x_offset, y_offset,
         target_latitude, target_longitude, target_altitude, track_id, view_id, lock_target);
 }
 
 inline void pack_set_cam_optics_and_control_parameters(
-    message &msg, const char *stream_name, uint8_t cam_id, int8_t zoom, float fov) {
+    message &msg, const char *stream_name, uint8_t cam_id, int8_t zoom, float fov, bool no_ack = false) {
 
     msg.version      = VERSION;
-    msg.message_type = SET_PARAMETERS;
+    msg.message_type = set_message_type(no_ack);
     pack_cam_optics_and_control_parameters(msg, stream_name, cam_id, zoom, fov);
 }
 
@@ -942,9 +1493,9 @@ inline void pack_set_cam_depth_estimation_parameters(message &msg, const char *s
 inline void pack_set_single_target_tracking_parameters(
     message &msg, single_target_tracker_command command, const char *stream_name, uint8_t cam_id, float x_offset, float y_offset,
     uint8_t detection_id, uint16_t zoom_level, float confidence, float yaw_global, float pitch_global,
-    uint8_t rel_frame_of_reference, float yaw_rel, float pitch_rel, bool lock_target = false) {
+    uint8_t rel_frame_of_reference, float yaw_rel, float pitch_rel, bool lock_target = false, bool no_ack = false) {
     msg.version      = VERSION;
-    msg.message_type = SET_PARAMETERS;
+    msg.message_type = set_message_type(no_ack);
     pack_single_target_tracking_parameters(msg, command, stream_name, cam_id, x_offset, y_offset,
         detection_id, zoom_level, confidence, yaw_global, pitch_global, rel_frame_of_reference, yaw_rel, pitch_rel,
         0, single_target_tracking_status::OFF, lock_target);
@@ -956,6 +1507,31 @@ inline void pack_set_calibration_parameters(message &msg, uint8_t cam_id, calibr
     pack_calibration_parameters(msg, cam_id, calib_command, CALIBRATION_STATUS_NOT_STARTED, 0, 0);
 }
 
+/*
+    Grant (client) or report (DigiView) of flow-control credit. See credit_parameters.
+*/
+inline void pack_credit_message(
+    message &msg, uint64_t frame_limit, uint64_t byte_limit = UINT64_MAX, uint64_t frames_sent = 0, uint64_t bytes_sent = 0,
+    uint32_t dropped_ticks = 0) {
+    msg.version = VERSION;
+    msg.message_type = CREDIT;
+    msg.param_type = 0;
+    msg.interval_ms = 0;
+    pack_credit_parameters(msg, frame_limit, byte_limit, frames_sent, bytes_sent, dropped_ticks);
+}
+
+/*
+    Receive status for reliable SETs. See reliable_status_parameters.
+*/
+inline void pack_reliable_status_message(
+    message &msg, uint16_t session, uint16_t base, uint64_t received, uint64_t missing, const uint8_t *outcomes) {
+    msg.version = VERSION;
+    msg.message_type = RELIABLE_STATUS;
+    msg.param_type = 0;
+    msg.interval_ms = 0;
+    pack_reliable_status_parameters(msg, session, base, received, missing, outcomes);
+}
+
 inline void pack_debug_message(
     message &msg, int32_t param1 = 0, int32_t param2 = 0, int32_t param3 = 0, int32_t param4 = 0,
     int32_t param5 = 0, int32_t param6 = 0, int32_t param7 = 0, int32_t param8 = 0) {
@@ -1076,6 +1652,31 @@ inline void unpack_detection_parameters(message &raw_msg, detection_parameters &
     memcpy(&params.missed_redetection_penalty, (void *)&raw_msg.data[offset], sizeof(uint8_t));
 }
 
+/*
+    Reads the filter from a TRACKED_DETECTION GET. Returns false, leaving filter empty (everything passes), if the GET
+    carries no filter.
+*/
+inline bool unpack_tracked_detection_filter(const message &raw_msg, tracked_detection_filter &filter) {
+    filter = tracked_detection_filter();
+    int16_t type;
+    memcpy(&type, (void *)&raw_msg.data[TRACKED_DETECTION_TYPE_OFFSET], sizeof(int16_t));
+    if (raw_msg.param_type != TRACKED_DETECTION || type != TRACKED_DETECTION_FILTERED_GET) return false;
+    filter.flags     = raw_msg.data[TRACKED_DETECTION_FILTER_FLAGS_OFFSET];
+    filter.min_score = raw_msg.data[TRACKED_DETECTION_SCORE_OFFSET];
+    memcpy(&filter.class_mask, (void *)&raw_msg.data[TRACKED_DETECTION_FILTER_CLASS_MASK_OFFSET], sizeof(uint32_t));
+    memcpy(&filter.since_us, (void *)&raw_msg.data[TRACKED_DETECTION_PUBLISH_TIMESTAMP_OFFSET], sizeof(uint64_t));
+    filter.max_count = raw_msg.data[TRACKED_DETECTION_FILTER_MAX_COUNT_OFFSET];
+    const uint8_t sort = raw_msg.data[TRACKED_DETECTION_FILTER_SORT_OFFSET];
+    filter.sort = sort <= DETECTION_SORT_NEWEST ? static_cast<DETECTION_SORT>(sort) : DETECTION_SORT_INDEX;
+    int16_t window[4];
+    memcpy(window, (void *)&raw_msg.data[TRACKED_DETECTION_FILTER_WINDOW_OFFSET], sizeof(window));
+    filter.yaw_min   = static_cast<float>(window[0]) / 100.0f;
+    filter.yaw_max   = static_cast<float>(window[1]) / 100.0f;
+    filter.pitch_min = static_cast<float>(window[2]) / 100.0f;
+    filter.pitch_max = static_cast<float>(window[3]) / 100.0f;
+    return true;
+}
+
 inline void unpack_tracked_detection_parameters(message &raw_msg, tracked_detection_parameters &params) {
     uint16_t offset = 0;
     int32_t mrad;
@@ -1379,6 +1980,88 @@ inline void unpack_navigation_parameters(message &raw_msg, navigation_parameters
     memcpy(&params.position_quality, (void *)&raw_msg.data[offset], sizeof(uint8_t));
 }
 
+inline void unpack_bundle_parameters(message &raw_msg, bundle_parameters &params) {
+    uint16_t offset = 0;
+    memcpy((void *)&params.stream_name, (void *)&raw_msg.data[offset], STREAM_NAME_SIZE);
+    offset += STREAM_NAME_SIZE;
+    memcpy((void *)&params.cam_id, (void *)&raw_msg.data[offset], sizeof(uint8_t));
+    offset += sizeof(uint8_t);
+    memcpy((void *)&params.requested_mask, (void *)&raw_msg.data[offset], sizeof(uint32_t));
+    offset += sizeof(uint32_t);
+    memcpy((void *)&params.answered_mask, (void *)&raw_msg.data[offset], sizeof(uint32_t));
+    offset += sizeof(uint32_t);
+    memcpy((void *)&params.frame_count, (void *)&raw_msg.data[offset], sizeof(uint16_t));
+}
+
+/*
+    Unpacks one CAM_OFFSET_BATCH frame. A GET_PARAMETERS frame fills x and y; any other frame fills the angle pairs
+    selected by angles. point_count is clamped to what the frame can hold.
+*/
+inline void unpack_cam_offset_batch_parameters(message &raw_msg, cam_offset_batch_parameters &params) {
+    uint16_t offset = 0;
+    memcpy((void *)&params.stream_name, (void *)&raw_msg.data[offset], STREAM_NAME_SIZE);
+    offset += STREAM_NAME_SIZE;
+    params.cam_id       = raw_msg.data[offset++];
+    params.batch_id     = raw_msg.data[offset++];
+    params.angles       = raw_msg.data[offset++];
+    params.total_points = raw_msg.data[offset++];
+    params.first_point  = raw_msg.data[offset++];
+    params.point_count  = raw_msg.data[offset++];
+
+    const bool reply = raw_msg.message_type != GET_PARAMETERS;
+    params.angles &= CAM_OFFSET_ANGLES_BOTH;
+    if (params.angles == 0) params.angles = CAM_OFFSET_ANGLES_BOTH;
+    params.point_count = std::min(params.point_count, cam_offset_batch_points_per_frame(reply, params.angles));
+    for (uint8_t i = 0; i < params.point_count; ++i) {
+        int16_t pair[2];
+        if (!reply) {
+            memcpy(pair, (void *)&raw_msg.data[offset], sizeof(pair));
+            offset += sizeof(pair);
+            params.x[i] = static_cast<float>(pair[0]) / S16_MAX_F;
+            params.y[i] = static_cast<float>(pair[1]) / S16_MAX_F;
+            continue;
+        }
+        if (params.angles & CAM_OFFSET_ANGLES_GLOBAL) {
+            memcpy(pair, (void *)&raw_msg.data[offset], sizeof(pair));
+            offset += sizeof(pair);
+            params.yaw_global[i]   = cam_offset_batch_angle_from_s16(pair[0]);
+            params.pitch_global[i] = cam_offset_batch_angle_from_s16(pair[1]);
+        }
+        if (params.angles & CAM_OFFSET_ANGLES_RELATIVE) {
+            memcpy(pair, (void *)&raw_msg.data[offset], sizeof(pair));
+            offset += sizeof(pair);
+            params.yaw_rel[i]   = cam_offset_batch_angle_from_s16(pair[0]);
+            params.pitch_rel[i] = cam_offset_batch_angle_from_s16(pair[1]);
+        }
+    }
+}
+
+inline void unpack_credit_parameters(message &raw_msg, credit_parameters &params) {
+    uint16_t offset = 0;
+    memcpy(&params.frame_limit, (void *)&raw_msg.data[offset], sizeof(uint64_t));
+    offset += sizeof(uint64_t);
+    memcpy(&params.byte_limit, (void *)&raw_msg.data[offset], sizeof(uint64_t));
+    offset += sizeof(uint64_t);
+    memcpy(&params.frames_sent, (void *)&raw_msg.data[offset], sizeof(uint64_t));
+    offset += sizeof(uint64_t);
+    memcpy(&params.bytes_sent, (void *)&raw_msg.data[offset], sizeof(uint64_t));
+    offset += sizeof(uint64_t);
+    memcpy(&params.dropped_ticks, (void *)&raw_msg.data[offset], sizeof(uint32_t));
+}
+
+inline void unpack_reliable_status_parameters(message &raw_msg, reliable_status_parameters &params) {
+    uint16_t offset = 0;
+    memcpy(&params.session, (void *)&raw_msg.data[offset], sizeof(uint16_t));
+    offset += sizeof(uint16_t);
+    memcpy(&params.base, (void *)&raw_msg.data[offset], sizeof(uint16_t));
+    offset += sizeof(uint16_t);
+    memcpy(&params.received, (void *)&raw_msg.data[offset], sizeof(uint64_t));
+    offset += sizeof(uint64_t);
+    memcpy(&params.missing, (void *)&raw_msg.data[offset], sizeof(uint64_t));
+    offset += sizeof(uint64_t);
+    memcpy(params.outcomes, (void *)&raw_msg.data[offset], RELIABLE_STATUS_SPAN / 4);
+}
+
 inline void unpack_debug_parameters(message &raw_msg, debug_parameters &params) {
     uint16_t offset = 0;
     memcpy((void *)&params.param1, (void *)&raw_msg.data[offset], sizeof(int32_t));
@@ -1651,5 +2334,412 @@ inline void add_checksum_for_digiview_message(message& msg) {
     msg.checksum = checksum_generator.crc(reinterpret_cast<uint8_t *>(&msg), offsetof(message, checksum));
 }
 
+/*
+------------------------------------------------------------------------------------------------------------------------
+    FUSED PACK AND CHECKSUM
+
+    Single-pass variants of the pack functions. Every payload byte is folded into a running CRC as it is written, so
+    the frame is sealed without reading it back. The result is identical to calling pack_* followed by
+    add_checksum_for_digiview_message.
+
+    The header is folded first, so timestamp, version, message_type and interval_ms must be set before calling.
+------------------------------------------------------------------------------------------------------------------------
+*/
+
+// Lookup table for CRC8TYPE::BLUETOOTH. The preset reflects input and output, so the table runs the reflected
+// algorithm directly with the reversed polynomial (0xA7 -> 0xE5).
+struct crc8_bluetooth_table {
+    constexpr crc8_bluetooth_table() : entries() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint8_t crc_val = static_cast<uint8_t>(i);
+            for (uint8_t bit = 0; bit < 8; ++bit) {
+                crc_val = (crc_val & 0x01) ? static_cast<uint8_t>((crc_val >> 1) ^ 0xE5) : static_cast<uint8_t>(crc_val >> 1);
+            }
+            entries[i] = crc_val;
+        }
+    }
+    uint8_t entries[256];
+};
+
+static constexpr crc8_bluetooth_table CRC8_BLUETOOTH_TABLE{};
+
+struct crc8_running {
+    uint8_t value = 0x00;
+
+    void update(uint8_t byte) {
+        value = CRC8_BLUETOOTH_TABLE.entries[value ^ byte];
+    }
+
+    void update(const uint8_t *data, uint32_t n_bytes) {
+        for (uint32_t byte = 0; byte < n_bytes; ++byte) {
+            value = CRC8_BLUETOOTH_TABLE.entries[value ^ data[byte]];
+        }
+    }
+};
+
+/*
+    True if the frame's checksum matches its contents. Uses the lookup table, so it is cheap enough for every
+    received frame.
+*/
+inline bool has_valid_checksum_for_digiview_message(const message &msg) {
+    crc8_running crc;
+    crc.update(reinterpret_cast<const uint8_t *>(&msg), offsetof(message, checksum));
+    return crc.value == msg.checksum;
+}
+
+struct sealing_writer {
+    explicit sealing_writer(message &target) : msg(target) {
+        crc.update(reinterpret_cast<const uint8_t *>(&msg), offsetof(message, data));
+    }
+
+    void put_bytes(const void *src, uint16_t n_bytes) {
+        const uint8_t *bytes = static_cast<const uint8_t *>(src);
+        for (uint16_t i = 0; i < n_bytes; ++i) {
+            msg.data[offset + i] = bytes[i];
+            crc.update(bytes[i]);
+        }
+        offset += n_bytes;
+    }
+
+    template <typename T>
+    void put(const T &value) {
+        put_bytes(&value, sizeof(T));
+    }
+
+    void put_milli(float value) {
+        put(static_cast<int32_t>(value * 1000.0f));
+    }
+
+    void put_s16_offset(float value) {
+        put(static_cast<int16_t>(value * S16_MAX_F));
+    }
+
+    void put_stream_name(std::string_view stream_name) {
+        const uint16_t name_len = static_cast<uint16_t>(std::min(stream_name.size(), static_cast<size_t>(STREAM_NAME_SIZE)));
+        put_bytes(stream_name.data(), name_len);
+        for (uint16_t i = name_len; i < STREAM_NAME_SIZE; ++i) {
+            put(static_cast<uint8_t>(0));
+        }
+    }
+
+    // Folds the untouched payload tail and stores the checksum.
+    void seal() {
+        crc.update(&msg.data[offset], PARAMCOUNT - offset);
+        msg.checksum = crc.value;
+    }
+
+    message &msg;
+    uint16_t offset = 0;
+    crc8_running crc;
+};
+
+inline void pack_and_seal_system_status_parameters(message &msg, app_status status, uint8_t error, float jetson_temp) {
+    msg.param_type = SYSTEM_STATUS;
+    sealing_writer writer(msg);
+    writer.put(enum_to_u8(status));
+    writer.put(error);
+    writer.put_milli(jetson_temp);
+    writer.seal();
+}
+
+inline void pack_and_seal_ai_parameters(message &msg, bool run_ai, const char *scan_model_name) {
+    msg.param_type = AI;
+    sealing_writer writer(msg);
+    writer.put(run_ai);
+    writer.put_bytes(scan_model_name, 16);
+    writer.seal();
+}
+
+inline void pack_and_seal_model_parameters(message &msg, const char *model_name) {
+    msg.param_type = MODEL;
+    sealing_writer writer(msg);
+    writer.put_bytes(model_name, 16);
+    writer.seal();
+}
+
+template <typename StreamName>
+inline void pack_and_seal_video_output_parameters(
+    message &msg, StreamName &&stream_name, uint16_t width, uint16_t height, uint8_t fps, uint8_t layout_mode, uint8_t detection_overlay_mode,
+    uint8_t num_user_views = 0, bounding_box *views = nullptr, bounding_box detection_overlay_box = {}, uint16_t single_detection_size = 0) {
+
+    msg.param_type = VIDEO_OUTPUT;
+    sealing_writer writer(msg);
+    writer.put_stream_name(stream_name_source_view(stream_name));
+    writer.put(width);
+    writer.put(height);
+    writer.put(fps);
+    writer.put(layout_mode);
+    writer.put(detection_overlay_mode);
+    writer.put(num_user_views);
+    if (views != nullptr) {
+        if (num_user_views > 4) num_user_views = 4;
+        for (uint8_t i = 0; i < num_user_views; i++) {
+            writer.put(views[i].x);
+            writer.put(views[i].y);
+            writer.put(views[i].w);
+            writer.put(views[i].h);
+        }
+    }
+    writer.put(detection_overlay_box);
+    writer.put(single_detection_size);
+    writer.seal();
+}
+
+template <typename StreamName>
+inline void pack_and_seal_capture_parameters(message &msg, StreamName &&stream_name, bool pic, bool vid, uint16_t num_pics = 0, uint16_t num_vids = 0) {
+    msg.param_type    = CAPTURE;
+    uint8_t cap_flags = 0x0;
+    cap_flags        |= static_cast<uint8_t>(pic ? CAP_FLAG_SINGLE_IMAGE : 0);
+    cap_flags        |= static_cast<uint8_t>(vid ? CAP_FLAG_VIDEO : 0);
+    sealing_writer writer(msg);
+    writer.put_stream_name(stream_name_source_view(stream_name));
+    writer.put(cap_flags);
+    writer.put(num_pics);
+    writer.put(num_vids);
+    writer.seal();
+}
+
+inline void pack_and_seal_detection_parameters(
+    message &msg, uint8_t mode, uint8_t sorting_mode, float track_confidence_threshold, float scan_confidence_threshold,
+    float track_box_overlap, float scan_box_overlap, uint8_t creation_score_scale, uint8_t bonus_detection_scale,
+    uint8_t bonus_redetection_scale, uint8_t missed_detection_penalty, uint8_t missed_redetection_penalty) {
+
+    msg.param_type = DETECTION;
+    sealing_writer writer(msg);
+    writer.put(mode);
+    writer.put(sorting_mode);
+    writer.put(static_cast<uint8_t>(track_confidence_threshold * 255.0f));
+    writer.put(static_cast<uint8_t>(scan_confidence_threshold * 255.0f));
+    writer.put(static_cast<uint8_t>(track_box_overlap * 255.0f));
+    writer.put(static_cast<uint8_t>(scan_box_overlap * 255.0f));
+    writer.put(creation_score_scale);
+    writer.put(bonus_detection_scale);
+    writer.put(bonus_redetection_scale);
+    writer.put(missed_detection_penalty);
+    writer.put(missed_redetection_penalty);
+    writer.seal();
+}
+
+inline void pack_and_seal_tracked_detection_parameters(
+    message &msg, uint8_t total_detections, uint8_t index, uint8_t score, int16_t type, float yaw_global, float pitch_global,
+    uint8_t rel_frame_of_reference, float yaw_rel, float pitch_rel, float lat, float lon, float alt, float dist, float width, float height,
+    uint16_t track_id = 0, uint64_t publish_timestamp_us = 0, uint8_t view_id = UINT8_MAX) {
+    msg.param_type = TRACKED_DETECTION;
+    sealing_writer writer(msg);
+    writer.put(index);
+    writer.put(score);
+    writer.put(total_detections);
+    writer.put(type);
+    writer.put_milli(yaw_global);
+    writer.put_milli(pitch_global);
+    writer.put(rel_frame_of_reference);
+    writer.put_milli(yaw_rel);
+    writer.put_milli(pitch_rel);
+    writer.put_milli(lat);
+    writer.put_milli(lon);
+    writer.put_milli(alt);
+    writer.put_milli(dist);
+    writer.put_milli(width);
+    writer.put_milli(height);
+    writer.put(track_id);
+    writer.put(publish_timestamp_us);
+    writer.put(view_id == UINT8_MAX ? static_cast<uint8_t>(0U) : static_cast<uint8_t>(view_id + 1U));
+    writer.seal();
+}
+
+template <typename StreamName>
+inline void pack_and_seal_cam_targeting_parameters(
+    message &msg, StreamName &&stream_name, uint8_t cam_id, View::TargetingMode targeting_mode, bool euler_delta, float yaw, float pitch, float roll,
+    uint8_t lock_flags, float x_offset, float y_offset, float target_latitude,
+    float target_longitude, float target_altitude, uint16_t track_id = 0, int16_t view_id = -1, bool lock_target = false) {
+    msg.param_type = CAM_TARGETING;
+    sealing_writer writer(msg);
+    writer.put_stream_name(stream_name_source_view(stream_name));
+    writer.put(cam_id);
+    writer.put(enum_to_u8(targeting_mode));
+    writer.put(euler_delta);
+    writer.put_milli(yaw);
+    writer.put_milli(pitch);
+    writer.put_milli(roll);
+    writer.put(lock_flags);
+    writer.put_s16_offset(x_offset);
+    writer.put_s16_offset(y_offset);
+    writer.put_milli(target_latitude);
+    writer.put_milli(target_longitude);
+    writer.put_milli(target_altitude);
+    writer.put(track_id);
+    writer.put(view_id);
+    writer.put(lock_target);
+    writer.seal();
+}
+
+template <typename StreamName>
+inline void pack_and_seal_cam_optics_and_control_parameters(
+    message &msg, StreamName &&stream_name, uint8_t cam_id, int8_t zoom, float fov) {
+    msg.param_type = CAM_OPTICS_AND_CONTROL;
+    sealing_writer writer(msg);
+    writer.put_stream_name(stream_name_source_view(stream_name));
+    writer.put(cam_id);
+    writer.put(zoom);
+    writer.put_milli(fov);
+    writer.seal();
+}
+
+template <typename StreamName>
+inline void pack_and_seal_cam_offset_parameters(
+    message &msg, StreamName &&stream_name, uint8_t cam, float x, float y, float yaw_global = 0, float pitch_global = 0, float yaw_rel = 0, float pitch_rel = 0) {
+    msg.param_type = CAM_OFFSET;
+    sealing_writer writer(msg);
+    writer.put_stream_name(stream_name_source_view(stream_name));
+    writer.put(cam);
+    writer.put_s16_offset(x);
+    writer.put_s16_offset(y);
+    writer.put_milli(yaw_global);
+    writer.put_milli(pitch_global);
+    writer.put_milli(yaw_rel);
+    writer.put_milli(pitch_rel);
+    writer.seal();
+}
+
+inline void pack_and_seal_sensor_parameters(
+    message &msg, uint32_t min_exposure, uint32_t max_exposure, uint32_t min_gain, uint32_t max_gain, float target_brightness) {
+    msg.param_type = SENSOR;
+    sealing_writer writer(msg);
+    writer.put(min_exposure);
+    writer.put(max_exposure);
+    writer.put(min_gain);
+    writer.put(max_gain);
+    writer.put_milli(target_brightness);
+    writer.seal();
+}
+
+template <typename StreamName>
+inline void pack_and_seal_cam_depth_estimation_parameters(message &msg, StreamName &&stream_name, uint8_t cam_id, uint8_t depth_estimation_mode, float depth) {
+    msg.param_type = CAM_DEPTH_ESTIMATION;
+    sealing_writer writer(msg);
+    writer.put_stream_name(stream_name_source_view(stream_name));
+    writer.put(cam_id);
+    writer.put(depth_estimation_mode);
+    writer.put_milli(depth);
+    writer.seal();
+}
+
+template <typename StreamName>
+inline void pack_and_seal_single_target_tracking_parameters(
+    message &msg, single_target_tracker_command command, StreamName &&stream_name, uint8_t cam_id, float x_offset, float y_offset,
+    uint8_t detection_id, uint16_t zoom_level, float confidence, float yaw_global, float pitch_global,
+    uint8_t rel_frame_of_reference, float yaw_rel, float pitch_rel, uint64_t publish_timestamp_us = 0,
+    single_target_tracking_status status = single_target_tracking_status::OFF, bool lock_target = false) {
+
+    msg.param_type = SINGLE_TARGET_TRACKING;
+    sealing_writer writer(msg);
+    writer.put(enum_to_u8(command));
+    writer.put_stream_name(stream_name_source_view(stream_name));
+    writer.put(cam_id);
+    writer.put_s16_offset(x_offset);
+    writer.put_s16_offset(y_offset);
+    writer.put(detection_id);
+    writer.put(zoom_level);
+    writer.put_milli(confidence);
+    writer.put_milli(yaw_global);
+    writer.put_milli(pitch_global);
+    writer.put(rel_frame_of_reference);
+    writer.put_milli(yaw_rel);
+    writer.put_milli(pitch_rel);
+    writer.put(publish_timestamp_us);
+    writer.put(enum_to_u8(status));
+    writer.put(static_cast<uint8_t>(lock_target ? 1U : 0U));
+    writer.seal();
+}
+
+inline void pack_and_seal_calibration_parameters(
+    message &msg, uint8_t cam_id, calibration_command calib_command, calibration_status calib_status,
+    uint8_t completed_face_mask, uint8_t mag_progress_percent) {
+    msg.param_type = CALIBRATION;
+    sealing_writer writer(msg);
+    writer.put(cam_id);
+    writer.put(enum_to_u8(calib_command));
+    writer.put(enum_to_u8(calib_status));
+    writer.put(completed_face_mask);
+    writer.put(mag_progress_percent);
+    writer.seal();
+}
+
+inline void pack_and_seal_navigation_parameters(
+    message &msg, float altitude, float visual_lat = 0.0f, float visual_lon = 0.0f,
+    float next_waypoint_target_yaw = 0.0f, float next_waypoint_target_pitch = 0.0f,
+    float next_waypoint_target_roll = 0.0f, float visual_vel_x = 0.0f,
+    float visual_vel_y = 0.0f, float visual_vel_z = 0.0f, float desired_thrust = 0.0f, uint8_t position_quality = 0U) {
+    msg.param_type = NAVIGATION;
+    sealing_writer writer(msg);
+    writer.put_milli(altitude);
+    writer.put_milli(visual_lat);
+    writer.put_milli(visual_lon);
+    writer.put_milli(next_waypoint_target_yaw);
+    writer.put_milli(next_waypoint_target_pitch);
+    writer.put_milli(next_waypoint_target_roll);
+    writer.put_milli(visual_vel_x);
+    writer.put_milli(visual_vel_y);
+    writer.put_milli(visual_vel_z);
+    writer.put_milli(desired_thrust);
+    writer.put(position_quality);
+    writer.seal();
+}
+
+template <typename StreamName>
+inline void pack_and_seal_bundle_parameters(
+    message &msg, StreamName &&stream_name, uint8_t cam_id, uint32_t requested_mask, uint32_t answered_mask = 0,
+    uint16_t frame_count = 0) {
+    msg.param_type = BUNDLE;
+    sealing_writer writer(msg);
+    writer.put_stream_name(stream_name_source_view(stream_name));
+    writer.put(cam_id);
+    writer.put(requested_mask);
+    writer.put(answered_mask);
+    writer.put(frame_count);
+    writer.seal();
+}
+
+inline void pack_and_seal_debug_parameters(
+    message &msg, int32_t param1 = 0, int32_t param2 = 0, int32_t param3 = 0, int32_t param4 = 0,
+    int32_t param5 = 0, int32_t param6 = 0, int32_t param7 = 0, int32_t param8 = 0) {
+    sealing_writer writer(msg);
+    writer.put(param1);
+    writer.put(param2);
+    writer.put(param3);
+    writer.put(param4);
+    writer.put(param5);
+    writer.put(param6);
+    writer.put(param7);
+    writer.put(param8);
+    writer.seal();
+}
+
+/*
+    Sealed SET variants for the high-rate control groups.
+*/
+inline void pack_and_seal_set_cam_targeting_parameters(
+    message &msg, const char *stream_name, uint8_t cam_id, View::TargetingMode targeting_mode, bool euler_delta, float yaw, float pitch, float roll,
+    uint8_t lock_flags, float x_offset, float y_offset, float target_latitude,
+    float target_longitude, float target_altitude, uint16_t track_id = 0, int16_t view_id = -1, bool lock_target = false, bool no_ack = false) {
+
+    msg.version      = VERSION;
+    msg.message_type = set_message_type(no_ack);
+    pack_and_seal_cam_targeting_parameters(
+        msg, stream_name, cam_id, targeting_mode, euler_delta, yaw, pitch, roll, lock_flags, x_offset, y_offset,
+        target_latitude, target_longitude, target_altitude, track_id, view_id, lock_target);
+}
+
+inline void pack_and_seal_set_single_target_tracking_parameters(
+    message &msg, single_target_tracker_command command, const char *stream_name, uint8_t cam_id, float x_offset, float y_offset,
+    uint8_t detection_id, uint16_t zoom_level, float confidence, float yaw_global, float pitch_global,
+    uint8_t rel_frame_of_reference, float yaw_rel, float pitch_rel, bool lock_target = false, bool no_ack = false) {
+    msg.version      = VERSION;
+    msg.message_type = set_message_type(no_ack);
+    pack_and_seal_single_target_tracking_parameters(msg, command, stream_name, cam_id, x_offset, y_offset,
+        detection_id, zoom_level, confidence, yaw_global, pitch_global, rel_frame_of_reference, yaw_rel, pitch_rel,
+        0, single_target_tracking_status::OFF, lock_target);
+}
+
 #endif // MSG_DEFS_HPP
 
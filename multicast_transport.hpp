@@ -0,0 +1,440 @@
+#pragma once
+
+#ifndef MULTICAST_TRANSPORT_HPP
+#define MULTICAST_TRANSPORT_HPP
+
+#include <cerrno>
+#include <cstring>
+#include <vector>
+#include <stdint.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "msg_defs.hpp"
+#include "stream_names.hpp"
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+
+/*
+------------------------------------------------------------------------------------------------------------------------
+    MULTICAST FAN-OUT
+
+    CURRENT_PARAMETERS frames can be distributed over IPv4 multicast. Each frame is then sent once per group instead
+    of once per subscriber, so the producer's cost does not grow with the number of clients. Frames are assigned to
+    groups either by param_type (base + param_type) or by stream (base + MULTICAST_STREAM_GROUP_OFFSET + a hash of
+    the stream name). All groups share one UDP port.
+
+    Stream groups are derived from the 16-byte stream name alone, so sender and subscribers agree on them without
+    sharing any state, whichever order each process happened to see the names in. Different names can hash to the
+    same group; a subscriber that wants exactly one stream filters on frame_stream_name().
+
+    The sender queues frames per group and writes a whole batch with one sendmmsg call. Where the kernel supports
+    UDP GSO, every group's batch goes out as a single message with UDP_SEGMENT = sizeof(message), so the stack is
+    traversed once per group and batch rather than once per frame. If GSO is unavailable the sender falls back to
+    one datagram per sendmmsg entry. Each datagram on the wire is still exactly one 96-byte message.
+
+    The receiver joins any set of groups and reads batches with recvmmsg. IP_MULTICAST_ALL is turned off, so a
+    socket only sees the groups it has joined itself, even when several subscribers on the same host share the port.
+
+    Neither class is thread-safe.
+------------------------------------------------------------------------------------------------------------------------
+*/
+static constexpr uint16_t MULTICAST_DEFAULT_PORT        = 47400;
+static constexpr uint32_t MULTICAST_PARAM_TYPE_GROUPS   = 32;
+static constexpr uint32_t MULTICAST_STREAM_GROUP_OFFSET = MULTICAST_PARAM_TYPE_GROUPS;
+static constexpr uint32_t MULTICAST_STREAM_GROUPS       = 256;
+static constexpr uint32_t MULTICAST_GROUPS              = MULTICAST_STREAM_GROUP_OFFSET + MULTICAST_STREAM_GROUPS;
+static constexpr uint32_t MULTICAST_MAX_BATCH           = 64;  // Kernel limit on GSO segments per send.
+
+enum MULTICAST_GROUPING : uint8_t {
+    GROUP_BY_PARAM_TYPE,
+    GROUP_BY_STREAM,
+};
+
+struct multicast_config {
+    const char         *group_base        = "239.255.76.0";  // Administratively scoped; group n is base + n.
+    const char         *interface_address = "0.0.0.0";       // Local interface used for sending and joining.
+    uint16_t            port              = MULTICAST_DEFAULT_PORT;
+    uint8_t             ttl               = 1;
+    bool                loopback          = true;            // Deliver to subscribers on the sending host too.
+    bool                gso               = true;
+    MULTICAST_GROUPING  grouping          = GROUP_BY_PARAM_TYPE;
+};
+
+/*
+    Group index of a stream under GROUP_BY_STREAM: FNV-1a over the zero-padded 16-byte name field, reduced with the
+    top bits of the hash. Part of the wire contract, so it must not change without changing the group base.
+*/
+inline uint32_t multicast_stream_group(std::string_view stream_name) {
+    uint8_t field[STREAM_NAME_SIZE];
+    copy_stream_name_field(field, stream_name.substr(0, stream_name.find('\0')));
+    uint32_t h = 2166136261U;
+    for (uint32_t i = 0; i < STREAM_NAME_SIZE; ++i) {
+        h ^= field[i];
+        h *= 16777619U;
+    }
+    const uint64_t scaled = static_cast<uint64_t>(h) * MULTICAST_STREAM_GROUPS;
+    return MULTICAST_STREAM_GROUP_OFFSET + static_cast<uint32_t>(scaled >> 32);
+}
+
+/*
+    Group index for a frame, or -1 if it has no group under the chosen grouping (for example GROUP_BY_STREAM and a
+    parameter type without a stream_name). Frames without a stream fall back to their param_type group.
+*/
+inline int32_t multicast_group_index(const message &msg, MULTICAST_GROUPING grouping) {
+    if (grouping == GROUP_BY_STREAM && stream_name_offset(msg.param_type) >= 0) {
+        return static_cast<int32_t>(multicast_stream_group(frame_stream_name(msg)));
+    }
+    return msg.param_type < MULTICAST_PARAM_TYPE_GROUPS ? msg.param_type : -1;
+}
+
+inline bool multicast_group_address(const multicast_config &config, uint32_t group, in_addr &out) {
+    in_addr base;
+    if (inet_pton(AF_INET, config.group_base, &base) != 1) return false;
+    out.s_addr = htonl(ntohl(base.s_addr) + group);
+    return true;
+}
+
+struct multicast_stats {
+    uint64_t frames;
+    uint64_t datagrams_failed;
+    uint64_t syscalls;
+    uint64_t dropped;   // Sender: frames without a group. Receiver: datagrams that were not one message.
+};
+
+class multicast_sender {
+public:
+    multicast_sender() = default;
+    multicast_sender(const multicast_sender &) = delete;
+    multicast_sender &operator=(const multicast_sender &) = delete;
+
+    ~multicast_sender() {
+        close();
+    }
+
+    bool open(const multicast_config &config) {
+        close();
+        config_ = config;
+        fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd_ < 0) return false;
+
+        in_addr interface;
+        const int ttl  = config.ttl;
+        const int loop = config.loopback ? 1 : 0;
+        if (inet_pton(AF_INET, config.interface_address, &interface) != 1 ||
+            setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_IF, &interface, sizeof(interface)) != 0 ||
+            setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) != 0 ||
+            setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) != 0) {
+            close();
+            return false;
+        }
+
+        destinations_.resize(MULTICAST_GROUPS);
+        for (uint32_t g = 0; g < MULTICAST_GROUPS; ++g) {
+            sockaddr_in &dest = destinations_[g];
+            memset(&dest, 0, sizeof(dest));
+            dest.sin_family = AF_INET;
+            dest.sin_port   = htons(config.port);
+            if (!multicast_group_address(config, g, dest.sin_addr)) {
+                close();
+                return false;
+            }
+        }
+        batches_.assign(MULTICAST_GROUPS, group_batch{});
+        active_.clear();
+        headers_.resize(MULTICAST_MAX_BATCH);
+        iovecs_.resize(MULTICAST_MAX_BATCH);
+        controls_.resize(MULTICAST_MAX_BATCH);
+        gso_   = config.gso;
+        stats_ = {};
+        return true;
+    }
+
+    void close() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    /*
+        Queues one frame for its group. A group's batch is sent as soon as it is full; call flush() at the end of
+        each burst so nothing waits in the queue.
+    */
+    bool send(const message &msg) {
+        const int32_t group = multicast_group_index(msg, config_.grouping);
+        if (group < 0) {
+            stats_.dropped++;
+            return false;
+        }
+        group_batch &batch = batches_[group];
+        if (batch.count == 0) active_.push_back(static_cast<uint16_t>(group));
+        memcpy(&batch.frames[batch.count++], &msg, sizeof(message));
+        if (batch.count == MULTICAST_MAX_BATCH) flush();
+        return true;
+    }
+
+    /*
+        Sends every queued frame. Returns false if any datagram could not be sent.
+    */
+    bool flush() {
+        bool ok = true;
+        uint32_t entries = 0;
+        for (uint16_t group : active_) {
+            group_batch &batch = batches_[group];
+            if (gso_ && batch.count > 1) {
+                add_entry(entries, group, batch.frames, batch.count);
+                if (entries == MULTICAST_MAX_BATCH) ok &= send_entries(entries);
+            } else {
+                for (uint32_t i = 0; i < batch.count; ++i) {
+                    add_entry(entries, group, &batch.frames[i], 1);
+                    if (entries == MULTICAST_MAX_BATCH) ok &= send_entries(entries);
+                }
+            }
+        }
+        if (entries != 0) ok &= send_entries(entries);
+        for (uint16_t group : active_) batches_[group].count = 0;
+        active_.clear();
+        return ok;
+    }
+
+    bool gso_active() const {
+        return gso_;
+    }
+
+    const multicast_stats &stats() const {
+        return stats_;
+    }
+
+private:
+    struct group_batch {
+        uint32_t count = 0;
+        message  frames[MULTICAST_MAX_BATCH];
+    };
+
+    union segment_control {
+        char    buffer[CMSG_SPACE(sizeof(uint16_t))];
+        cmsghdr align;
+    };
+
+    void add_entry(uint32_t &entries, uint16_t group, message *frames, uint32_t count) {
+        iovec &iov  = iovecs_[entries];
+        iov.iov_base = frames;
+        iov.iov_len  = static_cast<size_t>(count) * sizeof(message);
+
+        mmsghdr &entry = headers_[entries];
+        memset(&entry, 0, sizeof(entry));
+        entry.msg_hdr.msg_name    = &destinations_[group];
+        entry.msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        entry.msg_hdr.msg_iov     = &iov;
+        entry.msg_hdr.msg_iovlen  = 1;
+        if (count > 1) {
+            segment_control &control = controls_[entries];
+            entry.msg_hdr.msg_control    = control.buffer;
+            entry.msg_hdr.msg_controllen = sizeof(control.buffer);
+            cmsghdr *cmsg    = CMSG_FIRSTHDR(&entry.msg_hdr);
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type  = UDP_SEGMENT;
+            cmsg->cmsg_len   = CMSG_LEN(sizeof(uint16_t));
+            const uint16_t segment = sizeof(message);
+            memcpy(CMSG_DATA(cmsg), &segment, sizeof(segment));
+        }
+        entries++;
+    }
+
+    bool send_entries(uint32_t &entries) {
+        bool ok = true;
+        uint32_t sent = 0;
+        while (sent < entries) {
+            const int n = sendmmsg(fd_, &headers_[sent], entries - sent, 0);
+            stats_.syscalls++;
+            if (n > 0) {
+                for (int i = 0; i < n; ++i) stats_.frames += iovecs_[sent + i].iov_len / sizeof(message);
+                sent += static_cast<uint32_t>(n);
+                continue;
+            }
+            if (errno == EINTR) continue;
+            const bool segmented = headers_[sent].msg_hdr.msg_control != nullptr;
+            if (segmented && (errno == EIO || errno == EINVAL || errno == ENOPROTOOPT)) {
+                // No GSO on this route or kernel: send this entry's frames one by one and stop using GSO.
+                gso_ = false;
+                ok &= send_unsegmented(headers_[sent]);
+            } else {
+                stats_.datagrams_failed += iovecs_[sent].iov_len / sizeof(message);
+                ok = false;
+            }
+            sent++;
+        }
+        entries = 0;
+        return ok;
+    }
+
+    bool send_unsegmented(const mmsghdr &entry) {
+        const message *frames = static_cast<const message *>(entry.msg_hdr.msg_iov[0].iov_base);
+        const size_t   count  = entry.msg_hdr.msg_iov[0].iov_len / sizeof(message);
+        bool ok = true;
+        for (size_t i = 0; i < count; ++i) {
+            stats_.syscalls++;
+            if (sendto(fd_, &frames[i], sizeof(message), 0, static_cast<const sockaddr *>(entry.msg_hdr.msg_name),
+                       entry.msg_hdr.msg_namelen) == static_cast<ssize_t>(sizeof(message))) {
+                stats_.frames++;
+            } else {
+                stats_.datagrams_failed++;
+                ok = false;
+            }
+        }
+        return ok;
+    }
+
+    multicast_config             config_;
+    int                          fd_  = -1;
+    bool                         gso_ = true;
+    std::vector<sockaddr_in>     destinations_;
+    std::vector<group_batch>     batches_;
+    std::vector<uint16_t>        active_;
+    std::vector<mmsghdr>         headers_;
+    std::vector<iovec>           iovecs_;
+    std::vector<segment_control> controls_;
+    multicast_stats              stats_ = {};
+};
+
+class multicast_receiver {
+public:
+    multicast_receiver() = default;
+    multicast_receiver(const multicast_receiver &) = delete;
+    multicast_receiver &operator=(const multicast_receiver &) = delete;
+
+    ~multicast_receiver() {
+        close();
+    }
+
+    bool open(const multicast_config &config, uint32_t batch = MULTICAST_MAX_BATCH) {
+        close();
+        config_ = config;
+        fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd_ < 0) return false;
+
+        const int on  = 1;
+        const int off = 0;
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family      = AF_INET;
+        addr.sin_port        = htons(config.port);
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        if (setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) != 0 ||
+            setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_ALL, &off, sizeof(off)) != 0 ||
+            bind(fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+            close();
+            return false;
+        }
+
+        batch_ = batch < 1 ? 1 : batch;
+        frames_.resize(batch_);
+        headers_.resize(batch_);
+        iovecs_.resize(batch_);
+        for (uint32_t i = 0; i < batch_; ++i) {
+            // One spare byte per buffer so oversized datagrams are detected instead of silently truncated.
+            iovecs_[i].iov_base = &frames_[i];
+            iovecs_[i].iov_len  = sizeof(receive_buffer);
+            memset(&headers_[i], 0, sizeof(mmsghdr));
+            headers_[i].msg_hdr.msg_iov    = &iovecs_[i];
+            headers_[i].msg_hdr.msg_iovlen = 1;
+        }
+        joined_.assign(MULTICAST_GROUPS, false);
+        stats_ = {};
+        return true;
+    }
+
+    void close() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    /*
+        Joining a group that is already joined succeeds, since several streams can share one group.
+    */
+    bool join_group(uint32_t group) {
+        if (group >= MULTICAST_GROUPS) return false;
+        if (joined_[group]) return true;
+        ip_mreq request;
+        if (!multicast_group_address(config_, group, request.imr_multiaddr) ||
+            inet_pton(AF_INET, config_.interface_address, &request.imr_interface) != 1) {
+            return false;
+        }
+        if (setsockopt(fd_, IPPROTO_IP, IP_ADD_MEMBERSHIP, &request, sizeof(request)) != 0) return false;
+        joined_[group] = true;
+        return true;
+    }
+
+    bool join_param_type(uint8_t param_type) {
+        return param_type < MULTICAST_PARAM_TYPE_GROUPS && join_group(param_type);
+    }
+
+    bool join_stream(std::string_view stream_name) {
+        return join_group(multicast_stream_group(stream_name));
+    }
+
+    bool join_stream(stream_name_id id) {
+        return id.value < stream_name_table::CAPACITY && join_stream(stream_name_source_view(id));
+    }
+
+    /*
+        Waits up to timeout_ms (-1 = forever) for at least one frame, then drains up to one batch without further
+        waiting and calls handler(const message &) for each frame. Returns the number of frames delivered, or -1 on a
+        socket error.
+    */
+    template <typename Handler>
+    int receive(Handler &&handler, int timeout_ms = -1) {
+        if (timeout_ms != last_timeout_ms_) {
+            timeval tv;
+            tv.tv_sec  = timeout_ms < 0 ? 0 : timeout_ms / 1000;
+            tv.tv_usec = timeout_ms < 0 ? 0 : (timeout_ms % 1000) * 1000;
+            setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            last_timeout_ms_ = timeout_ms;
+        }
+        const int n = recvmmsg(fd_, headers_.data(), batch_, MSG_WAITFORONE, nullptr);
+        stats_.syscalls++;
+        if (n < 0) return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+        int delivered = 0;
+        for (int i = 0; i < n; ++i) {
+            if (headers_[i].msg_len != sizeof(message)) {
+                stats_.dropped++;
+                continue;
+            }
+            stats_.frames++;
+            delivered++;
+            handler(frames_[i].frame);
+        }
+        return delivered;
+    }
+
+    const multicast_stats &stats() const {
+        return stats_;
+    }
+
+private:
+    struct receive_buffer {
+        message frame;
+        uint8_t overflow;
+    };
+
+    multicast_config             config_;
+    int                          fd_    = -1;
+    uint32_t                     batch_ = 0;
+    int                          last_timeout_ms_ = -2;
+    std::vector<receive_buffer>  frames_;
+    std::vector<mmsghdr>         headers_;
+    std::vector<iovec>           iovecs_;
+    std::vector<bool>            joined_;
+    multicast_stats              stats_ = {};
+};
+
+#endif // MULTICAST_TRANSPORT_HPP
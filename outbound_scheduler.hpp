@@ -0,0 +1,279 @@
+#pragma once
+
+#ifndef OUTBOUND_SCHEDULER_HPP
+#define OUTBOUND_SCHEDULER_HPP
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+#include <stdint.h>
+
+#include "msg_defs.hpp"
+
+/*
+------------------------------------------------------------------------------------------------------------------------
+    OUTBOUND SCHEDULER
+
+    Separates control traffic from bulk telemetry on one connection. Every outgoing frame gets a traffic class and
+    waits in that class's lock-free queue. A single sender thread calls run_tick() once per link tick. The byte
+    budget is a token bucket: each tick adds byte_budget_per_tick, unused bytes carry over up to byte_burst, and a
+    frame goes out when the bucket holds its cost. Frames are taken either by strict priority or by weighted round
+    robin: each round a class may send weights[c] frames, classes are served in priority order within the round, and
+    a new round starts once every class with waiting frames has used its share. All frames cost the same, so this is
+    deficit round robin with a quantum of weights[c] frames.
+
+    Default classes:
+        TRAFFIC_CONTROL    QUIT, CREDIT, and SETs of CAM_TARGETING, SINGLE_TARGET_TRACKING, CAM_OPTICS_AND_CONTROL and
+                           SYSTEM_STATUS (halt/reboot)
+        TRAFFIC_TELEMETRY  CURRENT_PARAMETERS of DETECTION and TRACKED_DETECTION, and recurring GETs (interval_ms > 0)
+        TRAFFIC_NORMAL     everything else (one-off GETs, other SETs, acknowledgements and error replies)
+    set_class() overrides the class for any MESSAGE_TYPE x PARAM_TYPE pair.
+
+    Queues are bounded multi-producer single-consumer rings. enqueue() may be called from any thread; run_tick()
+    must only be called from one thread at a time.
+------------------------------------------------------------------------------------------------------------------------
+*/
+enum TRAFFIC_CLASS : uint8_t {
+    TRAFFIC_CONTROL,
+    TRAFFIC_NORMAL,
+    TRAFFIC_TELEMETRY,
+    TRAFFIC_CLASSES,
+};
+
+inline TRAFFIC_CLASS default_traffic_class(const message &msg) {
+    if (msg.message_type == QUIT || msg.message_type == CREDIT || msg.message_type == RELIABLE_STATUS) {
+        return TRAFFIC_CONTROL;
+    }
+    if (is_set_message(msg.message_type)) {
+        switch (msg.param_type) {
+            case CAM_TARGETING:
+            case SINGLE_TARGET_TRACKING:
+            case CAM_OPTICS_AND_CONTROL:
+            case SYSTEM_STATUS:
+                return TRAFFIC_CONTROL;
+            default:
+                return TRAFFIC_NORMAL;
+        }
+    }
+    if (msg.message_type == CURRENT_PARAMETERS &&
+        (msg.param_type == DETECTION || msg.param_type == TRACKED_DETECTION)) {
+        return TRAFFIC_TELEMETRY;
+    }
+    if (msg.message_type == GET_PARAMETERS && msg.interval_ms > 0) return TRAFFIC_TELEMETRY;
+    return TRAFFIC_NORMAL;
+}
+
+enum SCHEDULING_POLICY : uint8_t {
+    SCHEDULE_STRICT_PRIORITY,
+    SCHEDULE_WEIGHTED,
+};
+
+struct outbound_scheduler_config {
+    uint32_t          queue_capacity = 1024;                  // Per class, rounded up to a power of two.
+    SCHEDULING_POLICY policy         = SCHEDULE_STRICT_PRIORITY;
+    uint32_t          weights[TRAFFIC_CLASSES] = {8, 4, 1};   // Weighted policy: frames per round for each class.
+    uint32_t          byte_budget_per_tick = 0;               // 0 = unlimited.
+    uint32_t          byte_burst           = 0;               // Bucket cap; 0 = one tick's budget, at least a frame.
+    uint32_t          frame_overhead       = 0;               // Link bytes charged per frame on top of sizeof(message).
+};
+
+struct outbound_class_stats {
+    uint64_t enqueued;
+    uint64_t sent;
+    uint64_t dropped;   // Queue full.
+};
+
+class outbound_scheduler {
+public:
+    explicit outbound_scheduler(const outbound_scheduler_config &config = outbound_scheduler_config())
+        : config_(config), overrides_(1U << 16, NO_OVERRIDE) {
+        uint32_t capacity = 2;
+        while (capacity < config.queue_capacity) capacity <<= 1;
+        for (class_queue &queue : queues_) queue.init(capacity);
+    }
+
+    outbound_scheduler(const outbound_scheduler &) = delete;
+    outbound_scheduler &operator=(const outbound_scheduler &) = delete;
+
+    /*
+        Overrides the class of every frame with this message_type and param_type. Not thread-safe with enqueue();
+        configure before traffic starts.
+    */
+    void set_class(uint8_t message_type, uint8_t param_type, TRAFFIC_CLASS traffic_class) {
+        overrides_[(static_cast<uint32_t>(message_type) << 8) | param_type] = traffic_class;
+    }
+
+    TRAFFIC_CLASS class_of(const message &msg) const {
+        const uint8_t forced = overrides_[(static_cast<uint32_t>(msg.message_type) << 8) | msg.param_type];
+        return forced == NO_OVERRIDE ? default_traffic_class(msg) : static_cast<TRAFFIC_CLASS>(forced);
+    }
+
+    /*
+        Queues a frame in its class. Returns false if that class's queue is full.
+    */
+    bool enqueue(const message &msg) {
+        return enqueue(msg, class_of(msg));
+    }
+
+    bool enqueue(const message &msg, TRAFFIC_CLASS traffic_class) {
+        class_queue &queue = queues_[traffic_class];
+        if (!queue.push(msg)) {
+            queue.dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        queue.enqueued.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /*
+        Sends queued frames through send(const message &, TRAFFIC_CLASS), which returns false if the link cannot
+        take more right now. Adds this tick's budget to the bucket, then stops when the bucket cannot pay for another
+        frame, the link refuses a frame or every queue is empty. Returns the number of frames sent.
+    */
+    template <typename Sender>
+    uint32_t run_tick(Sender &&send) {
+        const uint64_t cost = sizeof(message) + config_.frame_overhead;
+        uint64_t budget = UINT64_MAX;
+        if (config_.byte_budget_per_tick != 0) {
+            // Never below one frame, or a budget smaller than a frame could not send anything.
+            uint64_t cap = config_.byte_burst != 0 ? config_.byte_burst : config_.byte_budget_per_tick;
+            if (cap < cost) cap = cost;
+            tokens_ += config_.byte_budget_per_tick;
+            if (tokens_ > cap) tokens_ = cap;
+            budget = tokens_;
+        }
+        uint32_t sent = 0;
+        while (budget >= cost) {
+            const int32_t c = next_class();
+            if (c < 0) break;
+            class_queue &queue = queues_[c];
+            if (!queue.front_ready()) break;
+            if (!send(queue.front(), static_cast<TRAFFIC_CLASS>(c))) break;
+            queue.pop();
+            queue.sent.fetch_add(1, std::memory_order_relaxed);
+            if (config_.policy == SCHEDULE_WEIGHTED) credits_[c]--;
+            budget -= cost;
+            sent++;
+        }
+        if (config_.byte_budget_per_tick != 0) tokens_ = budget;
+        return sent;
+    }
+
+    /*
+        Frames waiting in a class. Approximate while producers are active.
+    */
+    uint64_t depth(TRAFFIC_CLASS traffic_class) const {
+        const class_queue &queue = queues_[traffic_class];
+        return queue.enqueued.load(std::memory_order_relaxed) - queue.sent.load(std::memory_order_relaxed);
+    }
+
+    outbound_class_stats stats(TRAFFIC_CLASS traffic_class) const {
+        const class_queue &queue = queues_[traffic_class];
+        return {queue.enqueued.load(std::memory_order_relaxed), queue.sent.load(std::memory_order_relaxed),
+                queue.dropped.load(std::memory_order_relaxed)};
+    }
+
+private:
+    static constexpr uint8_t NO_OVERRIDE = 0xFF;
+
+    // Bounded MPSC ring (Vyukov), the same scheme the capture recorder uses.
+    struct class_queue {
+        struct alignas(64) slot {
+            std::atomic<uint64_t> sequence;
+            message               frame;
+        };
+
+        class_queue() = default;
+        class_queue(const class_queue &) = delete;
+        class_queue &operator=(const class_queue &) = delete;
+
+        ~class_queue() {
+            free(slots);
+        }
+
+        void init(uint32_t capacity) {
+            mask  = capacity - 1;
+            slots = static_cast<slot *>(aligned_alloc(alignof(slot), sizeof(slot) * capacity));
+            if (slots == nullptr) throw std::bad_alloc();
+            for (uint32_t i = 0; i < capacity; ++i) {
+                new (&slots[i].sequence) std::atomic<uint64_t>(i);
+            }
+        }
+
+        bool push(const message &msg) {
+            uint64_t pos = enqueue_pos.load(std::memory_order_relaxed);
+            slot *s;
+            for (;;) {
+                s = &slots[pos & mask];
+                const uint64_t seq = s->sequence.load(std::memory_order_acquire);
+                const int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+                if (diff == 0) {
+                    if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = enqueue_pos.load(std::memory_order_relaxed);
+                }
+            }
+            memcpy(&s->frame, &msg, sizeof(message));
+            s->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool front_ready() const {
+            return slots[dequeue_pos & mask].sequence.load(std::memory_order_acquire) == dequeue_pos + 1;
+        }
+
+        const message &front() const {
+            return slots[dequeue_pos & mask].frame;
+        }
+
+        void pop() {
+            slots[dequeue_pos & mask].sequence.store(dequeue_pos + mask + 1, std::memory_order_release);
+            dequeue_pos++;
+        }
+
+        slot                              *slots = nullptr;
+        uint64_t                           mask  = 0;
+        alignas(64) std::atomic<uint64_t>  enqueue_pos{0};
+        alignas(64) uint64_t               dequeue_pos = 0;
+        std::atomic<uint64_t>              enqueued{0};
+        std::atomic<uint64_t>              sent{0};
+        std::atomic<uint64_t>              dropped{0};
+    };
+
+    int32_t next_class() {
+        if (config_.policy == SCHEDULE_STRICT_PRIORITY) {
+            for (uint32_t c = 0; c < TRAFFIC_CLASSES; ++c) {
+                if (queues_[c].front_ready()) return static_cast<int32_t>(c);
+            }
+            return -1;
+        }
+
+        // Weighted round robin: serve classes in priority order while they have credits; start a new round when every
+        // ready class is out.
+        for (int pass = 0; pass < 2; ++pass) {
+            bool any_ready = false;
+            for (uint32_t c = 0; c < TRAFFIC_CLASSES; ++c) {
+                if (!queues_[c].front_ready()) continue;
+                any_ready = true;
+                if (credits_[c] > 0) return static_cast<int32_t>(c);
+            }
+            if (!any_ready) return -1;
+            for (uint32_t c = 0; c < TRAFFIC_CLASSES; ++c) {
+                credits_[c] = config_.weights[c] == 0 ? 1 : config_.weights[c];
+            }
+        }
+        return -1;
+    }
+
+    outbound_scheduler_config  config_;
+    std::vector<uint8_t>       overrides_;
+    class_queue                queues_[TRAFFIC_CLASSES];
+    uint32_t                   credits_[TRAFFIC_CLASSES] = {};
+    uint64_t                   tokens_ = 0;
+};
+
+#endif // OUTBOUND_SCHEDULER_HPP
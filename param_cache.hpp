@@ -0,0 +1,192 @@
+#pragma once
+
+#ifndef PARAM_CACHE_HPP
+#define PARAM_CACHE_HPP
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <stdint.h>
+
+#include "msg_defs.hpp"
+
+/*
+------------------------------------------------------------------------------------------------------------------------
+    PARAMETER CACHE
+
+    Last-value cache of CURRENT_PARAMETERS frames keyed by (param_type, stream_name, cam_id). Each entry is guarded by
+    a seqlock. Writers take the entry by making its sequence odd, store the frame and make it even again. Readers
+    copy the frame and retry if the sequence moved, so they never lock or allocate. The entry version is the number of
+    publishes (sequence / 2); consumers compare it to skip frames they have already seen.
+
+    The table has a fixed capacity chosen at construction. Keys are never removed.
+------------------------------------------------------------------------------------------------------------------------
+*/
+struct param_cache_key {
+    uint8_t param_type;
+    uint8_t cam_id;
+    char    stream_name[STREAM_NAME_SIZE];
+};
+
+inline param_cache_key make_param_cache_key(uint8_t param_type, std::string_view stream_name = {}, uint8_t cam_id = 255) {
+    param_cache_key key;
+    key.param_type = param_type;
+    key.cam_id     = cam_id;
+    copy_stream_name_field(reinterpret_cast<uint8_t *>(key.stream_name), stream_name);
+    return key;
+}
+
+inline param_cache_key make_param_cache_key(const message &frame) {
+    return make_param_cache_key(frame.param_type, frame_stream_name(frame), frame_cam_id(frame));
+}
+
+inline uint32_t param_cache_hash(const param_cache_key &key) {
+    uint32_t h = 2166136261U;
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&key);
+    for (size_t i = 0; i < sizeof(param_cache_key); ++i) {
+        h ^= bytes[i];
+        h *= 16777619U;
+    }
+    return h;
+}
+
+class param_cache {
+public:
+    static constexpr uint32_t FRAME_WORDS = (sizeof(message) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    struct alignas(64) entry {
+        std::atomic<uint32_t> state{EMPTY};
+        param_cache_key       key;
+        std::atomic<uint64_t> sequence{0};
+        std::atomic<uint64_t> words[FRAME_WORDS];
+    };
+
+    explicit param_cache(uint32_t capacity = 256) {
+        uint32_t size = 1;
+        while (size < capacity * 2) size <<= 1;
+        mask_    = size - 1;
+        entries_ = std::unique_ptr<entry[]>(new entry[size]);
+    }
+
+    /*
+        Returns the entry for key, or nullptr if it has never been published. The pointer stays valid for the lifetime
+        of the cache, so hot readers can resolve it once and call read() on it directly. A slot whose key is READY but
+        whose first publish has not completed (version 0) is treated as absent.
+    */
+    const entry *find(const param_cache_key &key) const {
+        for (uint32_t i = param_cache_hash(key) & mask_, probes = 0; probes <= mask_; i = (i + 1) & mask_, ++probes) {
+            const entry &e = entries_[i];
+            const uint32_t state = e.state.load(std::memory_order_acquire);
+            if (state == EMPTY) return nullptr;
+            if (state == READY && memcmp(&e.key, &key, sizeof(param_cache_key)) == 0) {
+                return version(e) != 0 ? &e : nullptr;
+            }
+        }
+        return nullptr;
+    }
+
+    /*
+        Stores frame as the latest value for its key. Returns false if the table is full.
+    */
+    bool publish(const message &frame) {
+        return publish(make_param_cache_key(frame), frame);
+    }
+
+    bool publish(const param_cache_key &key, const message &frame) {
+        entry *e = find_or_insert(key);
+        if (e == nullptr) return false;
+
+        uint64_t seq = e->sequence.load(std::memory_order_relaxed);
+        for (;;) {
+            if ((seq & 1) == 0 &&
+                e->sequence.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+                break;
+            }
+            seq = e->sequence.load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+
+        uint64_t words[FRAME_WORDS] = {};
+        memcpy(words, &frame, sizeof(message));
+        for (uint32_t i = 0; i < FRAME_WORDS; ++i) {
+            e->words[i].store(words[i], std::memory_order_relaxed);
+        }
+        e->sequence.store(seq + 2, std::memory_order_release);
+        return true;
+    }
+
+    /*
+        Copies a consistent snapshot of the entry. version is 0 if nothing has been published yet.
+    */
+    static bool read(const entry &e, message &out, uint64_t &version) {
+        uint64_t words[FRAME_WORDS];
+        for (;;) {
+            const uint64_t before = e.sequence.load(std::memory_order_acquire);
+            if (before & 1) continue;
+            for (uint32_t i = 0; i < FRAME_WORDS; ++i) {
+                words[i] = e.words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (e.sequence.load(std::memory_order_relaxed) == before) {
+                version = before / 2;
+                break;
+            }
+        }
+        memcpy(&out, words, sizeof(message));
+        return version != 0;
+    }
+
+    bool read(const param_cache_key &key, message &out, uint64_t &version) const {
+        const entry *e = find(key);
+        if (e == nullptr) return false;
+        return read(*e, out, version);
+    }
+
+    /*
+        Copies the entry only if its version differs from last_version, then updates last_version.
+    */
+    static bool read_if_changed(const entry &e, message &out, uint64_t &last_version) {
+        if (e.sequence.load(std::memory_order_acquire) / 2 == last_version) return false;
+        uint64_t version;
+        if (!read(e, out, version) || version == last_version) return false;
+        last_version = version;
+        return true;
+    }
+
+    static uint64_t version(const entry &e) {
+        return e.sequence.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    enum : uint32_t {
+        EMPTY,
+        CLAIMED,
+        READY,
+    };
+
+    entry *find_or_insert(const param_cache_key &key) {
+        for (uint32_t i = param_cache_hash(key) & mask_, probes = 0; probes <= mask_; i = (i + 1) & mask_, ++probes) {
+            entry &e = entries_[i];
+            uint32_t state = e.state.load(std::memory_order_acquire);
+            if (state == EMPTY) {
+                if (e.state.compare_exchange_strong(state, CLAIMED, std::memory_order_acquire)) {
+                    e.key = key;
+                    e.state.store(READY, std::memory_order_release);
+                    return &e;
+                }
+            }
+            // Another writer may be claiming this slot; wait until its key is visible.
+            while (state == CLAIMED) {
+                state = e.state.load(std::memory_order_acquire);
+            }
+            if (memcmp(&e.key, &key, sizeof(param_cache_key)) == 0) return &e;
+        }
+        return nullptr;
+    }
+
+    uint32_t                  mask_ = 0;
+    std::unique_ptr<entry[]>  entries_;
+};
+
+#endif // PARAM_CACHE_HPP
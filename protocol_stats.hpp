@@ -0,0 +1,222 @@
+#pragma once
+
+#ifndef PROTOCOL_STATS_HPP
+#define PROTOCOL_STATS_HPP
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <stdint.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "msg_defs.hpp"
+
+/*
+------------------------------------------------------------------------------------------------------------------------
+    PROTOCOL STATISTICS PAGE
+
+    Hot-path counters kept in a named POSIX shared-memory object (/dev/shm/digiview_stats_<name>). External tools can
+    watch them without attaching to the process (see tools/stats_top.cpp). For every direction x MESSAGE_TYPE x
+    PARAM_TYPE there is one cell with frame, byte, checksum-error and validation-failure counts. Cells are padded to
+    a cache line so threads updating different cells do not share lines.
+
+    Recording is a relaxed atomic add on mapped memory: no locks and no system calls. The page starts with a
+    versioned header describing its layout; readers must check it before reading cells.
+------------------------------------------------------------------------------------------------------------------------
+*/
+static constexpr uint32_t PROTOCOL_STATS_MAGIC          = 0x53535644; // "DVSS"
+static constexpr uint16_t PROTOCOL_STATS_LAYOUT_VERSION = 4;
+static constexpr uint32_t PROTOCOL_STATS_DIRECTIONS     = 2;
+static constexpr uint32_t PROTOCOL_STATS_MESSAGE_SLOTS  = 16;  // EMPTY .. RELIABLE_STATUS, QUIT, other.
+static constexpr uint32_t PROTOCOL_STATS_PARAM_SLOTS    = 32;  // param_type values >= 31 share the last slot.
+
+enum STATS_DIRECTION : uint8_t {
+    STATS_RECEIVED,
+    STATS_SENT,
+};
+
+struct alignas(64) protocol_stats_cell {
+    std::atomic<uint64_t> frames;
+    std::atomic<uint64_t> bytes;
+    std::atomic<uint64_t> checksum_errors;
+    std::atomic<uint64_t> validation_failures;
+};
+
+struct protocol_stats_header {
+    uint32_t magic;
+    uint16_t layout_version;
+    uint16_t cell_size;
+    uint32_t directions;
+    uint32_t message_slots;
+    uint32_t param_slots;
+    uint32_t reserved;
+    uint64_t created_us;
+    char     name[32];
+};
+
+struct protocol_stats_layout {
+    alignas(64) protocol_stats_header header;
+    protocol_stats_cell cells[PROTOCOL_STATS_DIRECTIONS][PROTOCOL_STATS_MESSAGE_SLOTS][PROTOCOL_STATS_PARAM_SLOTS];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared-memory counters need lock-free 64-bit atomics");
+
+inline uint32_t protocol_stats_message_slot(uint8_t message_type) {
+    if (message_type <= RELIABLE_STATUS) return message_type;
+    return message_type == QUIT ? RELIABLE_STATUS + 1 : RELIABLE_STATUS + 2;
+}
+
+inline uint32_t protocol_stats_param_slot(uint8_t param_type) {
+    return param_type < PROTOCOL_STATS_PARAM_SLOTS ? param_type : PROTOCOL_STATS_PARAM_SLOTS - 1;
+}
+
+inline void protocol_stats_object_name(const char *name, char (&out)[64]) {
+    snprintf(out, sizeof(out), "/digiview_stats_%s", name);
+}
+
+class protocol_stats {
+public:
+    protocol_stats() = default;
+    protocol_stats(const protocol_stats &) = delete;
+    protocol_stats &operator=(const protocol_stats &) = delete;
+
+    ~protocol_stats() {
+        close();
+    }
+
+    /*
+        Creates (or resets) the named page for writing. Returns false if shared memory is unavailable.
+    */
+    bool create(const char *name) {
+        close();
+        char object[64];
+        protocol_stats_object_name(name, object);
+        const int fd = shm_open(object, O_RDWR | O_CREAT, 0644);
+        if (fd < 0) return false;
+        if (ftruncate(fd, sizeof(protocol_stats_layout)) != 0) {
+            ::close(fd);
+            return false;
+        }
+        if (!map(fd, PROT_READ | PROT_WRITE)) return false;
+
+        memset(static_cast<void *>(page_), 0, sizeof(protocol_stats_layout));
+        protocol_stats_header &header = page_->header;
+        header.layout_version = PROTOCOL_STATS_LAYOUT_VERSION;
+        header.cell_size      = sizeof(protocol_stats_cell);
+        header.directions     = PROTOCOL_STATS_DIRECTIONS;
+        header.message_slots  = PROTOCOL_STATS_MESSAGE_SLOTS;
+        header.param_slots    = PROTOCOL_STATS_PARAM_SLOTS;
+        timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        header.created_us     = static_cast<uint64_t>(ts.tv_sec) * 1000000ULL + static_cast<uint64_t>(ts.tv_nsec) / 1000ULL;
+        snprintf(header.name, sizeof(header.name), "%s", name);
+        // Publish the magic last so readers never see a half-initialised page.
+        std::atomic_thread_fence(std::memory_order_release);
+        reinterpret_cast<std::atomic<uint32_t> *>(&header.magic)->store(PROTOCOL_STATS_MAGIC, std::memory_order_release);
+        return true;
+    }
+
+    /*
+        Maps an existing page read-only. Returns false if it is missing, smaller than the layout, or its layout does
+        not match this build.
+    */
+    bool open_readonly(const char *name) {
+        close();
+        char object[64];
+        protocol_stats_object_name(name, object);
+        const int fd = shm_open(object, O_RDONLY, 0);
+        if (fd < 0) return false;
+        // A writer that has not sized the object yet, or a foreign object, would fault on first access.
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(protocol_stats_layout))) {
+            ::close(fd);
+            return false;
+        }
+        if (!map(fd, PROT_READ)) return false;
+        const protocol_stats_header &header = page_->header;
+        if (header.magic != PROTOCOL_STATS_MAGIC || header.layout_version != PROTOCOL_STATS_LAYOUT_VERSION ||
+            header.cell_size != sizeof(protocol_stats_cell) || header.directions != PROTOCOL_STATS_DIRECTIONS ||
+            header.message_slots != PROTOCOL_STATS_MESSAGE_SLOTS || header.param_slots != PROTOCOL_STATS_PARAM_SLOTS) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (page_ != nullptr) {
+            munmap(page_, sizeof(protocol_stats_layout));
+            page_ = nullptr;
+        }
+    }
+
+    /*
+        Removes the named object. Mapped pages stay valid until they are closed.
+    */
+    static void unlink(const char *name) {
+        char object[64];
+        protocol_stats_object_name(name, object);
+        shm_unlink(object);
+    }
+
+    bool is_open() const {
+        return page_ != nullptr;
+    }
+
+    void record_frame(STATS_DIRECTION direction, const message &msg, uint32_t bytes = sizeof(message)) {
+        if (page_ == nullptr) return;
+        protocol_stats_cell &c = cell_for(direction, msg);
+        c.frames.fetch_add(1, std::memory_order_relaxed);
+        c.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void record_checksum_error(STATS_DIRECTION direction, const message &msg) {
+        if (page_ == nullptr) return;
+        cell_for(direction, msg).checksum_errors.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void record_validation_failure(STATS_DIRECTION direction, const message &msg) {
+        if (page_ == nullptr) return;
+        cell_for(direction, msg).validation_failures.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /*
+        Counts a received frame and checks its checksum. Returns the checksum result.
+    */
+    bool record_received(const message &msg) {
+        record_frame(STATS_RECEIVED, msg);
+        const bool valid = has_valid_checksum_for_digiview_message(msg);
+        if (!valid) record_checksum_error(STATS_RECEIVED, msg);
+        return valid;
+    }
+
+    const protocol_stats_cell &cell(STATS_DIRECTION direction, uint32_t message_slot, uint32_t param_slot) const {
+        return page_->cells[direction][message_slot][param_slot];
+    }
+
+    const protocol_stats_header &header() const {
+        return page_->header;
+    }
+
+private:
+    bool map(int fd, int protection) {
+        void *mapped = mmap(nullptr, sizeof(protocol_stats_layout), protection, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) return false;
+        page_ = static_cast<protocol_stats_layout *>(mapped);
+        return true;
+    }
+
+    protocol_stats_cell &cell_for(STATS_DIRECTION direction, const message &msg) {
+        return page_->cells[direction][protocol_stats_message_slot(msg.message_type)][protocol_stats_param_slot(msg.param_type)];
+    }
+
+    protocol_stats_layout *page_ = nullptr;
+};
+
+#endif // PROTOCOL_STATS_HPP
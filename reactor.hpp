@@ -0,0 +1,465 @@
+#pragma once
+
+#ifndef REACTOR_HPP
+#define REACTOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "msg_defs.hpp"
+
+/*
+------------------------------------------------------------------------------------------------------------------------
+    CONNECTION REACTOR
+
+    Multiplexes many DigiView unit connections on one thread with epoll. Two kinds of connection are supported:
+
+        stream    a connected byte stream (TCP, UNIX stream, serial bridge). Each connection has an incremental
+                  parser: bytes go into a fixed receive buffer and whole 96-byte frames are cut from it, so partial
+                  reads are handled without allocating;
+        datagram  a connected UDP socket, where one datagram is one frame. Datagrams are drained with recvmmsg.
+
+    Frames with a bad checksum or the wrong size are counted and dropped. Every buffer is allocated when the reactor
+    is constructed. send() writes straight to the socket; whatever a stream socket does not take waits in the
+    connection's transmit ring until EPOLLOUT, and frames that do not fit are dropped and counted.
+
+    Each connection is read for at most config.read_budget frames per wakeup, so one busy unit cannot starve the
+    others. A reactor is driven by one thread: every call except wake() belongs on that thread.
+
+    sharded_reactor runs N reactors on N threads and spreads connections across them by unit_id.
+------------------------------------------------------------------------------------------------------------------------
+*/
+struct reactor_config {
+    uint32_t max_connections = 1024;
+    uint32_t rx_buffer_frames = 16;   // Per stream connection.
+    uint32_t tx_buffer_frames = 64;   // Per stream connection.
+    uint32_t read_budget      = 32;   // Frames read from one connection per wakeup.
+    uint32_t max_events       = 256;
+};
+
+struct reactor_connection_stats {
+    uint64_t frames_in;
+    uint64_t frames_out;
+    uint64_t checksum_errors;
+    uint64_t malformed;     // Datagrams that were not exactly one frame.
+    uint64_t tx_dropped;    // Frames refused because the transmit ring was full or the socket would block.
+};
+
+class reactor {
+public:
+    static constexpr uint32_t MAX_DATAGRAM_BATCH = 16;
+
+    explicit reactor(const reactor_config &config = reactor_config())
+        : config_(config), connections_(config.max_connections), events_(config.max_events) {
+        if (config_.rx_buffer_frames == 0) config_.rx_buffer_frames = 1;
+        if (config_.tx_buffer_frames == 0) config_.tx_buffer_frames = 1;
+        const size_t rx_bytes = static_cast<size_t>(config_.rx_buffer_frames) * sizeof(message);
+        const size_t tx_bytes = static_cast<size_t>(config_.tx_buffer_frames) * sizeof(message);
+        buffers_.reset(new uint8_t[(rx_bytes + tx_bytes) * config.max_connections]);
+        free_.reserve(config.max_connections);
+        for (uint32_t i = 0; i < config.max_connections; ++i) {
+            connection &c = connections_[i];
+            c.rx          = &buffers_[(rx_bytes + tx_bytes) * i];
+            c.tx          = c.rx + rx_bytes;
+            c.rx_capacity = static_cast<uint32_t>(rx_bytes);
+            c.tx_capacity = static_cast<uint32_t>(tx_bytes);
+            free_.push_back(config.max_connections - 1 - i);
+        }
+        for (uint32_t i = 0; i < MAX_DATAGRAM_BATCH; ++i) {
+            iov_[i].iov_base             = &datagrams_[i];
+            iov_[i].iov_len              = sizeof(message) + 1;   // One spare byte detects oversized datagrams.
+            batch_[i].msg_hdr            = {};
+            batch_[i].msg_hdr.msg_iov    = &iov_[i];
+            batch_[i].msg_hdr.msg_iovlen = 1;
+        }
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        wake_fd_  = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoll_event ev = {};
+        ev.events   = EPOLLIN;
+        ev.data.u32 = WAKE_ID;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+    }
+
+    reactor(const reactor &) = delete;
+    reactor &operator=(const reactor &) = delete;
+
+    ~reactor() {
+        for (uint32_t i = 0; i < connections_.size(); ++i) {
+            if (connections_[i].fd >= 0) remove(static_cast<int>(i));
+        }
+        close(wake_fd_);
+        close(epoll_fd_);
+    }
+
+    /*
+        Registers a non-blocking connected socket and returns its connection id, or -1 if the table is full or epoll
+        refuses the descriptor. The reactor closes the descriptor when the connection is removed.
+    */
+    int add_stream(int fd, uint32_t unit_id) {
+        return add(fd, unit_id, false);
+    }
+
+    int add_datagram(int fd, uint32_t unit_id) {
+        return add(fd, unit_id, true);
+    }
+
+    /*
+        Unregisters and closes a connection. Its id may be reused by a later add.
+    */
+    void remove(int id) {
+        connection &c = connections_[id];
+        if (c.fd < 0) return;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, c.fd, nullptr);
+        close(c.fd);
+        c.fd = -1;
+        free_.push_back(static_cast<uint32_t>(id));
+    }
+
+    /*
+        Sends one frame. Returns false if the frame was dropped because the connection cannot take it now.
+    */
+    bool send(int id, const message &msg) {
+        connection &c = connections_[id];
+        if (c.fd < 0) return false;
+        if (c.datagram) {
+            if (::send(c.fd, &msg, sizeof(msg), MSG_DONTWAIT) != static_cast<ssize_t>(sizeof(msg))) {
+                c.stats.tx_dropped++;
+                return false;
+            }
+            c.stats.frames_out++;
+            return true;
+        }
+        const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&msg);
+        uint32_t written = 0;
+        if (c.tx_used == 0) {
+            const ssize_t n = ::send(c.fd, bytes, sizeof(msg), MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (n > 0) written = static_cast<uint32_t>(n);
+        }
+        if (written < sizeof(msg)) {
+            // A partly written frame always fits: it was written into an empty ring.
+            if (c.tx_capacity - c.tx_used < sizeof(msg) - written) {
+                c.stats.tx_dropped++;
+                return false;
+            }
+            tx_push(c, bytes + written, static_cast<uint32_t>(sizeof(msg)) - written);
+            watch_writable(c, true);
+        }
+        c.stats.frames_out++;
+        return true;
+    }
+
+    /*
+        Waits up to timeout_ms for activity and dispatches it. on_frame(int id, uint32_t unit_id, const message &) is
+        called for every valid frame, on_close(int id, uint32_t unit_id) when the peer closes or the socket fails;
+        the connection is removed right after on_close returns. Returns the number of frames dispatched.
+    */
+    template <typename OnFrame, typename OnClose>
+    uint32_t poll(int timeout_ms, OnFrame &&on_frame, OnClose &&on_close) {
+        const int n = epoll_wait(epoll_fd_, events_.data(), static_cast<int>(events_.size()), timeout_ms);
+        uint32_t frames = 0;
+        for (int i = 0; i < n; ++i) {
+            const uint32_t id = events_[i].data.u32;
+            if (id == WAKE_ID) {
+                uint64_t count;
+                while (read(wake_fd_, &count, sizeof(count)) > 0) {
+                }
+                continue;
+            }
+            connection &c = connections_[id];
+            if (c.fd < 0) continue;
+            bool closed = (events_[i].events & (EPOLLERR | EPOLLHUP)) != 0 && (events_[i].events & EPOLLIN) == 0;
+            if (!closed && (events_[i].events & EPOLLOUT)) closed = !flush(c);
+            if (!closed && (events_[i].events & EPOLLIN)) {
+                closed = c.datagram ? !read_datagrams(static_cast<int>(id), c, on_frame, frames)
+                                    : !read_stream(static_cast<int>(id), c, on_frame, frames);
+            }
+            if (closed) {
+                on_close(static_cast<int>(id), c.unit_id);
+                remove(static_cast<int>(id));
+            }
+        }
+        return frames;
+    }
+
+    template <typename OnFrame>
+    uint32_t poll(int timeout_ms, OnFrame &&on_frame) {
+        return poll(timeout_ms, on_frame, [](int, uint32_t) {});
+    }
+
+    /*
+        Interrupts a poll() waiting on another thread. Safe to call from any thread.
+    */
+    void wake() {
+        const uint64_t one = 1;
+        ssize_t ignored = write(wake_fd_, &one, sizeof(one));
+        (void)ignored;
+    }
+
+    uint32_t unit_id(int id) const {
+        return connections_[id].unit_id;
+    }
+
+    const reactor_connection_stats &stats(int id) const {
+        return connections_[id].stats;
+    }
+
+    uint32_t connection_count() const {
+        return static_cast<uint32_t>(connections_.size() - free_.size());
+    }
+
+private:
+    static constexpr uint32_t WAKE_ID = UINT32_MAX;
+
+    struct connection {
+        int      fd       = -1;
+        uint32_t unit_id  = 0;
+        bool     datagram = false;
+        bool     writable_watched = false;
+        uint8_t *rx = nullptr;
+        uint8_t *tx = nullptr;
+        uint32_t rx_capacity = 0;
+        uint32_t rx_used     = 0;
+        uint32_t tx_capacity = 0;
+        uint32_t tx_head     = 0;
+        uint32_t tx_used     = 0;
+        reactor_connection_stats stats = {};
+    };
+
+    int add(int fd, uint32_t unit_id, bool datagram) {
+        if (free_.empty()) return -1;
+        const uint32_t id = free_.back();
+        connection &c = connections_[id];
+        epoll_event ev = {};
+        ev.events   = EPOLLIN | EPOLLRDHUP;
+        ev.data.u32 = id;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) != 0) return -1;
+        free_.pop_back();
+        c.fd               = fd;
+        c.unit_id          = unit_id;
+        c.datagram         = datagram;
+        c.writable_watched = false;
+        c.rx_used          = 0;
+        c.tx_head          = 0;
+        c.tx_used          = 0;
+        c.stats            = {};
+        return static_cast<int>(id);
+    }
+
+    template <typename OnFrame>
+    bool read_stream(int id, connection &c, OnFrame &&on_frame, uint32_t &frames) {
+        for (uint32_t budget = config_.read_budget; budget > 0;) {
+            const uint32_t space = c.rx_capacity - c.rx_used;
+            const ssize_t n = recv(c.fd, c.rx + c.rx_used, space, MSG_DONTWAIT);
+            if (n == 0) return false;
+            if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+            c.rx_used += static_cast<uint32_t>(n);
+
+            uint32_t offset = 0;
+            for (; c.rx_used - offset >= sizeof(message); offset += sizeof(message)) {
+                message msg;
+                memcpy(&msg, c.rx + offset, sizeof(message));
+                if (deliver(id, c, msg, on_frame)) frames++;
+                if (budget > 0) budget--;
+            }
+            // Keep the partial frame at the front for the next read.
+            if (offset > 0) {
+                memmove(c.rx, c.rx + offset, c.rx_used - offset);
+                c.rx_used -= offset;
+            }
+            if (static_cast<uint32_t>(n) < space) break;   // Socket drained.
+        }
+        return true;
+    }
+
+    template <typename OnFrame>
+    bool read_datagrams(int id, connection &c, OnFrame &&on_frame, uint32_t &frames) {
+        for (uint32_t budget = config_.read_budget; budget > 0;) {
+            const uint32_t want = budget < MAX_DATAGRAM_BATCH ? budget : MAX_DATAGRAM_BATCH;
+            const int n = recvmmsg(c.fd, batch_, want, MSG_DONTWAIT, nullptr);
+            if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR || errno == ECONNREFUSED;
+            for (int i = 0; i < n; ++i) {
+                if (batch_[i].msg_len != sizeof(message)) {
+                    c.stats.malformed++;
+                    continue;
+                }
+                if (deliver(id, c, datagrams_[i], on_frame)) frames++;
+            }
+            budget -= static_cast<uint32_t>(n);
+            if (static_cast<uint32_t>(n) < want) break;
+        }
+        return true;
+    }
+
+    template <typename OnFrame>
+    bool deliver(int id, connection &c, const message &msg, OnFrame &&on_frame) {
+        if (!has_valid_checksum_for_digiview_message(msg)) {
+            c.stats.checksum_errors++;
+            return false;
+        }
+        c.stats.frames_in++;
+        on_frame(id, c.unit_id, msg);
+        return true;
+    }
+
+    void tx_push(connection &c, const uint8_t *bytes, uint32_t len) {
+        uint32_t tail = (c.tx_head + c.tx_used) % c.tx_capacity;
+        for (uint32_t copied = 0; copied < len;) {
+            const uint32_t chunk = std::min(len - copied, c.tx_capacity - tail);
+            memcpy(c.tx + tail, bytes + copied, chunk);
+            copied += chunk;
+            tail = (tail + chunk) % c.tx_capacity;
+        }
+        c.tx_used += len;
+    }
+
+    // Writes queued bytes. Returns false if the socket failed.
+    bool flush(connection &c) {
+        while (c.tx_used > 0) {
+            const uint32_t chunk = std::min(c.tx_used, c.tx_capacity - c.tx_head);
+            const ssize_t n = ::send(c.fd, c.tx + c.tx_head, chunk, MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return true;
+                return false;
+            }
+            c.tx_head = (c.tx_head + static_cast<uint32_t>(n)) % c.tx_capacity;
+            c.tx_used -= static_cast<uint32_t>(n);
+        }
+        c.tx_head = 0;
+        watch_writable(c, false);
+        return true;
+    }
+
+    void watch_writable(connection &c, bool on) {
+        if (c.writable_watched == on) return;
+        epoll_event ev = {};
+        ev.events   = EPOLLIN | EPOLLRDHUP | (on ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+        ev.data.u32 = static_cast<uint32_t>(&c - connections_.data());
+        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, c.fd, &ev);
+        c.writable_watched = on;
+    }
+
+    reactor_config               config_;
+    std::vector<connection>      connections_;
+    std::vector<uint32_t>        free_;
+    std::vector<epoll_event>     events_;
+    std::unique_ptr<uint8_t[]>   buffers_;
+    message                      datagrams_[MAX_DATAGRAM_BATCH];
+    iovec                        iov_[MAX_DATAGRAM_BATCH];
+    mmsghdr                      batch_[MAX_DATAGRAM_BATCH];
+    int                          epoll_fd_ = -1;
+    int                          wake_fd_  = -1;
+};
+
+/*
+    Runs shard_count reactors, each on its own thread. A connection is handed to shard unit_id % shard_count when it
+    is added and stays there, so a unit's frames are always handled in order by one thread. Handlers run on the
+    shard's thread and receive its reactor, which they may use to send replies on the same shard.
+*/
+class sharded_reactor {
+public:
+    using frame_handler = std::function<void(reactor &, int id, uint32_t unit_id, const message &)>;
+    using close_handler = std::function<void(reactor &, int id, uint32_t unit_id)>;
+
+    sharded_reactor(uint32_t shard_count, frame_handler on_frame, close_handler on_close = close_handler(),
+                    const reactor_config &config = reactor_config())
+        : on_frame_(std::move(on_frame)), on_close_(std::move(on_close)) {
+        if (shard_count == 0) shard_count = 1;
+        for (uint32_t i = 0; i < shard_count; ++i) shards_.emplace_back(new shard(config));
+        for (auto &s : shards_) {
+            shard *self = s.get();
+            self->thread = std::thread([this, self] { run(*self); });
+        }
+    }
+
+    sharded_reactor(const sharded_reactor &) = delete;
+    sharded_reactor &operator=(const sharded_reactor &) = delete;
+
+    ~sharded_reactor() {
+        stop_.store(true, std::memory_order_relaxed);
+        for (auto &s : shards_) {
+            s->loop.wake();
+            s->thread.join();
+        }
+    }
+
+    /*
+        Queues a connection for its shard. The shard registers it on its next wakeup; if its table is full the
+        descriptor is closed.
+    */
+    void add_stream(int fd, uint32_t unit_id) {
+        post(fd, unit_id, false);
+    }
+
+    void add_datagram(int fd, uint32_t unit_id) {
+        post(fd, unit_id, true);
+    }
+
+    uint32_t shard_count() const {
+        return static_cast<uint32_t>(shards_.size());
+    }
+
+private:
+    struct pending_connection {
+        int      fd;
+        uint32_t unit_id;
+        bool     datagram;
+    };
+
+    struct shard {
+        explicit shard(const reactor_config &config) : loop(config) {}
+
+        reactor                         loop;
+        std::mutex                      mutex;
+        std::vector<pending_connection> inbox;
+        std::vector<pending_connection> draining;
+        std::thread                     thread;
+    };
+
+    void post(int fd, uint32_t unit_id, bool datagram) {
+        shard &s = *shards_[unit_id % shards_.size()];
+        {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            s.inbox.push_back({fd, unit_id, datagram});
+        }
+        s.loop.wake();
+    }
+
+    void run(shard &s) {
+        while (!stop_.load(std::memory_order_relaxed)) {
+            {
+                std::lock_guard<std::mutex> lock(s.mutex);
+                s.draining.swap(s.inbox);
+            }
+            for (const pending_connection &p : s.draining) {
+                const int id = p.datagram ? s.loop.add_datagram(p.fd, p.unit_id) : s.loop.add_stream(p.fd, p.unit_id);
+                if (id < 0) close(p.fd);
+            }
+            s.draining.clear();
+            s.loop.poll(
+                100, [&](int id, uint32_t unit_id, const message &msg) { on_frame_(s.loop, id, unit_id, msg); },
+                [&](int id, uint32_t unit_id) {
+                    if (on_close_) on_close_(s.loop, id, unit_id);
+                });
+        }
+    }
+
+    frame_handler                       on_frame_;
+    close_handler                       on_close_;
+    std::vector<std::unique_ptr<shard>> shards_;
+    std::atomic<bool>                   stop_{false};
+};
+
+#endif // REACTOR_HPP
@@ -0,0 +1,391 @@
+#pragma once
+
+#ifndef RELIABLE_DELIVERY_HPP
+#define RELIABLE_DELIVERY_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <stdint.h>
+
+#include "msg_defs.hpp"
+
+/*
+------------------------------------------------------------------------------------------------------------------------
+    RELIABLE SET DELIVERY
+
+    Optional reliability for SETs that must take effect exactly once over UDP, such as starting a recording or a
+    calibration command. The client sends them as SET_PARAMETERS_RELIABLE with a session and a sequence number.
+    DigiView applies each sequence number once and answers with RELIABLE_STATUS, which reports what arrived, what is
+    missing and the outcome of each SET.
+
+        reliable_sender    client side. Keeps up to config.window SETs in flight and retransmits them after an
+                           RTT-adaptive timeout (RFC 6298 estimator, exponential backoff), or early once
+                           config.missing_reports statuses have reported them missing. A status received for a SET
+                           completes it with its outcome.
+        reliable_receiver  DigiView side, one per client. Tracks the last RELIABLE_STATUS_SPAN sequence numbers,
+                           applies new SETs, drops duplicates and keeps each outcome so a lost status is repaired
+                           by the next one. A new session replaces the current one; the last
+                           RELIABLE_RETIRED_SESSIONS replaced sessions are remembered, and late frames from them are
+                           dropped, so a stale retransmit can neither run nor reset the live session's window.
+
+    The sender's window is at most half the status span, so every SET still in flight is covered by the receiver's
+    window and a retransmission is never applied twice.
+
+    The receiver only tells sessions apart by number. A restarted client that reused its session would start again
+    at sequence 0 and have its first SETs dropped as duplicates, so by default every reliable_sender draws a random
+    non-zero session. Frames must reach the link one by one: coalescing_queue keeps SET_PARAMETERS_RELIABLE frames
+    apart, and nothing else may merge or replace them.
+
+    High-rate idempotent traffic (telemetry, streaming CAM_TARGETING and SINGLE_TARGET_TRACKING) should bypass this
+    layer: a newer value replaces a lost one. default_reliable_delivery() encodes that policy. Neither class is
+    thread-safe.
+------------------------------------------------------------------------------------------------------------------------
+*/
+static constexpr uint32_t RELIABLE_MAX_WINDOW = RELIABLE_STATUS_SPAN / 2;
+static constexpr uint32_t RELIABLE_RETIRED_SESSIONS = 8;
+
+/*
+    True for frames that should go through reliable_sender: SETs of every group except the streaming control groups.
+*/
+inline bool default_reliable_delivery(const message &msg) {
+    if (msg.message_type != SET_PARAMETERS) return false;
+    return msg.param_type != CAM_TARGETING && msg.param_type != SINGLE_TARGET_TRACKING;
+}
+
+struct reliable_config {
+    uint32_t window          = RELIABLE_MAX_WINDOW;   // SETs in flight, at most RELIABLE_MAX_WINDOW.
+    uint32_t initial_rto_us  = 500000;
+    uint32_t min_rto_us      = 20000;
+    uint32_t max_rto_us      = 4000000;
+    uint32_t max_retransmits = 10;                    // Then the SET completes with outcome EMPTY.
+    uint32_t missing_reports = 2;                     // Statuses reporting a SET missing before it is resent early.
+    uint16_t session         = 0;                     // 0: random. Never reuse one after a restart.
+};
+
+/*
+    A random non-zero session number. random_device is mixed with the clock in case it is deterministic.
+*/
+inline uint16_t random_reliable_session() {
+    std::random_device device;
+    uint64_t seed = (static_cast<uint64_t>(device()) << 32) ^
+                    static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    for (;;) {
+        // splitmix64 finaliser.
+        uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        const uint16_t session = static_cast<uint16_t>((z ^ (z >> 31)) >> 48);
+        if (session != 0) return session;
+    }
+}
+
+struct reliable_sender_stats {
+    uint64_t sent;
+    uint64_t retransmits;
+    uint64_t fast_retransmits;   // Retransmits triggered by a missing bit rather than a timeout.
+    uint64_t completed;
+    uint64_t failed;
+    uint32_t srtt_us;
+    uint32_t rto_us;
+};
+
+class reliable_sender {
+public:
+    explicit reliable_sender(const reliable_config &config = reliable_config())
+        : config_(config), rto_us_(config.initial_rto_us) {
+        config_.window = std::max<uint32_t>(1, std::min(config_.window, RELIABLE_MAX_WINDOW));
+        if (config_.session == 0) config_.session = random_reliable_session();
+    }
+
+    uint16_t session() const {
+        return config_.session;
+    }
+
+    /*
+        Turns a packed SET into SET_PARAMETERS_RELIABLE and checksums it, ready to send. Returns its sequence number,
+        or -1 if the window is full and the caller must wait for completions.
+    */
+    int32_t send(message &msg, uint64_t now_us) {
+        if (in_flight_ >= config_.window || static_cast<uint16_t>(next_sequence_ - oldest_) >= config_.window) {
+            return -1;
+        }
+        const uint16_t sequence = next_sequence_++;
+        msg.message_type = SET_PARAMETERS_RELIABLE;
+        msg.interval_ms  = (static_cast<uint32_t>(config_.session) << 16) | sequence;
+        add_checksum_for_digiview_message(msg);
+
+        entry &e = entries_[sequence % RELIABLE_MAX_WINDOW];
+        e.active         = true;
+        e.sequence       = sequence;
+        e.frame          = msg;
+        e.first_sent_us  = now_us;
+        e.last_sent_us   = now_us;
+        e.retransmits    = 0;
+        e.missing_reports = 0;
+        e.rto_us         = rto_us_;
+        e.deadline_us    = now_us + rto_us_;
+        if (in_flight_++ == 0) oldest_ = sequence;
+        stats_.sent++;
+        return sequence;
+    }
+
+    /*
+        Applies a RELIABLE_STATUS for this session. on_done(uint16_t sequence, uint8_t outcome, const message &frame,
+        uint64_t elapsed_us) is called for every SET it completes; outcome is ACKNOWLEDGEMENT, DATA_ERROR, FORBIDDEN or
+        UNKNOWN. Returns false for any other message.
+    */
+    template <typename OnDone>
+    bool on_message(message &msg, uint64_t now_us, OnDone &&on_done) {
+        if (msg.message_type != RELIABLE_STATUS || !has_valid_checksum_for_digiview_message(msg)) return false;
+        reliable_status_parameters status;
+        unpack_reliable_status_parameters(msg, status);
+        if (status.session != config_.session) return true;
+
+        for (uint32_t i = 0; i < RELIABLE_STATUS_SPAN; ++i) {
+            const uint16_t sequence = static_cast<uint16_t>(status.base + i);
+            entry &e = entries_[sequence % RELIABLE_MAX_WINDOW];
+            if (!e.active || e.sequence != sequence) continue;
+            if (status.received & (1ULL << i)) {
+                // Karn's rule: only SETs sent once give an unambiguous RTT sample.
+                if (e.retransmits == 0) sample_rtt(now_us - e.first_sent_us);
+                const uint8_t outcome = reliable_outcome_type((status.outcomes[i / 4] >> ((i % 4) * 2)) & 3);
+                finish(e, outcome, now_us, on_done);
+            } else if ((status.missing & (1ULL << i)) && now_us - e.last_sent_us >= srtt_us_ &&
+                       ++e.missing_reports >= config_.missing_reports) {
+                // Reordering also leaves gaps, so wait for more than one report before resending early.
+                e.deadline_us     = now_us;
+                e.fast            = true;
+                e.missing_reports = 0;
+            }
+        }
+        return true;
+    }
+
+    /*
+        Retransmits every SET whose timer expired or that was reported missing, calling transmit(const message &),
+        and fails SETs that ran out of retransmits through on_done with outcome EMPTY. Returns the number of frames
+        transmitted.
+    */
+    template <typename Transmit, typename OnDone>
+    uint32_t poll(uint64_t now_us, Transmit &&transmit, OnDone &&on_done) {
+        uint32_t transmitted = 0;
+        for (entry &e : entries_) {
+            if (!e.active || e.deadline_us > now_us) continue;
+            if (e.retransmits >= config_.max_retransmits) {
+                stats_.failed++;
+                finish(e, EMPTY, now_us, on_done);
+                continue;
+            }
+            if (e.fast) {
+                stats_.fast_retransmits++;
+            } else {
+                e.rto_us = std::min(e.rto_us * 2, config_.max_rto_us);
+            }
+            e.fast         = false;
+            e.missing_reports = 0;
+            e.retransmits++;
+            e.last_sent_us = now_us;
+            e.deadline_us  = now_us + e.rto_us;
+            stats_.retransmits++;
+            transmit(e.frame);
+            transmitted++;
+        }
+        return transmitted;
+    }
+
+    /*
+        Earliest time poll() has work to do, or UINT64_MAX if nothing is in flight.
+    */
+    uint64_t next_deadline_us() const {
+        uint64_t next = UINT64_MAX;
+        for (const entry &e : entries_) {
+            if (e.active) next = std::min(next, e.deadline_us);
+        }
+        return next;
+    }
+
+    uint32_t in_flight() const {
+        return in_flight_;
+    }
+
+    reliable_sender_stats stats() const {
+        reliable_sender_stats s = stats_;
+        s.srtt_us = srtt_us_;
+        s.rto_us  = rto_us_;
+        return s;
+    }
+
+private:
+    struct entry {
+        bool     active = false;
+        bool     fast   = false;
+        uint16_t sequence = 0;
+        uint32_t retransmits = 0;
+        uint32_t missing_reports = 0;
+        uint32_t rto_us = 0;
+        uint64_t first_sent_us = 0;
+        uint64_t last_sent_us  = 0;
+        uint64_t deadline_us   = 0;
+        message  frame = {};
+    };
+
+    void sample_rtt(uint64_t rtt_us) {
+        const uint32_t r = static_cast<uint32_t>(std::min<uint64_t>(rtt_us, UINT32_MAX));
+        if (!has_sample_) {
+            srtt_us_   = r;
+            rttvar_us_ = r / 2;
+            has_sample_ = true;
+        } else {
+            const uint32_t delta = srtt_us_ > r ? srtt_us_ - r : r - srtt_us_;
+            rttvar_us_ = (3 * rttvar_us_ + delta) / 4;
+            srtt_us_   = (7 * srtt_us_ + r) / 8;
+        }
+        rto_us_ = std::min(config_.max_rto_us, std::max(config_.min_rto_us, srtt_us_ + 4 * rttvar_us_));
+    }
+
+    template <typename OnDone>
+    void finish(entry &e, uint8_t outcome, uint64_t now_us, OnDone &&on_done) {
+        e.active = false;
+        e.fast   = false;
+        in_flight_--;
+        if (outcome != EMPTY) stats_.completed++;
+        on_done(e.sequence, outcome, static_cast<const message &>(e.frame), now_us - e.first_sent_us);
+        // The window slides past every finished SET at its start.
+        while (in_flight_ > 0 && !(entries_[oldest_ % RELIABLE_MAX_WINDOW].active &&
+                                   entries_[oldest_ % RELIABLE_MAX_WINDOW].sequence == oldest_)) {
+            oldest_++;
+        }
+        if (in_flight_ == 0) oldest_ = next_sequence_;
+    }
+
+    reliable_config       config_;
+    entry                 entries_[RELIABLE_MAX_WINDOW];
+    uint16_t              next_sequence_ = 0;
+    uint16_t              oldest_        = 0;
+    uint32_t              in_flight_     = 0;
+    bool                  has_sample_    = false;
+    uint32_t              srtt_us_       = 0;
+    uint32_t              rttvar_us_     = 0;
+    uint32_t              rto_us_;
+    reliable_sender_stats stats_ = {};
+};
+
+struct reliable_receiver_stats {
+    uint64_t applied;
+    uint64_t duplicates;
+    uint64_t stale;      // Older than the window; dropped without being applied.
+    uint64_t retired;    // From a session already replaced by a newer one; dropped without being applied.
+    uint64_t sessions;
+};
+
+class reliable_receiver {
+public:
+    /*
+        Handles a SET_PARAMETERS_RELIABLE with a valid checksum. New SETs are passed to apply(message &), which applies
+        the change and returns the reply type it would have sent for a SET_PARAMETERS (ACKNOWLEDGEMENT, DATA_ERROR,
+        FORBIDDEN or UNKNOWN). Duplicates and frames from retired sessions are not applied. Returns true when the
+        caller should send pack_status(); false for any other message, which the caller handles as usual (including
+        CHECKSUM_ERROR).
+    */
+    template <typename Apply>
+    bool on_message(message &msg, Apply &&apply) {
+        if (msg.message_type != SET_PARAMETERS_RELIABLE || !has_valid_checksum_for_digiview_message(msg)) return false;
+        const uint16_t session  = reliable_session(msg);
+        const uint16_t sequence = reliable_sequence(msg);
+        if (!active_ || session != session_) {
+            if (active_ && retired(session)) {
+                stats_.retired++;
+                return true;
+            }
+            if (active_) retire(session_);
+            // Senders number every session from 0, so anything below the first arrival is still expected.
+            active_   = true;
+            session_  = session;
+            highest_  = sequence;
+            received_ = 0;
+            span_     = std::min<uint32_t>(RELIABLE_STATUS_SPAN, sequence + 1U);
+            stats_.sessions++;
+            accept(msg, sequence, 0, apply);
+            return true;
+        }
+        const int16_t ahead = static_cast<int16_t>(sequence - highest_);
+        if (ahead > 0) {
+            received_ = ahead >= static_cast<int16_t>(RELIABLE_STATUS_SPAN) ? 0 : received_ << ahead;
+            highest_  = sequence;
+            span_     = std::min<uint32_t>(RELIABLE_STATUS_SPAN, span_ + ahead);
+            accept(msg, sequence, 0, apply);
+        } else if (-ahead < static_cast<int32_t>(RELIABLE_STATUS_SPAN)) {
+            const uint32_t age = static_cast<uint32_t>(-ahead);
+            if (received_ & (1ULL << age)) {
+                stats_.duplicates++;
+            } else {
+                accept(msg, sequence, age, apply);
+            }
+        } else {
+            stats_.stale++;
+        }
+        return true;
+    }
+
+    /*
+        Builds the checksummed RELIABLE_STATUS covering the newest RELIABLE_STATUS_SPAN sequence numbers.
+    */
+    void pack_status(message &msg) const {
+        const uint16_t base = static_cast<uint16_t>(highest_ - (RELIABLE_STATUS_SPAN - 1));
+        uint64_t received = 0;
+        uint64_t missing  = 0;
+        uint8_t  outcomes[RELIABLE_STATUS_SPAN / 4] = {};
+        for (uint32_t i = 0; i < RELIABLE_STATUS_SPAN; ++i) {
+            const uint32_t age = RELIABLE_STATUS_SPAN - 1 - i;
+            if (age >= span_) continue;
+            if (received_ & (1ULL << age)) {
+                received |= 1ULL << i;
+                const uint16_t sequence = static_cast<uint16_t>(base + i);
+                outcomes[i / 4] |= static_cast<uint8_t>(outcomes_[sequence % RELIABLE_STATUS_SPAN] << ((i % 4) * 2));
+            } else {
+                missing |= 1ULL << i;
+            }
+        }
+        pack_reliable_status_message(msg, session_, base, received, missing, outcomes);
+        add_checksum_for_digiview_message(msg);
+    }
+
+    const reliable_receiver_stats &stats() const {
+        return stats_;
+    }
+
+private:
+    bool retired(uint16_t session) const {
+        for (uint32_t i = 0; i < retired_count_; ++i) {
+            if (retired_[i] == session) return true;
+        }
+        return false;
+    }
+
+    void retire(uint16_t session) {
+        retired_[retired_next_] = session;
+        retired_next_ = (retired_next_ + 1) % RELIABLE_RETIRED_SESSIONS;
+        if (retired_count_ < RELIABLE_RETIRED_SESSIONS) retired_count_++;
+    }
+
+    template <typename Apply>
+    void accept(message &msg, uint16_t sequence, uint32_t age, Apply &&apply) {
+        received_ |= 1ULL << age;
+        outcomes_[sequence % RELIABLE_STATUS_SPAN] = reliable_outcome_code(apply(msg));
+        stats_.applied++;
+    }
+
+    bool                    active_   = false;
+    uint16_t                session_  = 0;
+    uint16_t                highest_  = 0;
+    uint64_t                received_ = 0;   // Bit n: highest_ - n has arrived.
+    uint32_t                span_     = 0;   // Sequence numbers of this session inside the window.
+    uint8_t                 outcomes_[RELIABLE_STATUS_SPAN] = {};
+    uint16_t                retired_[RELIABLE_RETIRED_SESSIONS] = {};
+    uint32_t                retired_count_ = 0;
+    uint32_t                retired_next_  = 0;
+    reliable_receiver_stats stats_ = {};
+};
+
+#endif // RELIABLE_DELIVERY_HPP
@@ -0,0 +1,457 @@
+#pragma once
+
+#ifndef SHM_RING_HPP
+#define SHM_RING_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <stdint.h>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "msg_defs.hpp"
+
+/*
+------------------------------------------------------------------------------------------------------------------------
+    SHARED-MEMORY BROADCAST RING
+
+    Same-host fan-out of message frames: one producer publishes into a ring held in a named POSIX shared-memory
+    object (/dev/shm/digiview_ring_<name>), and any number of reader processes consume it, each with its own cursor.
+    Readers never write to the slots, so adding one costs the producer nothing.
+
+    Every slot carries a stamp that works like a seqlock: odd while the producer is writing it, 2 * (seq + 1) once
+    frame seq is complete. A reader that falls more than a ring behind is moved forward to the oldest frame still
+    available. Frames skipped this way, or overwritten while being read, are counted in lost().
+
+    Frames are stored and copied as relaxed 64-bit atomic words, the same way param_cache does, so a reader copying
+    a slot the producer is rewriting is a detected retry rather than a data race. peek() copies the frame into a
+    buffer owned by the reader. Call release() when done with it; if it returns false the producer overwrote the slot
+    while it was being copied, and whatever was read from the copy must be discarded.
+
+    Sleeping readers wait on a futex in the shared page. The producer only makes the wake syscall when some reader
+    is actually asleep, so busy-polling readers (spin_us) keep the publish path free of syscalls.
+
+    A restarted producer creates a new object under the same name, then marks the old ring retired and wakes its
+    sleepers. Readers drain what is left of the old ring and then re-attach by name, starting at the oldest frame of
+    the new ring. Each ring carries a generation number that counts these replacements.
+------------------------------------------------------------------------------------------------------------------------
+*/
+static constexpr uint32_t SHM_RING_MAGIC          = 0x52525644; // "DVRR"
+static constexpr uint16_t SHM_RING_LAYOUT_VERSION = 2;
+static constexpr uint32_t SHM_RING_FRAME_WORDS    = (sizeof(message) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+static constexpr uint32_t SHM_RING_RETIRED_POLL_US = 1000;
+
+struct alignas(64) shm_ring_slot {
+    std::atomic<uint64_t> stamp;
+    std::atomic<uint64_t> words[SHM_RING_FRAME_WORDS];
+};
+
+struct shm_ring_header {
+    uint32_t magic;
+    uint16_t layout_version;
+    uint16_t slot_size;
+    uint32_t capacity;
+    uint32_t generation;
+
+    alignas(64) std::atomic<uint64_t> write_seq;
+    alignas(64) std::atomic<uint32_t> futex_word;
+    std::atomic<uint32_t>             waiters;
+    std::atomic<uint32_t>             retired;   // Set once a new producer has replaced this ring.
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared-memory ring needs lock-free 64-bit atomics");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be a plain 32-bit integer");
+
+inline size_t shm_ring_bytes(uint32_t capacity) {
+    return sizeof(shm_ring_header) + static_cast<size_t>(capacity) * sizeof(shm_ring_slot);
+}
+
+inline void shm_ring_object_name(const char *name, char (&out)[64]) {
+    snprintf(out, sizeof(out), "/digiview_ring_%s", name);
+}
+
+inline long shm_ring_futex(std::atomic<uint32_t> &word, int op, uint32_t value, const timespec *timeout) {
+    // Not FUTEX_PRIVATE_FLAG: waiters and waker are in different processes.
+    return syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), op, value, timeout, nullptr, 0);
+}
+
+class shm_ring_producer {
+public:
+    shm_ring_producer() = default;
+    shm_ring_producer(const shm_ring_producer &) = delete;
+    shm_ring_producer &operator=(const shm_ring_producer &) = delete;
+
+    ~shm_ring_producer() {
+        close();
+    }
+
+    /*
+        Creates (or replaces) the named ring. capacity is rounded up to a power of two. With notify = false the
+        producer never wakes sleeping readers, for setups where every reader busy-polls.
+    */
+    bool create(const char *name, uint32_t capacity = 4096, bool notify = true) {
+        close();
+        uint32_t rounded = 2;
+        while (rounded < capacity) rounded <<= 1;
+
+        char object[64];
+        shm_ring_object_name(name, object);
+        // The previous ring is retired only after its replacement is ready, so woken readers can re-attach at once.
+        shm_ring_header *previous = map_previous(object);
+        shm_unlink(object);
+        const bool created = create_object(object, rounded, previous == nullptr ? 1 : previous->generation + 1, notify);
+        if (previous != nullptr) retire(previous);
+        return created;
+    }
+
+    void close() {
+        if (header_ != nullptr) {
+            munmap(header_, bytes_);
+            header_ = nullptr;
+            slots_  = nullptr;
+        }
+    }
+
+    /*
+        Publishes one frame. Never blocks; slow readers are overrun rather than holding up the producer.
+    */
+    void publish(const message &msg) {
+        shm_ring_slot &slot = slots_[next_seq_ & mask_];
+        slot.stamp.store(2 * next_seq_ + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        uint64_t words[SHM_RING_FRAME_WORDS] = {};
+        memcpy(words, &msg, sizeof(message));
+        for (uint32_t i = 0; i < SHM_RING_FRAME_WORDS; ++i) {
+            slot.words[i].store(words[i], std::memory_order_relaxed);
+        }
+        slot.stamp.store(2 * next_seq_ + 2, std::memory_order_release);
+        next_seq_++;
+
+        if (!notify_) {
+            header_->write_seq.store(next_seq_, std::memory_order_release);
+            return;
+        }
+        // Pairs with the seq_cst waiters increment in shm_ring_reader::wait so that either the reader sees the new
+        // write_seq or the producer sees the waiter.
+        header_->write_seq.store(next_seq_, std::memory_order_seq_cst);
+        if (header_->waiters.load(std::memory_order_seq_cst) != 0) {
+            header_->futex_word.fetch_add(1, std::memory_order_release);
+            shm_ring_futex(header_->futex_word, FUTEX_WAKE, INT_MAX, nullptr);
+        }
+    }
+
+    /*
+        Removes the named object. Mapped rings stay valid until they are closed.
+    */
+    static void unlink(const char *name) {
+        char object[64];
+        shm_ring_object_name(name, object);
+        shm_unlink(object);
+    }
+
+    uint64_t published() const {
+        return next_seq_;
+    }
+
+    uint32_t generation() const {
+        return header_ != nullptr ? header_->generation : 0;
+    }
+
+private:
+    bool create_object(const char *object, uint32_t rounded, uint32_t generation, bool notify) {
+        const int fd = shm_open(object, O_RDWR | O_CREAT | O_EXCL, 0644);
+        if (fd < 0) return false;
+        const size_t bytes = shm_ring_bytes(rounded);
+        if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+            ::close(fd);
+            return false;
+        }
+        void *mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) return false;
+
+        // ftruncate zero-fills, which is a valid initial state for every atomic in the page.
+        header_         = static_cast<shm_ring_header *>(mapped);
+        slots_          = reinterpret_cast<shm_ring_slot *>(header_ + 1);
+        bytes_          = bytes;
+        mask_           = rounded - 1;
+        notify_         = notify;
+        next_seq_       = 0;
+        header_->layout_version = SHM_RING_LAYOUT_VERSION;
+        header_->slot_size      = sizeof(shm_ring_slot);
+        header_->capacity       = rounded;
+        header_->generation     = generation;
+        reinterpret_cast<std::atomic<uint32_t> *>(&header_->magic)->store(SHM_RING_MAGIC, std::memory_order_release);
+        return true;
+    }
+
+    // Header of a ring left behind under the same name by an earlier producer, or nullptr.
+    static shm_ring_header *map_previous(const char *object) {
+        const int fd = shm_open(object, O_RDWR, 0);
+        if (fd < 0) return nullptr;
+        struct stat st;
+        void *mapped = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(shm_ring_header)) {
+            mapped = mmap(nullptr, sizeof(shm_ring_header), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        if (mapped == MAP_FAILED) return nullptr;
+        shm_ring_header *header = static_cast<shm_ring_header *>(mapped);
+        if (header->magic != SHM_RING_MAGIC) {
+            munmap(mapped, sizeof(shm_ring_header));
+            return nullptr;
+        }
+        return header;
+    }
+
+    static void retire(shm_ring_header *previous) {
+        previous->retired.store(1, std::memory_order_seq_cst);
+        previous->futex_word.fetch_add(1, std::memory_order_release);
+        shm_ring_futex(previous->futex_word, FUTEX_WAKE, INT_MAX, nullptr);
+        munmap(previous, sizeof(shm_ring_header));
+    }
+
+    shm_ring_header *header_   = nullptr;
+    shm_ring_slot   *slots_    = nullptr;
+    size_t           bytes_    = 0;
+    uint64_t         mask_     = 0;
+    uint64_t         next_seq_ = 0;
+    bool             notify_   = true;
+};
+
+class shm_ring_reader {
+public:
+    shm_ring_reader() = default;
+    shm_ring_reader(const shm_ring_reader &) = delete;
+    shm_ring_reader &operator=(const shm_ring_reader &) = delete;
+
+    ~shm_ring_reader() {
+        close();
+    }
+
+    /*
+        Maps an existing ring. The reader starts at the next frame to be published, or at the oldest frame
+        still in the ring if from_oldest is set.
+    */
+    bool open(const char *name, bool from_oldest = false) {
+        close();
+        shm_ring_object_name(name, object_);
+        if (!attach(from_oldest)) return false;
+        lost_       = 0;
+        reattached_ = 0;
+        return true;
+    }
+
+    void close() {
+        if (header_ != nullptr) {
+            munmap(header_, bytes_);
+            header_ = nullptr;
+            slots_  = nullptr;
+        }
+    }
+
+    /*
+        Copy of the next frame, or nullptr if the reader has caught up. The copy stays readable until the next peek();
+        release() tells whether it is intact. Once a retired ring is drained, the reader re-attaches to its
+        replacement.
+    */
+    const message *peek() {
+        for (;;) {
+            const uint64_t head = header_->write_seq.load(std::memory_order_acquire);
+            if (cursor_ >= head) {
+                if (header_->retired.load(std::memory_order_acquire) == 0 || !reattach()) return nullptr;
+                continue;
+            }
+            // The slot of the oldest frame may already be being rewritten, so keep one slot of margin.
+            if (head - cursor_ > mask_) {
+                lost_  += head - mask_ - cursor_;
+                cursor_ = head - mask_;
+            }
+            const shm_ring_slot &slot = slots_[cursor_ & mask_];
+            expected_ = 2 * cursor_ + 2;
+            const uint64_t stamp = slot.stamp.load(std::memory_order_acquire);
+            if (stamp == expected_) {
+                uint64_t words[SHM_RING_FRAME_WORDS];
+                for (uint32_t i = 0; i < SHM_RING_FRAME_WORDS; ++i) {
+                    words[i] = slot.words[i].load(std::memory_order_relaxed);
+                }
+                memcpy(&frame_, words, sizeof(message));
+                return &frame_;
+            }
+            // Lapped between the two loads: count the frame and move on.
+            lost_++;
+            cursor_++;
+        }
+    }
+
+    /*
+        Finishes with the frame returned by peek(). Returns false if the slot was overwritten while it was copied.
+    */
+    bool release() {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const bool intact = slots_[cursor_ & mask_].stamp.load(std::memory_order_relaxed) == expected_;
+        if (!intact) lost_++;
+        cursor_++;
+        return intact;
+    }
+
+    /*
+        Copies the next intact frame into out. Returns false if the reader has caught up.
+    */
+    bool read(message &out) {
+        for (;;) {
+            if (peek() == nullptr) return false;
+            if (release()) {
+                out = frame_;
+                return true;
+            }
+        }
+    }
+
+    /*
+        Waits until a frame is available. Polls for up to spin_us first, then sleeps on the futex. timeout_us < 0
+        waits forever. Returns false on timeout.
+    */
+    bool wait(int64_t timeout_us = -1, uint32_t spin_us = 0) {
+        if (available()) return true;
+        const uint64_t start_us = monotonic_us();
+        while (spin_us != 0 && monotonic_us() - start_us < spin_us) {
+            if (available()) return true;
+            cpu_relax();
+        }
+
+        for (;;) {
+            // The word is loaded before the retired flag, so a retirement in between makes the futex wait return.
+            const uint32_t word = header_->futex_word.load(std::memory_order_acquire);
+            // Nobody will wake a futex on a retired ring: switch to the replacement, or poll until it appears.
+            const bool retired = header_->retired.load(std::memory_order_acquire) != 0;
+            if (retired && !available() && reattach()) {
+                if (available()) return true;
+                continue;
+            }
+            header_->waiters.fetch_add(1, std::memory_order_seq_cst);
+            if (header_->write_seq.load(std::memory_order_seq_cst) > cursor_) {
+                header_->waiters.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+            timespec ts;
+            timespec *timeout = nullptr;
+            uint64_t remaining = retired ? SHM_RING_RETIRED_POLL_US : UINT64_MAX;
+            if (timeout_us >= 0) {
+                const uint64_t elapsed = monotonic_us() - start_us;
+                if (elapsed >= static_cast<uint64_t>(timeout_us)) {
+                    header_->waiters.fetch_sub(1, std::memory_order_relaxed);
+                    return false;
+                }
+                remaining = std::min(remaining, static_cast<uint64_t>(timeout_us) - elapsed);
+            }
+            if (remaining != UINT64_MAX) {
+                ts.tv_sec  = static_cast<time_t>(remaining / 1000000);
+                ts.tv_nsec = static_cast<long>((remaining % 1000000) * 1000);
+                timeout = &ts;
+            }
+            shm_ring_futex(header_->futex_word, FUTEX_WAIT, word, timeout);
+            header_->waiters.fetch_sub(1, std::memory_order_relaxed);
+            if (available()) return true;
+        }
+    }
+
+    bool available() const {
+        return header_->write_seq.load(std::memory_order_acquire) > cursor_;
+    }
+
+    /*
+        Frames published but not yet consumed by this reader.
+    */
+    uint64_t backlog() const {
+        const uint64_t head = header_->write_seq.load(std::memory_order_acquire);
+        return head > cursor_ ? head - cursor_ : 0;
+    }
+
+    uint64_t lost() const {
+        return lost_;
+    }
+
+    uint32_t generation() const {
+        return header_->generation;
+    }
+
+    /*
+        Number of times the reader followed a restarted producer to a new ring.
+    */
+    uint64_t reattached() const {
+        return reattached_;
+    }
+
+private:
+    // Maps the ring currently under object_. On success replaces the current mapping; otherwise leaves it alone.
+    bool attach(bool from_oldest) {
+        // O_RDWR only so that wait() can register itself in the waiters count; the mapping of the slots is the same
+        // one the producer writes.
+        const int fd = shm_open(object_, O_RDWR, 0);
+        if (fd < 0) return false;
+        shm_ring_header probe;
+        if (pread(fd, &probe, sizeof(probe), 0) != static_cast<ssize_t>(sizeof(probe)) ||
+            probe.magic != SHM_RING_MAGIC || probe.layout_version != SHM_RING_LAYOUT_VERSION ||
+            probe.slot_size != sizeof(shm_ring_slot) || probe.capacity == 0 ||
+            (probe.capacity & (probe.capacity - 1)) != 0 || probe.retired.load(std::memory_order_relaxed) != 0) {
+            ::close(fd);
+            return false;
+        }
+        const size_t bytes = shm_ring_bytes(probe.capacity);
+        void *mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) return false;
+
+        close();
+        header_ = static_cast<shm_ring_header *>(mapped);
+        slots_  = reinterpret_cast<const shm_ring_slot *>(header_ + 1);
+        bytes_  = bytes;
+        mask_   = probe.capacity - 1;
+        const uint64_t head = header_->write_seq.load(std::memory_order_acquire);
+        cursor_ = (from_oldest && head > mask_) ? head - mask_ : (from_oldest ? 0 : head);
+        return true;
+    }
+
+    bool reattach() {
+        if (!attach(true)) return false;
+        reattached_++;
+        return true;
+    }
+
+    static uint64_t monotonic_us() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000ULL + static_cast<uint64_t>(ts.tv_nsec) / 1000ULL;
+    }
+
+    static void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        __asm__ __volatile__("yield");
+#endif
+    }
+
+    shm_ring_header     *header_   = nullptr;
+    const shm_ring_slot *slots_    = nullptr;
+    size_t               bytes_    = 0;
+    uint64_t             mask_     = 0;
+    uint64_t             cursor_   = 0;
+    uint64_t             expected_ = 0;
+    uint64_t             lost_     = 0;
+    uint64_t             reattached_ = 0;
+    char                 object_[64] = {};
+    message              frame_;
+};
+
+#endif // SHM_RING_HPP
@@ -0,0 +1,152 @@
+#pragma once
+
+#ifndef STREAM_NAMES_HPP
+#define STREAM_NAMES_HPP
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <string_view>
+#include <stdint.h>
+
+#include "msg_defs.hpp"
+
+/*
+------------------------------------------------------------------------------------------------------------------------
+    STREAM NAME INTERNING
+
+    Maps stream names to dense ids (0, 1, 2, ...) the first time they are seen, so per-message routing and cache
+    lookups can index arrays instead of hashing strings. Names are stored as canonical zero-padded 16-byte fields and
+    compared with stream_name_equal.
+
+    Lookups of known names are lock-free. Inserting a new name takes a mutex, which only happens once per name.
+
+    The pack functions that take a stream name also accept a stream_name_id, which they resolve through the
+    process-wide table returned by stream_names().
+------------------------------------------------------------------------------------------------------------------------
+*/
+static constexpr uint16_t INVALID_STREAM_NAME_ID = UINT16_MAX;
+
+struct stream_name_id {
+    uint16_t value;
+};
+
+class stream_name_table {
+public:
+    static constexpr uint32_t CAPACITY = 256;
+
+    stream_name_table() {
+        for (uint32_t i = 0; i < SLOTS; ++i) {
+            slots_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    stream_name_table(const stream_name_table &) = delete;
+    stream_name_table &operator=(const stream_name_table &) = delete;
+
+    /*
+        Returns the id for a 16-byte stream name field, assigning a new one on first sight. Returns
+        INVALID_STREAM_NAME_ID if the table is full.
+    */
+    uint16_t intern_field(const char *field) {
+        alignas(16) uint8_t key[STREAM_NAME_SIZE];
+        canonical_stream_name_field(key, field);
+        const uint16_t id = find_canonical(key);
+        if (id != INVALID_STREAM_NAME_ID) return id;
+        return insert_canonical(key);
+    }
+
+    uint16_t intern(std::string_view stream_name) {
+        alignas(16) uint8_t key[STREAM_NAME_SIZE];
+        copy_stream_name_field(key, stream_name);
+        canonical_stream_name_field(key, reinterpret_cast<const char *>(key));
+        const uint16_t id = find_canonical(key);
+        if (id != INVALID_STREAM_NAME_ID) return id;
+        return insert_canonical(key);
+    }
+
+    /*
+        Returns the id for a 16-byte stream name field without inserting it.
+    */
+    uint16_t find_field(const char *field) const {
+        alignas(16) uint8_t key[STREAM_NAME_SIZE];
+        canonical_stream_name_field(key, field);
+        return find_canonical(key);
+    }
+
+    /*
+        Zero-padded 16-byte field for id. id must have been returned by this table.
+    */
+    const char *field(uint16_t id) const {
+        return names_[id];
+    }
+
+    std::string_view view(uint16_t id) const {
+        return id < size() ? stream_name_field_view(names_[id]) : std::string_view{};
+    }
+
+    uint32_t size() const {
+        return count_.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr uint32_t SLOTS = CAPACITY * 2;
+
+    uint16_t find_canonical(const uint8_t *key) const {
+        for (uint32_t i = stream_name_hash(key) & (SLOTS - 1), probes = 0; probes < SLOTS; i = (i + 1) & (SLOTS - 1), ++probes) {
+            const uint16_t slot = slots_[i].load(std::memory_order_acquire);
+            if (slot == 0) return INVALID_STREAM_NAME_ID;
+            if (stream_name_equal(names_[slot - 1], key)) return static_cast<uint16_t>(slot - 1);
+        }
+        return INVALID_STREAM_NAME_ID;
+    }
+
+    uint16_t insert_canonical(const uint8_t *key) {
+        std::lock_guard<std::mutex> lock(insert_mutex_);
+        const uint16_t existing = find_canonical(key);
+        if (existing != INVALID_STREAM_NAME_ID) return existing;
+
+        const uint32_t id = count_.load(std::memory_order_relaxed);
+        if (id >= CAPACITY) return INVALID_STREAM_NAME_ID;
+        memcpy(names_[id], key, STREAM_NAME_SIZE);
+        uint32_t i = stream_name_hash(key) & (SLOTS - 1);
+        while (slots_[i].load(std::memory_order_relaxed) != 0) {
+            i = (i + 1) & (SLOTS - 1);
+        }
+        count_.store(id + 1, std::memory_order_release);
+        slots_[i].store(static_cast<uint16_t>(id + 1), std::memory_order_release);
+        return static_cast<uint16_t>(id);
+    }
+
+    alignas(16) char       names_[CAPACITY][STREAM_NAME_SIZE] = {};
+    std::atomic<uint16_t>  slots_[SLOTS];
+    std::atomic<uint32_t>  count_{0};
+    std::mutex             insert_mutex_;
+};
+
+inline stream_name_table &stream_names() {
+    static stream_name_table table;
+    return table;
+}
+
+inline stream_name_id intern_stream_name(std::string_view stream_name) {
+    return {stream_names().intern(stream_name)};
+}
+
+/*
+    Interned id of the frame's stream_name, or INVALID_STREAM_NAME_ID if the parameter type has none.
+*/
+inline uint16_t frame_stream_name_id(const message &msg, stream_name_table &table = stream_names()) {
+    const int16_t offset = stream_name_offset(msg.param_type);
+    if (offset < 0) return INVALID_STREAM_NAME_ID;
+    return table.intern_field(reinterpret_cast<const char *>(&msg.data[offset]));
+}
+
+/*
+    Lets every pack_* template accept a stream_name_id in place of a name.
+*/
+inline std::string_view stream_name_source_view(stream_name_id id) {
+    return stream_names().view(id.value);
+}
+
+#endif // STREAM_NAMES_HPP
@@ -0,0 +1,290 @@
+#pragma once
+
+#ifndef TELEMETRY_LOD_HPP
+#define TELEMETRY_LOD_HPP
+
+#include <algorithm>
+#include <cfloat>
+#include <vector>
+#include <stdint.h>
+
+#include "msg_defs.hpp"
+
+/*
+------------------------------------------------------------------------------------------------------------------------
+    TELEMETRY LEVEL OF DETAIL
+
+    Min/max/mean pyramids for plotting telemetry over whole missions. A lod_series keeps config.levels levels of
+    time-aligned buckets. Level 0 buckets are config.base_bucket_us wide and each level above is config.fanout times
+    wider. Every level is a ring of config.buckets_per_level buckets, so memory is fixed when the series is created:
+    fine levels hold the recent past and coarse levels reach back over the whole mission.
+
+    append() updates one bucket per level. query() answers "n buckets over [t0, t1]" from the coarsest level whose
+    buckets are no wider than (t1 - t0) / n and that still covers t0. It reads fewer than n * fanout + 1 buckets
+    whatever the length of the history, or at most buckets_per_level once the top level is reached. Output buckets
+    are built from whole level buckets, so their edges are exact only to the width of the level used.
+
+    telemetry_lod feeds a set of series from unpacked frames: NAVIGATION velocities and altitude, SYSTEM_STATUS
+    jetson_temp, and global yaw and pitch per track_id for a bounded number of tracks. Nothing is thread-safe.
+------------------------------------------------------------------------------------------------------------------------
+*/
+struct lod_config {
+    uint64_t base_bucket_us    = 1000;
+    uint32_t fanout            = 4;
+    uint32_t levels            = 12;     // 1 ms .. 4^11 ms (70 min) buckets by default.
+    uint32_t buckets_per_level = 4096;   // Ring size per level; sets the memory cap.
+};
+
+struct lod_bucket {
+    float    min;
+    float    max;
+    double   sum;
+    uint32_t count;   // 0: no samples.
+
+    float mean() const {
+        return count == 0 ? 0.0f : static_cast<float>(sum / count);
+    }
+};
+
+class lod_series {
+public:
+    explicit lod_series(const lod_config &config = lod_config()) : config_(config) {
+        config_.fanout            = std::max<uint32_t>(2, config_.fanout);
+        config_.levels            = std::max<uint32_t>(1, config_.levels);
+        config_.buckets_per_level = std::max<uint32_t>(2, config_.buckets_per_level);
+        config_.base_bucket_us    = std::max<uint64_t>(1, config_.base_bucket_us);
+        width_us_.resize(config_.levels);
+        newest_.assign(config_.levels, 0);
+        uint64_t width = config_.base_bucket_us;
+        for (uint32_t k = 0; k < config_.levels; ++k, width *= config_.fanout) width_us_[k] = width;
+        slots_.resize(static_cast<size_t>(config_.levels) * config_.buckets_per_level);
+        for (slot &s : slots_) s.index = UINT64_MAX;
+    }
+
+    /*
+        Adds one sample. Samples may arrive slightly out of order; a sample older than what a level still holds only
+        updates the coarser levels.
+    */
+    void append(uint64_t t_us, float value) {
+        for (uint32_t k = 0; k < config_.levels; ++k) {
+            const uint64_t index = t_us / width_us_[k];
+            if (samples_ != 0 && index + config_.buckets_per_level <= newest_[k]) continue;
+            slot &s = slots_[static_cast<size_t>(k) * config_.buckets_per_level + index % config_.buckets_per_level];
+            if (s.index != index) {
+                s.index  = index;
+                s.bucket = {value, value, 0.0, 0};
+            }
+            s.bucket.min = std::min(s.bucket.min, value);
+            s.bucket.max = std::max(s.bucket.max, value);
+            s.bucket.sum += value;
+            s.bucket.count++;
+            if (samples_ == 0 || index > newest_[k]) newest_[k] = index;
+        }
+        first_us_ = samples_ == 0 ? t_us : std::min(first_us_, t_us);
+        last_us_  = samples_ == 0 ? t_us : std::max(last_us_, t_us);
+        samples_++;
+    }
+
+    /*
+        Fills out[0 .. n) with the min, max and mean of the samples in n equal slices of [t0_us, t1_us). Slices with
+        no samples have count 0. Returns the level the answer was built from.
+    */
+    uint32_t query(uint64_t t0_us, uint64_t t1_us, uint32_t n, lod_bucket *out) const {
+        for (uint32_t i = 0; i < n; ++i) out[i] = {FLT_MAX, -FLT_MAX, 0.0, 0};
+        if (n == 0 || t1_us <= t0_us || samples_ == 0) return 0;
+        const uint64_t slice_us = std::max<uint64_t>(1, (t1_us - t0_us + n - 1) / n);
+
+        uint32_t level = 0;
+        while (level + 1 < config_.levels && width_us_[level + 1] <= slice_us) level++;
+        while (level + 1 < config_.levels && !covers(level, t0_us)) level++;
+
+        // Only the recorded span is scanned, which bounds the top level as well.
+        const uint64_t width = width_us_[level];
+        const uint64_t from  = std::max(t0_us, first_us_);
+        const uint64_t to    = std::min(t1_us, last_us_ + 1);
+        const slot *ring = &slots_[static_cast<size_t>(level) * config_.buckets_per_level];
+        for (uint64_t index = from / width; from < to && index <= (to - 1) / width; ++index) {
+            const slot &s = ring[index % config_.buckets_per_level];
+            if (s.index != index) continue;
+            // A level bucket goes to the slice containing its midpoint.
+            const uint64_t middle = index * width + width / 2;
+            const uint64_t i = middle <= t0_us ? 0 : std::min<uint64_t>(n - 1, (middle - t0_us) / slice_us);
+            lod_bucket &o = out[i];
+            o.min = std::min(o.min, s.bucket.min);
+            o.max = std::max(o.max, s.bucket.max);
+            o.sum += s.bucket.sum;
+            o.count += s.bucket.count;
+        }
+        for (uint32_t i = 0; i < n; ++i) {
+            if (out[i].count == 0) out[i].min = out[i].max = 0.0f;
+        }
+        return level;
+    }
+
+    uint64_t samples() const {
+        return samples_;
+    }
+
+    uint64_t first_us() const {
+        return first_us_;
+    }
+
+    uint64_t last_us() const {
+        return last_us_;
+    }
+
+    uint64_t bucket_width_us(uint32_t level) const {
+        return width_us_[level];
+    }
+
+    size_t memory_bytes() const {
+        return slots_.size() * sizeof(slot) + width_us_.size() * sizeof(uint64_t) * 2;
+    }
+
+private:
+    struct slot {
+        uint64_t   index;   // Absolute bucket index (t_us / width); UINT64_MAX when empty.
+        lod_bucket bucket;
+    };
+
+    bool covers(uint32_t level, uint64_t t_us) const {
+        const uint64_t newest = newest_[level];
+        const uint64_t oldest = newest + 1 >= config_.buckets_per_level ? newest + 1 - config_.buckets_per_level : 0;
+        return std::max(t_us, first_us_) / width_us_[level] >= oldest;
+    }
+
+    lod_config            config_;
+    std::vector<uint64_t> width_us_;
+    std::vector<uint64_t> newest_;
+    std::vector<slot>     slots_;
+    uint64_t              samples_  = 0;
+    uint64_t              first_us_ = 0;
+    uint64_t              last_us_  = 0;
+};
+
+enum TELEMETRY_SERIES : uint8_t {
+    SERIES_ALTITUDE,
+    SERIES_VISUAL_VEL_X,
+    SERIES_VISUAL_VEL_Y,
+    SERIES_VISUAL_VEL_Z,
+    SERIES_JETSON_TEMP,
+    TELEMETRY_SERIES_COUNT,
+};
+
+class telemetry_lod {
+public:
+    /*
+        track_config is used for the per-track series; at most max_tracks tracks are kept, and the one updated
+        longest ago makes room for a new one.
+    */
+    explicit telemetry_lod(const lod_config &config = lod_config(),
+                           const lod_config &track_config = default_track_config(), uint32_t max_tracks = 32)
+        : series_(TELEMETRY_SERIES_COUNT, lod_series(config)), track_config_(track_config) {
+        tracks_.reserve(max_tracks);
+        max_tracks_ = std::max<uint32_t>(1, max_tracks);
+    }
+
+    static lod_config default_track_config() {
+        lod_config config;
+        config.buckets_per_level = 256;
+        return config;
+    }
+
+    /*
+        Adds the plotted fields of a CURRENT_PARAMETERS frame. NAVIGATION and SYSTEM_STATUS are stamped with
+        receive_us; TRACKED_DETECTION uses its publish timestamp when the sender provides one. Returns false for
+        frames that carry none of the plotted fields.
+    */
+    bool observe(message &msg, uint64_t receive_us) {
+        if (msg.message_type != CURRENT_PARAMETERS) return false;
+        switch (msg.param_type) {
+            case NAVIGATION: {
+                navigation_parameters nav;
+                unpack_navigation_parameters(msg, nav);
+                series_[SERIES_ALTITUDE].append(receive_us, nav.altitude);
+                series_[SERIES_VISUAL_VEL_X].append(receive_us, nav.visual_vel_x);
+                series_[SERIES_VISUAL_VEL_Y].append(receive_us, nav.visual_vel_y);
+                series_[SERIES_VISUAL_VEL_Z].append(receive_us, nav.visual_vel_z);
+                return true;
+            }
+            case SYSTEM_STATUS: {
+                system_status_parameters status;
+                unpack_system_status_parameters(msg, status);
+                series_[SERIES_JETSON_TEMP].append(receive_us, status.jetson_temp);
+                return true;
+            }
+            case TRACKED_DETECTION: {
+                tracked_detection_parameters det;
+                unpack_tracked_detection_parameters(msg, det);
+                if (det.track_id == 0) return false;
+                const uint64_t t_us = det.publish_timestamp_us != 0 ? det.publish_timestamp_us : receive_us;
+                track_series &track = track_for(det.track_id, t_us);
+                track.yaw.append(t_us, det.yaw_global);
+                track.pitch.append(t_us, det.pitch_global);
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+
+    const lod_series &series(TELEMETRY_SERIES which) const {
+        return series_[which];
+    }
+
+    const lod_series *track_yaw(uint16_t track_id) const {
+        const track_series *track = find(track_id);
+        return track == nullptr ? nullptr : &track->yaw;
+    }
+
+    const lod_series *track_pitch(uint16_t track_id) const {
+        const track_series *track = find(track_id);
+        return track == nullptr ? nullptr : &track->pitch;
+    }
+
+    size_t memory_bytes() const {
+        size_t bytes = 0;
+        for (const lod_series &s : series_) bytes += s.memory_bytes();
+        for (const track_series &t : tracks_) bytes += t.yaw.memory_bytes() + t.pitch.memory_bytes();
+        return bytes;
+    }
+
+private:
+    struct track_series {
+        uint16_t   track_id;
+        uint64_t   last_us;
+        lod_series yaw;
+        lod_series pitch;
+    };
+
+    const track_series *find(uint16_t track_id) const {
+        for (const track_series &t : tracks_) {
+            if (t.track_id == track_id) return &t;
+        }
+        return nullptr;
+    }
+
+    track_series &track_for(uint16_t track_id, uint64_t t_us) {
+        track_series *oldest = nullptr;
+        for (track_series &t : tracks_) {
+            if (t.track_id == track_id) {
+                t.last_us = std::max(t.last_us, t_us);
+                return t;
+            }
+            if (oldest == nullptr || t.last_us < oldest->last_us) oldest = &t;
+        }
+        if (tracks_.size() < max_tracks_) {
+            tracks_.push_back({track_id, t_us, lod_series(track_config_), lod_series(track_config_)});
+            return tracks_.back();
+        }
+        *oldest = {track_id, t_us, lod_series(track_config_), lod_series(track_config_)};
+        return *oldest;
+    }
+
+    std::vector<lod_series>   series_;
+    lod_config                track_config_;
+    std::vector<track_series> tracks_;
+    uint32_t                  max_tracks_;
+};
+
+#endif // TELEMETRY_LOD_HPP
@@ -0,0 +1,253 @@
+/*
+    capture_reader_test: capture_recorder -> capture_reader round trip, sidecar index reuse, and recovery from corrupt
+    or truncated sidecars and captures.
+*/
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <unistd.h>
+
+#include "../capture_reader.hpp"
+#include "../capture_recorder.hpp"
+#include "test_check.hpp"
+
+static const uint32_t FRAMES = 5000;
+
+static std::string temp_path(const char *suffix) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "/tmp/capture_reader_test_%d%s", static_cast<int>(getpid()), suffix);
+    return buffer;
+}
+
+static void write_capture(const std::string &path, bool compress) {
+    capture_recorder recorder;
+    capture_recorder_config config;
+    config.path       = path.c_str();
+    config.block_size = 16384;   // Small blocks so the capture has many of them.
+    config.compress   = compress;
+    CHECK(recorder.open(config));
+    for (uint32_t i = 0; i < FRAMES; ++i) {
+        message msg = {};
+        msg.version      = VERSION;
+        msg.message_type = CURRENT_PARAMETERS;
+        if (i % 2 == 0) {
+            pack_tracked_detection_parameters(msg, 1, 0, 200, 1, 1.0f, 2.0f, 0, 0, 0, 52.0f, 5.0f, 10.0f, 100.0f, 0.1f, 0.1f,
+                                              static_cast<uint16_t>(1 + i % 10));
+        } else {
+            pack_navigation_parameters(msg, 100.0f);
+        }
+        add_checksum_for_digiview_message(msg);
+        while (!recorder.record(msg, CAPTURE_RECEIVED, 0, 1000000ULL + i)) {
+        }
+    }
+    recorder.close();
+    CHECK(recorder.stats().records_written == FRAMES);
+}
+
+static uint64_t count(capture_reader &reader, const capture_query &q = capture_query()) {
+    return reader.query(q, [](const capture_record &) {});
+}
+
+static void overwrite(const std::string &path, long offset, const void *data, size_t size) {
+    FILE *file = fopen(path.c_str(), "r+b");
+    CHECK(file != nullptr);
+    if (file == nullptr) return;
+    fseek(file, offset, SEEK_SET);
+    fwrite(data, size, 1, file);
+    fclose(file);
+}
+
+static void check_queries(capture_reader &reader) {
+    CHECK(count(reader) == FRAMES);
+    capture_query by_track;
+    by_track.track_id = 3;
+    CHECK(count(reader, by_track) == FRAMES / 10);   // Even frames cycle through tracks 1, 3, 5, 7, 9.
+    capture_query by_type;
+    by_type.param_type = NAVIGATION;
+    CHECK(count(reader, by_type) == FRAMES / 2);
+    capture_query by_time;
+    by_time.from_us = 1000000ULL + 100;
+    by_time.to_us   = 1000000ULL + 199;
+    CHECK(count(reader, by_time) == 100);
+}
+
+static void test_round_trip_and_sidecar(bool compress) {
+    const std::string path    = temp_path(compress ? "_z.dvc" : ".dvc");
+    const std::string sidecar = path + ".idx";
+    write_capture(path, compress);
+
+    {
+        capture_reader reader;
+        CHECK(reader.open(path.c_str()));
+        CHECK(reader.index().size() > 1);
+        check_queries(reader);
+        CHECK(access(sidecar.c_str(), F_OK) == 0);
+    }
+    size_t blocks;
+    {
+        // Second open reuses the sidecar.
+        capture_reader reader;
+        CHECK(reader.open(path.c_str()));
+        blocks = reader.index().size();
+        check_queries(reader);
+    }
+
+    const long entries = static_cast<long>(sizeof(capture_index_header));
+    const long count_field = static_cast<long>(offsetof(capture_index_header, block_count));
+
+    // Absurd block count: must not allocate for it, and the index is rebuilt from the capture.
+    const uint64_t huge = 1ULL << 40;
+    overwrite(sidecar, count_field, &huge, sizeof(huge));
+    {
+        capture_reader reader;
+        CHECK(reader.open(path.c_str()));
+        CHECK(reader.index().size() == blocks);
+        check_queries(reader);
+    }
+
+    // Entry pointing past the end of the capture.
+    const uint64_t past_end = 1ULL << 50;
+    overwrite(sidecar, entries + static_cast<long>(offsetof(capture_block_index_entry, offset)), &past_end, sizeof(past_end));
+    {
+        capture_reader reader;
+        CHECK(reader.open(path.c_str()));
+        check_queries(reader);
+    }
+
+    // Misaligned entry, and an entry whose record count disagrees with its block.
+    const uint64_t misaligned = CAPTURE_BLOCK_ALIGNMENT + 8;
+    overwrite(sidecar, entries + static_cast<long>(offsetof(capture_block_index_entry, offset)), &misaligned, sizeof(misaligned));
+    {
+        capture_reader reader;
+        CHECK(reader.open(path.c_str()));
+        check_queries(reader);
+    }
+    const uint32_t records = 1U << 30;
+    overwrite(sidecar, entries + static_cast<long>(offsetof(capture_block_index_entry, record_count)), &records, sizeof(records));
+    {
+        capture_reader reader;
+        CHECK(reader.open(path.c_str()));
+        check_queries(reader);
+    }
+
+    // Truncated sidecar.
+    CHECK(truncate(sidecar.c_str(), static_cast<off_t>(sizeof(capture_index_header) + 10)) == 0);
+    {
+        capture_reader reader;
+        CHECK(reader.open(path.c_str()));
+        check_queries(reader);
+    }
+
+    // Truncated capture: only whole blocks before the cut are indexed.
+    struct stat st;
+    CHECK(stat(path.c_str(), &st) == 0);
+    CHECK(truncate(path.c_str(), st.st_size / 2 + 100) == 0);
+    {
+        capture_reader reader;
+        CHECK(reader.open(path.c_str()));
+        CHECK(reader.index().size() < blocks);
+        uint64_t indexed = 0;
+        for (const capture_block_index_entry &entry : reader.index()) indexed += entry.record_count;
+        CHECK(count(reader) == indexed);
+        CHECK(indexed < FRAMES);
+    }
+
+    remove(path.c_str());
+    remove(sidecar.c_str());
+}
+
+static void test_many_tracks_per_block() {
+    // Every block holds well over 1000 distinct tracks. Track 60000 only occurs in a short run of records, so a query
+    // for it must read the one or two blocks holding that run, and a query for an absent track must read none.
+    const std::string path    = temp_path("_tracks.dvc");
+    const std::string sidecar = path + ".idx";
+    const uint32_t    frames  = 40000;
+    const uint32_t    tracks  = 1500;
+    {
+        capture_recorder recorder;
+        capture_recorder_config config;
+        config.path       = path.c_str();
+        config.block_size = 1U << 20;
+        CHECK(recorder.open(config));
+        for (uint32_t i = 0; i < frames; ++i) {
+            const bool rare = i >= 20000 && i < 20010;
+            message msg = {};
+            msg.version      = VERSION;
+            msg.message_type = CURRENT_PARAMETERS;
+            pack_tracked_detection_parameters(msg, 1, 0, 200, 1, 1.0f, 2.0f, 0, 0, 0, 52.0f, 5.0f, 10.0f, 100.0f, 0.1f,
+                                              0.1f, static_cast<uint16_t>(rare ? 60000 : 1 + i % tracks));
+            add_checksum_for_digiview_message(msg);
+            while (!recorder.record(msg, CAPTURE_RECEIVED, 0, 1000000ULL + i)) {
+            }
+        }
+        recorder.close();
+        CHECK(recorder.stats().records_written == frames);
+    }
+
+    for (int pass = 0; pass < 2; ++pass) {   // Built from the capture, then loaded from the sidecar.
+        capture_reader reader;
+        CHECK(reader.open(path.c_str()));
+        CHECK(reader.index().size() >= 4);
+        for (const capture_block_index_entry &entry : reader.index()) CHECK(entry.track_count >= 1000);
+
+        capture_query rare;
+        rare.track_id = 60000;
+        CHECK(count(reader, rare) == 10);
+        CHECK(reader.blocks_scanned() >= 1 && reader.blocks_scanned() <= 2);
+
+        capture_query absent;
+        absent.track_id = 60001;
+        CHECK(count(reader, absent) == 0);
+        CHECK(reader.blocks_scanned() == 0);
+
+        capture_query common;
+        common.track_id = 7;
+        CHECK(count(reader, common) == (frames - 10) / tracks + 1);
+        CHECK(reader.blocks_scanned() == reader.index().size());
+    }
+
+    // An unsorted track list in the sidecar is rejected and the index rebuilt.
+    uint64_t block_count = 0;
+    {
+        capture_reader reader;
+        CHECK(reader.open(path.c_str()));
+        block_count = reader.index().size();
+    }
+    const long track_ids =
+        static_cast<long>(sizeof(capture_index_header) + block_count * sizeof(capture_block_index_entry));
+    const uint16_t unsorted = 0xFFFF;
+    overwrite(sidecar, track_ids, &unsorted, sizeof(unsorted));
+    {
+        capture_reader reader;
+        CHECK(reader.open(path.c_str()));
+        capture_query rare;
+        rare.track_id = 60000;
+        CHECK(count(reader, rare) == 10);
+        CHECK(reader.track_ids().front() != 0xFFFF);
+    }
+
+    remove(path.c_str());
+    remove(sidecar.c_str());
+}
+
+static void test_rejects_non_capture() {
+    const std::string path = temp_path("_junk.dvc");
+    FILE *file = fopen(path.c_str(), "wb");
+    CHECK(file != nullptr);
+    if (file == nullptr) return;
+    static const uint8_t junk[CAPTURE_BLOCK_ALIGNMENT * 2] = {1, 2, 3};
+    fwrite(junk, sizeof(junk), 1, file);
+    fclose(file);
+    capture_reader reader;
+    CHECK(!reader.open(path.c_str()));
+    remove(path.c_str());
+}
+
+int main() {
+    test_round_trip_and_sidecar(false);
+    test_round_trip_and_sidecar(true);
+    test_many_tracks_per_block();
+    test_rejects_non_capture();
+    return test_result();
+}
@@ -0,0 +1,125 @@
+/*
+    coalescing_queue_test: keying, delta merging and capacity of the coalescing outbound queue (coalescing_queue.hpp).
+*/
+#include "../coalescing_queue.hpp"
+#include "test_check.hpp"
+
+static const View::TargetingMode DIRECTIONAL = static_cast<View::TargetingMode>(0);
+
+static message set_targeting(const char *stream, bool delta, float yaw) {
+    message msg = {};
+    pack_set_cam_targeting_parameters(msg, stream, 0, DIRECTIONAL, delta, yaw, 0, 0, 0, 0, 0, 0, 0, 0);
+    add_checksum_for_digiview_message(msg);
+    return msg;
+}
+
+static message get_targeting(const char *stream, bool delta) {
+    message msg = {};
+    pack_get_parameters(msg, CAM_TARGETING, stream, 0);
+    msg.data[CAM_TARGETING_EULER_DELTA_OFFSET] = delta ? 1 : 0;
+    add_checksum_for_digiview_message(msg);
+    return msg;
+}
+
+static int32_t yaw_mdeg(const message &msg) {
+    int32_t yaw;
+    memcpy(&yaw, &msg.data[CAM_TARGETING_YAW_OFFSET], sizeof(yaw));
+    return yaw;
+}
+
+static void test_zero_keys() {
+    // max_keys = 0 is clamped to one key; find() must still terminate on the first miss.
+    coalescing_queue queue(0);
+    CHECK(queue.push(set_targeting("a", false, 1.0f), 0));
+    CHECK(!queue.push(set_targeting("b", false, 1.0f), 0));
+    CHECK(queue.push(set_targeting("a", false, 2.0f), 1));
+    message out;
+    CHECK(queue.pop(out) && yaw_mdeg(out) == 2000);
+    CHECK(!queue.pop(out));
+    CHECK(queue.push(set_targeting("b", false, 3.0f), 2));
+    CHECK(queue.stats().rejected == 1);
+}
+
+static void test_get_and_set_do_not_coalesce() {
+    coalescing_queue queue;
+    CHECK(queue.push(set_targeting("cam", false, 10.0f), 0));
+    CHECK(queue.push(get_targeting("cam", false), 1));
+    CHECK(queue.depth() == 2);
+    CHECK(queue.stats().coalesced == 0);
+
+    message out;
+    CHECK(queue.pop(out) && out.message_type == SET_PARAMETERS && yaw_mdeg(out) == 10000);
+    CHECK(queue.pop(out) && out.message_type == GET_PARAMETERS);
+}
+
+static void test_delta_merges_only_sets() {
+    coalescing_queue queue;
+    CHECK(queue.push(set_targeting("cam", false, 10.0f), 0));
+    CHECK(queue.push(set_targeting("cam", true, 1.5f), 1));
+    CHECK(queue.push(set_targeting("cam", true, 0.5f), 2));
+    CHECK(queue.stats().merged_deltas == 2);
+
+    // GETs that happen to carry the delta flag are replaced, never folded.
+    CHECK(queue.push(get_targeting("cam", true), 3));
+    CHECK(queue.push(get_targeting("cam", true), 4));
+    CHECK(queue.stats().merged_deltas == 2);
+    CHECK(queue.depth() == 2);
+
+    message out;
+    CHECK(queue.pop(out) && out.message_type == SET_PARAMETERS);
+    CHECK(yaw_mdeg(out) == 12000 && out.data[CAM_TARGETING_EULER_DELTA_OFFSET] == 0);
+    CHECK(has_valid_checksum_for_digiview_message(out));
+    CHECK(queue.pop(out) && out.message_type == GET_PARAMETERS);
+}
+
+static void test_erase_keeps_probing_intact() {
+    // Fill and drain repeatedly with keys that share table neighbourhoods.
+    coalescing_queue queue(4);
+    const char *streams[] = {"s0", "s1", "s2", "s3"};
+    for (int round = 0; round < 50; ++round) {
+        for (const char *stream : streams) CHECK(queue.push(set_targeting(stream, false, static_cast<float>(round)), 0));
+        for (const char *stream : streams) CHECK(!queue.push(get_targeting(stream, false), 0));   // Full of SET keys.
+        message out;
+        uint32_t popped = 0;
+        while (queue.pop(out)) popped++;
+        CHECK(popped == 4);
+    }
+}
+
+static void test_reliable_sets_never_coalesce() {
+    // Each reliable SET has its own sequence number; replacing one would leave a gap the receiver never fills.
+    coalescing_queue queue;
+    for (uint16_t sequence = 0; sequence < 3; ++sequence) {
+        message msg = set_targeting("cam", sequence != 0, 1.0f);
+        msg.message_type = SET_PARAMETERS_RELIABLE;
+        msg.interval_ms  = (7U << 16) | sequence;
+        add_checksum_for_digiview_message(msg);
+        CHECK(queue.push(msg, sequence));
+    }
+    CHECK(queue.push(set_targeting("cam", false, 5.0f), 3));
+    CHECK(queue.depth() == 4);
+    CHECK(queue.stats().coalesced == 0);
+
+    message out;
+    for (uint16_t sequence = 0; sequence < 3; ++sequence) {
+        CHECK(queue.pop(out) && out.message_type == SET_PARAMETERS_RELIABLE && reliable_sequence(out) == sequence);
+        CHECK(yaw_mdeg(out) == 1000);
+    }
+    CHECK(queue.pop(out) && out.message_type == SET_PARAMETERS);
+
+    // They still count against max_keys.
+    coalescing_queue small(2);
+    message reliable = set_targeting("cam", false, 1.0f);
+    reliable.message_type = SET_PARAMETERS_RELIABLE;
+    CHECK(small.push(reliable, 0) && small.push(reliable, 0));
+    CHECK(!small.push(reliable, 0));
+}
+
+int main() {
+    test_zero_keys();
+    test_get_and_set_do_not_coalesce();
+    test_delta_merges_only_sets();
+    test_erase_keeps_probing_intact();
+    test_reliable_sets_never_coalesce();
+    return test_result();
+}
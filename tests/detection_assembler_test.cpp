@@ -0,0 +1,141 @@
+/*
+    detection_assembler_test: grouping of TRACKED_DETECTION replies into snapshots (detection_assembler.hpp), with
+    duplicate and late replies and pending-slot eviction.
+*/
+#include <vector>
+
+#include "../detection_assembler.hpp"
+#include "test_check.hpp"
+
+struct emitted {
+    uint64_t publish_timestamp_us;
+    uint8_t  total_detections;
+    uint8_t  count;
+    bool     complete;
+};
+
+struct collector {
+    std::vector<emitted> snapshots;
+
+    void operator()(const detection_snapshot &snapshot) {
+        snapshots.push_back(emitted{snapshot.publish_timestamp_us, snapshot.total_detections, snapshot.count,
+                                    snapshot.complete});
+    }
+};
+
+static tracked_detection_parameters reply(uint64_t publish_timestamp_us, uint8_t total, uint8_t index) {
+    tracked_detection_parameters det = {};
+    det.publish_timestamp_us = publish_timestamp_us;
+    det.total_detections     = total;
+    det.index                = index;
+    det.track_id             = static_cast<uint16_t>(index + 1);
+    return det;
+}
+
+static void test_complete_and_duplicates() {
+    detection_assembler assembler;
+    collector out;
+    assembler.add(reply(1000, 3, 0), 0, out);
+    assembler.add(reply(1000, 3, 0), 0, out);   // Duplicate while pending.
+    assembler.add(reply(1000, 3, 2), 0, out);
+    assembler.add(reply(1000, 3, 1), 0, out);
+    CHECK(out.snapshots.size() == 1);
+    CHECK(out.snapshots[0].complete && out.snapshots[0].count == 3);
+    CHECK(assembler.stats().duplicates == 1);
+
+    // Duplicates of an emitted frame must not open a new pending frame.
+    assembler.add(reply(1000, 3, 1), 10, out);
+    assembler.add(reply(1000, 3, 0), 10, out);
+    assembler.expire(1000000, out);
+    assembler.flush(out);
+    CHECK(out.snapshots.size() == 1);
+    CHECK(assembler.stats().late == 2);
+    CHECK(assembler.stats().incomplete == 0);
+}
+
+static void test_late_after_timeout() {
+    detection_assembler assembler(8, 100);
+    collector out;
+    assembler.add(reply(2000, 2, 0), 0, out);
+    assembler.expire(100, out);
+    CHECK(out.snapshots.size() == 1);
+    CHECK(!out.snapshots[0].complete && out.snapshots[0].count == 1);
+
+    // The missing index arrives after the frame timed out.
+    assembler.add(reply(2000, 2, 1), 150, out);
+    assembler.expire(1000, out);
+    assembler.flush(out);
+    CHECK(out.snapshots.size() == 1);
+    CHECK(assembler.stats().late == 1);
+    CHECK(assembler.stats().incomplete == 1);
+
+    // A new frame with the same total but a new timestamp is still assembled.
+    assembler.add(reply(2100, 2, 0), 200, out);
+    assembler.add(reply(2100, 2, 1), 200, out);
+    CHECK(out.snapshots.size() == 2);
+    CHECK(out.snapshots.back().complete);
+}
+
+static void test_slot_eviction() {
+    detection_assembler assembler(2);
+    collector out;
+    assembler.add(reply(1, 2, 0), 0, out);
+    assembler.add(reply(2, 2, 0), 1, out);
+    assembler.add(reply(3, 2, 0), 2, out);   // Evicts frame 1, the oldest.
+    CHECK(out.snapshots.size() == 1);
+    CHECK(out.snapshots[0].publish_timestamp_us == 1 && !out.snapshots[0].complete);
+
+    // The rest of the evicted frame is dropped; it must not evict frame 2 in turn.
+    assembler.add(reply(1, 2, 1), 3, out);
+    CHECK(out.snapshots.size() == 1);
+    CHECK(assembler.stats().late == 1);
+
+    assembler.add(reply(2, 2, 1), 4, out);
+    assembler.add(reply(3, 2, 1), 5, out);
+    CHECK(out.snapshots.size() == 3);
+    CHECK(out.snapshots[1].publish_timestamp_us == 2 && out.snapshots[1].complete);
+    CHECK(out.snapshots[2].publish_timestamp_us == 3 && out.snapshots[2].complete);
+}
+
+static void test_empty_frames() {
+    detection_assembler assembler;
+    collector out;
+    assembler.add(reply(5000, 0, 0), 0, out);
+    assembler.add(reply(5000, 0, 0), 0, out);   // Same empty frame answered twice.
+    CHECK(out.snapshots.size() == 1);
+    CHECK(out.snapshots[0].complete && out.snapshots[0].total_detections == 0);
+    CHECK(assembler.stats().late == 1);
+}
+
+static void test_legacy_timestamps() {
+    // Without publish timestamps frames cannot be told apart, so nothing is dropped as late.
+    detection_assembler assembler;
+    collector out;
+    for (int frame = 0; frame < 3; ++frame) {
+        assembler.add(reply(0, 1, 0), static_cast<uint64_t>(frame), out);
+    }
+    CHECK(out.snapshots.size() == 3);
+    CHECK(assembler.stats().late == 0);
+}
+
+static void test_recent_keys_bounded() {
+    detection_assembler assembler(8, 200000, 4);
+    collector out;
+    for (uint64_t ts = 1; ts <= 5; ++ts) assembler.add(reply(ts, 1, 0), ts, out);
+    CHECK(out.snapshots.size() == 5);
+    // Key 1 has been pushed out of the ring of 4, key 5 has not.
+    assembler.add(reply(1, 1, 0), 10, out);
+    assembler.add(reply(5, 1, 0), 10, out);
+    CHECK(out.snapshots.size() == 6);
+    CHECK(assembler.stats().late == 1);
+}
+
+int main() {
+    test_complete_and_duplicates();
+    test_late_after_timeout();
+    test_slot_eviction();
+    test_empty_frames();
+    test_legacy_timestamps();
+    test_recent_keys_bounded();
+    return test_result();
+}
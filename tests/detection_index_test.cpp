@@ -0,0 +1,99 @@
+/*
+    detection_index_test: radius and nearest queries of the detection index (detection_index.hpp) against a linear
+    scan, including cell sizes that do not divide 360 and caps that wrap across 0 / 360 and +-180 degrees.
+*/
+#include <algorithm>
+#include <vector>
+
+#include "../detection_index.hpp"
+#include "test_check.hpp"
+
+static tracked_detection_parameters detection(uint16_t track_id, float yaw, float pitch) {
+    tracked_detection_parameters det = {};
+    det.track_id     = track_id;
+    det.yaw_global   = yaw;
+    det.pitch_global = pitch;
+    return det;
+}
+
+static std::vector<uint16_t> found_ids(const detection_hit *hits, uint32_t count) {
+    std::vector<uint16_t> ids;
+    for (uint32_t i = 0; i < count; ++i) ids.push_back(hits[i].track_id);
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+static void test_wrap_with_uneven_cells() {
+    // 360 / 0.7 is not a whole number: yaw -0.95 wraps into the last, narrower column unless the cell is rounded.
+    detection_index_config config;
+    config.bearing_cell_deg = 0.7;
+    detection_index index(config);
+    CHECK(index.update(detection(1, -0.95f, 0.0f), 0));
+
+    detection_hit hits[4];
+    CHECK(index.within_bearing(-0.95f, 0.0f, 0.02f, hits, 4) == 1);
+    CHECK(hits[0].track_id == 1);
+    CHECK(index.within_bearing(359.05f, 0.0f, 0.02f, hits, 4) == 1);
+    CHECK(index.within_bearing(-360.95f, 0.0f, 0.02f, hits, 4) == 1);
+    CHECK(index.nearest_bearing(-0.95f, 0.0f, 1, hits) == 1);
+    CHECK(hits[0].track_id == 1);
+}
+
+static void test_wrap_matches_linear_scan() {
+    const double cells[] = {0.7, 1.3, 2.0, 7.0, 50.0};
+    std::vector<tracked_detection_parameters> dets;
+    uint16_t track_id = 1;
+    // Detections straddling 0 / 360 and +-180, at several latitudes.
+    const float yaws[]    = {-3.1f, -0.95f, -0.01f, 0.0f, 0.3f, 2.6f, 179.2f, 179.99f, -179.99f, -178.4f, 358.8f};
+    const float pitches[] = {-60.0f, -5.0f, 0.0f, 0.4f, 33.0f, 71.0f};
+    for (float yaw : yaws) {
+        for (float pitch : pitches) dets.push_back(detection(track_id++, yaw, pitch));
+    }
+
+    const float query_yaws[] = {-721.0f, -359.5f, -1.0f, 0.0f, 0.2f, 180.0f, -180.0f, 359.9f, 361.2f};
+    const float radii[]      = {0.02f, 0.5f, 1.5f, 4.0f, 12.0f};
+    detection_hit hits[128];
+    for (double cell : cells) {
+        detection_index_config config;
+        config.bearing_cell_deg = cell;
+        detection_index index(config);
+        for (const tracked_detection_parameters &det : dets) CHECK(index.update(det, 0));
+
+        for (float yaw : query_yaws) {
+            for (float pitch : pitches) {
+                for (float radius : radii) {
+                    std::vector<uint16_t> expected;
+                    for (const tracked_detection_parameters &det : dets) {
+                        if (angular_distance_deg(yaw, pitch, det.yaw_global, det.pitch_global) <= radius) {
+                            expected.push_back(det.track_id);
+                        }
+                    }
+                    const uint32_t count = index.within_bearing(yaw, pitch, radius, hits, 128);
+                    CHECK(found_ids(hits, count) == expected);
+                }
+            }
+        }
+    }
+}
+
+static void test_nearest_across_zero() {
+    detection_index_config config;
+    config.bearing_cell_deg = 0.7;
+    detection_index index(config);
+    CHECK(index.update(detection(1, 359.6f, 0.0f), 0));
+    CHECK(index.update(detection(2, 0.5f, 0.0f), 0));
+    CHECK(index.update(detection(3, 3.0f, 0.0f), 0));
+
+    detection_hit hits[3];
+    CHECK(index.nearest_bearing(-0.1f, 0.0f, 3, hits) == 3);
+    CHECK(hits[0].track_id == 1);
+    CHECK(hits[1].track_id == 2);
+    CHECK(hits[2].track_id == 3);
+}
+
+int main() {
+    test_wrap_with_uneven_cells();
+    test_wrap_matches_linear_scan();
+    test_nearest_across_zero();
+    return test_result();
+}
@@ -0,0 +1,135 @@
+/*
+    latency_histogram_test: bucket mapping, percentiles and shard merging of the latency histograms
+    (latency_histogram.hpp), checked against distributions whose exact percentiles are known.
+*/
+#include <thread>
+#include <vector>
+
+#include "../latency_histogram.hpp"
+#include "test_check.hpp"
+
+// A reported percentile is the upper edge of the bucket holding the exact value: never below it, at most 1/32 above.
+static bool close_above(uint64_t reported, uint64_t exact) {
+    return reported >= exact && reported - exact <= exact / LATENCY_SUB_BUCKETS;
+}
+
+static void test_buckets() {
+    uint32_t previous = 0;
+    for (uint64_t v = 0; v < (1U << 20); ++v) {
+        const uint32_t bucket = latency_bucket(v);
+        CHECK(bucket >= previous && bucket < LATENCY_BUCKETS);
+        CHECK(close_above(latency_bucket_upper(bucket), v));
+        if (v < LATENCY_SUB_BUCKETS) CHECK(latency_bucket_upper(bucket) == v);
+        previous = bucket;
+    }
+    for (uint32_t exponent = 20; exponent <= LATENCY_MAX_EXPONENT; ++exponent) {
+        const uint64_t edges[] = {1ULL << exponent, (1ULL << exponent) + 12345, (2ULL << exponent) - 1};
+        for (uint64_t v : edges) {
+            const uint32_t bucket = latency_bucket(v);
+            CHECK(bucket == LATENCY_BUCKETS - 1 ? latency_bucket_upper(bucket) == UINT64_MAX
+                                                : close_above(latency_bucket_upper(bucket), v));
+        }
+    }
+    CHECK(latency_bucket(1ULL << 40) == LATENCY_BUCKETS - 1);
+    CHECK(latency_bucket(UINT64_MAX) == LATENCY_BUCKETS - 1);
+    for (uint32_t msb = 0; msb < 64; ++msb) {
+        CHECK(latency_msb(1ULL << msb) == msb && latency_msb((2ULL << msb) - 1) == msb);
+    }
+}
+
+static void test_uniform() {
+    // 1..100000 us once each: p50 = 50000, p99 = 99000, p99.9 = 99900.
+    latency_histograms histograms;
+    latency_shard *shard = histograms.register_thread();
+    for (uint64_t v = 1; v <= 100000; ++v) shard->record(NAVIGATION, v);
+    const latency_summary s = histograms.summarize(NAVIGATION);
+    CHECK(s.count == 100000);
+    CHECK(close_above(s.p50_us, 50000));
+    CHECK(close_above(s.p99_us, 99000));
+    CHECK(close_above(s.p999_us, 99900));
+    CHECK(s.max_us == 100000);
+    CHECK(histograms.summarize(CAM_TARGETING).count == 0);
+}
+
+static void test_small_values_exact() {
+    // Below 2^LATENCY_SUB_BITS every value has its own bucket, so percentiles are exact.
+    latency_histograms histograms;
+    latency_shard *shard = histograms.register_thread();
+    for (uint32_t round = 0; round < 10; ++round) {
+        for (uint64_t v = 0; v < 20; ++v) shard->record(DETECTION, v);
+    }
+    const latency_summary s = histograms.summarize(DETECTION);
+    CHECK(s.p50_us == 9 && s.p99_us == 19 && s.p999_us == 19 && s.max_us == 19);
+}
+
+static void test_long_tail() {
+    // 99.8% at 100 us, 0.2% at 1 s: p99 stays at 100 us, p99.9 lands in the tail, max is exact.
+    latency_histograms histograms;
+    latency_shard *shard = histograms.register_thread();
+    for (uint32_t i = 0; i < 99800; ++i) shard->record(TRACKED_DETECTION, 100);
+    for (uint32_t i = 0; i < 199; ++i) shard->record(TRACKED_DETECTION, 1000000);
+    shard->record(TRACKED_DETECTION, 1000003);
+    const latency_summary s = histograms.summarize(TRACKED_DETECTION);
+    CHECK(close_above(s.p50_us, 100) && close_above(s.p99_us, 100));
+    CHECK(close_above(s.p999_us, 1000000) && s.p999_us <= s.max_us);
+    CHECK(s.max_us == 1000003);
+
+    // Values beyond 2^LATENCY_MAX_EXPONENT share the last bucket; the maximum is still exact.
+    shard->record(SYSTEM_STATUS, 1ULL << 45);
+    CHECK(histograms.summarize(SYSTEM_STATUS).max_us == 1ULL << 45);
+    CHECK(histograms.summarize(SYSTEM_STATUS).p50_us == 1ULL << 45);
+}
+
+static void test_merge_across_threads() {
+    // The same samples split over four recording threads summarize like one shard holding them all.
+    latency_histograms split;
+    latency_histograms single;
+    latency_shard *all = single.register_thread();
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < 4; ++t) {
+        latency_shard *shard = split.register_thread();
+        threads.emplace_back([shard, t] {
+            for (uint64_t v = t; v < 200000; v += 4) shard->record(NAVIGATION, v * 7 % 50021);
+        });
+    }
+    for (std::thread &thread : threads) thread.join();
+    for (uint64_t v = 0; v < 200000; ++v) all->record(NAVIGATION, v * 7 % 50021);
+
+    std::vector<uint64_t> merged(LATENCY_BUCKETS), expected(LATENCY_BUCKETS);
+    CHECK(split.merge(NAVIGATION, merged.data()) == single.merge(NAVIGATION, expected.data()));
+    CHECK(merged == expected);
+    const latency_summary a = split.summarize(NAVIGATION);
+    const latency_summary b = single.summarize(NAVIGATION);
+    CHECK(a.count == 200000 && a.count == b.count);
+    CHECK(a.p50_us == b.p50_us && a.p99_us == b.p99_us && a.p999_us == b.p999_us && a.max_us == b.max_us);
+    CHECK(close_above(a.p50_us, 25010));
+}
+
+static void test_record_frame() {
+    latency_histograms histograms;
+    latency_shard *shard = histograms.register_thread();
+    message msg = {};
+    pack_navigation_parameters(msg, 100.0f);
+    msg.timestamp = 5000;
+    shard->record_frame(msg, 5250);
+    shard->record_frame(msg, 4000);   // Clock skew: recorded as 0.
+    msg.timestamp = 0;
+    shard->record_frame(msg, 9000);   // No publish time: ignored.
+    const latency_summary s = histograms.summarize(NAVIGATION);
+    CHECK(s.count == 2 && s.max_us == 250);
+    CHECK(s.p50_us == 0);
+
+    // param_type values past the table share its last slot.
+    shard->record(200, 7);
+    CHECK(histograms.summarize(LATENCY_PARAM_TYPES - 1).count == 1);
+}
+
+int main() {
+    test_buckets();
+    test_uniform();
+    test_small_values_exact();
+    test_long_tail();
+    test_merge_across_threads();
+    test_record_frame();
+    return test_result();
+}
@@ -0,0 +1,66 @@
+/*
+    multicast_group_test: group assignment of the multicast fan-out (multicast_transport.hpp). Stream groups must
+    depend only on the stream name, not on the order in which a process interned its names.
+*/
+#include "../multicast_transport.hpp"
+#include "test_check.hpp"
+
+static message targeting_frame(const char *stream_name) {
+    message msg = {};
+    msg.version      = VERSION;
+    msg.message_type = CURRENT_PARAMETERS;
+    pack_cam_targeting_parameters(msg, stream_name, 0, static_cast<View::TargetingMode>(0), false, 0.0f, 0.0f, 0.0f, 0,
+                                  0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+    return msg;
+}
+
+static void test_independent_of_interning_order() {
+    // A subscriber that interned other names first must still compute the sender's group.
+    const uint32_t before = multicast_stream_group("camera2");
+    intern_stream_name("zoom");
+    intern_stream_name("camera9");
+    intern_stream_name("camera2");
+    CHECK(multicast_stream_group("camera2") == before);
+    CHECK(multicast_group_index(targeting_frame("camera2"), GROUP_BY_STREAM) == static_cast<int32_t>(before));
+
+    stream_name_table local;
+    local.intern("camera2");
+    CHECK(multicast_stream_group(local.view(0)) == before);
+}
+
+static void test_group_range_and_fallback() {
+    const char *names[] = {"", "cam", "camera1", "camera2", "eo", "ir", "a_sixteen_chars_", "longer_than_sixteen_chars"};
+    for (const char *name : names) {
+        const uint32_t group = multicast_stream_group(name);
+        CHECK(group >= MULTICAST_STREAM_GROUP_OFFSET && group < MULTICAST_GROUPS);
+    }
+    // Names are compared as their 16-byte wire field, so longer names map like their truncation.
+    CHECK(multicast_stream_group("longer_than_sixteen_chars") == multicast_stream_group("longer_than_sixt"));
+    CHECK(multicast_stream_group(std::string_view("cam\0junk", 8)) == multicast_stream_group("cam"));
+
+    message nav = {};
+    pack_navigation_parameters(nav, 100.0f);
+    CHECK(multicast_group_index(nav, GROUP_BY_STREAM) == NAVIGATION);
+    CHECK(multicast_group_index(targeting_frame("cam"), GROUP_BY_PARAM_TYPE) == CAM_TARGETING);
+}
+
+static void test_spread() {
+    // Similar names should not pile onto a few groups.
+    bool used[MULTICAST_STREAM_GROUPS] = {};
+    uint32_t distinct = 0;
+    for (uint32_t i = 0; i < 64; ++i) {
+        char name[16];
+        snprintf(name, sizeof(name), "camera%u", i);
+        const uint32_t group = multicast_stream_group(name) - MULTICAST_STREAM_GROUP_OFFSET;
+        if (!used[group]) distinct++;
+        used[group] = true;
+    }
+    CHECK(distinct >= 48);
+}
+
+int main() {
+    test_independent_of_interning_order();
+    test_group_range_and_fallback();
+    test_spread();
+    return test_result();
+}
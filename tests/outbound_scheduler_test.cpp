@@ -0,0 +1,117 @@
+/*
+    outbound_scheduler_test: byte budget and class selection of the outbound scheduler (outbound_scheduler.hpp). A
+    budget smaller than one frame must still send, and unused budget carries over only up to the bucket cap.
+*/
+#include <vector>
+
+#include "../outbound_scheduler.hpp"
+#include "test_check.hpp"
+
+static const uint32_t FRAME_COST = static_cast<uint32_t>(sizeof(message));
+
+struct recorder {
+    std::vector<TRAFFIC_CLASS> classes;
+
+    bool operator()(const message &, TRAFFIC_CLASS traffic_class) {
+        classes.push_back(traffic_class);
+        return true;
+    }
+};
+
+static void fill(outbound_scheduler &scheduler, TRAFFIC_CLASS traffic_class, uint32_t frames) {
+    message msg = {};
+    for (uint32_t i = 0; i < frames; ++i) CHECK(scheduler.enqueue(msg, traffic_class));
+}
+
+static void test_budget_below_frame_cost() {
+    // A quarter of a frame per tick: one frame every fourth tick, not nothing.
+    outbound_scheduler_config config;
+    config.byte_budget_per_tick = (FRAME_COST + 3) / 4;
+    outbound_scheduler scheduler(config);
+    fill(scheduler, TRAFFIC_NORMAL, 16);
+
+    recorder out;
+    std::vector<uint32_t> per_tick;
+    for (int tick = 0; tick < 16; ++tick) per_tick.push_back(scheduler.run_tick(out));
+    CHECK(out.classes.size() == 4);
+    for (int tick = 0; tick < 16; ++tick) CHECK(per_tick[tick] == (tick % 4 == 3 ? 1U : 0U));
+}
+
+static void test_carry_over_is_capped() {
+    outbound_scheduler_config config;
+    config.byte_budget_per_tick = FRAME_COST + FRAME_COST / 2;
+    config.byte_burst           = FRAME_COST * 3;
+    outbound_scheduler scheduler(config);
+    recorder out;
+
+    // Half a frame left over each tick adds up to an extra frame every other tick.
+    fill(scheduler, TRAFFIC_NORMAL, 6);
+    uint32_t sent = 0;
+    for (int tick = 0; tick < 4; ++tick) sent += scheduler.run_tick(out);
+    CHECK(sent == 6);
+
+    // An idle link saves up no more than the cap.
+    for (int tick = 0; tick < 100; ++tick) CHECK(scheduler.run_tick(out) == 0);
+    fill(scheduler, TRAFFIC_NORMAL, 10);
+    CHECK(scheduler.run_tick(out) == 3);
+    CHECK(scheduler.run_tick(out) == 1);
+
+    // Without byte_burst the bucket holds one tick's budget.
+    outbound_scheduler_config tight;
+    tight.byte_budget_per_tick = FRAME_COST * 2;
+    outbound_scheduler bounded(tight);
+    for (int tick = 0; tick < 10; ++tick) bounded.run_tick(out);
+    fill(bounded, TRAFFIC_NORMAL, 10);
+    CHECK(bounded.run_tick(out) == 2);
+}
+
+static void test_refused_frame_keeps_budget() {
+    outbound_scheduler_config config;
+    config.byte_budget_per_tick = FRAME_COST;
+    config.byte_burst           = FRAME_COST * 2;
+    outbound_scheduler scheduler(config);
+    fill(scheduler, TRAFFIC_NORMAL, 4);
+    CHECK(scheduler.run_tick([](const message &, TRAFFIC_CLASS) { return false; }) == 0);
+    recorder out;
+    CHECK(scheduler.run_tick(out) == 2);
+}
+
+static void test_weighted_round_robin() {
+    outbound_scheduler_config config;
+    config.policy     = SCHEDULE_WEIGHTED;
+    config.weights[0] = 3;
+    config.weights[1] = 2;
+    config.weights[2] = 1;
+    outbound_scheduler scheduler(config);
+    fill(scheduler, TRAFFIC_CONTROL, 30);
+    fill(scheduler, TRAFFIC_NORMAL, 30);
+    fill(scheduler, TRAFFIC_TELEMETRY, 30);
+
+    recorder out;
+    CHECK(scheduler.run_tick(out) == 90);
+    // Each of the first ten rounds is three control, two normal and one telemetry frame, in priority order.
+    const TRAFFIC_CLASS round[] = {TRAFFIC_CONTROL, TRAFFIC_CONTROL, TRAFFIC_CONTROL, TRAFFIC_NORMAL, TRAFFIC_NORMAL,
+                                   TRAFFIC_TELEMETRY};
+    for (uint32_t i = 0; i < 60; ++i) CHECK(out.classes[i] == round[i % 6]);
+}
+
+static void test_strict_priority() {
+    outbound_scheduler scheduler;
+    fill(scheduler, TRAFFIC_TELEMETRY, 2);
+    fill(scheduler, TRAFFIC_NORMAL, 2);
+    fill(scheduler, TRAFFIC_CONTROL, 2);
+    recorder out;
+    CHECK(scheduler.run_tick(out) == 6);
+    const TRAFFIC_CLASS expected[] = {TRAFFIC_CONTROL, TRAFFIC_CONTROL, TRAFFIC_NORMAL, TRAFFIC_NORMAL,
+                                      TRAFFIC_TELEMETRY, TRAFFIC_TELEMETRY};
+    for (uint32_t i = 0; i < 6; ++i) CHECK(out.classes[i] == expected[i]);
+}
+
+int main() {
+    test_budget_below_frame_cost();
+    test_carry_over_is_capped();
+    test_refused_frame_keeps_budget();
+    test_weighted_round_robin();
+    test_strict_priority();
+    return test_result();
+}
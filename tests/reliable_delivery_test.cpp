@@ -0,0 +1,109 @@
+/*
+    reliable_delivery_test: sessions of reliable SET delivery (reliable_delivery.hpp). A restarted client must not have
+    its first SETs dropped as repeats of the previous run.
+*/
+#include <vector>
+
+#include "../reliable_delivery.hpp"
+#include "test_check.hpp"
+
+static message reliable_set(reliable_sender &sender, uint64_t now_us) {
+    message msg = {};
+    pack_set_cam_targeting_parameters(msg, "cam", 0, static_cast<View::TargetingMode>(0), false, 1.0f, 0, 0, 0, 0, 0,
+                                      0, 0, 0);
+    CHECK(sender.send(msg, now_us) >= 0);
+    return msg;
+}
+
+static void test_default_sessions_are_random() {
+    for (int i = 0; i < 100; ++i) {
+        reliable_sender sender;
+        CHECK(sender.session() != 0);
+        CHECK(reliable_session(reliable_set(sender, 0)) == sender.session());
+    }
+
+    reliable_config config;
+    config.session = 42;
+    reliable_sender fixed(config);
+    CHECK(fixed.session() == 42);
+}
+
+static void test_restarted_client_is_applied() {
+    reliable_receiver receiver;
+    uint32_t applied = 0;
+    const auto apply = [&](message &) {
+        applied++;
+        return static_cast<uint8_t>(ACKNOWLEDGEMENT);
+    };
+
+    reliable_sender first;
+    for (int i = 0; i < 3; ++i) {
+        message msg = reliable_set(first, 0);
+        CHECK(receiver.on_message(msg, apply));
+    }
+    CHECK(applied == 3);
+
+    // The client restarts and numbers its SETs from 0 again. Draw until the sessions differ, as a real restart
+    // would almost always do on the first try.
+    reliable_sender second;
+    while (second.session() == first.session()) second = reliable_sender();
+    for (int i = 0; i < 3; ++i) {
+        message msg = reliable_set(second, 0);
+        CHECK(receiver.on_message(msg, apply));
+    }
+    CHECK(applied == 6);
+    CHECK(receiver.stats().duplicates == 0);
+    CHECK(receiver.stats().sessions == 2);
+}
+
+static void test_late_frame_from_replaced_session() {
+    // Session A is replaced by B. A retransmit of A's that was delayed in the network must not be applied, and must
+    // not make the receiver forget what B has already sent.
+    reliable_receiver receiver;
+    uint32_t applied = 0;
+    const auto apply = [&](message &) {
+        applied++;
+        return static_cast<uint8_t>(ACKNOWLEDGEMENT);
+    };
+    reliable_config config;
+    config.session = 100;
+    reliable_sender a(config);
+    config.session = 200;
+    reliable_sender b(config);
+
+    std::vector<message> sent_by_a;
+    for (int i = 0; i < 6; ++i) {
+        sent_by_a.push_back(reliable_set(a, 0));
+        CHECK(receiver.on_message(sent_by_a.back(), apply));
+    }
+    message b0 = reliable_set(b, 0);
+    message b1 = reliable_set(b, 0);
+    CHECK(receiver.on_message(b0, apply));
+    CHECK(receiver.on_message(b1, apply));
+    CHECK(applied == 8);
+
+    CHECK(receiver.on_message(sent_by_a[5], apply));   // Late A seq 5.
+    CHECK(receiver.on_message(b1, apply));             // B seq 1 resent.
+    CHECK(applied == 8);
+    CHECK(receiver.stats().retired == 1);
+    CHECK(receiver.stats().duplicates == 1);
+    CHECK(receiver.stats().sessions == 2);
+
+    message status;
+    receiver.pack_status(status);
+    reliable_status_parameters parsed;
+    unpack_reliable_status_parameters(status, parsed);
+    CHECK(parsed.session == 200);
+
+    // B's next SET is applied as usual.
+    message b2 = reliable_set(b, 0);
+    CHECK(receiver.on_message(b2, apply));
+    CHECK(applied == 9);
+}
+
+int main() {
+    test_default_sessions_are_random();
+    test_restarted_client_is_applied();
+    test_late_frame_from_replaced_session();
+    return test_result();
+}
@@ -0,0 +1,132 @@
+/*
+    shm_ring_test: shared-memory broadcast ring (shm_ring.hpp). Frames read under a concurrent producer are never torn,
+    and readers follow a restarted producer to the new ring, both when polling and when asleep in wait().
+*/
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+#include "../shm_ring.hpp"
+#include "test_check.hpp"
+
+static std::string ring_name(const char *suffix) {
+    return "test_" + std::to_string(getpid()) + "_" + suffix;
+}
+
+// Every data byte and the timestamp carry the same sequence number, so a mixed copy is easy to spot.
+static message stamped(uint64_t seq) {
+    message msg = {};
+    msg.timestamp    = seq;
+    msg.version      = VERSION;
+    msg.message_type = CURRENT_PARAMETERS;
+    memset(msg.data, static_cast<uint8_t>(seq), sizeof(msg.data));
+    return msg;
+}
+
+static bool intact(const message &msg) {
+    for (uint32_t i = 0; i < sizeof(msg.data); ++i) {
+        if (msg.data[i] != static_cast<uint8_t>(msg.timestamp)) return false;
+    }
+    return true;
+}
+
+static void test_no_torn_frames() {
+    const std::string name = ring_name("torn");
+    shm_ring_producer producer;
+    CHECK(producer.create(name.c_str(), 8, false));
+    shm_ring_reader reader;
+    CHECK(reader.open(name.c_str()));
+
+    std::atomic<bool> stop{false};
+    std::thread writer([&] {
+        for (uint64_t seq = 0; !stop.load(std::memory_order_relaxed); ++seq) producer.publish(stamped(seq));
+    });
+    uint64_t read = 0, torn = 0, last = 0;
+    bool ordered = true;
+    message msg;
+    const auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+    while (std::chrono::steady_clock::now() < end) {
+        if (!reader.read(msg)) continue;
+        torn += intact(msg) ? 0 : 1;
+        if (read > 0 && msg.timestamp <= last) ordered = false;
+        last = msg.timestamp;
+        read++;
+    }
+    stop.store(true);
+    writer.join();
+    CHECK(read > 0);
+    CHECK(torn == 0);
+    CHECK(ordered);
+    shm_ring_producer::unlink(name.c_str());
+}
+
+static void test_reattach_after_restart() {
+    const std::string name = ring_name("restart");
+    shm_ring_reader reader;
+    message msg;
+    {
+        shm_ring_producer first;
+        CHECK(first.create(name.c_str(), 16));
+        CHECK(first.generation() == 1);
+        CHECK(reader.open(name.c_str()));
+        for (uint64_t seq = 0; seq < 4; ++seq) first.publish(stamped(seq));
+        CHECK(reader.read(msg) && msg.timestamp == 0);
+
+        // The producer restarts: a new process would create the ring again under the same name.
+        shm_ring_producer second;
+        CHECK(second.create(name.c_str(), 16));
+        CHECK(second.generation() == 2);
+        second.publish(stamped(100));
+        second.publish(stamped(101));
+
+        // What was left in the old ring is still delivered, then the reader moves to the new ring.
+        uint64_t expected[] = {1, 2, 3, 100, 101};
+        for (uint64_t seq : expected) {
+            CHECK(reader.read(msg) && msg.timestamp == seq);
+        }
+        CHECK(!reader.read(msg));
+        CHECK(reader.reattached() == 1);
+        CHECK(reader.generation() == 2);
+        CHECK(reader.lost() == 0);
+
+        second.publish(stamped(102));
+        CHECK(reader.read(msg) && msg.timestamp == 102);
+    }
+    shm_ring_producer::unlink(name.c_str());
+}
+
+static void test_sleeping_reader_follows_restart() {
+    const std::string name = ring_name("sleep");
+    shm_ring_producer first;
+    CHECK(first.create(name.c_str(), 16));
+    shm_ring_reader reader;
+    CHECK(reader.open(name.c_str()));
+
+    std::atomic<int> woke{0};
+    message msg = {};
+    std::thread sleeper([&] {
+        // Bounded so a missed wake-up fails the test instead of hanging it.
+        if (reader.wait(2000000) && reader.read(msg)) woke.store(1);
+        else woke.store(-1);
+    });
+    usleep(50000);
+    shm_ring_producer second;
+    CHECK(second.create(name.c_str(), 16));
+    second.publish(stamped(7));
+    sleeper.join();
+    CHECK(woke.load() == 1);
+    CHECK(msg.timestamp == 7);
+    CHECK(reader.reattached() == 1);
+    shm_ring_producer::unlink(name.c_str());
+}
+
+int main() {
+    test_no_torn_frames();
+    test_reattach_after_restart();
+    test_sleeping_reader_follows_restart();
+    return test_result();
+}
@@ -0,0 +1,81 @@
+/*
+    stream_name_test: stream name helpers in msg_defs.hpp. C strings placed right before an unmapped page must be
+    measured without touching it, and the 16-byte field helpers must agree with a plain scalar scan.
+*/
+#include <cstring>
+#include <string>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "../msg_defs.hpp"
+#include "test_check.hpp"
+
+// Copies text (with its terminator) to the very end of a readable page that is followed by a PROT_NONE page.
+static const char *at_page_end(char *page, size_t page_size, const char *text) {
+    const size_t size = strlen(text) + 1;
+    char *dst = page + page_size - size;
+    memcpy(dst, text, size);
+    return dst;
+}
+
+static void test_c_strings_at_page_end() {
+    const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    void *mapping = mmap(nullptr, page_size * 2, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    CHECK(mapping != MAP_FAILED);
+    if (mapping == MAP_FAILED) return;
+    char *page = static_cast<char *>(mapping);
+    CHECK(mprotect(page + page_size, page_size, PROT_NONE) == 0);
+
+    CHECK(stream_name_length(at_page_end(page, page_size, "")) == 0);
+    CHECK(stream_name_length(at_page_end(page, page_size, "cam")) == 3);
+    CHECK(stream_name_view(at_page_end(page, page_size, "cam")) == "cam");
+    CHECK(stream_name_view(at_page_end(page, page_size, "fifteen_chars__")) == "fifteen_chars__");
+
+    // A name without a terminator is cut at STREAM_NAME_SIZE.
+    memset(page + page_size - STREAM_NAME_SIZE, 'x', STREAM_NAME_SIZE);
+    CHECK(stream_name_length(page + page_size - STREAM_NAME_SIZE) == STREAM_NAME_SIZE);
+    CHECK(stream_name_field_length(page + page_size - STREAM_NAME_SIZE) == STREAM_NAME_SIZE);
+
+    message msg = {};
+    pack_cam_targeting_parameters(msg, at_page_end(page, page_size, "cam"), 0, static_cast<View::TargetingMode>(0),
+                                  false, 0.0f, 0.0f, 0.0f, 0, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+    CHECK(frame_stream_name(msg) == "cam");
+
+    munmap(mapping, page_size * 2);
+}
+
+static void test_fields_match_scalar() {
+    for (uint32_t length = 0; length <= STREAM_NAME_SIZE; ++length) {
+        // Garbage after the terminator must not change the length, and canonical fields must compare equal.
+        alignas(16) char field[STREAM_NAME_SIZE];
+        memset(field, 'a', sizeof(field));
+        if (length < STREAM_NAME_SIZE) field[length] = '\0';
+        CHECK(stream_name_field_length(field) == length);
+        CHECK(stream_name_field_length(field) == stream_name_length(field));
+        CHECK(stream_name_field_view(field) == std::string(length, 'a'));
+
+        uint8_t canonical[STREAM_NAME_SIZE];
+        uint8_t padded[STREAM_NAME_SIZE];
+        canonical_stream_name_field(canonical, field);
+        copy_stream_name_field(padded, std::string(length, 'a'));
+        CHECK(stream_name_equal(canonical, padded));
+        CHECK(stream_name_hash(canonical) == stream_name_hash(padded));
+    }
+
+    // Unaligned fields.
+    char buffer[STREAM_NAME_SIZE + 3] = {};
+    memcpy(buffer + 3, "unaligned", 9);
+    CHECK(stream_name_field_length(buffer + 3) == 9);
+    uint8_t other[STREAM_NAME_SIZE];
+    copy_stream_name_field(other, "unaligned");
+    CHECK(stream_name_equal(buffer + 3, other));
+    other[15] = 1;
+    CHECK(!stream_name_equal(buffer + 3, other));
+}
+
+int main() {
+    test_c_strings_at_page_end();
+    test_fields_match_scalar();
+    return test_result();
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#ifndef TEST_CHECK_HPP
+#define TEST_CHECK_HPP
+
+#include <cstdio>
+
+/*
+    Minimal check macro for the standalone tests: a failed check prints its location and expression and is counted;
+    main() returns test_result() so CTest sees the failure.
+*/
+inline int &test_failures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(expr)                                                                    \
+    do {                                                                               \
+        if (!(expr)) {                                                                 \
+            std::printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #expr);       \
+            test_failures()++;                                                         \
+        }                                                                              \
+    } while (0)
+
+inline int test_result() {
+    if (test_failures() == 0) {
+        std::printf("ok\n");
+        return 0;
+    }
+    std::printf("FAILED: %d check(s)\n", test_failures());
+    return 1;
+}
+
+#endif // TEST_CHECK_HPP
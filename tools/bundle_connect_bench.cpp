@@ -0,0 +1,168 @@
+/*
+    bundle_connect_bench: connect-to-ready time with one GET per group versus one bundled GET (BUNDLE).
+
+        g++ -std=c++17 -O2 -pthread -I.. -I../digiview_commons bundle_connect_bench.cpp -o bundle_connect_bench
+        ./bundle_connect_bench [rtt_ms] [detections]
+
+    A minimal DigiView simulator runs on a loopback UDP socket and holds every reply back by rtt_ms to model a
+    high-latency link. It answers plain GETs with one CURRENT_PARAMETERS frame per group, or `detections` frames for
+    TRACKED_DETECTION. It answers a BUNDLE GET with the same frames back to back, closed by a BUNDLE frame. The client
+    is "ready" once it holds a reply for every group in BUNDLE_SUPPORTED_MASK.
+*/
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../msg_defs.hpp"
+
+static const uint16_t SIMULATOR_PORT = 47500;
+
+static sockaddr_in loopback(uint16_t port) {
+    sockaddr_in addr = {};
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return addr;
+}
+
+static void send_frame(int fd, message &msg, const sockaddr_in &to) {
+    add_checksum_for_digiview_message(msg);
+    sendto(fd, &msg, sizeof(msg), 0, reinterpret_cast<const sockaddr *>(&to), sizeof(to));
+}
+
+// Sends the reply frames for one group and returns how many were sent.
+static uint16_t reply_group(int fd, uint8_t param_type, const char *stream_name, uint8_t detections, const sockaddr_in &to) {
+    message reply = {};
+    reply.version      = VERSION;
+    reply.message_type = CURRENT_PARAMETERS;
+    if (param_type == TRACKED_DETECTION) {
+        // An empty scene is still answered, with one frame carrying total_detections = 0.
+        const uint8_t frames = detections == 0 ? 1 : detections;
+        for (uint8_t i = 0; i < frames; ++i) {
+            pack_tracked_detection_parameters(reply, detections, i, 90, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, i + 1, 1000);
+            send_frame(fd, reply, to);
+        }
+        return frames;
+    }
+    reply.param_type = param_type;
+    copy_stream_name_field(&reply.data[0], stream_name_view(stream_name));
+    send_frame(fd, reply, to);
+    return 1;
+}
+
+static void run_simulator(int fd, uint32_t rtt_ms, uint8_t detections, std::atomic<bool> &stop) {
+    timeval tv = {0, 100000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    while (!stop.load()) {
+        message request;
+        sockaddr_in from;
+        socklen_t from_len = sizeof(from);
+        if (recvfrom(fd, &request, sizeof(request), 0, reinterpret_cast<sockaddr *>(&from), &from_len) != sizeof(request)) continue;
+        if (request.message_type != GET_PARAMETERS) continue;
+        std::this_thread::sleep_for(std::chrono::milliseconds(rtt_ms));
+
+        if (request.param_type != BUNDLE) {
+            reply_group(fd, request.param_type, reinterpret_cast<const char *>(request.data), detections, from);
+            continue;
+        }
+        bundle_parameters bundle;
+        unpack_bundle_parameters(request, bundle);
+        uint32_t answered = 0;
+        uint16_t frames   = 0;
+        const uint32_t wanted = bundle.requested_mask & BUNDLE_SUPPORTED_MASK;
+        for (uint8_t param_type = 0; param_type < 32; ++param_type) {
+            if (!(wanted & param_type_bit(param_type))) continue;
+            const uint16_t sent = reply_group(fd, param_type, bundle.stream_name, detections, from);
+            if (sent != 0) answered |= param_type_bit(param_type);
+            frames += sent;
+        }
+        message closing = {};
+        closing.version      = VERSION;
+        closing.message_type = CURRENT_PARAMETERS;
+        pack_bundle_parameters(closing, bundle.stream_name, bundle.cam_id, bundle.requested_mask, answered, frames);
+        send_frame(fd, closing, from);
+    }
+}
+
+// Reads replies until every group in mask is covered (and, for bundles, the closing frame has arrived).
+static bool await_replies(int fd, uint32_t mask, bool bundled) {
+    uint32_t have = 0;
+    bool closed   = !bundled;
+    uint8_t detections_seen = 0;
+    while (have != mask || !closed) {
+        message reply;
+        if (recv(fd, &reply, sizeof(reply), 0) != sizeof(reply)) return false;
+        if (!has_valid_checksum_for_digiview_message(reply) || reply.message_type != CURRENT_PARAMETERS) continue;
+        if (reply.param_type == BUNDLE) {
+            closed = true;
+            continue;
+        }
+        if (reply.param_type == TRACKED_DETECTION) {
+            tracked_detection_parameters det;
+            unpack_tracked_detection_parameters(reply, det);
+            if (++detections_seen < det.total_detections) continue;
+        }
+        have |= param_type_bit(reply.param_type);
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    const uint32_t rtt_ms     = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 150;
+    const uint8_t  detections = argc > 2 ? static_cast<uint8_t>(atoi(argv[2])) : 5;
+
+    const int simulator_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    const sockaddr_in simulator_addr = loopback(SIMULATOR_PORT);
+    if (bind(simulator_fd, reinterpret_cast<const sockaddr *>(&simulator_addr), sizeof(simulator_addr)) != 0) {
+        perror("bind");
+        return 2;
+    }
+    std::atomic<bool> stop{false};
+    std::thread simulator(run_simulator, simulator_fd, rtt_ms, detections, std::ref(stop));
+
+    const int client_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    timeval tv = {5, 0};
+    setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    uint32_t groups = 0;
+    for (uint8_t p = 0; p < 32; ++p) groups += (BUNDLE_SUPPORTED_MASK & param_type_bit(p)) ? 1 : 0;
+
+    bool ok = true;
+    auto start = std::chrono::steady_clock::now();
+    for (uint8_t param_type = 0; param_type < 32 && ok; ++param_type) {
+        if (!(BUNDLE_SUPPORTED_MASK & param_type_bit(param_type))) continue;
+        message get = {};
+        if (param_type == TRACKED_DETECTION) {
+            pack_get_tracked_detection_all(get, 0);
+        } else {
+            pack_get_parameters(get, param_type, "stream0", 0);
+        }
+        send_frame(client_fd, get, simulator_addr);
+        ok = await_replies(client_fd, param_type_bit(param_type), false);
+    }
+    const double sequential_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    message get = {};
+    pack_get_bundle_parameters(get, BUNDLE_SUPPORTED_MASK, "stream0", 0);
+    send_frame(client_fd, get, simulator_addr);
+    ok = ok && await_replies(client_fd, BUNDLE_SUPPORTED_MASK, true);
+    const double bundled_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    stop.store(true);
+    simulator.join();
+    close(client_fd);
+    close(simulator_fd);
+
+    printf("rtt %u ms, %u groups, %u detections\n", rtt_ms, groups, detections);
+    printf("one GET per group: %8.1f ms to ready\n", sequential_ms);
+    printf("bundled GET:       %8.1f ms to ready\n", bundled_ms);
+    if (!ok) printf("FAILED: timed out waiting for replies\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,194 @@
+/*
+    cam_offset_batch_bench: latency of converting many screen points to angles with single CAM_OFFSET GETs versus one
+    CAM_OFFSET_BATCH exchange.
+
+        g++ -std=c++17 -O2 -pthread -I.. -I../digiview_commons cam_offset_batch_bench.cpp -o cam_offset_batch_bench
+        ./cam_offset_batch_bench [rtt_ms] [points]
+
+    A minimal DigiView simulator on a loopback UDP socket converts points with a pinhole model (60 x 40 degree field
+    of view, camera at yaw 30, pitch -5) and holds every answer back by rtt_ms. Single queries are answered one by
+    one; a batch is answered once all of its GET frames have arrived. The program prints the time to convert all
+    points each way, the frames used and the largest angle difference between the two answers.
+*/
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../msg_defs.hpp"
+
+static const uint16_t SIMULATOR_PORT = 47501;
+static const float    HALF_HFOV_DEG  = 30.0f;
+static const float    HALF_VFOV_DEG  = 20.0f;
+static const float    CAM_YAW_DEG    = 30.0f;
+static const float    CAM_PITCH_DEG  = -5.0f;
+static const float    DEG            = 3.14159265f / 180.0f;
+
+static sockaddr_in loopback(uint16_t port) {
+    sockaddr_in addr = {};
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return addr;
+}
+
+static void send_frame(int fd, message &msg, const sockaddr_in &to) {
+    add_checksum_for_digiview_message(msg);
+    sendto(fd, &msg, sizeof(msg), 0, reinterpret_cast<const sockaddr *>(&to), sizeof(to));
+}
+
+static void convert(float x, float y, float &yaw_global, float &pitch_global, float &yaw_rel, float &pitch_rel) {
+    yaw_rel      = std::atan(x * std::tan(HALF_HFOV_DEG * DEG)) / DEG;
+    pitch_rel    = -std::atan(y * std::tan(HALF_VFOV_DEG * DEG)) / DEG;
+    yaw_global   = yaw_rel + CAM_YAW_DEG;
+    pitch_global = pitch_rel + CAM_PITCH_DEG;
+}
+
+static void run_simulator(int fd, uint32_t rtt_ms, std::atomic<bool> &stop) {
+    timeval tv = {0, 100000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    std::vector<float> x(256), y(256), yaw_global(256), pitch_global(256), yaw_rel(256), pitch_rel(256);
+    uint32_t batch_received = 0;
+    while (!stop.load()) {
+        message request;
+        sockaddr_in from;
+        socklen_t from_len = sizeof(from);
+        if (recvfrom(fd, &request, sizeof(request), 0, reinterpret_cast<sockaddr *>(&from), &from_len) != sizeof(request)) continue;
+        if (request.message_type != GET_PARAMETERS) continue;
+
+        message reply = {};
+        reply.version      = VERSION;
+        reply.message_type = CURRENT_PARAMETERS;
+        if (request.param_type == CAM_OFFSET) {
+            cam_offset_parameters query;
+            unpack_cam_offset_parameters(request, query);
+            float yg, pg, yr, pr;
+            convert(query.x, query.y, yg, pg, yr, pr);
+            std::this_thread::sleep_for(std::chrono::milliseconds(rtt_ms));
+            pack_cam_offset_parameters(reply, query.stream_name, query.cam_id, query.x, query.y, yg, pg, yr, pr);
+            send_frame(fd, reply, from);
+            continue;
+        }
+        if (request.param_type != CAM_OFFSET_BATCH) continue;
+
+        cam_offset_batch_parameters batch;
+        unpack_cam_offset_batch_parameters(request, batch);
+        if (batch.first_point == 0) batch_received = 0;
+        for (uint8_t i = 0; i < batch.point_count; ++i) {
+            const uint8_t point = batch.first_point + i;
+            x[point] = batch.x[i];
+            y[point] = batch.y[i];
+            convert(x[point], y[point], yaw_global[point], pitch_global[point], yaw_rel[point], pitch_rel[point]);
+        }
+        batch_received += batch.point_count;
+        if (batch_received < batch.total_points) continue;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(rtt_ms));
+        uint8_t first = 0;
+        do {
+            first += pack_cam_offset_batch_angles(reply, batch.stream_name, batch.cam_id, batch.batch_id, batch.angles, yaw_global.data(),
+                                                  pitch_global.data(), yaw_rel.data(), pitch_rel.data(), batch.total_points, first);
+            send_frame(fd, reply, from);
+        } while (first < batch.total_points);
+    }
+}
+
+int main(int argc, char **argv) {
+    const uint32_t rtt_ms = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 50;
+    const uint32_t points = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 32;
+    const uint8_t  total  = static_cast<uint8_t>(points > 255 ? 255 : points);
+
+    const int simulator_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    const sockaddr_in simulator_addr = loopback(SIMULATOR_PORT);
+    if (bind(simulator_fd, reinterpret_cast<const sockaddr *>(&simulator_addr), sizeof(simulator_addr)) != 0) {
+        perror("bind");
+        return 2;
+    }
+    std::atomic<bool> stop{false};
+    std::thread simulator(run_simulator, simulator_fd, rtt_ms, std::ref(stop));
+
+    const int client_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    timeval tv = {5, 0};
+    setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    // Detection box corners and click targets spread over the view.
+    std::vector<float> x(total), y(total);
+    for (uint8_t i = 0; i < total; ++i) {
+        x[i] = std::sin(i * 0.7f) * 0.95f;
+        y[i] = std::cos(i * 1.3f) * 0.9f;
+    }
+    std::vector<float> single_yaw(total), single_pitch(total), batch_yaw(total), batch_pitch(total);
+
+    bool ok = true;
+    auto start = std::chrono::steady_clock::now();
+    for (uint8_t i = 0; i < total && ok; ++i) {
+        message get = {};
+        pack_get_cam_offset_parameters(get, "stream0", 0, x[i], y[i]);
+        send_frame(client_fd, get, simulator_addr);
+        message reply;
+        if (recv(client_fd, &reply, sizeof(reply), 0) != sizeof(reply) || !has_valid_checksum_for_digiview_message(reply)) {
+            ok = false;
+            break;
+        }
+        cam_offset_parameters answer;
+        unpack_cam_offset_parameters(reply, answer);
+        single_yaw[i]   = answer.yaw_global;
+        single_pitch[i] = answer.pitch_global;
+    }
+    const double single_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    uint32_t get_frames = 0;
+    uint8_t first = 0;
+    do {
+        message get = {};
+        first += pack_get_cam_offset_batch(get, "stream0", 0, 7, x.data(), y.data(), total, first, CAM_OFFSET_ANGLES_GLOBAL);
+        send_frame(client_fd, get, simulator_addr);
+        get_frames++;
+    } while (first < total);
+    uint32_t reply_frames = 0;
+    uint32_t answered     = 0;
+    while (ok && answered < total) {
+        message reply;
+        if (recv(client_fd, &reply, sizeof(reply), 0) != sizeof(reply) || !has_valid_checksum_for_digiview_message(reply)) {
+            ok = false;
+            break;
+        }
+        cam_offset_batch_parameters batch;
+        unpack_cam_offset_batch_parameters(reply, batch);
+        if (batch.batch_id != 7) continue;
+        for (uint8_t i = 0; i < batch.point_count; ++i) {
+            batch_yaw[batch.first_point + i]   = batch.yaw_global[i];
+            batch_pitch[batch.first_point + i] = batch.pitch_global[i];
+        }
+        answered += batch.point_count;
+        reply_frames++;
+        if (total == 0) break;
+    }
+    const double batch_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    stop.store(true);
+    simulator.join();
+    close(client_fd);
+    close(simulator_fd);
+
+    float max_error = 0.0f;
+    for (uint8_t i = 0; i < total; ++i) {
+        max_error = std::max(max_error, std::fabs(single_yaw[i] - batch_yaw[i]));
+        max_error = std::max(max_error, std::fabs(single_pitch[i] - batch_pitch[i]));
+    }
+    printf("rtt %u ms, %u points\n", rtt_ms, total);
+    printf("single CAM_OFFSET GETs: %8.1f ms, %u GET frames, %u reply frames\n", single_ms, total, total);
+    printf("CAM_OFFSET_BATCH:       %8.1f ms, %u GET frames, %u reply frames\n", batch_ms, get_frames, reply_frames);
+    printf("largest global angle difference: %.4f degrees\n", max_error);
+    if (!ok) printf("FAILED: timed out waiting for replies\n");
+    return ok && max_error < 0.01f ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+/*
+    capture_bench: sustained frame rate of the capture recorder (capture_recorder.hpp) and the cost of record() on the
+    calling thread.
+
+        g++ -std=c++17 -O2 -pthread -I.. -I../digiview_commons capture_bench.cpp -o capture_bench
+        ./capture_bench [frames_per_s] [seconds] [producers] [compress] [path]
+
+    `producers` threads share the target rate (default 1M frames/s for 3 s, one producer, uncompressed, written to
+    /tmp/capture_bench.dvc) and call record() on a fixed schedule with a mix of TRACKED_DETECTION, NAVIGATION and
+    CAM_TARGETING frames. Every 64th call is timed. After close(), the capture is opened with capture_reader and every
+    record is counted. The program prints the achieved rate, drops, bytes and blocks written, record() latency
+    percentiles and whether O_DIRECT was used. It fails if the reader does not see exactly the records written.
+*/
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "../capture_reader.hpp"
+#include "../capture_recorder.hpp"
+
+static uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static message frame_for(uint64_t i) {
+    message msg = {};
+    msg.timestamp    = i;
+    msg.version      = VERSION;
+    msg.message_type = CURRENT_PARAMETERS;
+    switch (i % 4) {
+        case 0:
+        case 1:
+            pack_tracked_detection_parameters(msg, 8, static_cast<uint8_t>(i & 7), 200, 1, 0.001f * (i & 0xFFFF), 5.0f, 0,
+                                              1.0f, 2.0f, 52.0f, 5.0f, 100.0f, 800.0f, 0.1f, 0.2f,
+                                              static_cast<uint16_t>(1 + (i & 63)), i);
+            break;
+        case 2: pack_navigation_parameters(msg, 100.0f, 52.0f, 5.0f); break;
+        default:
+            pack_cam_targeting_parameters(msg, "stream0", 0, static_cast<View::TargetingMode>(0), false, 10.0f, -5.0f, 0.0f,
+                                          0, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+            break;
+    }
+    add_checksum_for_digiview_message(msg);
+    return msg;
+}
+
+int main(int argc, char **argv) {
+    const uint64_t rate      = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    const double   seconds   = argc > 2 ? atof(argv[2]) : 3.0;
+    const uint32_t producers = argc > 3 ? std::max(1, atoi(argv[3])) : 1;
+    const bool     compress  = argc > 4 && atoi(argv[4]) != 0;
+    const char    *path      = argc > 5 ? argv[5] : "/tmp/capture_bench.dvc";
+
+    // Frames are built up front so the timed loop measures record() rather than packing.
+    std::vector<message> frames(4096);
+    for (uint64_t i = 0; i < frames.size(); ++i) frames[i] = frame_for(i);
+
+    capture_recorder recorder;
+    capture_recorder_config config;
+    config.path     = path;
+    config.compress = compress;
+    if (!recorder.open(config)) {
+        printf("cannot open %s\n", path);
+        return 1;
+    }
+
+    const uint64_t per_producer = static_cast<uint64_t>(rate * seconds) / producers;
+    const uint64_t period_ns    = 1000000000ULL * producers / std::max<uint64_t>(rate, 1);
+    std::vector<std::vector<uint32_t>> latencies(producers);
+    std::atomic<uint64_t> attempted{0};
+    const uint64_t start_ns = now_ns();
+    std::vector<std::thread> threads;
+    for (uint32_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            std::vector<uint32_t> &lat = latencies[p];
+            lat.reserve(per_producer / 64 + 1);
+            uint64_t next_ns = start_ns;
+            for (uint64_t i = 0; i < per_producer; ++i) {
+                // Pace to the schedule; a producer that falls behind sends back to back until it catches up.
+                while (now_ns() < next_ns) {
+                }
+                next_ns += period_ns;
+                const message &frame = frames[(i * producers + p) & (frames.size() - 1)];
+                if ((i & 63) == 0) {
+                    const uint64_t t0 = now_ns();
+                    recorder.record(frame, CAPTURE_RECEIVED, p);
+                    lat.push_back(static_cast<uint32_t>(now_ns() - t0));
+                } else {
+                    recorder.record(frame, CAPTURE_RECEIVED, p);
+                }
+            }
+            attempted.fetch_add(per_producer, std::memory_order_relaxed);
+        });
+    }
+    for (std::thread &t : threads) t.join();
+    const double produce_s = (now_ns() - start_ns) * 1e-9;
+    const bool direct = recorder.direct_io_active();
+    recorder.close();
+    const double total_s = (now_ns() - start_ns) * 1e-9;
+    const capture_recorder_stats stats = recorder.stats();
+
+    std::vector<uint32_t> all;
+    for (const std::vector<uint32_t> &lat : latencies) all.insert(all.end(), lat.begin(), lat.end());
+    std::sort(all.begin(), all.end());
+    const auto pct = [&](double p) { return all.empty() ? 0u : all[std::min(all.size() - 1, static_cast<size_t>(all.size() * p))]; };
+
+    capture_reader reader;
+    uint64_t read_back = 0;
+    if (reader.open(path, false)) read_back = reader.query(capture_query(), [](const capture_record &) {});
+
+    printf("target %llu frames/s for %.1f s, %u producer(s), %s, %s\n", static_cast<unsigned long long>(rate), seconds,
+           producers, compress ? "compressed" : "uncompressed", direct ? "O_DIRECT" : "buffered");
+    printf("offered:  %llu frames in %.3f s (%.0f frames/s)\n", static_cast<unsigned long long>(attempted.load()),
+           produce_s, attempted.load() / produce_s);
+    printf("written:  %llu frames, %llu dropped, %llu blocks, %.1f MB (%.1f MB/s including drain)\n",
+           static_cast<unsigned long long>(stats.records_written), static_cast<unsigned long long>(stats.records_dropped),
+           static_cast<unsigned long long>(stats.blocks_written), stats.bytes_written / 1e6,
+           stats.bytes_written / 1e6 / total_s);
+    printf("record(): p50 %u ns  p99 %u ns  p99.9 %u ns  max %u ns\n", pct(0.50), pct(0.99), pct(0.999),
+           all.empty() ? 0u : all.back());
+    printf("read back: %llu records\n", static_cast<unsigned long long>(read_back));
+    remove(path);
+
+    const bool ok = stats.records_written + stats.records_dropped == attempted.load() && read_back == stats.records_written;
+    printf("%s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
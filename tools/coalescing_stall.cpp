@@ -0,0 +1,137 @@
+/*
+    coalescing_stall: simulated link stall for the coalescing outbound queue (coalescing_queue.hpp).
+
+        g++ -std=c++17 -O2 -I.. -I../digiview_commons coalescing_stall.cpp -o coalescing_stall
+        ./coalescing_stall [rate_hz] [stall_ms]
+
+    A gimbal loop sends CAM_TARGETING SETs for two cameras at rate_hz. Camera 0 gets absolute angles and camera 1
+    relative (euler_delta) moves. The link can send one frame every 2 ms, except for a stall of stall_ms starting at
+    t = 1 s. The same traffic goes through a plain FIFO and through the coalescing queue, on a virtual clock. For each
+    the program prints the peak queue depth, the age of the commands sent after the stall, and whether camera 1's
+    total relative motion survived. Exit status 1 means the coalescing queue failed one of the checks.
+*/
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+
+#include "../coalescing_queue.hpp"
+
+static const uint64_t LINK_INTERVAL_US = 2000;
+static const uint64_t STALL_START_US   = 1000000;
+static const uint64_t RUN_US           = 5000000;
+
+struct run_result {
+    uint32_t max_depth;
+    uint64_t max_age_us;          // Send time minus the time the sent command was generated.
+    uint64_t drain_us;            // Time after the stall until the queue was empty again; UINT64_MAX if never.
+    int64_t  delta_pushed_mdeg;
+    int64_t  delta_sent_mdeg;
+};
+
+static message make_command(uint8_t cam_id, bool delta, float yaw) {
+    message msg = {};
+    const View::TargetingMode directional = static_cast<View::TargetingMode>(0);
+    pack_set_cam_targeting_parameters(msg, "stream0", cam_id, directional, delta, yaw, 0, 0, 0, 0, 0, 0, 0, 0);
+    add_checksum_for_digiview_message(msg);
+    return msg;
+}
+
+static int32_t yaw_mdeg(const message &msg) {
+    int32_t yaw;
+    memcpy(&yaw, &msg.data[CAM_TARGETING_YAW_OFFSET], sizeof(yaw));
+    return yaw;
+}
+
+template <typename Push, typename Pop, typename Depth>
+static run_result simulate(uint32_t rate_hz, uint64_t stall_us, Push &&push, Pop &&pop, Depth &&depth) {
+    run_result r = {};
+    r.drain_us = UINT64_MAX;
+    const uint64_t command_interval_us = 1000000 / rate_hz;
+    const uint64_t stall_end_us        = STALL_START_US + stall_us;
+    uint64_t next_command_us = 0;
+    uint64_t next_send_us    = 0;
+    uint32_t step            = 0;
+    for (uint64_t now = 0; now < RUN_US; now += 100) {
+        while (next_command_us <= now) {
+            const float yaw = static_cast<float>(step % 3600) / 10.0f;
+            push(make_command(0, false, yaw), now);
+            push(make_command(1, true, 0.5f), now);
+            r.delta_pushed_mdeg += 500;
+            step++;
+            next_command_us += command_interval_us;
+        }
+        if (depth() > r.max_depth) r.max_depth = depth();
+
+        const bool stalled = now >= STALL_START_US && now < stall_end_us;
+        if (stalled || next_send_us > now) continue;
+        message sent;
+        uint64_t generated_us;
+        if (!pop(sent, generated_us)) continue;
+        next_send_us = now + LINK_INTERVAL_US;
+        if (sent.data[CAM_TARGETING_EULER_DELTA_OFFSET]) r.delta_sent_mdeg += yaw_mdeg(sent);
+        if (now >= stall_end_us && now - generated_us > r.max_age_us) r.max_age_us = now - generated_us;
+        if (now >= stall_end_us && r.drain_us == UINT64_MAX && depth() == 0) r.drain_us = now - stall_end_us;
+    }
+    // Whatever is still queued would go out next; count it so the totals compare like for like.
+    message rest;
+    uint64_t generated_us;
+    while (pop(rest, generated_us)) {
+        if (rest.data[CAM_TARGETING_EULER_DELTA_OFFSET]) r.delta_sent_mdeg += yaw_mdeg(rest);
+    }
+    return r;
+}
+
+static void report(const char *name, const run_result &r) {
+    char drained[32];
+    if (r.drain_us == UINT64_MAX) {
+        snprintf(drained, sizeof(drained), "never");
+    } else {
+        snprintf(drained, sizeof(drained), "%.1f ms", r.drain_us / 1e3);
+    }
+    printf("%-10s peak depth %6u  max command age after stall %8.1f ms  drained after stall: %-10s  "
+           "delta yaw pushed %lld sent %lld mdeg\n",
+           name, r.max_depth, r.max_age_us / 1e3, drained, static_cast<long long>(r.delta_pushed_mdeg),
+           static_cast<long long>(r.delta_sent_mdeg));
+}
+
+int main(int argc, char **argv) {
+    const uint32_t rate_hz  = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 200;
+    const uint64_t stall_us = (argc > 2 ? strtoull(argv[2], nullptr, 10) : 2000) * 1000;
+
+    struct fifo_entry {
+        message  frame;
+        uint64_t generated_us;
+    };
+    std::deque<fifo_entry> fifo;
+    const run_result plain = simulate(
+        rate_hz, stall_us,
+        [&](const message &msg, uint64_t now) { fifo.push_back({msg, now}); },
+        [&](message &out, uint64_t &generated_us) {
+            if (fifo.empty()) return false;
+            out          = fifo.front().frame;
+            generated_us = fifo.front().generated_us;
+            fifo.pop_front();
+            return true;
+        },
+        [&] { return static_cast<uint32_t>(fifo.size()); });
+
+    coalescing_queue queue(16);
+    const run_result coalesced = simulate(
+        rate_hz, stall_us,
+        [&](const message &msg, uint64_t now) { queue.push(msg, now); },
+        [&](message &out, uint64_t &generated_us) { return queue.pop(out, nullptr, &generated_us); },
+        [&] { return queue.depth(); });
+
+    report("fifo", plain);
+    report("coalescing", coalesced);
+    const coalescing_queue_stats stats = queue.stats();
+    printf("coalescing stats: pushed %llu coalesced %llu merged deltas %llu popped %llu rejected %llu\n",
+           static_cast<unsigned long long>(stats.pushed), static_cast<unsigned long long>(stats.coalesced),
+           static_cast<unsigned long long>(stats.merged_deltas), static_cast<unsigned long long>(stats.popped),
+           static_cast<unsigned long long>(stats.rejected));
+
+    const bool ok = coalesced.max_depth <= 2 && coalesced.delta_sent_mdeg == coalesced.delta_pushed_mdeg &&
+                    coalesced.max_age_us <= 1000000 / rate_hz + LINK_INTERVAL_US * 2;
+    printf("%s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
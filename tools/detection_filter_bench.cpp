@@ -0,0 +1,98 @@
+/*
+    detection_filter_bench: reply frames per published frame with and without a TRACKED_DETECTION GET filter
+    (detection_filter.hpp).
+
+        g++ -std=c++17 -O2 -I.. -I../digiview_commons detection_filter_bench.cpp -o detection_filter_bench
+        ./detection_filter_bench [detections] [frames]
+
+    Generates a synthetic scene: `detections` tracks per published frame spread over the full yaw circle, eight
+    classes and uniform scores. A recurring GET either asks for everything, or for score >= 60 of classes 0 and 2 in
+    a 120 degree forward sector, highest score first, at most 16. The filter is packed into a GET and read back, as a
+    server would, before it is evaluated. The program prints reply frames per published frame for both and the
+    evaluation cost.
+*/
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "../detection_filter.hpp"
+
+int main(int argc, char **argv) {
+    const uint32_t detections = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 60;
+    const uint32_t frames     = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 10000;
+    const uint8_t  count      = static_cast<uint8_t>(detections > 255 ? 255 : detections);
+
+    tracked_detection_filter wanted;
+    wanted.flags      = DETECTION_FILTER_SCORE | DETECTION_FILTER_CLASS | DETECTION_FILTER_SECTOR | DETECTION_FILTER_MAX_COUNT;
+    wanted.min_score  = 60;
+    wanted.class_mask = (1U << 0) | (1U << 2);
+    wanted.yaw_min    = -60.0f;
+    wanted.yaw_max    = 60.0f;
+    wanted.pitch_min  = -30.0f;
+    wanted.pitch_max  = 30.0f;
+    wanted.max_count  = 16;
+    wanted.sort       = DETECTION_SORT_SCORE;
+
+    message get = {};
+    pack_get_tracked_detection_filtered(get, wanted, 0);
+    tracked_detection_filter filter;
+    if (!unpack_tracked_detection_filter(get, filter) || filter.flags != wanted.flags || filter.class_mask != wanted.class_mask ||
+        filter.min_score != wanted.min_score || filter.yaw_min != wanted.yaw_min || filter.max_count != wanted.max_count ||
+        filter.sort != wanted.sort) {
+        printf("FAILED: filter did not survive packing\n");
+        return 1;
+    }
+    message plain = {};
+    pack_get_tracked_detection_all(plain, 0);
+    if (unpack_tracked_detection_filter(plain, filter)) {
+        printf("FAILED: unfiltered GET read as filtered\n");
+        return 1;
+    }
+    unpack_tracked_detection_filter(get, filter);
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> yaw(-180.0f, 180.0f);
+    std::uniform_real_distribution<float> pitch(-45.0f, 45.0f);
+    std::uniform_int_distribution<int>    score(0, 100);
+    std::uniform_int_distribution<int>    type(0, 7);
+
+    std::vector<tracked_detection_parameters> scene(count);
+    std::vector<uint8_t> selected(count);
+    uint64_t plain_frames    = 0;
+    uint64_t filtered_frames = 0;
+    uint64_t eval_ns         = 0;
+    bool ordered = true;
+    for (uint32_t f = 0; f < frames; ++f) {
+        for (uint8_t i = 0; i < count; ++i) {
+            tracked_detection_parameters &det = scene[i];
+            det.index                = i;
+            det.total_detections     = count;
+            det.score                = static_cast<uint8_t>(score(rng));
+            det.type                 = static_cast<int16_t>(type(rng));
+            det.yaw_global           = yaw(rng);
+            det.pitch_global         = pitch(rng);
+            det.track_id             = static_cast<uint16_t>(i + 1);
+            det.publish_timestamp_us = static_cast<uint64_t>(f) * 33333;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        const uint8_t n = select_tracked_detections(filter, scene.data(), count, selected.data());
+        eval_ns += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        for (uint8_t k = 1; k < n; ++k) ordered = ordered && scene[selected[k - 1]].score >= scene[selected[k]].score;
+
+        // An empty answer still costs one frame.
+        plain_frames    += count == 0 ? 1 : count;
+        filtered_frames += n == 0 ? 1 : n;
+    }
+
+    const double plain_per_frame    = static_cast<double>(plain_frames) / frames;
+    const double filtered_per_frame = static_cast<double>(filtered_frames) / frames;
+    printf("%u detections per frame, %u frames\n", count, frames);
+    printf("unfiltered GET: %6.2f reply frames per published frame\n", plain_per_frame);
+    printf("filtered GET:   %6.2f reply frames per published frame (%.1fx fewer)\n", filtered_per_frame,
+           plain_per_frame / filtered_per_frame);
+    printf("filter evaluation: %.0f ns per published frame\n", static_cast<double>(eval_ns) / frames);
+    if (!ordered) printf("FAILED: replies not in score order\n");
+    return ordered ? 0 : 1;
+}
@@ -0,0 +1,185 @@
+/*
+    detection_index_bench: nearest-k and radius queries over live detections with the spatial index
+    (detection_index.hpp) against a linear scan of every tracked_detection_parameters.
+
+        g++ -std=c++17 -O2 -pthread -I.. -I../digiview_commons detection_index_bench.cpp -o detection_index_bench
+        ./detection_index_bench [detections] [queries] [seed]
+
+    Spreads `detections` tracks over the full yaw circle and pitch -30 .. 60 degrees, with positions within about
+    5 km of a reference point. Every track is then moved slightly and fed back through observe(), as if a new frame
+    of TRACKED_DETECTION had arrived. Each query type runs `queries` times from random points through the index and
+    through a linear scan, and the two answers are compared.
+*/
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "../detection_filter.hpp"
+#include "../detection_index.hpp"
+
+static const float REF_LATITUDE  = 52.0f;
+static const float REF_LONGITUDE = 5.0f;
+static const double METRES_PER_DEGREE = DETECTION_INDEX_EARTH_RADIUS_M * DETECTION_INDEX_DEG_TO_RAD;
+
+static double now_s() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct rng {
+    uint64_t state;
+
+    double uniform(double lo, double hi) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return lo + (hi - lo) * ((state >> 11) * (1.0 / 9007199254740992.0));
+    }
+};
+
+struct point {
+    float a;   // yaw or latitude
+    float b;   // pitch or longitude
+};
+
+static bool by_distance(const detection_hit &x, const detection_hit &y) {
+    return x.distance < y.distance || (x.distance == y.distance && x.track_id < y.track_id);
+}
+
+// Reference answers from scanning every detection.
+static uint32_t linear_nearest(const std::vector<tracked_detection_parameters> &dets, bool bearing, point q, uint32_t k,
+                               std::vector<detection_hit> &scratch, detection_hit *out) {
+    scratch.clear();
+    for (const tracked_detection_parameters &d : dets) {
+        if (bearing) {
+            scratch.push_back({d.track_id, angular_distance_deg(q.a, q.b, d.yaw_global, d.pitch_global)});
+        } else {
+            scratch.push_back({d.track_id, angular_distance_deg(q.b, q.a, d.longitude, d.latitude) * METRES_PER_DEGREE});
+        }
+    }
+    const uint32_t found = std::min<uint32_t>(k, static_cast<uint32_t>(scratch.size()));
+    std::partial_sort(scratch.begin(), scratch.begin() + found, scratch.end(), by_distance);
+    std::copy(scratch.begin(), scratch.begin() + found, out);
+    return found;
+}
+
+static uint32_t linear_within(const std::vector<tracked_detection_parameters> &dets, bool bearing, point q, double radius,
+                              detection_hit *out) {
+    uint32_t found = 0;
+    for (const tracked_detection_parameters &d : dets) {
+        // Compared in degrees, as the index does, so both round the same way.
+        const double scale = bearing ? 1.0 : METRES_PER_DEGREE;
+        const double deg   = bearing ? angular_distance_deg(q.a, q.b, d.yaw_global, d.pitch_global)
+                                     : angular_distance_deg(q.b, q.a, d.longitude, d.latitude);
+        if (deg <= static_cast<float>(radius) / scale) out[found++] = {d.track_id, deg * scale};
+    }
+    return found;
+}
+
+static bool same(detection_hit *a, uint32_t na, detection_hit *b, uint32_t nb, bool sorted) {
+    if (na != nb) return false;
+    if (!sorted) {
+        std::sort(a, a + na, by_distance);
+        std::sort(b, b + nb, by_distance);
+    }
+    for (uint32_t i = 0; i < na; ++i) {
+        // Ties may come back in a different order; compare distances, which must match exactly.
+        if (a[i].distance != b[i].distance) return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    const uint32_t detections = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 2000;
+    const uint32_t queries    = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 20000;
+    rng random = {argc > 3 ? strtoull(argv[3], nullptr, 10) : 1};
+
+    detection_index_config config;
+    config.max_detections = std::max<uint32_t>(detections, 1);
+    detection_index index(config);
+    std::vector<tracked_detection_parameters> dets(detections);
+
+    message frame = {};
+    frame.version      = VERSION;
+    frame.message_type = CURRENT_PARAMETERS;
+    const auto place = [&](uint32_t i, float yaw, float pitch, float lat, float lon) {
+        pack_tracked_detection_parameters(frame, detections, i, 0.9f, 0, yaw, pitch, 0, 0, 0, lat, lon, 100.0f, 500.0f,
+                                          0.1f, 0.1f, static_cast<uint16_t>(i + 1));
+        unpack_tracked_detection_parameters(frame, dets[i]);
+        index.observe(frame, 0);
+    };
+    for (uint32_t i = 0; i < detections; ++i) {
+        place(i, static_cast<float>(random.uniform(-180, 180)), static_cast<float>(random.uniform(-30, 60)),
+              static_cast<float>(REF_LATITUDE + random.uniform(-0.045, 0.045)),
+              static_cast<float>(REF_LONGITUDE + random.uniform(-0.07, 0.07)));
+    }
+
+    // One frame of movement for every track: the cost the index adds to each unpack.
+    double start = now_s();
+    for (uint32_t i = 0; i < detections; ++i) {
+        const tracked_detection_parameters &d = dets[i];
+        place(i, wrap_yaw_degrees(d.yaw_global + static_cast<float>(random.uniform(-0.5, 0.5))),
+              std::max(-30.0f, std::min(60.0f, d.pitch_global + static_cast<float>(random.uniform(-0.5, 0.5)))),
+              d.latitude + static_cast<float>(random.uniform(-1e-4, 1e-4)),
+              d.longitude + static_cast<float>(random.uniform(-1e-4, 1e-4)));
+    }
+    const double update_ns = (now_s() - start) * 1e9 / std::max<uint32_t>(detections, 1);
+
+    std::vector<point> bearings(queries), positions(queries);
+    for (uint32_t q = 0; q < queries; ++q) {
+        bearings[q]  = {static_cast<float>(random.uniform(-180, 180)), static_cast<float>(random.uniform(-30, 60))};
+        positions[q] = {static_cast<float>(REF_LATITUDE + random.uniform(-0.045, 0.045)),
+                        static_cast<float>(REF_LONGITUDE + random.uniform(-0.07, 0.07))};
+    }
+
+    printf("%u detections, %u queries per row, index update %.0f ns per observe()\n", detections, queries, update_ns);
+    printf("%-22s %10s %10s %10s %10s\n", "query", "index us", "linear us", "speedup", "avg hits");
+
+    struct query_kind {
+        const char *name;
+        bool        bearing;
+        uint32_t    k;        // 0: radius query
+        double      radius;   // degrees or metres
+    };
+    const query_kind kinds[] = {
+        {"nearest bearing k=1", true, 1, 0},
+        {"nearest bearing k=8", true, 8, 0},
+        {"bearing within 3 deg", true, 0, 3.0},
+        {"nearest position k=1", false, 1, 0},
+        {"nearest position k=8", false, 8, 0},
+        {"position within 250 m", false, 0, 250.0},
+    };
+    std::vector<detection_hit> fast(detections + 1), slow(detections + 1), scratch;
+    scratch.reserve(detections);
+    bool ok = true;
+    for (const query_kind &kind : kinds) {
+        const std::vector<point> &points = kind.bearing ? bearings : positions;
+        double index_s = 0, linear_s = 0;
+        uint64_t hits = 0;
+        for (uint32_t q = 0; q < queries; ++q) {
+            const point p = points[q];
+            uint32_t nf, ns;
+            start = now_s();
+            if (kind.k != 0) {
+                nf = kind.bearing ? index.nearest_bearing(p.a, p.b, kind.k, fast.data())
+                                  : index.nearest_position(p.a, p.b, kind.k, fast.data());
+            } else {
+                nf = kind.bearing ? index.within_bearing(p.a, p.b, static_cast<float>(kind.radius), fast.data(), detections)
+                                  : index.within_position(p.a, p.b, static_cast<float>(kind.radius), fast.data(), detections);
+            }
+            index_s += now_s() - start;
+            start = now_s();
+            ns = kind.k != 0 ? linear_nearest(dets, kind.bearing, p, kind.k, scratch, slow.data())
+                             : linear_within(dets, kind.bearing, p, kind.radius, slow.data());
+            linear_s += now_s() - start;
+            hits += nf;
+            if (!same(fast.data(), nf, slow.data(), ns, kind.k != 0)) {
+                if (ok) printf("FAILED: %s query %u: index %u hits, linear %u hits\n", kind.name, q, nf, ns);
+                ok = false;
+            }
+        }
+        printf("%-22s %10.2f %10.2f %9.1fx %10.1f\n", kind.name, index_s * 1e6 / queries, linear_s * 1e6 / queries,
+               linear_s / index_s, static_cast<double>(hits) / queries);
+    }
+    printf("%s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,219 @@
+/*
+    flow_control_loopback: a recurring stream to a throttled reader over loopback UDP, with and without credit-based
+    flow control (flow_control.hpp).
+
+        g++ -std=c++17 -O2 -pthread -I.. -I../digiview_commons flow_control_loopback.cpp -o flow_control_loopback
+        ./flow_control_loopback [stream_hz] [reader_hz] [window] [loss]
+
+    The producer publishes a TRACKED_DETECTION tick at stream_hz for 3 s. The reader consumes at most reader_hz frames
+    per second from a 256 KiB socket buffer. It measures each frame's age when consumed and how many frames the
+    producer had sent that it had not yet consumed. With flow control the reader grants `window` frames of credit and
+    the producer skips ticks while out of credit. The producer reports its dropped ticks in CREDIT messages.
+
+    A third run repeats the credit-based one with `loss` (default 0.1) of the frames and grants dropped by a
+    link_emulator (link_emulator.hpp) in each direction. The stream must keep flowing: the reader makes up for lost
+    frames from the frames_sent of each CREDIT report.
+*/
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../flow_control.hpp"
+#include "../link_emulator.hpp"
+
+static const uint16_t PRODUCER_PORT = 47502;
+static const uint16_t READER_PORT   = 47503;
+static const uint64_t RUN_US        = 3000000;
+
+static uint64_t now_us() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static sockaddr_in loopback(uint16_t port) {
+    sockaddr_in addr = {};
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return addr;
+}
+
+static int bound_socket(uint16_t port) {
+    const int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    const sockaddr_in addr = loopback(port);
+    if (bind(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0) {
+        perror("bind");
+        exit(2);
+    }
+    return fd;
+}
+
+struct run_result {
+    std::vector<uint64_t> age_us;
+    uint64_t              max_unconsumed;
+    uint64_t              sent;
+    uint64_t              lost;
+    uint64_t              consumed;
+    uint32_t              reported_dropped_ticks;
+};
+
+// Sends one datagram through a lossy link_emulator. The link has no delay, so what survives goes out at once.
+static bool send_over(link_emulator &link, int fd, const message &msg, const sockaddr_in &to) {
+    const uint64_t t = now_us();
+    if (!link.send(&msg, sizeof(msg), t)) return false;
+    link.receive(t, [&](const uint8_t *data, size_t len, uint64_t) {
+        sendto(fd, data, len, 0, reinterpret_cast<const sockaddr *>(&to), sizeof(to));
+    });
+    return true;
+}
+
+static run_result run(bool flow_control, uint32_t stream_hz, uint32_t reader_hz, uint64_t window, double loss) {
+    const int producer_fd = bound_socket(PRODUCER_PORT);
+    const int reader_fd   = bound_socket(READER_PORT);
+    const int rcvbuf = 256 * 1024;
+    setsockopt(reader_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    timeval tv = {0, 200000};
+    setsockopt(reader_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    run_result r = {};
+    std::atomic<uint64_t> sent{0};
+    std::atomic<uint64_t> lost{0};
+    std::atomic<bool>     producing{true};
+    link_config lossy;
+    lossy.loss = loss;
+
+    flow_control_config config;
+    config.require_credit = true;
+    config.initial_frames = window;
+    flow_controller flow(config);
+
+    std::thread producer([&] {
+        const sockaddr_in reader = loopback(READER_PORT);
+        link_emulator downlink(lossy);
+        const uint64_t period_us = 1000000 / stream_hz;
+        const uint64_t start     = now_us();
+        uint64_t next_report = start;
+        message frame = {};
+        frame.version      = VERSION;
+        frame.message_type = CURRENT_PARAMETERS;
+        for (uint64_t tick = start; tick < start + RUN_US; tick += period_us) {
+            while (now_us() < tick) std::this_thread::sleep_for(std::chrono::microseconds(50));
+            message credit;
+            while (recv(producer_fd, &credit, sizeof(credit), MSG_DONTWAIT) == sizeof(credit)) flow.on_message(credit);
+
+            if (flow_control && tick >= next_report) {
+                message report;
+                flow.pack_report(report);
+                send_over(downlink, producer_fd, report, reader);
+                next_report = tick + 100000;
+            }
+            if (flow_control && !flow.admit_tick()) continue;
+            if (flow_control && !flow.try_send(TRAFFIC_TELEMETRY)) continue;
+            pack_tracked_detection_parameters(frame, 1, 0, 90, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, now_us());
+            add_checksum_for_digiview_message(frame);
+            const bool delivered = send_over(downlink, producer_fd, frame, reader);
+            sent.fetch_add(1);
+            if (!delivered) lost.fetch_add(1);   // After sent, so the reader never sees more lost than sent.
+        }
+        producing.store(false);
+    });
+
+    // Reader: consumes one frame per 1/reader_hz and keeps consuming for a while after the producer stops.
+    const sockaddr_in producer_addr = loopback(PRODUCER_PORT);
+    const uint64_t consume_us = 1000000 / reader_hz;
+    credit_granter granter(window);
+    link_config uplink_config = lossy;
+    uplink_config.seed = 2;
+    link_emulator uplink(uplink_config);
+    uint64_t idle_since = 0;
+    for (;;) {
+        message msg;
+        const ssize_t n = recv(reader_fd, &msg, sizeof(msg), 0);
+        const uint64_t t = now_us();
+        if (n != sizeof(msg)) {
+            if (!producing.load()) {
+                if (idle_since == 0) idle_since = t;
+                if (t - idle_since > 500000) break;
+            }
+            if (flow_control && granter.due(t)) {
+                message grant;
+                granter.pack_grant(grant, t);
+                send_over(uplink, reader_fd, grant, producer_addr);
+            }
+            continue;
+        }
+        idle_since = 0;
+        bool grant_due;
+        if (msg.message_type == CREDIT) {
+            credit_parameters report;
+            unpack_credit_parameters(msg, report);
+            r.reported_dropped_ticks = report.dropped_ticks;
+            grant_due = granter.on_report(msg);
+        } else {
+            tracked_detection_parameters det;
+            unpack_tracked_detection_parameters(msg, det);
+            r.age_us.push_back(t - det.publish_timestamp_us);
+            const uint64_t lost_so_far = lost.load();
+            r.max_unconsumed = std::max(r.max_unconsumed, sent.load() - lost_so_far - r.consumed);
+            std::this_thread::sleep_for(std::chrono::microseconds(consume_us));
+            r.consumed++;
+            grant_due = granter.consumed();
+        }
+        if (flow_control && (grant_due || granter.due(now_us()))) {
+            message grant;
+            granter.pack_grant(grant, now_us());
+            send_over(uplink, reader_fd, grant, producer_addr);
+        }
+    }
+    producer.join();
+    r.sent = sent.load();
+    r.lost = lost.load();
+    if (flow_control) r.reported_dropped_ticks = std::max(r.reported_dropped_ticks, flow.stats().dropped_ticks);
+    close(producer_fd);
+    close(reader_fd);
+    return r;
+}
+
+static void report(const char *name, run_result &r) {
+    std::sort(r.age_us.begin(), r.age_us.end());
+    const auto pct = [&](uint32_t p) { return r.age_us.empty() ? 0.0 : r.age_us[std::min(r.age_us.size() - 1, r.age_us.size() * p / 100)] / 1e3; };
+    printf("%-17s sent %6llu consumed %6llu lost %6llu  age p50 %7.1f ms p99 %7.1f ms max %7.1f ms  "
+           "max unconsumed %5llu  dropped ticks %u\n",
+           name, static_cast<unsigned long long>(r.sent), static_cast<unsigned long long>(r.consumed),
+           static_cast<unsigned long long>(r.sent - r.consumed), pct(50), pct(99), r.age_us.empty() ? 0.0 : r.age_us.back() / 1e3,
+           static_cast<unsigned long long>(r.max_unconsumed), r.reported_dropped_ticks);
+}
+
+int main(int argc, char **argv) {
+    const uint32_t stream_hz = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 1000;
+    const uint32_t reader_hz = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 200;
+    const uint64_t window    = argc > 3 ? strtoull(argv[3], nullptr, 10) : 16;
+    const double   loss      = argc > 4 ? atof(argv[4]) : 0.1;
+
+    printf("stream %u Hz, reader %u frames/s, window %llu frames\n", stream_hz, reader_hz, static_cast<unsigned long long>(window));
+    run_result plain = run(false, stream_hz, reader_hz, window, 0.0);
+    report("no credit", plain);
+    run_result credited = run(true, stream_hz, reader_hz, window, 0.0);
+    report("credit-based", credited);
+    run_result lossy = run(true, stream_hz, reader_hz, window, loss);
+    char lossy_name[32];
+    snprintf(lossy_name, sizeof(lossy_name), "credit, %.0f%% loss", loss * 100);
+    report(lossy_name, lossy);
+
+    // The lossy run must not stall once `window` frames have been lost: it should consume most of what the reader
+    // can take in 3 s.
+    const bool ok = credited.sent == credited.consumed && credited.max_unconsumed <= window + 1 &&
+                    lossy.sent == lossy.consumed + lossy.lost && lossy.max_unconsumed <= window + 1 &&
+                    lossy.consumed >= static_cast<uint64_t>(reader_hz) * RUN_US / 1000000 / 2;
+    printf("%s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+/*
+    latency_histogram_bench: cost per recorded sample of the latency histograms (latency_histogram.hpp).
+
+        g++ -std=c++17 -O2 -pthread -I.. -I../digiview_commons latency_histogram_bench.cpp -o latency_histogram_bench
+        ./latency_histogram_bench [samples] [threads] [max_ns]
+
+    Each of `threads` threads (default 4) records `samples` samples (default 20 million) into its own shard, spread
+    over the param_types and over latencies from 1 us to about 1 s, as record_frame() would see them. The loop is
+    timed once for the whole run; the program prints the cost per sample for one thread and for all threads together,
+    and the time summarize() takes while they record. It fails if a sample recorded by one thread alone costs more than
+    max_ns (default 20) on average, or if the merged counts do not add up to the samples recorded.
+*/
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "../latency_histogram.hpp"
+
+static uint64_t now_ns() {
+    const auto since_epoch = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch).count());
+}
+
+// Recorded values are generated ahead of the timed loop, so the loop measures record() and not the generator.
+static std::vector<uint32_t> make_latencies(uint32_t seed) {
+    std::vector<uint32_t> values(1 << 16);
+    uint64_t state = seed * 0x9E3779B97F4A7C15ULL + 1;
+    for (uint32_t &v : values) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        const uint32_t exponent = static_cast<uint32_t>(state >> 59) % 20;   // 1 us .. 1 s.
+        v = static_cast<uint32_t>((1ULL << exponent) + ((state >> 20) & ((1ULL << exponent) - 1)));
+    }
+    return values;
+}
+
+static double record_run(latency_shard *shard, const std::vector<uint32_t> &values, uint64_t samples) {
+    const uint64_t t0 = now_ns();
+    for (uint64_t i = 0; i < samples; ++i) {
+        shard->record(static_cast<uint8_t>(i % 24), values[i & (values.size() - 1)]);
+    }
+    return static_cast<double>(now_ns() - t0) / static_cast<double>(samples);
+}
+
+int main(int argc, char **argv) {
+    const uint64_t samples = argc > 1 ? strtoull(argv[1], nullptr, 10) : 20000000;
+    const uint32_t threads = argc > 2 ? std::max(1, atoi(argv[2])) : 4;
+    const double   max_ns  = argc > 3 ? atof(argv[3]) : 20.0;
+
+    latency_histograms histograms;
+
+    // One thread alone.
+    latency_shard *solo = histograms.register_thread();
+    const double solo_ns = record_run(solo, make_latencies(0), samples);
+
+    // All threads at once, each into its own shard, with a reader summarizing meanwhile.
+    std::vector<double> per_thread_ns(threads);
+    std::vector<std::thread> workers;
+    std::atomic<uint32_t> running{threads};
+    const uint64_t t0 = now_ns();
+    for (uint32_t t = 0; t < threads; ++t) {
+        latency_shard *shard = histograms.register_thread();
+        workers.emplace_back([&, shard, t] {
+            per_thread_ns[t] = record_run(shard, make_latencies(t + 1), samples);
+            running.fetch_sub(1);
+        });
+    }
+    uint64_t summaries = 0, summary_ns = 0;
+    while (running.load() != 0) {
+        const uint64_t s0 = now_ns();
+        histograms.summarize(NAVIGATION);
+        summary_ns += now_ns() - s0;
+        summaries++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    for (std::thread &worker : workers) worker.join();
+    const double wall_ns = static_cast<double>(now_ns() - t0);
+
+    uint64_t total = 0;
+    std::vector<uint64_t> counts(LATENCY_BUCKETS);
+    for (uint32_t p = 0; p < LATENCY_PARAM_TYPES; ++p) {
+        histograms.merge(static_cast<uint8_t>(p), counts.data());
+        for (uint64_t c : counts) total += c;
+    }
+    const uint64_t expected = samples * (threads + 1);
+
+    double worst_ns = solo_ns;
+    for (double ns : per_thread_ns) worst_ns = std::max(worst_ns, ns);
+    printf("1 thread        %6.2f ns/sample\n", solo_ns);
+    printf("%-2u threads      %6.2f ns/sample per thread (worst), %6.2f ns/sample aggregate\n", threads, worst_ns,
+           wall_ns / static_cast<double>(samples * threads));
+    printf("summarize       %6.1f us while recording (%llu calls)\n",
+           summaries == 0 ? 0.0 : static_cast<double>(summary_ns) / summaries / 1e3,
+           static_cast<unsigned long long>(summaries));
+    printf("samples merged  %llu of %llu\n", static_cast<unsigned long long>(total),
+           static_cast<unsigned long long>(expected));
+
+    const bool ok = total == expected && solo_ns <= max_ns;
+    printf("%s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,213 @@
+/*
+    link_emulator_bench: the native recurring TRACKED_DETECTION stream over emulated constrained links
+    (link_emulator.hpp).
+
+        g++ -std=c++17 -O2 -pthread -I.. -I../digiview_commons link_emulator_bench.cpp -o link_emulator_bench
+        ./link_emulator_bench [detections] [seconds] [seed]
+
+    A 50 ms recurring GET publishes `detections` frames per tick. Each link profile is run twice on a virtual clock:
+    once with one frame per datagram, as the protocol does today, and once with a whole tick packed into as few
+    datagrams as the MTU allows. For each run the program reports delivered frames, complete ticks, tick age (publish
+    to last frame of the tick) and wire bandwidth.
+
+    It then checks that the same seed gives identical results, and sends GETs through a link_relay on the LTE profile
+    to show the relay's round trip on real sockets.
+*/
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "../link_emulator.hpp"
+#include "../msg_defs.hpp"
+
+static const uint64_t TICK_US          = 50000;
+static const uint16_t RELAY_PORT       = 47505;
+static const uint16_t RELAY_TARGET     = 47506;
+
+struct run_result {
+    uint64_t   frames_sent;
+    uint64_t   frames_delivered;
+    uint64_t   ticks;
+    uint64_t   complete_ticks;
+    double     age_p50_ms;
+    double     age_p99_ms;
+    double     wire_kbps;
+    link_stats stats;
+};
+
+static run_result run(const link_config &config, uint32_t detections, double seconds, bool batch) {
+    link_emulator link(config);
+    const uint32_t payload = config.mtu > config.overhead_bytes ? config.mtu - config.overhead_bytes : 65507;
+    const uint32_t frames_per_datagram = batch ? std::max<uint32_t>(1, payload / sizeof(message)) : 1;
+    const uint64_t ticks = static_cast<uint64_t>(seconds * 1e6 / TICK_US);
+
+    std::vector<uint32_t> received(ticks, 0);
+    std::vector<uint64_t> last_arrival(ticks, 0);
+    run_result r = {};
+    const auto consume = [&](const uint8_t *data, size_t len, uint64_t at) {
+        for (size_t offset = 0; offset + sizeof(message) <= len; offset += sizeof(message)) {
+            message msg;
+            memcpy(&msg, data + offset, sizeof(msg));
+            if (!has_valid_checksum_for_digiview_message(msg)) continue;
+            const uint64_t tick = msg.timestamp;
+            received[tick]++;
+            last_arrival[tick] = std::max(last_arrival[tick], at);
+            r.frames_delivered++;
+        }
+    };
+
+    std::vector<message> datagram(frames_per_datagram);
+    for (uint64_t tick = 0; tick < ticks; ++tick) {
+        const uint64_t now = tick * TICK_US;
+        link.receive(now, consume);
+        uint32_t queued = 0;
+        for (uint32_t d = 0; d < detections; ++d) {
+            message &frame = datagram[queued++];
+            frame = {};
+            frame.version      = VERSION;
+            frame.message_type = CURRENT_PARAMETERS;
+            frame.timestamp    = tick;
+            pack_tracked_detection_parameters(frame, static_cast<uint8_t>(detections), static_cast<uint8_t>(d), 90, 1,
+                                              10.0f * d, 1.0f, 0, 0, 0, 0, 0, 0, 0, 0, 0, static_cast<uint16_t>(d), now);
+            add_checksum_for_digiview_message(frame);
+            if (queued == frames_per_datagram || d + 1 == detections) {
+                link.send(datagram.data(), queued * sizeof(message), now);
+                r.frames_sent += queued;
+                queued = 0;
+            }
+        }
+    }
+    link.receive(UINT64_MAX, consume);
+
+    std::vector<uint64_t> ages;
+    for (uint64_t tick = 0; tick < ticks; ++tick) {
+        if (received[tick] != detections) continue;
+        r.complete_ticks++;
+        ages.push_back(last_arrival[tick] - tick * TICK_US);
+    }
+    std::sort(ages.begin(), ages.end());
+    if (!ages.empty()) {
+        r.age_p50_ms = ages[ages.size() / 2] / 1e3;
+        r.age_p99_ms = ages[std::min(ages.size() - 1, ages.size() * 99 / 100)] / 1e3;
+    }
+    r.ticks     = ticks;
+    r.stats     = link.stats();
+    r.wire_kbps = r.stats.wire_bytes * 8 / seconds / 1e3;
+    return r;
+}
+
+static void report(const char *profile, const char *mode, const run_result &r) {
+    printf("%-16s %-18s %7.1f%% frames %7.1f%% ticks  age p50 %8.1f ms p99 %8.1f ms  %8.1f kbit/s  queue drops %llu\n",
+           profile, mode, 100.0 * r.frames_delivered / std::max<uint64_t>(1, r.frames_sent),
+           100.0 * r.complete_ticks / std::max<uint64_t>(1, r.ticks), r.age_p50_ms, r.age_p99_ms, r.wire_kbps,
+           static_cast<unsigned long long>(r.stats.dropped_queue));
+}
+
+static uint64_t now_us() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static sockaddr_in loopback(uint16_t port) {
+    sockaddr_in addr = {};
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return addr;
+}
+
+// Round trips of single GET frames through a relay with the LTE profile in both directions. Returns the median.
+static double relay_round_trip_ms(uint64_t seed, uint32_t round_trips) {
+    const int target = socket(AF_INET, SOCK_DGRAM, 0);
+    const sockaddr_in target_addr = loopback(RELAY_TARGET);
+    if (bind(target, reinterpret_cast<const sockaddr *>(&target_addr), sizeof(target_addr)) != 0) return -1;
+    link_config uplink = link_profile_lte_uplink(seed);
+    uplink.loss = 0;
+    link_config downlink = uplink;
+    downlink.seed = seed + 1;
+    link_relay relay;
+    if (!relay.open(RELAY_PORT, target_addr, uplink, downlink)) return -1;
+
+    std::thread echo([&] {
+        for (uint32_t i = 0; i < round_trips; ++i) {
+            message msg;
+            sockaddr_in from;
+            socklen_t from_len = sizeof(from);
+            if (recvfrom(target, &msg, sizeof(msg), 0, reinterpret_cast<sockaddr *>(&from), &from_len) != sizeof(msg)) break;
+            msg.message_type = CURRENT_PARAMETERS;
+            add_checksum_for_digiview_message(msg);
+            sendto(target, &msg, sizeof(msg), 0, reinterpret_cast<const sockaddr *>(&from), from_len);
+        }
+    });
+    const int client = socket(AF_INET, SOCK_DGRAM, 0);
+    timeval tv = {2, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    const sockaddr_in relay_addr = loopback(RELAY_PORT);
+    std::vector<double> rtt_ms;
+    for (uint32_t i = 0; i < round_trips; ++i) {
+        message get = {};
+        pack_get_parameters(get, TRACKED_DETECTION);
+        add_checksum_for_digiview_message(get);
+        const uint64_t start = now_us();
+        sendto(client, &get, sizeof(get), 0, reinterpret_cast<const sockaddr *>(&relay_addr), sizeof(relay_addr));
+        message reply;
+        if (recv(client, &reply, sizeof(reply), 0) != sizeof(reply)) break;
+        rtt_ms.push_back((now_us() - start) / 1e3);
+    }
+    echo.join();
+    relay.close();
+    close(client);
+    close(target);
+    if (rtt_ms.size() != round_trips) return -1;
+    std::sort(rtt_ms.begin(), rtt_ms.end());
+    return rtt_ms[rtt_ms.size() / 2];
+}
+
+int main(int argc, char **argv) {
+    const uint32_t detections = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 20;
+    const double   seconds    = argc > 2 ? atof(argv[2]) : 60.0;
+    const uint64_t seed       = argc > 3 ? strtoull(argv[3], nullptr, 10) : 1;
+
+    struct profile {
+        const char *name;
+        link_config config;
+    };
+    link_config lan;
+    lan.bandwidth_bps = 100000000;
+    lan.latency_us    = 200;
+    lan.mtu           = 1500;
+    lan.seed          = seed;
+    const profile profiles[] = {
+        {"lan", lan},
+        {"lte uplink", link_profile_lte_uplink(seed)},
+        {"narrowband radio", link_profile_narrowband_radio(seed)},
+    };
+
+    printf("%u detections per 50 ms tick, %.0f s virtual time, seed %llu\n", detections, seconds,
+           static_cast<unsigned long long>(seed));
+    bool ok = true;
+    for (const profile &p : profiles) {
+        const run_result single  = run(p.config, detections, seconds, false);
+        const run_result batched = run(p.config, detections, seconds, true);
+        report(p.name, "frame per datagram", single);
+        report(p.name, "tick per datagram", batched);
+
+        const run_result again = run(p.config, detections, seconds, false);
+        if (memcmp(&again.stats, &single.stats, sizeof(link_stats)) != 0 || again.frames_delivered != single.frames_delivered) {
+            printf("FAILED: %s is not deterministic for a fixed seed\n", p.name);
+            ok = false;
+        }
+    }
+
+    const double rtt = relay_round_trip_ms(seed, 20);
+    if (rtt < 0) {
+        printf("FAILED: relay round trip\n");
+        ok = false;
+    } else {
+        printf("link_relay, lte profile both ways: GET round trip p50 %.1f ms\n", rtt);
+    }
+    return ok ? 0 : 1;
+}
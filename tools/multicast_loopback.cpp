@@ -0,0 +1,117 @@
+/*
+    multicast_loopback: local check of the multicast fan-out (multicast_transport.hpp) over the loopback interface.
+
+        g++ -std=c++17 -O2 -pthread -I.. -I../digiview_commons multicast_loopback.cpp -o multicast_loopback
+        ./multicast_loopback [frames] [max_subscribers]
+
+    For 1, 2, 4, ... max_subscribers receivers joined to the TRACKED_DETECTION group, the sender publishes the same
+    frames in bursts. The program prints the sender's cost per frame and the number of syscalls it made, and checks
+    that every subscriber received every frame intact. Exit status 1 means a subscriber saw a lost or corrupted frame.
+    Exit status 77 means the host cannot do multicast on the loopback interface at all (sockets cannot join, or every
+    datagram is refused for lack of a route); CTest reports that as skipped rather than passed.
+*/
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../multicast_transport.hpp"
+
+static const uint32_t BURST = 32;
+static const int      NO_MULTICAST = 77;   // CTest's SKIP_RETURN_CODE for this program.
+
+struct subscriber_result {
+    uint64_t received = 0;
+    uint64_t corrupt  = 0;
+    uint64_t out_of_order = 0;
+};
+
+int main(int argc, char **argv) {
+    const uint64_t frames          = argc > 1 ? strtoull(argv[1], nullptr, 10) : 100000;
+    const uint32_t max_subscribers = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 8;
+
+    multicast_config config;
+    config.interface_address = "127.0.0.1";
+
+    bool all_ok = true;
+    for (uint32_t subscribers = 1; subscribers <= max_subscribers; subscribers *= 2) {
+        std::vector<std::unique_ptr<multicast_receiver>> receivers;
+        for (uint32_t i = 0; i < subscribers; ++i) {
+            receivers.emplace_back(new multicast_receiver());
+            if (!receivers.back()->open(config) || !receivers.back()->join_param_type(TRACKED_DETECTION)) {
+                fprintf(stderr, "cannot open subscriber socket (is multicast enabled on lo?)\n");
+                return NO_MULTICAST;
+            }
+        }
+
+        std::vector<subscriber_result> results(subscribers);
+        std::atomic<bool> done{false};
+        std::vector<std::thread> threads;
+        for (uint32_t i = 0; i < subscribers; ++i) {
+            threads.emplace_back([&, i] {
+                subscriber_result &r = results[i];
+                uint64_t expected = 0;
+                while (r.received < frames) {
+                    const int n = receivers[i]->receive([&](const message &msg) {
+                        if (!has_valid_checksum_for_digiview_message(msg)) {
+                            r.corrupt++;
+                            return;
+                        }
+                        if (msg.timestamp != expected) r.out_of_order++;
+                        expected = msg.timestamp + 1;
+                        r.received++;
+                    }, 200);
+                    if (n == 0 && done.load()) break;
+                }
+            });
+        }
+
+        multicast_sender sender;
+        if (!sender.open(config)) {
+            fprintf(stderr, "cannot open sender socket\n");
+            return NO_MULTICAST;
+        }
+        message msg = {};
+        msg.message_type = CURRENT_PARAMETERS;
+        pack_tracked_detection_parameters(msg, 1, 0, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 7, 0);
+
+        double send_ns = 0;
+        for (uint64_t i = 0; i < frames; ++i) {
+            msg.timestamp = i;
+            add_checksum_for_digiview_message(msg);
+            const auto start = std::chrono::steady_clock::now();
+            sender.send(msg);
+            if ((i + 1) % BURST == 0 || i + 1 == frames) sender.flush();
+            send_ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            if ((i + 1) % BURST == 0) {
+                // Pace bursts so the subscribers' socket buffers are not the thing being measured.
+                std::this_thread::sleep_for(std::chrono::microseconds(20 * subscribers));
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        done.store(true);
+        for (auto &t : threads) t.join();
+
+        const multicast_stats &stats = sender.stats();
+        if (subscribers == 1 && stats.datagrams_failed != 0 && results[0].received == 0) {
+            fprintf(stderr, "every datagram failed and none arrived (no multicast route on lo?)\n");
+            return NO_MULTICAST;
+        }
+        printf("subscribers %2u  gso %s  sender syscalls %llu (%.3f per frame)  send %.0f ns/frame\n", subscribers,
+               sender.gso_active() ? "on " : "off", static_cast<unsigned long long>(stats.syscalls),
+               static_cast<double>(stats.syscalls) / frames, send_ns / frames);
+        for (uint32_t i = 0; i < subscribers; ++i) {
+            const subscriber_result &r = results[i];
+            const bool ok = r.received == frames && r.corrupt == 0 && r.out_of_order == 0;
+            all_ok &= ok;
+            printf("    subscriber %u: received %llu/%llu corrupt %llu out of order %llu %s\n", i,
+                   static_cast<unsigned long long>(r.received), static_cast<unsigned long long>(frames),
+                   static_cast<unsigned long long>(r.corrupt), static_cast<unsigned long long>(r.out_of_order),
+                   ok ? "ok" : "FAILED");
+        }
+    }
+    return all_ok ? 0 : 1;
+}
@@ -0,0 +1,155 @@
+/*
+    no_ack_bench: link utilisation of 100 Hz control SETs with and without ACKNOWLEDGEMENT replies, over emulated links
+    (SET_PARAMETERS_NO_ACK, link_emulator.hpp).
+
+        g++ -std=c++17 -O2 -pthread -I.. -I../digiview_commons no_ack_bench.cpp -o no_ack_bench
+        ./no_ack_bench [rate_hz] [seconds] [seed]
+
+    A client streams CAM_TARGETING with euler_delta and SINGLE_TARGET_TRACKING aim points, each at rate_hz. A simulated
+    unit answers each SET as DigiView does: CHECKSUM_ERROR for a corrupted frame, DATA_ERROR for an invalid cam_id,
+    otherwise ACKNOWLEDGEMENT, which SET_PARAMETERS_NO_ACK suppresses. About 1% of frames are corrupted and 1% carry
+    an invalid cam_id. Runs on a virtual clock. The program checks that both modes report the same errors.
+*/
+#include <cstdio>
+#include <cstdlib>
+
+#include "../link_emulator.hpp"
+#include "../msg_defs.hpp"
+
+static const uint8_t USER_VIEWS = 4;
+
+struct run_result {
+    uint64_t   sets;
+    uint64_t   acks;
+    uint64_t   checksum_errors;
+    uint64_t   data_errors;
+    double     uplink_kbps;
+    double     downlink_kbps;
+    link_stats downlink;
+};
+
+// The unit's reply to one received SET, or false if it sends none.
+static bool unit_reply(const message &request, message &reply) {
+    reply = request;
+    if (!has_valid_checksum_for_digiview_message(reply)) {
+        reply.message_type = CHECKSUM_ERROR;
+    } else if (reply.data[cam_id_offset(reply.param_type)] >= USER_VIEWS) {
+        reply.message_type = DATA_ERROR;
+    } else if (acknowledges_set(reply.message_type)) {
+        reply.message_type = ACKNOWLEDGEMENT;
+    } else {
+        return false;
+    }
+    add_checksum_for_digiview_message(reply);
+    return true;
+}
+
+static run_result run(const link_config &profile, bool no_ack, uint32_t rate_hz, double seconds, uint64_t seed) {
+    link_config down_config = profile;
+    down_config.seed = profile.seed + 1;
+    link_emulator uplink(profile);
+    link_emulator downlink(down_config);
+    uint64_t rng = seed;
+    const auto chance = [&](uint32_t per_mille) {
+        rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (rng >> 33) % 1000 < per_mille;
+    };
+
+    run_result r = {};
+    const uint64_t period_us = 1000000 / rate_hz;
+    const uint64_t end_us    = static_cast<uint64_t>(seconds * 1e6);
+    const auto deliver_replies = [&](uint64_t now) {
+        downlink.receive(now, [&](const uint8_t *data, size_t len, uint64_t) {
+            if (len != sizeof(message)) return;
+            message reply;
+            memcpy(&reply, data, sizeof(reply));
+            if (reply.message_type == ACKNOWLEDGEMENT) r.acks++;
+            if (reply.message_type == CHECKSUM_ERROR) r.checksum_errors++;
+            if (reply.message_type == DATA_ERROR) r.data_errors++;
+        });
+    };
+    const auto deliver_sets = [&](uint64_t now) {
+        uplink.receive(now, [&](const uint8_t *data, size_t len, uint64_t at) {
+            if (len != sizeof(message)) return;
+            message request;
+            memcpy(&request, data, sizeof(request));
+            message reply;
+            if (unit_reply(request, reply)) downlink.send(&reply, sizeof(reply), at);
+        });
+    };
+
+    for (uint64_t now = 0; now < end_us; now += period_us) {
+        deliver_sets(now);
+        deliver_replies(now);
+        for (int group = 0; group < 2; ++group) {
+            const uint8_t cam = chance(10) ? 0xFF : 0;
+            message set = {};
+            set.timestamp = now;
+            if (group == 0) {
+                pack_set_cam_targeting_parameters(set, "stream0", cam, static_cast<View::TargetingMode>(0), true, 0.05f, -0.02f,
+                                                  0, 0, 0, 0, 0, 0, 0, 0, -1, false, no_ack);
+            } else {
+                pack_set_single_target_tracking_parameters(set, static_cast<single_target_tracker_command>(0), "stream0", cam,
+                                                           0.01f, -0.01f, 0, 0, 0, 0, 0, 0, 0, 0, false, no_ack);
+            }
+            add_checksum_for_digiview_message(set);
+            if (chance(10)) set.data[40] ^= 0x5A;   // Corrupted in transit.
+            uplink.send(&set, sizeof(set), now);
+            r.sets++;
+        }
+    }
+    deliver_sets(UINT64_MAX);
+    deliver_replies(UINT64_MAX);
+
+    r.uplink_kbps   = uplink.stats().wire_bytes * 8 / seconds / 1e3;
+    r.downlink_kbps = downlink.stats().wire_bytes * 8 / seconds / 1e3;
+    r.downlink      = downlink.stats();
+    return r;
+}
+
+int main(int argc, char **argv) {
+    const uint32_t rate_hz = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 100;
+    const double   seconds = argc > 2 ? atof(argv[2]) : 30.0;
+    const uint64_t seed    = argc > 3 ? strtoull(argv[3], nullptr, 10) : 1;
+
+    link_config lossless_lte = link_profile_lte_uplink(seed);
+    lossless_lte.loss = 0;
+    link_config lossless_radio = link_profile_narrowband_radio(seed);
+    lossless_radio.loss = 0;
+    struct profile {
+        const char *name;
+        link_config config;
+    };
+    const profile profiles[] = {{"lte", lossless_lte}, {"narrowband radio", lossless_radio}};
+
+    printf("CAM_TARGETING + SINGLE_TARGET_TRACKING SETs at %u Hz each, %.0f s, 1%% corrupted, 1%% invalid cam_id\n",
+           rate_hz, seconds);
+    printf("%-17s %-22s %8s %8s %8s %8s %12s %12s %12s\n", "link", "mode", "sets", "acks", "crc_err", "data_err",
+           "up kbit/s", "down kbit/s", "total kbit/s");
+    bool ok = true;
+    for (const profile &p : profiles) {
+        const run_result acked  = run(p.config, false, rate_hz, seconds, seed);
+        const run_result silent = run(p.config, true, rate_hz, seconds, seed);
+        const run_result *results[] = {&acked, &silent};
+        const char *modes[] = {"SET_PARAMETERS", "SET_PARAMETERS_NO_ACK"};
+        for (int i = 0; i < 2; ++i) {
+            const run_result &r = *results[i];
+            printf("%-17s %-22s %8llu %8llu %8llu %8llu %12.1f %12.1f %12.1f\n", p.name, modes[i],
+                   static_cast<unsigned long long>(r.sets), static_cast<unsigned long long>(r.acks),
+                   static_cast<unsigned long long>(r.checksum_errors), static_cast<unsigned long long>(r.data_errors),
+                   r.uplink_kbps, r.downlink_kbps, r.uplink_kbps + r.downlink_kbps);
+        }
+        const double total_before = acked.uplink_kbps + acked.downlink_kbps;
+        const double total_after  = silent.uplink_kbps + silent.downlink_kbps;
+        const double bandwidth_kbps = p.config.bandwidth_bps / 1e3;
+        printf("%-17s downlink -%.1f%% (%.1f%% -> %.1f%% of link), total -%.1f%%\n", p.name,
+               100.0 * (1.0 - silent.downlink_kbps / acked.downlink_kbps), 100.0 * acked.downlink_kbps / bandwidth_kbps,
+               100.0 * silent.downlink_kbps / bandwidth_kbps, 100.0 * (1.0 - total_after / total_before));
+        if (silent.acks != 0 || silent.checksum_errors != acked.checksum_errors || silent.data_errors != acked.data_errors ||
+            acked.downlink.dropped_queue != 0 || silent.downlink.dropped_queue != 0) {
+            ok = false;
+        }
+    }
+    printf("%s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
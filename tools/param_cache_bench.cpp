@@ -0,0 +1,148 @@
+/*
+    param_cache_bench: reader/writer contention on the parameter cache (param_cache.hpp).
+
+        g++ -std=c++17 -O2 -pthread -I.. -I../digiview_commons param_cache_bench.cpp -o param_cache_bench
+        ./param_cache_bench [readers] [keys] [seconds]
+
+    One writer publishes to `keys` entries round robin as fast as it can while `readers` threads (default 4, 64 keys,
+    2 s) poll every entry with read_if_changed(). Each published frame carries its publish number in the timestamp and
+    in every data byte, so a reader can tell a torn copy from a consistent one. Every 64th publish and read is timed.
+    The program prints publish and read rates, latency percentiles and the share of reads that found a new version.
+    It fails if a reader ever sees a torn frame, a version going backwards, or an entry before its first publish.
+*/
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "../param_cache.hpp"
+
+static uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static param_cache_key key_for(uint32_t k) {
+    char name[32];
+    snprintf(name, sizeof(name), "stream%u", k);
+    return make_param_cache_key(CAM_TARGETING, name, static_cast<uint8_t>(k & 7));
+}
+
+struct reader_result {
+    uint64_t reads        = 0;
+    uint64_t changed      = 0;
+    uint64_t torn         = 0;
+    uint64_t regressions  = 0;
+    uint64_t unpublished  = 0;
+    std::vector<uint32_t> latencies;
+};
+
+static uint32_t percentile(std::vector<uint32_t> &values, double p) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, static_cast<size_t>(values.size() * p))];
+}
+
+int main(int argc, char **argv) {
+    const uint32_t readers = argc > 1 ? std::max(1, atoi(argv[1])) : 4;
+    const uint32_t keys    = argc > 2 ? std::max(1, atoi(argv[2])) : 64;
+    const double   seconds = argc > 3 ? atof(argv[3]) : 2.0;
+
+    param_cache cache(keys);
+    bool ok = cache.find(key_for(0)) == nullptr;
+
+    std::atomic<bool> stop{false};
+    std::vector<reader_result> results(readers);
+    std::vector<std::thread> threads;
+    for (uint32_t r = 0; r < readers; ++r) {
+        threads.emplace_back([&, r] {
+            reader_result &result = results[r];
+            result.latencies.reserve(1 << 20);
+            std::vector<const param_cache::entry *> entries(keys, nullptr);
+            std::vector<uint64_t> last_version(keys, 0);
+            message frame;
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (uint32_t k = 0; k < keys; ++k) {
+                    if (entries[k] == nullptr) {
+                        // An entry is only visible once it has a published value.
+                        entries[k] = cache.find(key_for(k));
+                        if (entries[k] == nullptr) continue;
+                        if (param_cache::version(*entries[k]) == 0) result.unpublished++;
+                    }
+                    const uint64_t previous = last_version[k];
+                    const bool timed = (result.reads & 63) == 0;
+                    const uint64_t t0 = timed ? now_ns() : 0;
+                    const bool changed = param_cache::read_if_changed(*entries[k], frame, last_version[k]);
+                    if (timed && result.latencies.size() < result.latencies.capacity()) {
+                        result.latencies.push_back(static_cast<uint32_t>(now_ns() - t0));
+                    }
+                    result.reads++;
+                    if (!changed) continue;
+                    result.changed++;
+                    if (last_version[k] < previous) result.regressions++;
+                    const uint8_t stamp = static_cast<uint8_t>(frame.timestamp);
+                    bool consistent = frame.param_type == CAM_TARGETING;
+                    for (uint32_t i = 0; i < sizeof(frame.data); ++i) consistent &= frame.data[i] == stamp;
+                    if (!consistent) result.torn++;
+                }
+            }
+        });
+    }
+
+    std::vector<param_cache_key> key_list(keys);
+    for (uint32_t k = 0; k < keys; ++k) key_list[k] = key_for(k);
+    std::vector<uint32_t> publish_latencies;
+    publish_latencies.reserve(1 << 20);
+    uint64_t published = 0;
+    bool full = false;
+    const uint64_t start_ns = now_ns();
+    const uint64_t end_ns   = start_ns + static_cast<uint64_t>(seconds * 1e9);
+    message frame = {};
+    frame.version      = VERSION;
+    frame.message_type = CURRENT_PARAMETERS;
+    frame.param_type   = CAM_TARGETING;
+    while ((published & 1023) != 0 || now_ns() < end_ns) {
+        frame.timestamp = published;
+        memset(frame.data, static_cast<uint8_t>(published), sizeof(frame.data));
+        const param_cache_key &key = key_list[published % keys];
+        if ((published & 63) == 0 && publish_latencies.size() < publish_latencies.capacity()) {
+            const uint64_t t0 = now_ns();
+            full |= !cache.publish(key, frame);
+            publish_latencies.push_back(static_cast<uint32_t>(now_ns() - t0));
+        } else {
+            full |= !cache.publish(key, frame);
+        }
+        published++;
+    }
+    const double elapsed_s = (now_ns() - start_ns) * 1e-9;
+    stop.store(true);
+    for (std::thread &t : threads) t.join();
+
+    uint64_t reads = 0, changed = 0, torn = 0, regressions = 0, unpublished = 0;
+    std::vector<uint32_t> read_latencies;
+    for (reader_result &result : results) {
+        reads += result.reads;
+        changed += result.changed;
+        torn += result.torn;
+        regressions += result.regressions;
+        unpublished += result.unpublished;
+        read_latencies.insert(read_latencies.end(), result.latencies.begin(), result.latencies.end());
+    }
+
+    printf("%u reader(s), %u keys, %.2f s\n", readers, keys, elapsed_s);
+    printf("publish: %llu (%.1f M/s)  p50 %u ns  p99 %u ns  p99.9 %u ns\n", static_cast<unsigned long long>(published),
+           published / elapsed_s / 1e6, percentile(publish_latencies, 0.50), percentile(publish_latencies, 0.99),
+           percentile(publish_latencies, 0.999));
+    printf("read:    %llu (%.1f M/s)  p50 %u ns  p99 %u ns  p99.9 %u ns  %.2f%% changed\n",
+           static_cast<unsigned long long>(reads), reads / elapsed_s / 1e6, percentile(read_latencies, 0.50),
+           percentile(read_latencies, 0.99), percentile(read_latencies, 0.999), reads ? 100.0 * changed / reads : 0.0);
+    printf("torn %llu  regressions %llu  unpublished %llu%s\n", static_cast<unsigned long long>(torn),
+           static_cast<unsigned long long>(regressions), static_cast<unsigned long long>(unpublished),
+           full ? "  table full" : "");
+
+    ok = ok && !full && torn == 0 && regressions == 0 && unpublished == 0 && changed > 0;
+    printf("%s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,191 @@
+/*
+    reactor_bench: throughput and latency of one epoll reactor, a sharded reactor and one thread per connection as the
+    number of DigiView units grows (reactor.hpp).
+
+        g++ -std=c++17 -O2 -pthread -I.. -I../digiview_commons reactor_bench.cpp -o reactor_bench
+        ./reactor_bench [seconds] [window] [shards]
+
+    Each unit is one stream socket pair. A unit simulator, itself a reactor on its own thread, keeps `window` frames
+    in flight per unit. Each frame carries its send time. The host side under test checks every frame, stamps it as a
+    reply and sends it back; the simulator records the round trip and sends the next frame. Reports frames per second
+    and round-trip percentiles for 1, 16, 64 and 256 units.
+*/
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../reactor.hpp"
+
+static const uint32_t UNIT_COUNTS[] = {1, 16, 64, 256};
+
+static uint64_t now_us() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static void set_nonblocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+static message request_frame(uint32_t unit_id) {
+    message msg = {};
+    msg.version      = VERSION;
+    msg.message_type = GET_PARAMETERS;
+    msg.param_type   = TRACKED_DETECTION;
+    const uint64_t t = now_us();
+    memcpy(&msg.data[0], &t, sizeof(t));
+    memcpy(&msg.data[8], &unit_id, sizeof(unit_id));
+    add_checksum_for_digiview_message(msg);
+    return msg;
+}
+
+static void make_reply(message &msg) {
+    msg.message_type = CURRENT_PARAMETERS;
+    add_checksum_for_digiview_message(msg);
+}
+
+enum HOST_MODEL { SINGLE_REACTOR, SHARDED_REACTOR, THREAD_PER_CONNECTION };
+
+struct run_result {
+    double   frames_per_s;
+    double   p50_us;
+    double   p99_us;
+    uint64_t checksum_errors;
+};
+
+static run_result run(HOST_MODEL model, uint32_t units, double seconds, uint32_t window, uint32_t shards) {
+    reactor_config config;
+    config.max_connections  = units;
+    config.tx_buffer_frames = window * 2;
+
+    std::vector<int> host_fds(units);
+    reactor simulator(config);
+    for (uint32_t u = 0; u < units; ++u) {
+        int pair[2];
+        socketpair(AF_UNIX, SOCK_STREAM, 0, pair);
+        set_nonblocking(pair[0]);
+        simulator.add_stream(pair[0], u);
+        host_fds[u] = pair[1];
+    }
+
+    std::atomic<bool>        stop{false};
+    std::atomic<uint64_t>    host_errors{0};
+    std::vector<std::thread> threads;
+    std::unique_ptr<reactor>         single;
+    std::unique_ptr<sharded_reactor> sharded;
+
+    const auto echo = [&](reactor &loop, int id, uint32_t, const message &msg) {
+        message reply = msg;
+        make_reply(reply);
+        loop.send(id, reply);
+    };
+    if (model == SINGLE_REACTOR) {
+        single.reset(new reactor(config));
+        for (uint32_t u = 0; u < units; ++u) {
+            set_nonblocking(host_fds[u]);
+            single->add_stream(host_fds[u], u);
+        }
+        threads.emplace_back([&] {
+            while (!stop.load(std::memory_order_relaxed)) {
+                single->poll(50, [&](int id, uint32_t unit, const message &msg) { echo(*single, id, unit, msg); });
+            }
+        });
+    } else if (model == SHARDED_REACTOR) {
+        sharded.reset(new sharded_reactor(shards, echo, sharded_reactor::close_handler(), config));
+        for (uint32_t u = 0; u < units; ++u) {
+            set_nonblocking(host_fds[u]);
+            sharded->add_stream(host_fds[u], u);
+        }
+    } else {
+        for (uint32_t u = 0; u < units; ++u) {
+            const int fd = host_fds[u];
+            threads.emplace_back([&, fd] {
+                timeval tv = {0, 50000};
+                setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+                message msg;
+                size_t have = 0;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    const ssize_t n = recv(fd, reinterpret_cast<uint8_t *>(&msg) + have, sizeof(msg) - have, 0);
+                    if (n <= 0) continue;
+                    have += static_cast<size_t>(n);
+                    if (have < sizeof(msg)) continue;
+                    have = 0;
+                    if (!has_valid_checksum_for_digiview_message(msg)) {
+                        host_errors.fetch_add(1, std::memory_order_relaxed);
+                        continue;
+                    }
+                    make_reply(msg);
+                    ::send(fd, &msg, sizeof(msg), MSG_NOSIGNAL);
+                }
+                close(fd);
+            });
+        }
+    }
+
+    // The simulator primes every unit with `window` requests, then sends one new request per reply.
+    for (uint32_t u = 0; u < units; ++u) {
+        for (uint32_t w = 0; w < window; ++w) simulator.send(static_cast<int>(u), request_frame(u));
+    }
+    std::vector<uint32_t> rtt_us;
+    rtt_us.reserve(1 << 20);
+    uint64_t completed = 0;
+    const uint64_t warmup_end = now_us() + 200000;
+    const uint64_t end        = warmup_end + static_cast<uint64_t>(seconds * 1e6);
+    for (uint64_t t = now_us(); t < end; t = now_us()) {
+        simulator.poll(10, [&](int id, uint32_t unit, const message &reply) {
+            uint64_t sent;
+            memcpy(&sent, &reply.data[0], sizeof(sent));
+            const uint64_t received = now_us();
+            if (received >= warmup_end) {
+                completed++;
+                rtt_us.push_back(static_cast<uint32_t>(received - sent));
+            }
+            simulator.send(id, request_frame(unit));
+        });
+    }
+
+    stop.store(true);
+    for (std::thread &t : threads) t.join();
+    sharded.reset();
+    single.reset();
+
+    run_result r = {};
+    r.frames_per_s = completed / seconds;
+    std::sort(rtt_us.begin(), rtt_us.end());
+    if (!rtt_us.empty()) {
+        r.p50_us = rtt_us[rtt_us.size() / 2];
+        r.p99_us = rtt_us[std::min(rtt_us.size() - 1, rtt_us.size() * 99 / 100)];
+    }
+    r.checksum_errors = host_errors.load();
+    for (uint32_t u = 0; u < units; ++u) r.checksum_errors += simulator.stats(static_cast<int>(u)).checksum_errors;
+    return r;
+}
+
+int main(int argc, char **argv) {
+    const double   seconds = argc > 1 ? atof(argv[1]) : 1.0;
+    const uint32_t window  = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 4;
+    const uint32_t shards  = argc > 3 ? static_cast<uint32_t>(atoi(argv[3])) : std::max(2u, std::thread::hardware_concurrency());
+
+    printf("%.1f s per run, %u frames in flight per unit, %u shards, %u hardware threads\n", seconds, window, shards,
+           std::thread::hardware_concurrency());
+    printf("%-24s %6s %14s %12s %12s\n", "host", "units", "frames/s", "rtt p50 us", "rtt p99 us");
+    static const char *NAMES[] = {"single reactor", "sharded reactor", "thread per connection"};
+    uint64_t errors = 0;
+    for (uint32_t units : UNIT_COUNTS) {
+        for (int model = SINGLE_REACTOR; model <= THREAD_PER_CONNECTION; ++model) {
+            const run_result r = run(static_cast<HOST_MODEL>(model), units, seconds, window, shards);
+            printf("%-24s %6u %14.0f %12.0f %12.0f\n", NAMES[model], units, r.frames_per_s, r.p50_us, r.p99_us);
+            errors += r.checksum_errors;
+        }
+    }
+    if (errors != 0) printf("FAILED: %llu checksum errors\n", static_cast<unsigned long long>(errors));
+    return errors == 0 ? 0 : 1;
+}
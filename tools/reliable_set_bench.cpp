@@ -0,0 +1,194 @@
+/*
+    reliable_set_bench: recovery of non-idempotent SETs at 10% loss, with today's timeout-and-resend versus the
+    selective-retransmit layer (reliable_delivery.hpp), over an emulated link (link_emulator.hpp).
+
+        g++ -std=c++17 -O2 -pthread -I.. -I../digiview_commons reliable_set_bench.cpp -o reliable_set_bench
+        ./reliable_set_bench [loss_percent] [bursts] [seed]
+
+    Every second the client sends a burst of 8 SETs (CAPTURE, CALIBRATION, AI, DETECTION). Both directions use the LTE
+    profile with the given loss. Runs on a virtual clock with 1 ms steps.
+
+        timeout    SET_PARAMETERS, each answered with ACKNOWLEDGEMENT. After 1 s without one, the client resends every
+                   SET of the burst it has no ACKNOWLEDGEMENT for. The unit applies everything it receives, so a lost
+                   ACKNOWLEDGEMENT makes it apply the SET twice.
+        reliable   SET_PARAMETERS_RELIABLE through reliable_sender, answered with RELIABLE_STATUS.
+
+    For each mode the program reports completion time (first send to confirmed outcome), frames and bytes on the wire
+    in both directions, SETs applied more than once, and SETs that never completed.
+*/
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "../link_emulator.hpp"
+#include "../reliable_delivery.hpp"
+
+static const uint32_t BURST_SIZE      = 8;
+static const uint64_t BURST_PERIOD_US = 1000000;
+static const uint64_t LEGACY_TIMEOUT_US = 1000000;
+static const uint64_t STEP_US         = 1000;
+
+struct run_result {
+    std::vector<uint64_t> completion_us;
+    uint64_t              uplink_frames;
+    uint64_t              downlink_frames;
+    uint64_t              wire_bytes;
+    uint64_t              applied_twice;
+    uint64_t              unfinished;
+};
+
+static message burst_set(uint32_t index) {
+    static const char model_name[STREAM_NAME_SIZE] = "model";
+    message msg = {};
+    switch (index % 4) {
+        case 0: pack_set_capture_parameters(msg, "stream0", index % 8 == 0, false); break;
+        case 1: pack_set_calibration_parameters(msg, 0, static_cast<calibration_command>(1)); break;
+        case 2: pack_set_ai_parameters(msg, true, model_name); break;
+        default: pack_set_detection_parameters(msg, 0, 0, 0.5f, 0.5f, 0.3f, 0.3f, 1, 1, 1, 1, 1); break;
+    }
+    // Tag each SET so the unit can count how often it was applied.
+    msg.timestamp = index;
+    return msg;
+}
+
+static run_result run(bool reliable, const link_config &profile, uint32_t bursts) {
+    link_config down_config = profile;
+    down_config.seed = profile.seed + 1;
+    link_emulator uplink(profile);
+    link_emulator downlink(down_config);
+
+    const uint32_t total = bursts * BURST_SIZE;
+    std::vector<uint32_t> applied(total, 0);
+    std::vector<uint64_t> first_sent(total, 0);
+    std::vector<bool>     done(total, false);
+    run_result r = {};
+    const auto complete = [&](uint32_t index, uint64_t now) {
+        if (done[index]) return;
+        done[index] = true;
+        r.completion_us.push_back(now - first_sent[index]);
+    };
+
+    reliable_sender   sender;
+    reliable_receiver receiver;
+    std::vector<uint32_t> pending;          // reliable: SETs waiting for window space.
+    std::vector<uint64_t> legacy_sent(total, UINT64_MAX);   // timeout: last send time.
+
+    const auto transmit = [&](const message &msg, uint64_t now) {
+        uplink.send(&msg, sizeof(msg), now);
+        r.uplink_frames++;
+    };
+
+    const uint64_t end_us = bursts * BURST_PERIOD_US + 30 * 1000000ULL;
+    for (uint64_t now = 0; now < end_us; now += STEP_US) {
+        // Unit side.
+        uplink.receive(now, [&](const uint8_t *data, size_t, uint64_t) {
+            message msg;
+            memcpy(&msg, data, sizeof(msg));
+            const auto apply = [&](message &set) {
+                applied[set.timestamp]++;
+                return static_cast<uint8_t>(ACKNOWLEDGEMENT);
+            };
+            message reply;
+            if (reliable) {
+                if (!receiver.on_message(msg, apply)) return;
+                receiver.pack_status(reply);
+            } else {
+                apply(msg);
+                reply = msg;
+                reply.message_type = ACKNOWLEDGEMENT;
+                add_checksum_for_digiview_message(reply);
+            }
+            downlink.send(&reply, sizeof(reply), now);
+            r.downlink_frames++;
+        });
+
+        // Client side.
+        downlink.receive(now, [&](const uint8_t *data, size_t, uint64_t) {
+            message msg;
+            memcpy(&msg, data, sizeof(msg));
+            if (reliable) {
+                sender.on_message(msg, now, [&](uint16_t, uint8_t outcome, const message &frame, uint64_t) {
+                    if (outcome != EMPTY) complete(static_cast<uint32_t>(frame.timestamp), now);
+                });
+            } else if (msg.message_type == ACKNOWLEDGEMENT) {
+                complete(static_cast<uint32_t>(msg.timestamp), now);
+            }
+        });
+
+        if (now % BURST_PERIOD_US == 0 && now / BURST_PERIOD_US < bursts) {
+            const uint32_t first = static_cast<uint32_t>(now / BURST_PERIOD_US) * BURST_SIZE;
+            for (uint32_t i = first; i < first + BURST_SIZE; ++i) {
+                first_sent[i] = now;
+                if (reliable) {
+                    pending.push_back(i);
+                } else {
+                    message set = burst_set(i);
+                    add_checksum_for_digiview_message(set);
+                    transmit(set, now);
+                    legacy_sent[i] = now;
+                }
+            }
+        }
+
+        if (reliable) {
+            while (!pending.empty()) {
+                message set = burst_set(pending.front());
+                if (sender.send(set, now) < 0) break;
+                transmit(set, now);
+                pending.erase(pending.begin());
+            }
+            sender.poll(now, [&](const message &frame) { transmit(frame, now); },
+                        [&](uint16_t, uint8_t, const message &, uint64_t) {});
+        } else {
+            // Resend every unconfirmed SET of a burst once its timeout has passed.
+            for (uint32_t i = 0; i < total; ++i) {
+                if (done[i] || legacy_sent[i] == UINT64_MAX) continue;
+                if (now - legacy_sent[i] >= LEGACY_TIMEOUT_US) {
+                    message set = burst_set(i);
+                    add_checksum_for_digiview_message(set);
+                    transmit(set, now);
+                    legacy_sent[i] = now;
+                }
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < total; ++i) {
+        if (applied[i] > 1) r.applied_twice++;
+        if (!done[i]) r.unfinished++;
+    }
+    r.wire_bytes = uplink.stats().wire_bytes + downlink.stats().wire_bytes;
+    return r;
+}
+
+int main(int argc, char **argv) {
+    const double   loss   = argc > 1 ? atof(argv[1]) / 100.0 : 0.10;
+    const uint32_t bursts = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 120;
+    const uint64_t seed   = argc > 3 ? strtoull(argv[3], nullptr, 10) : 1;
+
+    link_config profile = link_profile_lte_uplink(seed);
+    profile.loss       = loss;
+    profile.loss_burst = 1.0;
+
+    printf("%u bursts of %u SETs, %.0f%% loss each way, lte latency\n", bursts, BURST_SIZE, loss * 100);
+    printf("%-10s %10s %10s %10s %10s %10s %10s %12s %8s %10s\n", "mode", "p50 ms", "p99 ms", "max ms", "up frames",
+           "down frames", "kbytes", "applied 2x", "failed", "frames/SET");
+    bool ok = true;
+    for (int reliable = 0; reliable <= 1; ++reliable) {
+        run_result r = run(reliable != 0, profile, bursts);
+        std::sort(r.completion_us.begin(), r.completion_us.end());
+        const auto pct = [&](uint32_t p) {
+            return r.completion_us.empty() ? 0.0 : r.completion_us[std::min(r.completion_us.size() - 1, r.completion_us.size() * p / 100)] / 1e3;
+        };
+        printf("%-10s %10.1f %10.1f %10.1f %10llu %10llu %10.1f %12llu %8llu %10.2f\n", reliable ? "reliable" : "timeout",
+               pct(50), pct(99), r.completion_us.empty() ? 0.0 : r.completion_us.back() / 1e3,
+               static_cast<unsigned long long>(r.uplink_frames), static_cast<unsigned long long>(r.downlink_frames),
+               r.wire_bytes / 1e3, static_cast<unsigned long long>(r.applied_twice),
+               static_cast<unsigned long long>(r.unfinished),
+               static_cast<double>(r.uplink_frames + r.downlink_frames) / (bursts * BURST_SIZE));
+        if (reliable && (r.applied_twice != 0 || r.unfinished != 0)) ok = false;
+    }
+    printf("%s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
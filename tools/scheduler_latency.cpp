@@ -0,0 +1,105 @@
+/*
+    scheduler_latency: control-message latency under telemetry saturation for the outbound scheduler
+    (outbound_scheduler.hpp).
+
+        g++ -std=c++17 -O2 -I.. -I../digiview_commons scheduler_latency.cpp -o scheduler_latency
+        ./scheduler_latency [link_bps] [telemetry_hz] [control_hz]
+
+    A low-rate link (default 115200 bit/s, 28 bytes of framing per message) is ticked every 10 ms. TRACKED_DETECTION
+    replies are offered faster than the link can carry them, and CAM_TARGETING SETs at control_hz. The same traffic
+    runs through a single FIFO class, strict priority and weighted scheduling on a virtual clock. The program prints
+    control-message queueing latency and per-class delivery for each.
+*/
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "../outbound_scheduler.hpp"
+
+static const uint64_t TICK_US   = 10000;
+static const uint64_t RUN_US    = 10000000;
+static const uint32_t OVERHEAD  = 28;
+
+struct run_result {
+    std::vector<uint64_t> control_latency_us;
+    outbound_class_stats  telemetry;
+};
+
+static run_result simulate(outbound_scheduler &scheduler, uint32_t telemetry_hz, uint32_t control_hz) {
+    run_result r;
+    message telemetry = {};
+    telemetry.message_type = CURRENT_PARAMETERS;
+    pack_tracked_detection_parameters(telemetry, 1, 0, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 7, 0);
+    message control = {};
+    const View::TargetingMode directional = static_cast<View::TargetingMode>(0);
+    pack_set_cam_targeting_parameters(control, "stream0", 0, directional, false, 10, 5, 0, 0, 0, 0, 0, 0, 0);
+
+    const uint64_t telemetry_interval = 1000000 / telemetry_hz;
+    const uint64_t control_interval   = 1000000 / control_hz;
+    uint64_t next_telemetry = 0;
+    uint64_t next_control   = control_interval / 3;
+    for (uint64_t now = 0; now < RUN_US; now += TICK_US) {
+        // Arrivals during the last tick, stamped with their own arrival time.
+        while (next_telemetry < now) {
+            telemetry.timestamp = next_telemetry;
+            scheduler.enqueue(telemetry);
+            next_telemetry += telemetry_interval;
+        }
+        while (next_control < now) {
+            control.timestamp = next_control;
+            scheduler.enqueue(control);
+            next_control += control_interval;
+        }
+        scheduler.run_tick([&](const message &msg, TRAFFIC_CLASS) {
+            if (msg.param_type == CAM_TARGETING) r.control_latency_us.push_back(now - msg.timestamp);
+            return true;
+        });
+    }
+    r.telemetry = scheduler.stats(TRAFFIC_TELEMETRY);
+    return r;
+}
+
+static void report(const char *name, run_result &r, uint32_t control_offered) {
+    std::vector<uint64_t> &lat = r.control_latency_us;
+    std::sort(lat.begin(), lat.end());
+    const auto pct = [&](uint32_t p) { return lat.empty() ? 0.0 : lat[std::min(lat.size() - 1, lat.size() * p / 100)] / 1e3; };
+    printf("%-9s control sent %4zu/%u  latency p50 %8.1f ms  p99 %8.1f ms  max %8.1f ms   "
+           "telemetry sent %6llu dropped %6llu\n",
+           name, lat.size(), control_offered, pct(50), pct(99), lat.empty() ? 0.0 : lat.back() / 1e3,
+           static_cast<unsigned long long>(r.telemetry.sent), static_cast<unsigned long long>(r.telemetry.dropped));
+}
+
+int main(int argc, char **argv) {
+    const uint32_t link_bps     = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 115200;
+    const uint32_t telemetry_hz = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 400;
+    const uint32_t control_hz   = argc > 3 ? static_cast<uint32_t>(atoi(argv[3])) : 20;
+    const uint32_t control_offered = static_cast<uint32_t>(RUN_US / (1000000 / control_hz));
+
+    outbound_scheduler_config config;
+    config.byte_budget_per_tick = static_cast<uint32_t>(static_cast<uint64_t>(link_bps) / 8 * TICK_US / 1000000);
+    config.frame_overhead       = OVERHEAD;
+    printf("link %u bit/s: %u bytes per %llu ms tick, %u bytes per frame\n", link_bps, config.byte_budget_per_tick,
+           static_cast<unsigned long long>(TICK_US / 1000), static_cast<uint32_t>(sizeof(message)) + OVERHEAD);
+
+    {
+        // FIFO baseline: control shares the telemetry queue, so its counts include the control frames.
+        outbound_scheduler fifo(config);
+        fifo.set_class(SET_PARAMETERS, CAM_TARGETING, TRAFFIC_TELEMETRY);
+        run_result r = simulate(fifo, telemetry_hz, control_hz);
+        report("fifo", r, control_offered);
+    }
+    {
+        outbound_scheduler strict(config);
+        run_result r = simulate(strict, telemetry_hz, control_hz);
+        report("strict", r, control_offered);
+    }
+    {
+        outbound_scheduler_config weighted_config = config;
+        weighted_config.policy = SCHEDULE_WEIGHTED;
+        outbound_scheduler weighted(weighted_config);
+        run_result r = simulate(weighted, telemetry_hz, control_hz);
+        report("weighted", r, control_offered);
+    }
+    return 0;
+}
@@ -0,0 +1,121 @@
+/*
+    seal_bench: cost of packing and checksumming a frame with the fused pack_and_seal_* functions versus pack_*
+    followed by add_checksum_for_digiview_message.
+
+        g++ -std=c++17 -O2 -I.. -I../digiview_commons seal_bench.cpp -o seal_bench
+        ./seal_bench [frames]
+
+    For each parameter group below, `frames` frames are packed both ways with values that change every frame. The
+    program prints nanoseconds per frame for each path and checks that both produce byte-identical frames.
+*/
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "../msg_defs.hpp"
+
+static double now_s() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static message header(uint32_t i) {
+    message msg = {};
+    msg.timestamp    = 1000000ULL + i;
+    msg.version      = VERSION;
+    msg.message_type = CURRENT_PARAMETERS;
+    return msg;
+}
+
+struct group {
+    const char *name;
+    void (*two_pass)(message &, uint32_t);
+    void (*sealed)(message &, uint32_t);
+};
+
+static const group GROUPS[] = {
+    {"SYSTEM_STATUS",
+     [](message &m, uint32_t i) {
+         pack_system_status_parameters(m, APP_OK, 0, 40.0f + (i & 15));
+         add_checksum_for_digiview_message(m);
+     },
+     [](message &m, uint32_t i) { pack_and_seal_system_status_parameters(m, APP_OK, 0, 40.0f + (i & 15)); }},
+    {"TRACKED_DETECTION",
+     [](message &m, uint32_t i) {
+         pack_tracked_detection_parameters(m, 8, i & 7, 200, 1, 0.01f * i, 5.0f, 0, 1.0f, 2.0f, 52.0f, 5.0f, 100.0f,
+                                           800.0f, 0.1f, 0.2f, static_cast<uint16_t>(i), 1000000ULL + i);
+         add_checksum_for_digiview_message(m);
+     },
+     [](message &m, uint32_t i) {
+         pack_and_seal_tracked_detection_parameters(m, 8, i & 7, 200, 1, 0.01f * i, 5.0f, 0, 1.0f, 2.0f, 52.0f, 5.0f,
+                                                    100.0f, 800.0f, 0.1f, 0.2f, static_cast<uint16_t>(i), 1000000ULL + i);
+     }},
+    {"CAM_TARGETING",
+     [](message &m, uint32_t i) {
+         pack_cam_targeting_parameters(m, "stream0", 0, static_cast<View::TargetingMode>(0), false, 0.01f * i, -5.0f, 0.0f,
+                                       0, 0.1f, -0.1f, 52.0f, 5.0f, 100.0f);
+         add_checksum_for_digiview_message(m);
+     },
+     [](message &m, uint32_t i) {
+         pack_and_seal_cam_targeting_parameters(m, "stream0", 0, static_cast<View::TargetingMode>(0), false, 0.01f * i,
+                                                -5.0f, 0.0f, 0, 0.1f, -0.1f, 52.0f, 5.0f, 100.0f);
+     }},
+    {"NAVIGATION",
+     [](message &m, uint32_t i) {
+         pack_navigation_parameters(m, 100.0f + 0.001f * i, 52.0f, 5.0f, 0, 0, 0, 1.0f, 2.0f, 3.0f);
+         add_checksum_for_digiview_message(m);
+     },
+     [](message &m, uint32_t i) {
+         pack_and_seal_navigation_parameters(m, 100.0f + 0.001f * i, 52.0f, 5.0f, 0, 0, 0, 1.0f, 2.0f, 3.0f);
+     }},
+    {"SET CAM_TARGETING",
+     [](message &m, uint32_t i) {
+         pack_set_cam_targeting_parameters(m, "stream0", 0, static_cast<View::TargetingMode>(0), true, 0.01f * i, 0.0f,
+                                           0.0f, 0, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+         add_checksum_for_digiview_message(m);
+     },
+     [](message &m, uint32_t i) {
+         pack_and_seal_set_cam_targeting_parameters(m, "stream0", 0, static_cast<View::TargetingMode>(0), true, 0.01f * i,
+                                                    0.0f, 0.0f, 0, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+     }},
+};
+
+int main(int argc, char **argv) {
+    const uint32_t frames = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 1000000;
+
+    printf("%u frames per group\n", frames);
+    printf("%-20s %14s %14s %10s\n", "group", "two-pass ns", "sealed ns", "speedup");
+    bool ok = true;
+    uint32_t sink = 0;
+    for (const group &g : GROUPS) {
+        double start = now_s();
+        for (uint32_t i = 0; i < frames; ++i) {
+            message msg = header(i);
+            g.two_pass(msg, i);
+            sink += msg.checksum;
+        }
+        const double two_pass_ns = (now_s() - start) * 1e9 / frames;
+        start = now_s();
+        for (uint32_t i = 0; i < frames; ++i) {
+            message msg = header(i);
+            g.sealed(msg, i);
+            sink += msg.checksum;
+        }
+        const double sealed_ns = (now_s() - start) * 1e9 / frames;
+        printf("%-20s %14.1f %14.1f %9.1fx\n", g.name, two_pass_ns, sealed_ns, two_pass_ns / sealed_ns);
+
+        for (uint32_t i = 0; i < 1000; ++i) {
+            message a = header(i), b = header(i);
+            g.two_pass(a, i);
+            g.sealed(b, i);
+            if (memcmp(&a, &b, sizeof(message)) != 0) {
+                printf("FAILED: %s frame %u differs (checksum %02x vs %02x)\n", g.name, i, a.checksum, b.checksum);
+                ok = false;
+                break;
+            }
+        }
+    }
+    printf("(checksum sum %u)\n", sink);
+    printf("%s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,207 @@
+/*
+    shm_ring_bench: compares the shared-memory broadcast ring (shm_ring.hpp) with loopback UDP, the way same-host
+    consumers receive DigiView traffic today (one socket and one kernel copy per consumer).
+
+        g++ -std=c++17 -O2 -I.. -I../digiview_commons shm_ring_bench.cpp -o shm_ring_bench -lrt
+        ./shm_ring_bench [readers] [frames] [interval_us] [spin_us]
+
+    The producer stamps each frame with CLOCK_MONOTONIC and fans it out to every reader process. interval_us = 0
+    publishes flat out, which measures throughput. A positive interval paces publishing, which measures latency.
+    Each reader reports frames received, frames lost and one-way latency percentiles.
+*/
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../shm_ring.hpp"
+
+static const char *RING_NAME     = "bench";
+static const uint16_t UDP_PORT   = 47300;
+
+static uint64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+static void pace(uint64_t start_ns, uint64_t i, uint32_t interval_us) {
+    if (interval_us == 0) return;
+    const uint64_t due = start_ns + i * interval_us * 1000ULL;
+    while (now_ns() < due) {}
+}
+
+struct reader_result {
+    uint64_t received;
+    uint64_t lost;
+    uint64_t p50_ns;
+    uint64_t p99_ns;
+    uint64_t max_ns;
+};
+
+static reader_result summarize(std::vector<uint64_t> &latencies, uint64_t lost) {
+    reader_result r = {latencies.size(), lost, 0, 0, 0};
+    if (latencies.empty()) return r;
+    std::sort(latencies.begin(), latencies.end());
+    r.p50_ns = latencies[latencies.size() / 2];
+    r.p99_ns = latencies[latencies.size() * 99 / 100];
+    r.max_ns = latencies.back();
+    return r;
+}
+
+// The last frame has message_type QUIT so readers know when to stop.
+static reader_result run_shm_reader(uint64_t frames, uint32_t spin_us) {
+    shm_ring_reader reader;
+    while (!reader.open(RING_NAME, true)) usleep(1000);
+    std::vector<uint64_t> latencies;
+    latencies.reserve(frames);
+    for (;;) {
+        reader.wait(-1, spin_us);
+        const message *frame = reader.peek();
+        if (frame == nullptr) continue;
+        const uint64_t sent = frame->timestamp;
+        const bool quit = frame->message_type == QUIT;
+        if (!reader.release()) continue;
+        if (quit) break;
+        latencies.push_back(now_ns() - sent);
+    }
+    return summarize(latencies, reader.lost());
+}
+
+static reader_result run_udp_reader(int index, uint64_t frames) {
+    const int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    int buffer = 8 << 20;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+    sockaddr_in addr = {};
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(static_cast<uint16_t>(UDP_PORT + index));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+    std::vector<uint64_t> latencies;
+    latencies.reserve(frames);
+    message frame;
+    for (;;) {
+        if (recv(fd, &frame, sizeof(frame), 0) != static_cast<ssize_t>(sizeof(frame))) continue;
+        if (frame.message_type == QUIT) break;
+        latencies.push_back(now_ns() - frame.timestamp);
+    }
+    close(fd);
+    return summarize(latencies, frames - latencies.size());
+}
+
+template <typename Reader>
+static void spawn_readers(int readers, Reader &&reader, std::vector<int> &pipes, std::vector<pid_t> &pids) {
+    for (int i = 0; i < readers; ++i) {
+        int fds[2];
+        if (pipe(fds) != 0) exit(1);
+        const pid_t pid = fork();
+        if (pid == 0) {
+            close(fds[0]);
+            const reader_result result = reader(i);
+            if (write(fds[1], &result, sizeof(result)) != sizeof(result)) _exit(1);
+            _exit(0);
+        }
+        close(fds[1]);
+        pipes.push_back(fds[0]);
+        pids.push_back(pid);
+    }
+}
+
+static std::vector<reader_result> collect(std::vector<int> &pipes, std::vector<pid_t> &pids) {
+    std::vector<reader_result> results(pipes.size());
+    for (size_t i = 0; i < pipes.size(); ++i) {
+        if (read(pipes[i], &results[i], sizeof(reader_result)) != sizeof(reader_result)) results[i] = {};
+        close(pipes[i]);
+        waitpid(pids[i], nullptr, 0);
+    }
+    return results;
+}
+
+static void report(const char *transport, double seconds, uint64_t frames, const std::vector<reader_result> &results) {
+    printf("%-4s %8.2f Mframes/s published\n", transport, frames / seconds / 1e6);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const reader_result &r = results[i];
+        printf("     reader %zu: received %llu lost %llu  p50 %.1f us  p99 %.1f us  max %.1f us\n", i,
+               static_cast<unsigned long long>(r.received), static_cast<unsigned long long>(r.lost),
+               r.p50_ns / 1e3, r.p99_ns / 1e3, r.max_ns / 1e3);
+    }
+}
+
+int main(int argc, char **argv) {
+    const int      readers     = argc > 1 ? atoi(argv[1]) : 4;
+    const uint64_t frames      = argc > 2 ? strtoull(argv[2], nullptr, 10) : 200000;
+    const uint32_t interval_us = argc > 3 ? static_cast<uint32_t>(atoi(argv[3])) : 10;
+    const uint32_t spin_us     = argc > 4 ? static_cast<uint32_t>(atoi(argv[4])) : 0;
+
+    message frame = {};
+    frame.param_type   = SYSTEM_STATUS;
+    frame.message_type = CURRENT_PARAMETERS;
+
+    {
+        shm_ring_producer producer;
+        if (!producer.create(RING_NAME, 65536, true)) {
+            fprintf(stderr, "cannot create shared-memory ring\n");
+            return 1;
+        }
+        std::vector<int> pipes;
+        std::vector<pid_t> pids;
+        spawn_readers(readers, [&](int) { return run_shm_reader(frames, spin_us); }, pipes, pids);
+        usleep(200000);
+
+        const uint64_t start = now_ns();
+        for (uint64_t i = 0; i < frames; ++i) {
+            pace(start, i, interval_us);
+            frame.timestamp = now_ns();
+            producer.publish(frame);
+        }
+        const double seconds = (now_ns() - start) / 1e9;
+        message quit = frame;
+        quit.message_type = QUIT;
+        producer.publish(quit);
+        report("shm", seconds, frames, collect(pipes, pids));
+        shm_ring_producer::unlink(RING_NAME);
+    }
+
+    {
+        std::vector<int> pipes;
+        std::vector<pid_t> pids;
+        spawn_readers(readers, [&](int i) { return run_udp_reader(i, frames); }, pipes, pids);
+        usleep(200000);
+
+        const int fd = socket(AF_INET, SOCK_DGRAM, 0);
+        std::vector<sockaddr_in> targets(readers);
+        for (int i = 0; i < readers; ++i) {
+            targets[i] = {};
+            targets[i].sin_family      = AF_INET;
+            targets[i].sin_port        = htons(static_cast<uint16_t>(UDP_PORT + i));
+            targets[i].sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        }
+        const uint64_t start = now_ns();
+        for (uint64_t i = 0; i < frames; ++i) {
+            pace(start, i, interval_us);
+            frame.timestamp = now_ns();
+            for (const sockaddr_in &target : targets) {
+                sendto(fd, &frame, sizeof(frame), 0, reinterpret_cast<const sockaddr *>(&target), sizeof(target));
+            }
+        }
+        const double seconds = (now_ns() - start) / 1e9;
+        message quit = frame;
+        quit.message_type = QUIT;
+        for (int repeat = 0; repeat < 10; ++repeat) {
+            for (const sockaddr_in &target : targets) {
+                sendto(fd, &quit, sizeof(quit), 0, reinterpret_cast<const sockaddr *>(&target), sizeof(target));
+            }
+            usleep(10000);
+        }
+        close(fd);
+        report("udp", seconds, frames, collect(pipes, pids));
+    }
+    return 0;
+}
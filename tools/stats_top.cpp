@@ -0,0 +1,88 @@
+/*
+    stats_top: top-like viewer for a DigiView protocol statistics page (see protocol_stats.hpp).
+
+        g++ -std=c++17 -O2 -I.. -I../digiview_commons stats_top.cpp -o stats_top -lrt
+        ./stats_top <name> [interval_ms]
+
+    Every interval it prints one row per direction x MESSAGE_TYPE x PARAM_TYPE cell that has seen traffic: totals
+    and rates since the previous refresh.
+*/
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "../protocol_stats.hpp"
+
+static const char *message_type_name(uint32_t slot) {
+    static const char *names[PROTOCOL_STATS_MESSAGE_SLOTS] = {
+        "EMPTY", "GET", "SET", "CURRENT", "ACK", "CHECKSUM_ERROR",
+        "DATA_ERROR", "FORBIDDEN", "UNKNOWN", "DEBUG", "CREDIT", "SET_NO_ACK",
+        "SET_RELIABLE", "RELIABLE_STATUS", "QUIT", "OTHER",
+    };
+    return slot < PROTOCOL_STATS_MESSAGE_SLOTS ? names[slot] : "?";
+}
+
+struct cell_snapshot {
+    uint64_t frames;
+    uint64_t bytes;
+    uint64_t checksum_errors;
+    uint64_t validation_failures;
+};
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <name> [interval_ms]\n", argv[0]);
+        return 2;
+    }
+    const char *name = argv[1];
+    const long interval_ms = argc > 2 ? strtol(argv[2], nullptr, 10) : 1000;
+
+    protocol_stats stats;
+    if (!stats.open_readonly(name)) {
+        fprintf(stderr, "stats page '%s' not found or has an incompatible layout\n", name);
+        return 1;
+    }
+
+    const size_t cells = PROTOCOL_STATS_DIRECTIONS * PROTOCOL_STATS_MESSAGE_SLOTS * PROTOCOL_STATS_PARAM_SLOTS;
+    std::vector<cell_snapshot> previous(cells), current(cells);
+    auto last = std::chrono::steady_clock::now();
+
+    for (;;) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+        const auto now = std::chrono::steady_clock::now();
+        const double seconds = std::chrono::duration<double>(now - last).count();
+        last = now;
+
+        printf("\033[H\033[2J");
+        printf("digiview stats '%s'  refresh %ld ms\n\n", stats.header().name, interval_ms);
+        printf("%-4s %-15s %5s %14s %12s %14s %12s %10s %10s\n",
+               "dir", "message_type", "param", "frames", "frames/s", "bytes", "bytes/s", "crc_err", "invalid");
+
+        size_t i = 0;
+        for (uint32_t d = 0; d < PROTOCOL_STATS_DIRECTIONS; ++d) {
+            for (uint32_t m = 0; m < PROTOCOL_STATS_MESSAGE_SLOTS; ++m) {
+                for (uint32_t p = 0; p < PROTOCOL_STATS_PARAM_SLOTS; ++p, ++i) {
+                    const protocol_stats_cell &c = stats.cell(static_cast<STATS_DIRECTION>(d), m, p);
+                    cell_snapshot &s = current[i];
+                    s.frames              = c.frames.load(std::memory_order_relaxed);
+                    s.bytes               = c.bytes.load(std::memory_order_relaxed);
+                    s.checksum_errors     = c.checksum_errors.load(std::memory_order_relaxed);
+                    s.validation_failures = c.validation_failures.load(std::memory_order_relaxed);
+                    if (s.frames == 0 && s.checksum_errors == 0 && s.validation_failures == 0) continue;
+
+                    const cell_snapshot &prev = previous[i];
+                    printf("%-4s %-15s %5u %14llu %12.0f %14llu %12.0f %10llu %10llu\n",
+                           d == STATS_RECEIVED ? "rx" : "tx", message_type_name(m), p,
+                           static_cast<unsigned long long>(s.frames), (s.frames - prev.frames) / seconds,
+                           static_cast<unsigned long long>(s.bytes), (s.bytes - prev.bytes) / seconds,
+                           static_cast<unsigned long long>(s.checksum_errors),
+                           static_cast<unsigned long long>(s.validation_failures));
+                }
+            }
+        }
+        fflush(stdout);
+        previous.swap(current);
+    }
+}
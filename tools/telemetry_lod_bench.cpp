@@ -0,0 +1,130 @@
+/*
+    telemetry_lod_bench: ingest and plot-query cost of the min/max/mean pyramid (telemetry_lod.hpp) against scanning
+    raw samples.
+
+        g++ -std=c++17 -O2 -pthread -I.. -I../digiview_commons telemetry_lod_bench.cpp -o telemetry_lod_bench
+        ./telemetry_lod_bench [samples] [buckets]
+
+    Feeds `samples` NAVIGATION frames at 1 kHz through telemetry_lod::observe() and keeps the raw altitude samples
+    in a vector for comparison. It then asks for `buckets` min/max/mean buckets over the whole mission, the last hour,
+    last minute and last second, once from the pyramid and once by scanning the raw samples. For the whole mission
+    it checks that both give the same sample count, minimum, maximum and mean.
+*/
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "../telemetry_lod.hpp"
+
+static const uint64_t SAMPLE_PERIOD_US = 1000;
+
+static double now_s() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Reference: n buckets over [t0, t1) computed from raw samples.
+static void raw_query(const std::vector<uint64_t> &t, const std::vector<float> &v, uint64_t t0, uint64_t t1, uint32_t n,
+                      lod_bucket *out) {
+    for (uint32_t i = 0; i < n; ++i) out[i] = {FLT_MAX, -FLT_MAX, 0.0, 0};
+    const uint64_t slice = (t1 - t0 + n - 1) / n;
+    for (size_t k = std::lower_bound(t.begin(), t.end(), t0) - t.begin(); k < t.size() && t[k] < t1; ++k) {
+        lod_bucket &o = out[std::min<uint64_t>(n - 1, (t[k] - t0) / slice)];
+        o.min = std::min(o.min, v[k]);
+        o.max = std::max(o.max, v[k]);
+        o.sum += v[k];
+        o.count++;
+    }
+}
+
+static lod_bucket merge(const lod_bucket *b, uint32_t n) {
+    lod_bucket all = {FLT_MAX, -FLT_MAX, 0.0, 0};
+    for (uint32_t i = 0; i < n; ++i) {
+        if (b[i].count == 0) continue;
+        all.min = std::min(all.min, b[i].min);
+        all.max = std::max(all.max, b[i].max);
+        all.sum += b[i].sum;
+        all.count += b[i].count;
+    }
+    return all;
+}
+
+int main(int argc, char **argv) {
+    const uint64_t samples = argc > 1 ? strtoull(argv[1], nullptr, 10) : 10000000;
+    const uint32_t buckets = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 1000;
+
+    telemetry_lod lod;
+    std::vector<uint64_t> raw_t(samples);
+    std::vector<float>    raw_v(samples);
+
+    // Altitude: slow climb and descent, a fast oscillation and noise.
+    uint32_t noise = 12345;
+    message frame = {};
+    frame.version      = VERSION;
+    frame.message_type = CURRENT_PARAMETERS;
+    double ingest_s = 0;
+    for (uint64_t i = 0; i < samples; ++i) {
+        const uint64_t t = i * SAMPLE_PERIOD_US;
+        noise = noise * 1664525u + 1013904223u;
+        const float altitude = static_cast<float>(100.0 + 80.0 * std::sin(i * 1e-6) + 3.0 * std::sin(i * 0.01) +
+                                                  ((noise >> 8) & 0xFF) / 256.0);
+        raw_t[i] = t;
+        pack_navigation_parameters(frame, altitude, 0, 0, 0, 0, 0, 1.0f, 2.0f, 3.0f);
+        // pack_navigation_parameters stores altitude as-is, so the raw copy is exactly what the frame carries.
+        navigation_parameters check;
+        unpack_navigation_parameters(frame, check);
+        raw_v[i] = check.altitude;
+        const double start = now_s();
+        lod.observe(frame, t);
+        ingest_s += now_s() - start;
+    }
+    const lod_series &altitude = lod.series(SERIES_ALTITUDE);
+    const uint64_t end_us = samples * SAMPLE_PERIOD_US;
+
+    printf("%llu samples at 1 kHz (%.1f h), %u buckets per query\n", static_cast<unsigned long long>(samples),
+           end_us / 3.6e9, buckets);
+    printf("ingest through observe(): %.1f ns per NAVIGATION frame (4 series)\n", ingest_s * 1e9 / samples);
+    printf("memory: pyramid %.2f MB for %d series, raw samples %.1f MB for one series\n", lod.memory_bytes() / 1e6,
+           TELEMETRY_SERIES_COUNT, samples * (sizeof(uint64_t) + sizeof(float)) / 1e6);
+    printf("%-14s %8s %12s %12s %10s\n", "window", "level", "pyramid us", "raw us", "speedup");
+
+    struct window {
+        const char *name;
+        uint64_t    span_us;
+    };
+    const window windows[] = {
+        {"whole mission", end_us},
+        {"last hour", 3600ULL * 1000000},
+        {"last minute", 60ULL * 1000000},
+        {"last second", 1000000},
+    };
+    std::vector<lod_bucket> fast(buckets), slow(buckets);
+    bool ok = true;
+    for (const window &w : windows) {
+        const uint64_t t0 = w.span_us >= end_us ? 0 : end_us - w.span_us;
+        const uint32_t reps = 200;
+        uint32_t level = 0;
+        double start = now_s();
+        for (uint32_t r = 0; r < reps; ++r) level = altitude.query(t0, end_us, buckets, fast.data());
+        const double pyramid_us = (now_s() - start) * 1e6 / reps;
+        const uint32_t raw_reps = w.span_us > 600ULL * 1000000 ? 3 : 50;
+        start = now_s();
+        for (uint32_t r = 0; r < raw_reps; ++r) raw_query(raw_t, raw_v, t0, end_us, buckets, slow.data());
+        const double raw_us = (now_s() - start) * 1e6 / raw_reps;
+        printf("%-14s %8u %12.1f %12.1f %9.0fx\n", w.name, level, pyramid_us, raw_us, raw_us / pyramid_us);
+
+        if (t0 == 0) {
+            const lod_bucket a = merge(fast.data(), buckets);
+            const lod_bucket b = merge(slow.data(), buckets);
+            if (a.count != b.count || a.min != b.min || a.max != b.max || std::fabs(a.mean() - b.mean()) > 1e-3f) {
+                printf("FAILED: pyramid count %u min %f max %f mean %f, raw count %u min %f max %f mean %f\n", a.count,
+                       a.min, a.max, a.mean(), b.count, b.min, b.max, b.mean());
+                ok = false;
+            }
+        }
+    }
+    printf("%s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
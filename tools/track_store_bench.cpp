@@ -0,0 +1,130 @@
+/*
+    track_store_bench: the track history store (track_store.hpp) under a steady scene of tracks updated at the
+    TRACKED_DETECTION publish rate.
+
+        g++ -std=c++17 -O2 -I.. -I../digiview_commons track_store_bench.cpp -o track_store_bench
+        ./track_store_bench [tracks] [seconds] [history] [rate_hz]
+
+    Simulates `seconds` of publishing (default 1000 tracks for 60 s at 30 Hz, 64 samples of history) as fast as
+    possible. Every frame inserts one sample per live track, queries the newest 8 samples and the last second of every
+    track, and evicts tracks older than 2 s. Each second 2% of the tracks end and new track ids take their place.
+    The program prints the cost of each operation and the share of the frame period it would use. It fails if
+    ended tracks are not evicted, a window query returns the wrong number of samples, or an age limit of UINT64_MAX
+    or a sample stamped after now evicts anything.
+*/
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "../track_store.hpp"
+
+static const uint64_t MAX_AGE_US = 2000000;
+
+static uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct live_track {
+    uint16_t track_id;
+    uint64_t first_us;
+};
+
+int main(int argc, char **argv) {
+    const uint32_t tracks  = argc > 1 ? std::max(1, atoi(argv[1])) : 1000;
+    const double   seconds = argc > 2 ? atof(argv[2]) : 60.0;
+    const uint32_t history = argc > 3 ? std::max(1, atoi(argv[3])) : 64;
+    const uint32_t rate_hz = argc > 4 ? std::max(1, atoi(argv[4])) : 30;
+
+    const uint64_t period_us = 1000000ULL / rate_hz;
+    const uint64_t frames    = static_cast<uint64_t>(seconds * rate_hz);
+    const uint32_t churn     = std::max<uint32_t>(1, tracks / 50);
+
+    // Ended tracks stay in the store until evicted, so leave room for two seconds of churn.
+    track_store store(tracks + churn * 4, history);
+    std::vector<live_track> live(tracks);
+    uint16_t next_id = 1;
+    for (live_track &track : live) track = live_track{next_id++, 0};
+
+    tracked_detection_parameters det = {};
+    det.score = 200;
+    det.type  = 1;
+    std::vector<track_sample> out(std::max<uint32_t>(store.history(), 64));
+    uint64_t insert_ns = 0, latest_ns = 0, window_ns = 0, evict_ns = 0;
+    uint64_t inserts = 0, queries = 0, evicted = 0, expected_evictions = 0, window_errors = 0, failed_inserts = 0;
+
+    for (uint64_t frame = 0; frame < frames; ++frame) {
+        const uint64_t now_us = frame * period_us;
+        if (frame > 0 && frame % rate_hz == 0) {
+            for (uint32_t k = 0; k < churn; ++k) {
+                live_track &track = live[(frame / rate_hz * churn + k) % tracks];
+                track = live_track{next_id, now_us};
+                next_id = next_id == UINT16_MAX ? 1 : next_id + 1;
+            }
+            expected_evictions += churn;
+        }
+
+        uint64_t t0 = now_ns();
+        for (const live_track &track : live) {
+            det.track_id             = track.track_id;
+            det.publish_timestamp_us = now_us;
+            det.yaw_global           = 0.01f * static_cast<float>(frame + track.track_id);
+            det.latitude             = 52.0f + 1e-5f * static_cast<float>(frame);
+            failed_inserts += store.insert(det) ? 0 : 1;
+        }
+        uint64_t t1 = now_ns();
+        insert_ns += t1 - t0;
+        inserts += live.size();
+
+        for (const live_track &track : live) store.latest(track.track_id, 8, out.data());
+        uint64_t t2 = now_ns();
+        latest_ns += t2 - t1;
+
+        const uint64_t from_us = now_us >= 1000000 ? now_us - 1000000 : 0;
+        for (const live_track &track : live) {
+            const uint32_t got = store.window(track.track_id, from_us, now_us, out.data(), static_cast<uint32_t>(out.size()));
+            const uint64_t first_us = std::max(track.first_us, from_us);
+            const uint64_t in_window = (now_us - first_us) / period_us + 1;
+            const uint64_t expected = std::min<uint64_t>({in_window, store.history(), out.size()});
+            if (got != expected) window_errors++;
+        }
+        uint64_t t3 = now_ns();
+        window_ns += t3 - t2;
+        queries += live.size();
+
+        evicted += store.evict_stale(now_us, MAX_AGE_US);
+        evict_ns += now_ns() - t3;
+    }
+
+    const uint64_t end_us = frames > 0 ? (frames - 1) * period_us : 0;
+    // Tracks ended in the last MAX_AGE_US are not stale yet.
+    const uint64_t pending = store.size() - tracks;
+    const bool evictions_ok = evicted + pending == expected_evictions && pending <= churn * (MAX_AGE_US / 1000000 + 1);
+    const bool never_ok = store.evict_stale(end_us, UINT64_MAX) == 0;
+    track_store single(1, 1);
+    det.track_id             = 1;
+    det.publish_timestamp_us = 1000;
+    single.insert(det);
+    const bool future_ok = single.evict_stale(500, 0) == 0 && single.evict_stale(1000, 0) == 0 &&
+                           single.evict_stale(1001, 0) == 1;
+
+    const double frame_ns = static_cast<double>(insert_ns + latest_ns + window_ns + evict_ns) / std::max<uint64_t>(frames, 1);
+    printf("%u tracks at %u Hz, %.0f s simulated, history %u\n", tracks, rate_hz, seconds, store.history());
+    printf("insert:      %.1f ns/sample\n", static_cast<double>(insert_ns) / std::max<uint64_t>(inserts, 1));
+    printf("latest(8):   %.1f ns/query\n", static_cast<double>(latest_ns) / std::max<uint64_t>(queries, 1));
+    printf("window(1 s): %.1f ns/query\n", static_cast<double>(window_ns) / std::max<uint64_t>(queries, 1));
+    printf("evict_stale: %.1f us/frame\n", evict_ns / 1e3 / std::max<uint64_t>(frames, 1));
+    printf("per frame:   %.1f us of a %.1f ms period (%.2f%%)\n", frame_ns / 1e3, period_us / 1e3,
+           100.0 * frame_ns / (period_us * 1e3));
+    printf("evicted %llu of %llu ended tracks (%llu not yet stale), window errors %llu, failed inserts %llu\n",
+           static_cast<unsigned long long>(evicted), static_cast<unsigned long long>(expected_evictions),
+           static_cast<unsigned long long>(pending), static_cast<unsigned long long>(window_errors),
+           static_cast<unsigned long long>(failed_inserts));
+
+    const bool ok = evictions_ok && never_ok && future_ok && window_errors == 0 && failed_inserts == 0;
+    if (!never_ok) printf("evict_stale(now, UINT64_MAX) evicted tracks\n");
+    if (!future_ok) printf("evict_stale() on a single track with max_age 0 gave the wrong answer\n");
+    printf("%s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,273 @@
+/*
+    warm_start_bench: time from startup to a usable UI with a cold GET storm versus the warm-start cache
+    (warm_cache.hpp).
+
+        g++ -std=c++17 -O2 -pthread -I.. -I../digiview_commons warm_start_bench.cpp -o warm_start_bench
+        ./warm_start_bench [rtt_ms] [service_ms] [cache_path]
+
+    A minimal DigiView simulator on a loopback UDP socket answers GETs and BUNDLE GETs. It produces one reply frame
+    every service_ms, one after another, and each frame reaches the client rtt_ms after it was produced. The UI needs
+    AI, MODEL, DETECTION and SENSOR, plus VIDEO_OUTPUT, CAPTURE and CAM_OPTICS_AND_CONTROL for four streams.
+
+    Session 1 starts cold: it sends every GET at once, waits for all replies and stores them in the cache file.
+    Session 2 reopens the file, loads it into a param_cache and is usable at once. It then revalidates in the
+    background with bundled GETs until every value is confirmed.
+*/
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../warm_cache.hpp"
+
+static const uint16_t SIMULATOR_PORT = 47504;
+static const uint32_t UNIT_ID        = 1;
+static const char    *STREAMS[]      = {"stream0", "stream1", "stream2", "stream3"};
+static const uint8_t  GLOBAL_GROUPS[] = {AI, MODEL, DETECTION, SENSOR};
+static const uint8_t  STREAM_GROUPS[] = {VIDEO_OUTPUT, CAPTURE, CAM_OPTICS_AND_CONTROL};
+
+static uint64_t now_us() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static sockaddr_in loopback(uint16_t port) {
+    sockaddr_in addr = {};
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return addr;
+}
+
+static void send_frame(int fd, message &msg, const sockaddr_in &to) {
+    add_checksum_for_digiview_message(msg);
+    sendto(fd, &msg, sizeof(msg), 0, reinterpret_cast<const sockaddr *>(&to), sizeof(to));
+}
+
+static message group_reply(uint8_t param_type, const char *stream_name, uint8_t cam_id) {
+    message reply = {};
+    reply.version      = VERSION;
+    reply.message_type = CURRENT_PARAMETERS;
+    reply.param_type   = param_type;
+    memset(reply.data, param_type, sizeof(reply.data));
+    const int16_t stream_offset = stream_name_offset(param_type);
+    if (stream_offset >= 0) copy_stream_name_field(&reply.data[stream_offset], stream_name_view(stream_name));
+    const int16_t cam_offset = cam_id_offset(param_type);
+    if (cam_offset >= 0) reply.data[cam_offset] = cam_id;
+    add_checksum_for_digiview_message(reply);
+    return reply;
+}
+
+class simulator {
+public:
+    simulator(uint32_t rtt_ms, uint32_t service_ms) : rtt_us_(rtt_ms * 1000ULL), service_us_(service_ms * 1000ULL) {
+        fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+        const sockaddr_in addr = loopback(SIMULATOR_PORT);
+        if (bind(fd_, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0) {
+            perror("bind");
+            exit(2);
+        }
+        timeval tv = {0, 20000};
+        setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        receiver_ = std::thread([this] { receive_loop(); });
+        sender_   = std::thread([this] { send_loop(); });
+    }
+
+    ~simulator() {
+        stop_.store(true);
+        receiver_.join();
+        sender_.join();
+        close(fd_);
+    }
+
+private:
+    struct pending {
+        uint64_t    due_us;
+        message     frame;
+        sockaddr_in to;
+    };
+
+    void schedule(const message &frame, const sockaddr_in &to) {
+        const uint64_t now = now_us();
+        device_free_us_ = std::max(device_free_us_, now) + service_us_;
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back({device_free_us_ + rtt_us_, frame, to});
+    }
+
+    void receive_loop() {
+        while (!stop_.load()) {
+            message request;
+            sockaddr_in from;
+            socklen_t from_len = sizeof(from);
+            if (recvfrom(fd_, &request, sizeof(request), 0, reinterpret_cast<sockaddr *>(&from), &from_len) != sizeof(request)) continue;
+            if (request.message_type != GET_PARAMETERS) continue;
+            const char *stream = reinterpret_cast<const char *>(request.data);
+            if (request.param_type != BUNDLE) {
+                const int16_t stream_offset = stream_name_offset(request.param_type);
+                char name[STREAM_NAME_SIZE + 1] = {};
+                if (stream_offset >= 0) memcpy(name, stream, STREAM_NAME_SIZE);
+                schedule(group_reply(request.param_type, name, request.data[STREAM_NAME_SIZE]), from);
+                continue;
+            }
+            bundle_parameters bundle;
+            unpack_bundle_parameters(request, bundle);
+            char name[STREAM_NAME_SIZE + 1] = {};
+            memcpy(name, bundle.stream_name, STREAM_NAME_SIZE);
+            uint32_t answered = 0;
+            uint16_t frames   = 0;
+            for (uint8_t p = 0; p < 32; ++p) {
+                if (!(bundle.requested_mask & BUNDLE_SUPPORTED_MASK & param_type_bit(p))) continue;
+                schedule(group_reply(p, name, bundle.cam_id), from);
+                answered |= param_type_bit(p);
+                frames++;
+            }
+            message closing = {};
+            closing.version      = VERSION;
+            closing.message_type = CURRENT_PARAMETERS;
+            pack_bundle_parameters(closing, name, bundle.cam_id, bundle.requested_mask, answered, frames);
+            add_checksum_for_digiview_message(closing);
+            schedule(closing, from);
+        }
+    }
+
+    void send_loop() {
+        while (!stop_.load()) {
+            pending next;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (queue_.empty() || queue_.front().due_us > now_us()) {
+                    next.due_us = 0;
+                } else {
+                    next = queue_.front();
+                    queue_.pop_front();
+                }
+            }
+            if (next.due_us == 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+                continue;
+            }
+            sendto(fd_, &next.frame, sizeof(next.frame), 0, reinterpret_cast<const sockaddr *>(&next.to), sizeof(next.to));
+        }
+    }
+
+    uint64_t            rtt_us_;
+    uint64_t            service_us_;
+    uint64_t            device_free_us_ = 0;
+    int                 fd_;
+    std::atomic<bool>   stop_{false};
+    std::mutex          mutex_;
+    std::deque<pending> queue_;
+    std::thread         receiver_;
+    std::thread         sender_;
+};
+
+static std::vector<param_cache_key> ui_keys() {
+    std::vector<param_cache_key> keys;
+    for (uint8_t p : GLOBAL_GROUPS) keys.push_back(make_param_cache_key(p));
+    for (const char *stream : STREAMS) {
+        for (uint8_t p : STREAM_GROUPS) {
+            keys.push_back(make_param_cache_key(p, stream, cam_id_offset(p) >= 0 ? 0 : 255));
+        }
+    }
+    return keys;
+}
+
+static bool ui_ready(const param_cache &cache, const std::vector<param_cache_key> &keys) {
+    for (const param_cache_key &key : keys) {
+        if (cache.find(key) == nullptr) return false;
+    }
+    return true;
+}
+
+// Receives replies into the param_cache and the warm cache until done() holds or the socket times out.
+template <typename Done>
+static bool receive_until(int fd, param_cache &cache, warm_cache &warm, Done &&done) {
+    while (!done()) {
+        message reply;
+        if (recv(fd, &reply, sizeof(reply), 0) != sizeof(reply)) return false;
+        if (!has_valid_checksum_for_digiview_message(reply) || reply.message_type != CURRENT_PARAMETERS) continue;
+        if (reply.param_type == BUNDLE) continue;
+        cache.publish(reply);
+        warm.store(UNIT_ID, reply);
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    const uint32_t rtt_ms     = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 150;
+    const uint32_t service_ms = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 40;
+    const char    *path       = argc > 3 ? argv[3] : "/tmp/warm_start_bench.cache";
+    unlink(path);
+
+    simulator device(rtt_ms, service_ms);
+    const sockaddr_in device_addr = loopback(SIMULATOR_PORT);
+    const int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    timeval tv = {5, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    const std::vector<param_cache_key> keys = ui_keys();
+
+    // Session 1: cold start with a GET storm.
+    double cold_ms;
+    {
+        warm_cache warm;
+        if (!warm.open(path)) {
+            perror("open cache");
+            return 2;
+        }
+        param_cache cache;
+        const uint64_t start = now_us();
+        for (const param_cache_key &key : keys) {
+            message get = {};
+            pack_get_parameters(get, key.param_type, key.stream_name[0] != '\0' ? key.stream_name : nullptr, key.cam_id);
+            send_frame(fd, get, device_addr);
+        }
+        if (!receive_until(fd, cache, warm, [&] { return ui_ready(cache, keys); })) {
+            printf("FAILED: cold start timed out\n");
+            return 1;
+        }
+        cold_ms = (now_us() - start) / 1e3;
+        warm.sync(true);
+    }
+
+    // Session 2: warm start, then background revalidation.
+    warm_cache warm;
+    if (!warm.open(path)) {
+        perror("reopen cache");
+        return 2;
+    }
+    param_cache cache;
+    const uint64_t start = now_us();
+    const uint32_t loaded = warm.load(UNIT_ID, cache);
+    const bool usable = ui_ready(cache, keys);
+    const double warm_ms = (now_us() - start) / 1e3;
+
+    std::vector<message> gets;
+    warm.revalidation_gets(UNIT_ID, gets);
+    for (message &get : gets) send_frame(fd, get, device_addr);
+    const auto all_confirmed = [&] {
+        for (const param_cache_key &key : keys) {
+            if (!warm.is_confirmed(UNIT_ID, key)) return false;
+        }
+        return true;
+    };
+    const bool revalidated = receive_until(fd, cache, warm, all_confirmed);
+    const double revalidate_ms = (now_us() - start) / 1e3;
+    close(fd);
+
+    printf("rtt %u ms, %u ms per reply frame, %zu groups\n", rtt_ms, service_ms, keys.size());
+    printf("cold start (GET storm):       %8.3f ms to usable UI, %zu GETs\n", cold_ms, keys.size());
+    printf("warm start (mmapped cache):   %8.3f ms to usable UI, %u records loaded\n", warm_ms, loaded);
+    printf("background revalidation:     %8.3f ms until every value confirmed, %zu GETs\n", revalidate_ms, gets.size());
+    const bool ok = usable && revalidated && loaded == keys.size();
+    if (!ok) printf("FAILED\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,275 @@
+#pragma once
+
+#ifndef TRACK_PREDICTOR_HPP
+#define TRACK_PREDICTOR_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <stdint.h>
+
+#include "msg_defs.hpp"
+
+/*
+------------------------------------------------------------------------------------------------------------------------
+    TRACK PREDICTOR
+
+    Extrapolates tracks to the time a command is sent, so CAM_TARGETING aims where the target is rather than where it
+    was at publish_timestamp_us. Each track keeps two fading-memory filters per axis (global yaw, global pitch,
+    latitude, longitude), both updated on every detection:
+
+        CONSTANT_VELOCITY       alpha-beta filter: position and rate.
+        CONSTANT_ACCELERATION   alpha-beta-gamma filter: position, rate and acceleration.
+
+    config.smoothing (theta, 0 .. 1) sets the gains of both on yaw and pitch; 0 follows the newest detection exactly
+    and values near 1 average over many detections. Sample spacing comes from publish_timestamp_us, so irregular
+    publish rates and dropped replies are handled. Yaw and longitude residuals are wrapped, so tracks crossing +-180
+    do not jump.
+
+    Latitude and longitude are truncated to 1e-3 degrees on the wire (about 110 m), so they use the heavier
+    config.position_smoothing. At ground speeds their steps are mostly quantisation, which the acceleration term
+    amplifies; CONSTANT_VELOCITY is the better model for positions.
+
+    predict_batch() evaluates one model for many tracks without branching per track: state is stored as
+    struct-of-arrays, unknown track_ids read a zeroed sentinel slot, and the horizon is clamped to
+    [0, config.max_horizon_us] with min/max. Predictions of tracks with a single detection are that detection.
+
+    track_id 0 means "unavailable" on the wire and is not tracked. Nothing is thread-safe.
+------------------------------------------------------------------------------------------------------------------------
+*/
+enum TRACK_MODEL : uint8_t {
+    CONSTANT_VELOCITY,
+    CONSTANT_ACCELERATION,
+};
+
+struct track_predictor_config {
+    uint32_t max_tracks         = 1024;
+    float    smoothing          = 0.5f;     // theta of the fading-memory gains for yaw and pitch.
+    float    position_smoothing = 0.8f;     // theta for latitude and longitude.
+    uint64_t max_horizon_us     = 500000;   // Extrapolation never reaches further past the newest detection.
+};
+
+struct track_prediction {
+    float    yaw_global;
+    float    pitch_global;
+    float    latitude;
+    float    longitude;
+    uint32_t samples;   // Detections seen for the track; 0 for unknown track_ids.
+};
+
+class track_predictor {
+public:
+    explicit track_predictor(const track_predictor_config &config = track_predictor_config())
+        : capacity_(std::min<uint32_t>(std::max<uint32_t>(config.max_tracks, 1), UINT16_MAX - 1)),
+          max_horizon_s_(config.max_horizon_us * 1e-6) {
+        for (uint32_t k = 0; k < AXIS_COUNT; ++k) {
+            const float smoothing = k == AXIS_LATITUDE || k == AXIS_LONGITUDE ? config.position_smoothing : config.smoothing;
+            const double theta = std::max(0.0f, std::min(0.99f, smoothing));
+            gains &g = gains_[k];
+            g.cv_alpha = 1 - theta * theta;
+            g.cv_beta  = (1 - theta) * (1 - theta);
+            g.ca_alpha = 1 - theta * theta * theta;
+            g.ca_beta  = 1.5 * (1 - theta) * (1 - theta) * (1 + theta);
+            g.ca_gamma = 0.5 * (1 - theta) * (1 - theta) * (1 - theta);
+        }
+
+        // Slot capacity_ is the sentinel read by unknown track_ids; it is never written.
+        const uint32_t slots = capacity_ + 1;
+        slot_of_.assign(65536, static_cast<uint16_t>(capacity_));
+        track_id_.assign(slots, 0);
+        last_us_.assign(slots, 0);
+        samples_.assign(slots, 0);
+        for (axis_state &axis : axes_) {
+            axis.cv_x.assign(slots, 0.0);
+            axis.cv_v.assign(slots, 0.0);
+            axis.ca_x.assign(slots, 0.0);
+            axis.ca_v.assign(slots, 0.0);
+            axis.ca_a.assign(slots, 0.0);
+        }
+        free_slots_.resize(capacity_);
+        for (uint32_t i = 0; i < capacity_; ++i) free_slots_[i] = static_cast<uint16_t>(capacity_ - 1 - i);
+    }
+
+    /*
+        Feeds one detection, stamped with publish_timestamp_us or with receive_us when the sender provides none.
+        Returns false for track_id 0, for a detection not newer than the track's last one, or when all slots are in
+        use.
+    */
+    bool update(const tracked_detection_parameters &det, uint64_t receive_us) {
+        if (det.track_id == 0) return false;
+        const uint64_t t_us = det.publish_timestamp_us != 0 ? det.publish_timestamp_us : receive_us;
+        uint16_t slot = slot_of_[det.track_id];
+        if (slot == capacity_) {
+            if (free_slots_.empty()) return false;
+            slot = free_slots_.back();
+            free_slots_.pop_back();
+            slot_of_[det.track_id] = slot;
+            track_id_[slot] = det.track_id;
+            samples_[slot]  = 0;
+        } else if (t_us <= last_us_[slot]) {
+            return false;
+        }
+
+        const double z[AXIS_COUNT] = {det.yaw_global, det.pitch_global, det.latitude, det.longitude};
+        const double dt = (t_us - last_us_[slot]) * 1e-6;
+        for (uint32_t k = 0; k < AXIS_COUNT; ++k) {
+            axis_state &axis = axes_[k];
+            const gains &g = gains_[k];
+            const bool wraps = k == AXIS_YAW || k == AXIS_LONGITUDE;
+            if (samples_[slot] == 0) {
+                axis.cv_x[slot] = axis.ca_x[slot] = z[k];
+                axis.cv_v[slot] = axis.ca_v[slot] = axis.ca_a[slot] = 0.0;
+                continue;
+            }
+            if (samples_[slot] == 1) {
+                // Two points give the rate directly; the filters take over from the third detection.
+                const double rate = residual(z[k] - axis.cv_x[slot], wraps) / dt;
+                axis.cv_x[slot] = axis.ca_x[slot] = axis.cv_x[slot] + rate * dt;
+                axis.cv_v[slot] = axis.ca_v[slot] = rate;
+                continue;
+            }
+
+            const double cv_pred = axis.cv_x[slot] + axis.cv_v[slot] * dt;
+            const double cv_r    = residual(z[k] - cv_pred, wraps);
+            axis.cv_x[slot] = cv_pred + g.cv_alpha * cv_r;
+            axis.cv_v[slot] += g.cv_beta * cv_r / dt;
+
+            const double ca_pred = axis.ca_x[slot] + axis.ca_v[slot] * dt + 0.5 * axis.ca_a[slot] * dt * dt;
+            const double ca_r    = residual(z[k] - ca_pred, wraps);
+            axis.ca_x[slot] = ca_pred + g.ca_alpha * ca_r;
+            axis.ca_v[slot] += axis.ca_a[slot] * dt + g.ca_beta * ca_r / dt;
+            axis.ca_a[slot] += 2.0 * g.ca_gamma * ca_r / (dt * dt);
+        }
+        last_us_[slot] = t_us;
+        samples_[slot]++;
+        return true;
+    }
+
+    /*
+        Feeds a TRACKED_DETECTION CURRENT_PARAMETERS frame. Returns false for any other frame.
+    */
+    bool observe(message &msg, uint64_t receive_us) {
+        if (msg.message_type != CURRENT_PARAMETERS || msg.param_type != TRACKED_DETECTION) return false;
+        tracked_detection_parameters det;
+        unpack_tracked_detection_parameters(msg, det);
+        return update(det, receive_us);
+    }
+
+    /*
+        Extrapolates track_ids[0 .. n) to at_us with one model and writes the results to out.
+    */
+    void predict_batch(const uint16_t *track_ids, uint32_t n, uint64_t at_us, TRACK_MODEL model,
+                       track_prediction *out) const {
+        if (model == CONSTANT_ACCELERATION) {
+            predict_kernel<true>(track_ids, n, at_us, out);
+        } else {
+            predict_kernel<false>(track_ids, n, at_us, out);
+        }
+    }
+
+    /*
+        Single-track form of predict_batch. Returns false for an unknown track_id.
+    */
+    bool predict(uint16_t track_id, uint64_t at_us, TRACK_MODEL model, track_prediction &out) const {
+        predict_batch(&track_id, 1, at_us, model, &out);
+        return out.samples != 0;
+    }
+
+    /*
+        publish_timestamp_us (or receive time) of the track's newest detection; 0 for an unknown track_id.
+    */
+    uint64_t last_update_us(uint16_t track_id) const {
+        return last_us_[slot_of_[track_id]];
+    }
+
+    bool erase(uint16_t track_id) {
+        const uint16_t slot = slot_of_[track_id];
+        if (slot == capacity_) return false;
+        slot_of_[track_id] = static_cast<uint16_t>(capacity_);
+        track_id_[slot] = 0;
+        last_us_[slot]  = 0;
+        samples_[slot]  = 0;
+        free_slots_.push_back(slot);
+        return true;
+    }
+
+    /*
+        Removes tracks whose newest detection is older than now_us - max_age_us. Returns the number removed.
+    */
+    uint32_t evict_stale(uint64_t now_us, uint64_t max_age_us) {
+        uint32_t removed = 0;
+        for (uint32_t slot = 0; slot < capacity_; ++slot) {
+            if (track_id_[slot] == 0 || last_us_[slot] + max_age_us >= now_us) continue;
+            erase(track_id_[slot]);
+            removed++;
+        }
+        return removed;
+    }
+
+    uint32_t size() const {
+        return capacity_ - static_cast<uint32_t>(free_slots_.size());
+    }
+
+private:
+    enum TRACK_AXIS : uint8_t {
+        AXIS_YAW,
+        AXIS_PITCH,
+        AXIS_LATITUDE,
+        AXIS_LONGITUDE,
+        AXIS_COUNT,
+    };
+
+    struct gains {
+        double cv_alpha, cv_beta;
+        double ca_alpha, ca_beta, ca_gamma;
+    };
+
+    struct axis_state {
+        std::vector<double> cv_x;
+        std::vector<double> cv_v;
+        std::vector<double> ca_x;
+        std::vector<double> ca_v;
+        std::vector<double> ca_a;
+    };
+
+    static double wrap_degrees(double angle) {
+        return angle - 360.0 * std::floor((angle + 180.0) / 360.0);
+    }
+
+    static double residual(double r, bool wraps) {
+        return wraps ? wrap_degrees(r) : r;
+    }
+
+    template <bool Acceleration>
+    void predict_kernel(const uint16_t *track_ids, uint32_t n, uint64_t at_us, track_prediction *out) const {
+        const axis_state &yaw = axes_[AXIS_YAW], &pitch = axes_[AXIS_PITCH];
+        const axis_state &lat = axes_[AXIS_LATITUDE], &lon = axes_[AXIS_LONGITUDE];
+        for (uint32_t i = 0; i < n; ++i) {
+            const uint16_t s = slot_of_[track_ids[i]];
+            // Signed, so a send time before the newest detection clamps to 0 instead of wrapping.
+            const double elapsed = static_cast<double>(static_cast<int64_t>(at_us - last_us_[s])) * 1e-6;
+            const double dt = std::min(max_horizon_s_, std::max(0.0, elapsed));
+            const double half_dt2 = Acceleration ? 0.5 * dt * dt : 0.0;
+            const auto extrapolate = [&](const axis_state &a) {
+                return Acceleration ? a.ca_x[s] + a.ca_v[s] * dt + a.ca_a[s] * half_dt2 : a.cv_x[s] + a.cv_v[s] * dt;
+            };
+            out[i].yaw_global   = static_cast<float>(wrap_degrees(extrapolate(yaw)));
+            out[i].pitch_global = static_cast<float>(std::min(90.0, std::max(-90.0, extrapolate(pitch))));
+            out[i].latitude     = static_cast<float>(std::min(90.0, std::max(-90.0, extrapolate(lat))));
+            out[i].longitude    = static_cast<float>(wrap_degrees(extrapolate(lon)));
+            out[i].samples      = samples_[s];
+        }
+    }
+
+    uint32_t              capacity_;
+    double                max_horizon_s_;
+    gains                 gains_[AXIS_COUNT];
+    std::vector<uint16_t> slot_of_;   // Indexed by track_id; capacity_ for unknown tracks.
+    std::vector<uint16_t> track_id_;
+    std::vector<uint64_t> last_us_;
+    std::vector<uint32_t> samples_;
+    axis_state            axes_[AXIS_COUNT];
+    std::vector<uint16_t> free_slots_;
+};
+
+#endif // TRACK_PREDICTOR_HPP
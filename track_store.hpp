@@ -0,0 +1,300 @@
+#pragma once
+
+#ifndef TRACK_STORE_HPP
+#define TRACK_STORE_HPP
+
+#include <cstring>
+#include <vector>
+#include <stdint.h>
+
+#include "msg_defs.hpp"
+
+/*
+------------------------------------------------------------------------------------------------------------------------
+    TRACK STORE
+
+    Bounded per-track history of TRACKED_DETECTION data. Tracks are found through an open-addressing table keyed by
+    track_id. Each track owns a fixed-size ring of samples, stored as struct-of-arrays so scans over one field stay
+    contiguous. All memory is allocated up front; insert, lookup and eviction never allocate.
+
+    Samples are expected in publish order per track. Time-window queries binary-search the ring on
+    publish_timestamp_us.
+
+    track_id 0 means "unavailable" on the wire and is not stored. The store is not thread-safe.
+------------------------------------------------------------------------------------------------------------------------
+*/
+struct track_sample {
+    uint64_t publish_timestamp_us;
+    float    yaw_global;
+    float    pitch_global;
+    float    yaw_rel;
+    float    pitch_rel;
+    float    latitude;
+    float    longitude;
+    float    width;
+    float    height;
+    int16_t  type;
+    uint8_t  score;
+};
+
+class track_store {
+public:
+    static constexpr uint16_t NO_SLOT = UINT16_MAX;
+
+    /*
+        max_tracks is capped at 65535. history is rounded up to a power of two.
+    */
+    explicit track_store(uint32_t max_tracks = 1024, uint32_t history = 64) {
+        max_tracks_ = max_tracks < NO_SLOT ? max_tracks : NO_SLOT - 1;
+        history_    = 1;
+        while (history_ < history) history_ <<= 1;
+        uint32_t table_size = 1;
+        while (table_size < max_tracks_ * 2) table_size <<= 1;
+        table_mask_ = table_size - 1;
+
+        table_.assign(table_size, table_entry{0, NO_SLOT});
+        tracks_.assign(max_tracks_, track_state{});
+        free_slots_.resize(max_tracks_);
+        for (uint32_t i = 0; i < max_tracks_; ++i) {
+            free_slots_[i] = static_cast<uint16_t>(max_tracks_ - 1 - i);
+        }
+
+        const size_t samples = static_cast<size_t>(max_tracks_) * history_;
+        timestamp_us_.resize(samples);
+        yaw_global_.resize(samples);
+        pitch_global_.resize(samples);
+        yaw_rel_.resize(samples);
+        pitch_rel_.resize(samples);
+        latitude_.resize(samples);
+        longitude_.resize(samples);
+        width_.resize(samples);
+        height_.resize(samples);
+        type_.resize(samples);
+        score_.resize(samples);
+    }
+
+    /*
+        Appends one detection to its track, creating the track if needed. Returns false for track_id 0 or when all
+        track slots are in use.
+    */
+    bool insert(const tracked_detection_parameters &det) {
+        if (det.track_id == 0) return false;
+        uint16_t slot = find_slot(det.track_id);
+        if (slot == NO_SLOT) {
+            if (free_slots_.empty()) return false;
+            slot = free_slots_.back();
+            free_slots_.pop_back();
+            tracks_[slot] = track_state{det.track_id, 0, 0, 0};
+            table_insert(det.track_id, slot);
+        }
+
+        track_state &track = tracks_[slot];
+        const size_t i = static_cast<size_t>(slot) * history_ + (track.head & (history_ - 1));
+        timestamp_us_[i] = det.publish_timestamp_us;
+        yaw_global_[i]   = det.yaw_global;
+        pitch_global_[i] = det.pitch_global;
+        yaw_rel_[i]      = det.yaw_rel;
+        pitch_rel_[i]    = det.pitch_rel;
+        latitude_[i]     = det.latitude;
+        longitude_[i]    = det.longitude;
+        width_[i]        = det.width;
+        height_[i]       = det.height;
+        type_[i]         = det.type;
+        score_[i]        = det.score;
+        track.head++;
+        if (track.count < history_) track.count++;
+        track.last_update_us = det.publish_timestamp_us;
+        return true;
+    }
+
+    bool contains(uint16_t track_id) const {
+        return find_slot(track_id) != NO_SLOT;
+    }
+
+    uint32_t sample_count(uint16_t track_id) const {
+        const uint16_t slot = find_slot(track_id);
+        return slot == NO_SLOT ? 0 : tracks_[slot].count;
+    }
+
+    /*
+        Copies up to n of the newest samples of a track into out, oldest first. Returns the number copied.
+    */
+    uint32_t latest(uint16_t track_id, uint32_t n, track_sample *out) const {
+        const uint16_t slot = find_slot(track_id);
+        if (slot == NO_SLOT) return 0;
+        const track_state &track = tracks_[slot];
+        const uint32_t copied = n < track.count ? n : track.count;
+        for (uint32_t k = 0; k < copied; ++k) {
+            out[k] = sample_at(slot, track, track.count - copied + k);
+        }
+        return copied;
+    }
+
+    /*
+        Copies samples with from_us <= publish_timestamp_us <= to_us into out, oldest first, up to max_out. Returns
+        the number copied.
+    */
+    uint32_t window(uint16_t track_id, uint64_t from_us, uint64_t to_us, track_sample *out, uint32_t max_out) const {
+        const uint16_t slot = find_slot(track_id);
+        if (slot == NO_SLOT) return 0;
+        const track_state &track = tracks_[slot];
+
+        uint32_t lo = 0, hi = track.count;
+        while (lo < hi) {
+            const uint32_t mid = (lo + hi) / 2;
+            if (timestamp_us_[index_of(slot, track, mid)] < from_us) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        uint32_t copied = 0;
+        for (uint32_t k = lo; k < track.count && copied < max_out; ++k) {
+            if (timestamp_us_[index_of(slot, track, k)] > to_us) break;
+            out[copied++] = sample_at(slot, track, k);
+        }
+        return copied;
+    }
+
+    /*
+        Removes tracks whose newest sample is more than max_age_us older than now_us. Returns the number removed.
+        Written as an age comparison so that max_age_us = UINT64_MAX means "never", and samples stamped after now_us
+        are not stale.
+    */
+    uint32_t evict_stale(uint64_t now_us, uint64_t max_age_us) {
+        uint32_t removed = 0;
+        for (uint32_t slot = 0; slot < max_tracks_; ++slot) {
+            track_state &track = tracks_[slot];
+            if (track.track_id == 0) continue;
+            if (now_us <= track.last_update_us || now_us - track.last_update_us <= max_age_us) continue;
+            erase(track.track_id);
+            removed++;
+        }
+        return removed;
+    }
+
+    bool erase(uint16_t track_id) {
+        const uint16_t slot = find_slot(track_id);
+        if (slot == NO_SLOT) return false;
+        table_erase(track_id);
+        tracks_[slot] = track_state{};
+        free_slots_.push_back(slot);
+        return true;
+    }
+
+    uint32_t size() const {
+        return max_tracks_ - static_cast<uint32_t>(free_slots_.size());
+    }
+
+    uint32_t history() const {
+        return history_;
+    }
+
+    /*
+        Calls fn(track_id) for every live track.
+    */
+    template <typename Fn>
+    void for_each_track(Fn &&fn) const {
+        for (const track_state &track : tracks_) {
+            if (track.track_id != 0) fn(track.track_id);
+        }
+    }
+
+private:
+    struct table_entry {
+        uint16_t track_id;
+        uint16_t slot;
+    };
+
+    struct track_state {
+        uint16_t track_id;
+        uint32_t head;
+        uint32_t count;
+        uint64_t last_update_us;
+    };
+
+    static uint32_t hash(uint16_t track_id) {
+        return (static_cast<uint32_t>(track_id) * 2654435761U) >> 8;
+    }
+
+    size_t index_of(uint16_t slot, const track_state &track, uint32_t logical) const {
+        const uint32_t oldest = track.head - track.count;
+        return static_cast<size_t>(slot) * history_ + ((oldest + logical) & (history_ - 1));
+    }
+
+    track_sample sample_at(uint16_t slot, const track_state &track, uint32_t logical) const {
+        const size_t i = index_of(slot, track, logical);
+        track_sample sample;
+        sample.publish_timestamp_us = timestamp_us_[i];
+        sample.yaw_global           = yaw_global_[i];
+        sample.pitch_global         = pitch_global_[i];
+        sample.yaw_rel              = yaw_rel_[i];
+        sample.pitch_rel            = pitch_rel_[i];
+        sample.latitude             = latitude_[i];
+        sample.longitude            = longitude_[i];
+        sample.width                = width_[i];
+        sample.height               = height_[i];
+        sample.type                 = type_[i];
+        sample.score                = score_[i];
+        return sample;
+    }
+
+    uint16_t find_slot(uint16_t track_id) const {
+        for (uint32_t i = hash(track_id) & table_mask_;; i = (i + 1) & table_mask_) {
+            const table_entry &entry = table_[i];
+            if (entry.slot == NO_SLOT) return NO_SLOT;
+            if (entry.track_id == track_id) return entry.slot;
+        }
+    }
+
+    void table_insert(uint16_t track_id, uint16_t slot) {
+        uint32_t i = hash(track_id) & table_mask_;
+        while (table_[i].slot != NO_SLOT) {
+            i = (i + 1) & table_mask_;
+        }
+        table_[i] = table_entry{track_id, slot};
+    }
+
+    // Linear-probing delete with backward shift, so no tombstones build up as tracks come and go.
+    void table_erase(uint16_t track_id) {
+        uint32_t i = hash(track_id) & table_mask_;
+        while (table_[i].track_id != track_id || table_[i].slot == NO_SLOT) {
+            i = (i + 1) & table_mask_;
+        }
+        uint32_t j = i;
+        for (;;) {
+            table_[i].slot = NO_SLOT;
+            for (;;) {
+                j = (j + 1) & table_mask_;
+                if (table_[j].slot == NO_SLOT) return;
+                const uint32_t home = hash(table_[j].track_id) & table_mask_;
+                // Move entry j into the hole at i unless its home lies cyclically in (i, j].
+                const bool stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+                if (!stays) break;
+            }
+            table_[i] = table_[j];
+            i = j;
+        }
+    }
+
+    uint32_t                  max_tracks_ = 0;
+    uint32_t                  history_    = 0;
+    uint32_t                  table_mask_ = 0;
+    std::vector<table_entry>  table_;
+    std::vector<track_state>  tracks_;
+    std::vector<uint16_t>     free_slots_;
+
+    std::vector<uint64_t>     timestamp_us_;
+    std::vector<float>        yaw_global_;
+    std::vector<float>        pitch_global_;
+    std::vector<float>        yaw_rel_;
+    std::vector<float>        pitch_rel_;
+    std::vector<float>        latitude_;
+    std::vector<float>        longitude_;
+    std::vector<float>        width_;
+    std::vector<float>        height_;
+    std::vector<int16_t>      type_;
+    std::vector<uint8_t>      score_;
+};
+
+#endif // TRACK_STORE_HPP
@@ -0,0 +1,321 @@
+#pragma once
+
+#ifndef WARM_CACHE_HPP
+#define WARM_CACHE_HPP
+
+#include <atomic>
+#include <cstring>
+#include <ctime>
+#include <vector>
+#include <stdint.h>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "msg_defs.hpp"
+#include "param_cache.hpp"
+
+/*
+------------------------------------------------------------------------------------------------------------------------
+    WARM-START CACHE
+
+    On-disk snapshot of the last CURRENT_PARAMETERS frame for each (unit, param_type, stream_name, cam_id), so a
+    client can show last-known state right after a restart. unit_id is chosen by the application (for example a
+    serial number or address hash) and separates several DigiView units in one file.
+
+    The file is a fixed-capacity open-addressing table mapped with MAP_SHARED. store() writes straight into the
+    mapping, so saving costs a memcpy and no system calls; the kernel writes pages back on its own schedule and
+    sync() forces it. Each record carries a sequence that is odd while it is being written. Records left odd by a
+    crash, or whose frame fails its checksum, are ignored when loading.
+
+    Every open() starts a new session. load() publishes the saved frames into a param_cache, marked as not yet
+    confirmed; revalidation_gets() builds the GETs (bundled where possible) that refresh them, and every store()
+    confirms its record for the current session. is_confirmed() tells the UI whether a value is live or last-known.
+
+    Only param types in config.persist_mask are saved; fast-changing groups such as TRACKED_DETECTION are left out
+    by default. The file is locked while open, so a second process cannot open it. Not thread-safe: call store()
+    from the thread that receives replies.
+------------------------------------------------------------------------------------------------------------------------
+*/
+static constexpr uint32_t WARM_CACHE_MAGIC          = 0x43575644; // "DVWC"
+static constexpr uint16_t WARM_CACHE_LAYOUT_VERSION = 1;
+
+// Groups that rarely change between sessions.
+static constexpr uint32_t WARM_CACHE_DEFAULT_MASK =
+    param_type_bit(AI) | param_type_bit(MODEL) | param_type_bit(VIDEO_OUTPUT) | param_type_bit(CAPTURE) |
+    param_type_bit(DETECTION) | param_type_bit(SENSOR) | param_type_bit(CAM_OPTICS_AND_CONTROL) |
+    param_type_bit(CALIBRATION);
+
+struct warm_cache_config {
+    uint32_t capacity     = 1024;                     // Records, rounded up to a power of two. Used when creating.
+    uint32_t persist_mask = WARM_CACHE_DEFAULT_MASK;  // Bit n (param_type_bit) = PARAM_TYPE n.
+};
+
+struct warm_cache_header {
+    uint32_t magic;
+    uint16_t layout_version;
+    uint16_t record_size;
+    uint32_t capacity;
+    uint32_t reserved;
+    uint64_t session;
+    uint64_t created_us;
+};
+
+struct alignas(64) warm_cache_record {
+    uint32_t        used;
+    uint32_t        unit_id;
+    param_cache_key key;
+    uint64_t        sequence;   // Odd while the record is being written.
+    uint64_t        saved_us;   // Wall-clock time of the store.
+    uint64_t        session;    // Session of the last store.
+    message         frame;
+};
+
+class warm_cache {
+public:
+    warm_cache() = default;
+    warm_cache(const warm_cache &) = delete;
+    warm_cache &operator=(const warm_cache &) = delete;
+
+    ~warm_cache() {
+        close();
+    }
+
+    /*
+        Opens or creates the cache file and starts a new session. A file with another layout is reset. Returns false
+        if the file cannot be created, mapped or locked.
+    */
+    bool open(const char *path, const warm_cache_config &config = warm_cache_config()) {
+        close();
+        persist_mask_ = config.persist_mask;
+        fd_ = ::open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd_ < 0) return false;
+        if (flock(fd_, LOCK_EX | LOCK_NB) != 0) {
+            close();
+            return false;
+        }
+
+        warm_cache_header existing = {};
+        struct stat st;
+        const bool readable = fstat(fd_, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(warm_cache_header) &&
+                              pread(fd_, &existing, sizeof(existing), 0) == static_cast<ssize_t>(sizeof(existing));
+        const bool valid = readable && existing.magic == WARM_CACHE_MAGIC && existing.layout_version == WARM_CACHE_LAYOUT_VERSION &&
+                           existing.record_size == sizeof(warm_cache_record) && existing.capacity != 0 &&
+                           (existing.capacity & (existing.capacity - 1)) == 0 &&
+                           static_cast<size_t>(st.st_size) == file_size(existing.capacity);
+
+        uint32_t capacity = 1;
+        while (capacity < config.capacity) capacity <<= 1;
+        if (valid) capacity = existing.capacity;
+        size_ = file_size(capacity);
+        if (!valid && ftruncate(fd_, 0) != 0) {
+            close();
+            return false;
+        }
+        if (!valid && ftruncate(fd_, static_cast<off_t>(size_)) != 0) {
+            close();
+            return false;
+        }
+        void *base = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (base == MAP_FAILED) {
+            close();
+            return false;
+        }
+        header_  = static_cast<warm_cache_header *>(base);
+        records_ = reinterpret_cast<warm_cache_record *>(static_cast<uint8_t *>(base) + records_offset());
+        mask_    = capacity - 1;
+
+        if (!valid) {
+            header_->layout_version = WARM_CACHE_LAYOUT_VERSION;
+            header_->record_size    = sizeof(warm_cache_record);
+            header_->capacity       = capacity;
+            header_->session        = 0;
+            header_->created_us     = wall_clock_us();
+            header_->magic          = WARM_CACHE_MAGIC;
+        }
+        header_->session++;
+        return true;
+    }
+
+    void close() {
+        if (header_ != nullptr) {
+            munmap(header_, size_);
+            header_  = nullptr;
+            records_ = nullptr;
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);  // Also releases the lock.
+            fd_ = -1;
+        }
+    }
+
+    bool is_open() const {
+        return header_ != nullptr;
+    }
+
+    /*
+        Saves frame as the last-known value for its key and confirms it for this session. Frames that are not
+        CURRENT_PARAMETERS, fail their checksum or are outside persist_mask are ignored. Returns false if the frame
+        was not saved.
+    */
+    bool store(uint32_t unit_id, const message &frame) {
+        if (header_ == nullptr || frame.message_type != CURRENT_PARAMETERS) return false;
+        if (!(persist_mask_ & param_type_bit(frame.param_type)) || !has_valid_checksum_for_digiview_message(frame)) return false;
+        const param_cache_key key = make_param_cache_key(frame);
+        warm_cache_record *r = find_or_insert(unit_id, key);
+        if (r == nullptr) return false;
+        r->sequence++;
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        r->frame    = frame;
+        r->saved_us = wall_clock_us();
+        r->session  = header_->session;
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        r->sequence++;
+        return true;
+    }
+
+    /*
+        Publishes every saved frame of unit_id into cache and returns how many were loaded. The values are
+        last-known until is_confirmed() turns true for them.
+    */
+    uint32_t load(uint32_t unit_id, param_cache &cache) const {
+        uint32_t loaded = 0;
+        for_each(unit_id, [&](const warm_cache_record &r) {
+            if (cache.publish(r.key, r.frame)) loaded++;
+        });
+        return loaded;
+    }
+
+    /*
+        True once the key has been stored in this session, i.e. refreshed from the unit since startup.
+    */
+    bool is_confirmed(uint32_t unit_id, const param_cache_key &key) const {
+        const warm_cache_record *r = find(unit_id, key);
+        return r != nullptr && r->session == header_->session;
+    }
+
+    /*
+        Wall-clock time the saved value was received, or 0 if there is none.
+    */
+    uint64_t saved_us(uint32_t unit_id, const param_cache_key &key) const {
+        const warm_cache_record *r = find(unit_id, key);
+        return r == nullptr ? 0 : r->saved_us;
+    }
+
+    /*
+        Appends GETs that refresh every unconfirmed record of unit_id. Groups that can be bundled share one BUNDLE GET
+        per (stream_name, cam_id); the rest get a plain GET each.
+    */
+    void revalidation_gets(uint32_t unit_id, std::vector<message> &out) const {
+        struct bundle_target {
+            param_cache_key key;   // param_type unused.
+            uint32_t        mask;
+        };
+        std::vector<bundle_target> bundles;
+        for_each(unit_id, [&](const warm_cache_record &r) {
+            if (r.session == header_->session) return;
+            const char *stream = r.key.stream_name[0] != '\0' ? r.key.stream_name : nullptr;
+            if (!(BUNDLE_SUPPORTED_MASK & param_type_bit(r.key.param_type))) {
+                message get = {};
+                pack_get_parameters(get, r.key.param_type, stream, r.key.cam_id);
+                out.push_back(get);
+                return;
+            }
+            for (bundle_target &b : bundles) {
+                if (b.key.cam_id == r.key.cam_id && memcmp(b.key.stream_name, r.key.stream_name, STREAM_NAME_SIZE) == 0) {
+                    b.mask |= param_type_bit(r.key.param_type);
+                    return;
+                }
+            }
+            bundles.push_back({r.key, param_type_bit(r.key.param_type)});
+        });
+        for (const bundle_target &b : bundles) {
+            char stream[STREAM_NAME_SIZE + 1] = {};
+            memcpy(stream, b.key.stream_name, STREAM_NAME_SIZE);
+            message get = {};
+            pack_get_bundle_parameters(get, b.mask, stream, b.key.cam_id);
+            out.push_back(get);
+        }
+    }
+
+    /*
+        Asks the kernel to write dirty pages back now. wait blocks until they are on disk.
+    */
+    bool sync(bool wait = false) {
+        return header_ != nullptr && msync(header_, size_, wait ? MS_SYNC : MS_ASYNC) == 0;
+    }
+
+    uint64_t session() const {
+        return header_ == nullptr ? 0 : header_->session;
+    }
+
+private:
+    static size_t records_offset() {
+        return (sizeof(warm_cache_header) + alignof(warm_cache_record) - 1) / alignof(warm_cache_record) * alignof(warm_cache_record);
+    }
+
+    static size_t file_size(uint32_t capacity) {
+        return records_offset() + static_cast<size_t>(capacity) * sizeof(warm_cache_record);
+    }
+
+    static uint64_t wall_clock_us() {
+        timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000ULL + static_cast<uint64_t>(ts.tv_nsec) / 1000ULL;
+    }
+
+    static uint32_t hash(uint32_t unit_id, const param_cache_key &key) {
+        return param_cache_hash(key) ^ (unit_id * 0x9E3779B1U);
+    }
+
+    static bool intact(const warm_cache_record &r) {
+        return (r.sequence & 1) == 0 && has_valid_checksum_for_digiview_message(r.frame);
+    }
+
+    template <typename Handler>
+    void for_each(uint32_t unit_id, Handler &&handler) const {
+        if (header_ == nullptr) return;
+        for (uint32_t i = 0; i <= mask_; ++i) {
+            const warm_cache_record &r = records_[i];
+            if (r.used && r.unit_id == unit_id && intact(r)) handler(r);
+        }
+    }
+
+    const warm_cache_record *find(uint32_t unit_id, const param_cache_key &key) const {
+        if (header_ == nullptr) return nullptr;
+        for (uint32_t i = hash(unit_id, key) & mask_, probes = 0; probes <= mask_; i = (i + 1) & mask_, ++probes) {
+            const warm_cache_record &r = records_[i];
+            if (!r.used) return nullptr;
+            if (r.unit_id == unit_id && memcmp(&r.key, &key, sizeof(key)) == 0) return intact(r) ? &r : nullptr;
+        }
+        return nullptr;
+    }
+
+    warm_cache_record *find_or_insert(uint32_t unit_id, const param_cache_key &key) {
+        for (uint32_t i = hash(unit_id, key) & mask_, probes = 0; probes <= mask_; i = (i + 1) & mask_, ++probes) {
+            warm_cache_record &r = records_[i];
+            if (!r.used) {
+                r.unit_id  = unit_id;
+                r.key      = key;
+                r.sequence = 0;
+                std::atomic_signal_fence(std::memory_order_seq_cst);
+                r.used     = 1;
+                return &r;
+            }
+            if (r.unit_id == unit_id && memcmp(&r.key, &key, sizeof(key)) == 0) return &r;
+        }
+        return nullptr;
+    }
+
+    int                 fd_           = -1;
+    size_t              size_         = 0;
+    uint32_t            mask_         = 0;
+    uint32_t            persist_mask_ = 0;
+    warm_cache_header  *header_       = nullptr;
+    warm_cache_record  *records_      = nullptr;
+};
+
+#endif // WARM_CACHE_HPP